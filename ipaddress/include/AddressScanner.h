@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "IPAddress.h"
+
+namespace ip_address
+{
+	/*
+	 * Address found in text.
+	 */
+	struct AddressMatch
+	{
+		/* offset of the first character of the address in the scanned text */
+		size_t offset = 0;
+		size_t length = 0;
+		IPAddress address;
+	};
+
+	/*
+	 * Extracts every IPv4 and IPv6 address from unstructured text (logs, mail headers, configs), like grepcidr.
+	 *
+	 * A candidate is a maximal run of digits, hex letters, dots and colons that contains a dot or a colon and is
+	 * not glued to a letter or '_'. The scanner finds separators and run ends with SSE2 compares that classify
+	 * 16 bytes at a time, so text without candidates is skipped at memory speed, and validates candidates with
+	 * the strict numeric parsers below, which never allocate or resolve names. Trailing dots (end of a sentence)
+	 * are not part of a match, "1.2.3.4:80" yields 1.2.3.4 and "[2001:db8::1]:80" yields 2001:db8::1.
+	 *
+	 * scanParallel() splits the text in chunks at arbitrary bytes, a chunk owns the candidates that start in it
+	 * and reads past its end to finish them, so the merged matches equal those of scan().
+	 */
+	class AddressScanner final
+	{
+	public:
+		/* longest run that is considered, the longest IPv6 text form has 45 characters */
+		static constexpr size_t kMaxCandidateLength = 128;
+
+		/*
+		 * Parses a dotted quad, every part is a decimal number up to 255 without leading zeros.
+		 */
+		NODISCARD static bool parseIPv4(std::string_view text, IPAddressV4& addr4) noexcept;
+		/*
+		 * Parses the RFC 4291 text form: up to 8 groups of 1 to 4 hex digits, at most one "::" and an optional
+		 * dotted quad for the last 32 bits. Zone indices are not accepted.
+		 */
+		NODISCARD static bool parseIPv6(std::string_view text, IPAddressV6& addr6) noexcept;
+		NODISCARD static bool parse(std::string_view text, IPAddress& addr) noexcept;
+
+		/*
+		 * Appends the addresses in text to matches in order of their offsets.
+		 * @return number of appended matches.
+		 */
+		static size_t scan(std::string_view text, std::vector<AddressMatch>& matches);
+		/*
+		 * Like scan(), with the text split in chunks that are scanned on threads.
+		 * @param threads number of threads, 0 for one per hardware thread.
+		 * @param chunkSize bytes per chunk, 0 for several chunks of at least 1 MiB per thread.
+		 */
+		static size_t scanParallel(std::string_view text, std::vector<AddressMatch>& matches, size_t threads = 0,
+		                           size_t chunkSize = 0);
+		/*
+		 * Maps the file and scans it with scanParallel().
+		 * throws std::runtime_error if the file can not be mapped.
+		 */
+		static size_t scanFile(const std::string& path, std::vector<AddressMatch>& matches, size_t threads = 0);
+	};
+}
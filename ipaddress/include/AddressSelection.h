@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "IPEndPoint.h"
+
+namespace ip_address
+{
+	/*
+	 * Destination address selection of RFC 6724, orders the addresses of a host name by how likely a connection
+	 * to them is to work and to take the preferred path.
+	 *
+	 * Every destination is paired with the source address the stack would pick for it (RFC 6724 section 5:
+	 * same address, appropriate scope, matching label, longest matching prefix) out of the local addresses
+	 * given to the constructor. The destinations are then stably sorted by the rules of section 6: usable
+	 * (a source of the same family exists), matching scope, matching label, higher precedence, smaller scope
+	 * and the longest matching prefix with the source for IPv6. Deprecated, home address and encapsulation
+	 * rules (3, 4, 7) need interface state that is not available and are skipped.
+	 *
+	 * Precedence and label come from the default policy table of RFC 6724 section 2.1 which is searched once
+	 * per destination, the comparison works on precomputed keys.
+	 */
+	class AddressSorter final
+	{
+	public:
+		/* RFC 6724 section 3.1 scope values */
+		static constexpr uint8_t kScopeInterfaceLocal = 0x1;
+		static constexpr uint8_t kScopeLinkLocal = 0x2;
+		static constexpr uint8_t kScopeSiteLocal = 0x5;
+		static constexpr uint8_t kScopeGlobal = 0xE;
+
+		/*
+		 * Uses the addresses of the local interfaces from getifaddrs as sources.
+		 */
+		AddressSorter();
+		explicit AddressSorter(std::vector<IPAddress> sources);
+	public:
+		/*
+		 * Sorts destinations in place, most preferred first. Addresses that compare equal keep their order.
+		 */
+		void sort(std::vector<IPAddress>& destinations) const;
+		void sort(std::vector<IPEndPoint>& destinations) const;
+		/*
+		 * Selects the source address for destination.
+		 * @param source [out] the selected source.
+		 * @return false if there is no local address of the family of destination.
+		 */
+		NODISCARD bool getSource(const IPAddress& destination, IPAddress& source) const noexcept;
+
+		NODISCARD const std::vector<IPAddress>& getSources() const noexcept { return mSources; }
+
+		NODISCARD static uint8_t getPrecedence(const IPAddress& addr) noexcept;
+		NODISCARD static uint8_t getLabel(const IPAddress& addr) noexcept;
+		NODISCARD static uint8_t getScope(const IPAddress& addr) noexcept;
+	private:
+		struct Key
+		{
+			uint32_t index;
+			bool usable;
+			bool matchingScope;
+			bool matchingLabel;
+			uint8_t precedence;
+			uint8_t scope;
+			uint8_t commonPrefix;
+			bool isIPv6;
+		};
+	private:
+		NODISCARD Key makeKey(const IPAddress& destination, uint32_t index) const noexcept;
+		template <typename Address>
+		void sortAddresses(std::vector<Address>& destinations) const;
+	private:
+		std::vector<IPAddress> mSources;
+	};
+}
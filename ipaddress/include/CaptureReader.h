@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "PacketHeader.h"
+
+namespace ip_address
+{
+	/*
+	 * One IP packet from a capture file.
+	 */
+	struct CaptureRecord
+	{
+		/* capture time in nanoseconds since the epoch */
+		uint64_t timestamp = 0;
+		IPEndPoint source;
+		IPEndPoint destination;
+		/* transport protocol number e.g IPPROTO_TCP */
+		uint8_t protocol = 0;
+		/* captured bytes of the IP packet, points into the mapped file and is valid as long as the reader */
+		Span<const uint8_t> packet;
+	};
+
+	enum class CaptureFormat
+	{
+		kPcap,
+		kPcapNg,
+	};
+
+	/*
+	 * Streaming reader for classic pcap and pcapng capture files.
+	 *
+	 * The file is mapped read only with a sequential access hint and decoded in place, packets are never copied
+	 * and pages that were consumed are dropped from the page cache mapping so memory stays flat on large files.
+	 * Ethernet (with VLAN tags), raw IP, Linux cooked (SLL) and BSD loopback link types are understood, packets
+	 * that are not IPv4 or IPv6 are skipped.
+	 * Both byte orders and microsecond/nanosecond pcap files are supported, as well as the if_tsresol option
+	 * and multiple interfaces in pcapng.
+	 *
+	 *	CaptureReader reader("trace.pcapng");
+	 *	CaptureRecord records[256];
+	 *	while (const size_t count = reader.readBatch(records, 256)) { ... }
+	 */
+	class CaptureReader final
+	{
+	public:
+		/*
+		 * Maps the file and reads the file header.
+		 * throws std::runtime_error if the file can not be mapped or is neither pcap nor pcapng.
+		 */
+		explicit CaptureReader(const std::string& path);
+		~CaptureReader();
+		CaptureReader(const CaptureReader&) = delete;
+		CaptureReader& operator=(const CaptureReader&) = delete;
+	public:
+		/*
+		 * Decodes up to capacity IP packets from the current position.
+		 * @return number of records written, 0 at the end of the file or on a truncated/corrupt record.
+		 */
+		size_t readBatch(CaptureRecord* records, size_t capacity) noexcept;
+		/*
+		 * Splits the file into threadCount parts at record boundaries and decodes them concurrently.
+		 * callback(part, records, count) is called from the worker threads with batches of up to batchSize records,
+		 * records of one part arrive in file order. Does not move the position used by readBatch().
+		 * For pcapng the parts first scan their block headers for section headers and interface descriptions, so
+		 * every part starts with the interfaces described before it.
+		 */
+		void readParallel(size_t threadCount,
+		                  const std::function<void(size_t part, const CaptureRecord* records, size_t count)>& callback,
+		                  size_t batchSize = 256) const;
+		/* Restarts readBatch() at the first record */
+		void rewind() noexcept;
+
+		NODISCARD CaptureFormat getFormat() const noexcept { return mFormat; }
+		NODISCARD size_t getFileSize() const noexcept { return mSize; }
+	private:
+		struct Interface
+		{
+			uint16_t linkType = 0;
+			//timestamp unit, either 10^-exponent or 2^-exponent seconds
+			uint8_t exponent = 6;
+			bool binary = false;
+		};
+
+		struct Cursor
+		{
+			size_t offset = 0;
+			size_t end = 0;
+			//byte order of the current pcapng section, pcap files have one for the whole file
+			bool swapped = false;
+			std::vector<Interface> interfaces;
+			size_t released = 0;
+		};
+	private:
+		size_t read(Cursor& cursor, CaptureRecord* records, size_t capacity) const noexcept;
+		bool readPcapRecord(Cursor& cursor, CaptureRecord& record, bool& done) const noexcept;
+		bool readPcapNgBlock(Cursor& cursor, CaptureRecord& record, bool& done) const noexcept;
+		bool readInterface(Cursor& cursor, size_t body, size_t bodyLength) const noexcept;
+		/* appends the offsets of the section header and interface description blocks from offset to end */
+		void findDescriptions(size_t offset, size_t end, bool swapped, std::vector<size_t>& descriptions) const;
+		size_t findRecordBoundary(size_t offset, const Cursor& initial) const noexcept;
+		bool isPcapRecord(size_t offset) const noexcept;
+		bool isPcapNgBlock(size_t offset, bool swapped) const noexcept;
+		void release(Cursor& cursor) const noexcept;
+		uint32_t read32(size_t offset, bool swapped) const noexcept;
+		uint16_t read16(size_t offset, bool swapped) const noexcept;
+	private:
+		const uint8_t* mData = nullptr;
+		size_t mSize = 0;
+		CaptureFormat mFormat = CaptureFormat::kPcap;
+		//classic pcap only
+		uint32_t mSnapLength = 0;
+		bool mNanoseconds = false;
+		//position after the file header (pcap) or after the interfaces of the first section (pcapng)
+		Cursor mFirst;
+		Cursor mCursor;
+	};
+}
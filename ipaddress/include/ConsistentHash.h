@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "IPEndPoint.h"
+#include "util/Span.h"
+
+namespace ip_address
+{
+	/*
+	 * Jump consistent hash (Lamping and Veach), maps a client onto one of buckets in O(log buckets) without any table.
+	 * Growing from n to n + 1 buckets only moves 1/(n + 1) of the clients, but only the last bucket can be removed,
+	 * so it suits numbered shards rather than a backend pool with arbitrary failures (use MaglevTable for that).
+	 */
+	NODISCARD uint32_t jumpConsistentHash(uint64_t key, uint32_t buckets) noexcept;
+	NODISCARD uint32_t jumpConsistentHash(const IPAddress& client, uint32_t buckets, uint64_t seed = 0) noexcept;
+
+	/*
+	 * Maglev lookup table (Eisenbud et al., NSDI 2016) mapping client addresses onto backend endpoints in O(1).
+	 *
+	 * Every backend has its own permutation of the table slots derived from its address and port, the table is
+	 * filled by letting the backends claim their preferred free slots in turn, so each backend owns
+	 * getTableSize() / getBackendCount() slots (+1) and a lookup is one hash and one table read.
+	 *
+	 * addBackend() and removeBackend() update the existing table instead of rebuilding it: a new backend takes the
+	 * slots it prefers most from backends above their share, the slots of a removed backend go to the remaining
+	 * backend that ranks them highest. Only the slots that have to move change owner, which keeps the disruption
+	 * at the theoretical minimum and every backend within one slot of the others.
+	 * setBackends() does a full Maglev population.
+	 *
+	 * The table size is rounded up to a prime and should be well above the number of backends, e.g 100x for
+	 * backends to differ by less than 1% in load. Not thread safe, share it read-only or behind an RCU pointer.
+	 */
+	class MaglevTable final
+	{
+	public:
+		static constexpr uint32_t kDefaultTableSize = 65537;
+
+		explicit MaglevTable(uint32_t tableSize = kDefaultTableSize, uint64_t seed = 0);
+		~MaglevTable() = default;
+		MaglevTable(const MaglevTable&) = default;
+		MaglevTable& operator=(const MaglevTable&) = default;
+	public:
+		/*
+		 * Replaces every backend and fills the table from scratch, duplicates are ignored.
+		 */
+		void setBackends(Span<const IPEndPoint> backends);
+		/*
+		 * @return false if the backend is already in the table.
+		 */
+		bool addBackend(const IPEndPoint& backend);
+		/*
+		 * @return false if the backend is not in the table.
+		 */
+		bool removeBackend(const IPEndPoint& backend);
+		/*
+		 * @return the backend for client or nullptr when there are no backends.
+		 * The pointer is valid until the next change of the backends.
+		 */
+		NODISCARD const IPEndPoint* lookup(const IPAddress& client) const noexcept;
+		/*
+		 * Looks up every client, backends must have room for clients.size() pointers.
+		 */
+		void lookup(Span<const IPAddress> clients, const IPEndPoint** backends) const noexcept;
+
+		NODISCARD size_t getBackendCount() const noexcept { return mBackends.size(); }
+		NODISCARD uint32_t getTableSize() const noexcept { return mTableSize; }
+		/*
+		 * @return number of table slots owned by backend, 0 if it is not in the table.
+		 */
+		NODISCARD uint32_t getSlotCount(const IPEndPoint& backend) const noexcept;
+	private:
+		struct Backend
+		{
+			IPEndPoint endpoint;
+			uint64_t hash;
+			//permutation slot(j) = (offset + j * skip) % tableSize, rank(slot) = (slot - offset) * skipInverse
+			uint32_t offset;
+			uint32_t skip;
+			uint32_t skipInverse;
+			uint32_t slots;
+		};
+	private:
+		Backend makeBackend(const IPEndPoint& endpoint) const noexcept;
+		NODISCARD uint32_t getSlot(const Backend& backend, uint64_t j) const noexcept;
+		NODISCARD uint32_t getRank(const Backend& backend, uint32_t slot) const noexcept;
+		NODISCARD uint32_t getSlotIndex(const IPAddress& client) const noexcept;
+		NODISCARD size_t find(const IPEndPoint& endpoint) const noexcept;
+		//slots every backend should own, each gets tableSize / count and the remainder is spread one by one
+		NODISCARD std::vector<uint32_t> getShares() const;
+		void populate();
+	private:
+		uint32_t mTableSize;
+		uint64_t mSeed;
+		std::vector<Backend> mBackends;
+		//backend index per slot
+		std::vector<uint32_t> mTable;
+	};
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "IPEndPoint.h"
+#include "util/RcuPointer.h"
+#include "util/Span.h"
+
+namespace ip_address
+{
+	/*
+	 * Pool of backend endpoints that hands out the least loaded one with power-of-two-choices selection.
+	 *
+	 * Every backend owns a 64 byte aligned cache line with its in-flight request count and an exponentially
+	 * weighted moving average of its latency. acquire() samples two random backends and takes the one with the
+	 * lower (inFlight + 1) * latency, which keeps the maximum load close to the average without any state shared
+	 * by all threads: a pick reads two backend lines and increments one, threads only meet on the same backend.
+	 *
+	 * The backend list is an immutable snapshot behind an RCU pointer, acquire() never takes a lock.
+	 * addBackend(), removeBackend() and setBackends() publish a new snapshot and keep the statistics of the
+	 * backends that stay. A removed backend is freed once the grace period has passed and its last lease is done,
+	 * so a Lease stays valid across removals. All methods are thread safe.
+	 */
+	class EndpointPool final
+	{
+	private:
+		struct alignas(64) Backend
+		{
+			explicit Backend(const IPEndPoint& endpoint_, uint64_t latency_) : endpoint(endpoint_), latency(latency_) { }
+
+			IPEndPoint endpoint;
+			std::atomic<uint32_t> inFlight{ 0 };
+			//nanoseconds
+			std::atomic<uint64_t> latency;
+		};
+		static_assert(sizeof(Backend) % 64 == 0, "backends must not share cache lines");
+
+		struct Snapshot
+		{
+			std::vector<Backend*> backends;
+		};
+	public:
+		/*
+		 * One in-flight request on a backend, finish it with complete() or release(), the destructor calls release().
+		 */
+		class Lease
+		{
+		public:
+			Lease() noexcept = default;
+			~Lease() { release(); }
+			Lease(Lease&& other) noexcept : mBackend(other.mBackend), mDecay(other.mDecay) { other.mBackend = nullptr; }
+			Lease& operator=(Lease&& other) noexcept;
+			Lease(const Lease&) = delete;
+			Lease& operator=(const Lease&) = delete;
+
+			/*
+			 * @return false if the pool was empty.
+			 */
+			explicit operator bool() const noexcept { return mBackend != nullptr; }
+			NODISCARD const IPEndPoint& getEndPoint() const noexcept { return mBackend->endpoint; }
+			/*
+			 * Ends the request and adds latency in nanoseconds to the moving average of the backend.
+			 */
+			void complete(uint64_t latency) noexcept;
+			/*
+			 * Ends the request without a latency sample, e.g when it failed before reaching the backend.
+			 */
+			void release() noexcept;
+		private:
+			friend class EndpointPool;
+			Lease(Backend* backend, uint8_t decay) noexcept : mBackend(backend), mDecay(decay) { }
+
+			Backend* mBackend = nullptr;
+			uint8_t mDecay = 0;
+		};
+	public:
+		/*
+		 * @param initialLatency latency in nanoseconds assumed for a backend before its first sample.
+		 * @param decayShift every sample moves the average by 1 / 2^decayShift of the difference.
+		 */
+		explicit EndpointPool(uint64_t initialLatency = 1000000, uint8_t decayShift = 3);
+		~EndpointPool();
+		EndpointPool(const EndpointPool&) = delete;
+		EndpointPool& operator=(const EndpointPool&) = delete;
+	public:
+		/*
+		 * Replaces the backends, backends that stay keep their statistics. Duplicates are ignored.
+		 */
+		void setBackends(Span<const IPEndPoint> backends);
+		/*
+		 * @return false if the backend is already in the pool.
+		 */
+		bool addBackend(const IPEndPoint& backend);
+		/*
+		 * @return false if the backend is not in the pool.
+		 */
+		bool removeBackend(const IPEndPoint& backend);
+		/*
+		 * Picks the less loaded of two random backends and counts a request on it.
+		 * @return an empty lease if the pool has no backends.
+		 */
+		NODISCARD Lease acquire() noexcept;
+
+		NODISCARD size_t getBackendCount() const noexcept;
+		NODISCARD bool contains(const IPEndPoint& backend) const noexcept;
+		/*
+		 * @return the in-flight requests of backend, 0 if it is not in the pool.
+		 */
+		NODISCARD uint32_t getInFlight(const IPEndPoint& backend) const noexcept;
+		/*
+		 * @return the average latency of backend in nanoseconds, 0 if it is not in the pool.
+		 */
+		NODISCARD uint64_t getLatency(const IPEndPoint& backend) const noexcept;
+	private:
+		NODISCARD static const Backend* find(const Snapshot& snapshot, const IPEndPoint& backend) noexcept;
+		//publishes the owned backends as a new snapshot and frees retired backends without leases, mMutex held
+		void publish();
+	private:
+		uint64_t mInitialLatency;
+		uint8_t mDecayShift;
+		details::RcuPointer<Snapshot> mSnapshot;
+		std::mutex mMutex;
+		std::vector<std::unique_ptr<Backend>> mBackends;
+		std::vector<std::unique_ptr<Backend>> mRetired;
+	};
+}
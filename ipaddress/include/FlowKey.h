@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include "IPEndPoint.h"
+
+namespace ip_address
+{
+	/*
+	 * Five-tuple identifying a transport flow: source and destination address and port plus the protocol number.
+	 * Addresses use the same 16 byte storage as IPAddress (an IPv4 address occupies the first 4 bytes, the rest is 0)
+	 * so building a key is a fixed size copy, ports are kept in host byte order like IPEndPoint.
+	 */
+	class FlowKey final
+	{
+		friend class PacketClassifier;
+	public:
+		/* Largest RSS hash input: two IPv6 addresses and two ports */
+		static constexpr size_t kMaxHashInputSize = 36;
+
+		FlowKey() = default;
+		~FlowKey() = default;
+		FlowKey(const FlowKey& key) noexcept = default;
+		FlowKey& operator=(const FlowKey& rhs) noexcept = default;
+		/*
+		 * source and destination must have the same IPVersion.
+		 */
+		FlowKey(const IPEndPoint& source, const IPEndPoint& destination, uint8_t protocol) noexcept;
+	public:
+		bool operator==(const FlowKey& rhs) const noexcept;
+		bool operator!=(const FlowKey& rhs) const noexcept;
+	public:
+		NODISCARD IPEndPoint getSource() const;
+		NODISCARD IPEndPoint getDestination() const;
+		NODISCARD uint8_t getProtocol() const noexcept { return mProtocol; }
+		NODISCARD IPVersion getVersion() const noexcept { return mVersion; }
+		/*
+		 * @return the key of the opposite direction, source and destination swapped.
+		 */
+		NODISCARD FlowKey reversed() const noexcept;
+		/*
+		 * Writes the RSS hash input in the order NICs use: source address, destination address and, when
+		 * includePorts is set, source port and destination port, everything in network byte order.
+		 * @param out buffer of at least kMaxHashInputSize bytes
+		 * @return number of bytes written, 8/12 for IPv4 and 32/36 for IPv6
+		 */
+		size_t getHashInput(uint8_t* out, bool includePorts) const noexcept;
+	private:
+		IPAddressV6 mSource;
+		IPAddressV6 mDestination;
+		port_host_byte_order_t mSourcePort = 0;
+		port_host_byte_order_t mDestinationPort = 0;
+		uint8_t mProtocol = 0;
+		IPVersion mVersion = IPVersion::kUnknown;
+	};
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <vector>
+#include "AddressSelection.h"
+#include "IPEndPoint.h"
+#include "util/Span.h"
+
+namespace ip_address
+{
+	/*
+	 * Result of HappyEyeballsConnector::connect().
+	 */
+	struct ConnectResult
+	{
+		/* connected non-blocking TCP socket owned by the caller, -1 if every attempt failed */
+		int fd = -1;
+		/* endpoint fd is connected to */
+		IPEndPoint endpoint;
+		/* errno of the last failed attempt, ETIMEDOUT when the overall timeout expired */
+		int error = 0;
+		/* number of connection attempts started */
+		size_t attempts = 0;
+	};
+
+	/*
+	 * TCP connection racing of Happy Eyeballs version 2 (RFC 8305) for Linux.
+	 *
+	 * The endpoints are sorted with RFC 6724 and interleaved by address family, then a non-blocking connect is
+	 * started for the first one and for each following one when attemptDelay passes without a connection or
+	 * as soon as an attempt fails. All attempts run concurrently in one epoll set, the first one that connects
+	 * wins and the others are closed. connect() blocks the calling thread until then, at most for timeout.
+	 */
+	class HappyEyeballsConnector final
+	{
+	public:
+		struct Options
+		{
+			/* RFC 8305 connection attempt delay, the recommended value is 250ms */
+			std::chrono::milliseconds attemptDelay{ 250 };
+			/* limit for the whole race */
+			std::chrono::milliseconds timeout{ 10000 };
+			/* keep the order of the endpoints instead of sorting with RFC 6724, they are still interleaved */
+			bool keepOrder = false;
+		};
+
+		HappyEyeballsConnector();
+		explicit HappyEyeballsConnector(Options options);
+		HappyEyeballsConnector(Options options, AddressSorter sorter);
+	public:
+		NODISCARD ConnectResult connect(const std::vector<IPEndPoint>& endpoints) const;
+		/*
+		 * Reorders sorted endpoints so the address families alternate, starting with the family of the first one
+		 * (RFC 8305 section 4 with a first address family count of 1).
+		 */
+		NODISCARD static std::vector<IPEndPoint> interleave(const std::vector<IPEndPoint>& sorted);
+	private:
+		NODISCARD ConnectResult race(Span<const IPEndPoint> endpoints) const;
+	private:
+		Options mOptions;
+		AddressSorter mSorter;
+	};
+}
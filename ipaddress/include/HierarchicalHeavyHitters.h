@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "IPNetwork.h"
+#include "util/AddressKey.h"
+#include "util/SpaceSaving.h"
+
+namespace ip_address
+{
+	/*
+	 * A prefix reported by HierarchicalHeavyHitters::query().
+	 */
+	struct HeavyHitter
+	{
+		IPNetwork network;
+		/* estimated packets inside network, lowerBound <= real count <= upperBound with high probability */
+		uint64_t lowerBound = 0;
+		uint64_t upperBound = 0;
+		/* estimated packets inside network that are not inside a more specific reported prefix */
+		uint64_t conditionedCount = 0;
+	};
+
+	/*
+	 * Hierarchical heavy hitters over the prefix lattice of an address family, implemented as
+	 * Randomized HHH (Ben Basat et al., "Constant Time Updates in Hierarchical Heavy Hitters", SIGCOMM 2017).
+	 *
+	 * Every prefix length between minPrefixLength and the full address length (in steps of granularity bits)
+	 * is a level with its own Space-Saving summary. update() picks one level at random and increments the
+	 * prefix of the address at that level, so an update is O(1) no matter how many levels there are.
+	 * query() walks the levels from the most specific prefix to the least specific one and reports every
+	 * prefix whose traffic, after discounting the already reported prefixes below it, is at least phi * N.
+	 *
+	 * Counts are scaled by the number of levels so the estimates converge once N is well above
+	 * levels * countersPerLevel packets. Not thread safe, use one instance per thread and query them separately.
+	 */
+	template <typename Address>
+	class HierarchicalHeavyHitters final
+	{
+		using Traits = details::AddressKey<Address>;
+		using Key = typename Traits::Key;
+	public:
+		/*
+		 * @param countersPerLevel Space-Saving counters per level, use at least 1 / phi for the smallest phi that is queried.
+		 * @param minPrefixLength shortest prefix that is tracked, defaults to /8 for IPv4 and /16 for IPv6.
+		 * @param granularity bits between two levels, 1 tracks every prefix length and 8 tracks byte boundaries only.
+		 * @param confidenceZ adds 2 * confidenceZ * sqrt(N * levels) to every conditioned count, 0 reports point estimates
+		 *        while e.g 2.0 makes missed heavy hitters unlikely at the cost of extra reported prefixes.
+		 */
+		explicit HierarchicalHeavyHitters(size_t countersPerLevel,
+		                                  uint8_t minPrefixLength = Traits::kDefaultMinPrefixLength,
+		                                  uint8_t granularity = 1,
+		                                  double confidenceZ = 0.0,
+		                                  uint64_t seed = 0x9E3779B97F4A7C15ULL);
+	public:
+		/*
+		 * Counts one packet for addr.
+		 */
+		void update(const Address& addr) noexcept;
+		/*
+		 * @param phi fraction of the traffic between 0 and 1 that a prefix must carry to be reported.
+		 * @return the hierarchical heavy hitters, most specific prefixes first.
+		 */
+		NODISCARD std::vector<HeavyHitter> query(double phi) const;
+		/*
+		 * @return number of packets passed to update() since construction or clear().
+		 */
+		NODISCARD uint64_t getPacketCount() const noexcept;
+		/*
+		 * @return the tracked prefix lengths, most specific first.
+		 */
+		NODISCARD const std::vector<uint8_t>& getPrefixLengths() const noexcept;
+
+		void clear() noexcept;
+	private:
+		uint32_t nextLevel() noexcept;
+
+		std::vector<uint8_t> mPrefixLengths;
+		std::vector<details::SpaceSaving<Key, Traits>> mLevels;
+		double mConfidenceZ;
+		uint64_t mPacketCount = 0;
+		uint64_t mRandomState;
+	};
+
+	using HierarchicalHeavyHittersV4 = HierarchicalHeavyHitters<IPAddressV4>;
+	using HierarchicalHeavyHittersV6 = HierarchicalHeavyHitters<IPAddressV6>;
+
+	extern template class HierarchicalHeavyHitters<IPAddressV4>;
+	extern template class HierarchicalHeavyHitters<IPAddressV6>;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "IPAddress.h"
+#include "util/Span.h"
+
+namespace ip_address
+{
+	namespace details
+	{
+		/*
+		 * Slot of the perfect hash in a HostTable file.
+		 */
+		struct HostTableSlot
+		{
+			//low bits of the name hash, rejects most misses before the name compare
+			uint32_t tag;
+			uint32_t nameOffset;
+			uint32_t firstAddress;
+			uint16_t nameLength;
+			uint16_t addressCount;
+		};
+		static_assert(sizeof(HostTableSlot) == 16, "slot layout is part of the file format");
+	}
+
+	/*
+	 * Read-only host name to IPAddress table loaded from a binary file written by HostTableBuilder.
+	 *
+	 * The file holds a minimal perfect hash (hash and displace): a name selects a bucket, the seed stored for the
+	 * bucket selects the slot, and there are exactly as many slots as names. A lookup hashes the name once,
+	 * reads one seed and one slot and compares the name, so it costs two cache misses and never allocates.
+	 * Names are matched case-insensitively.
+	 *
+	 * The file is mapped with mmap and used in place, only the address section is copied into an array of
+	 * IPAddress at load time so lookups can return spans of it (the layout of IPAddress is up to the compiler, the
+	 * file stores a fixed version and bytes record instead).
+	 */
+	class HostTable final
+	{
+	public:
+		/*
+		 * Maps the table file.
+		 * throws std::runtime_error if the file can not be mapped or is not a valid table.
+		 */
+		explicit HostTable(const std::string& path);
+		~HostTable();
+		HostTable(const HostTable&) = delete;
+		HostTable& operator=(const HostTable&) = delete;
+	public:
+		/*
+		 * @return the addresses of name in the order of the hosts file, empty if the name is unknown.
+		 * The span is valid as long as the table.
+		 */
+		NODISCARD Span<const IPAddress> lookup(std::string_view name) const noexcept;
+
+		NODISCARD size_t getNameCount() const noexcept { return mNameCount; }
+		NODISCARD size_t getAddressCount() const noexcept { return mAddresses.size(); }
+	private:
+		const uint8_t* mData = nullptr;
+		size_t mSize = 0;
+		uint32_t mNameCount = 0;
+		uint32_t mBucketCount = 0;
+		const uint32_t* mSeeds = nullptr;
+		const details::HostTableSlot* mSlots = nullptr;
+		const char* mNames = nullptr;
+		std::vector<IPAddress> mAddresses;
+	};
+
+	/*
+	 * Collects host names and their addresses and writes them as a HostTable file.
+	 */
+	class HostTableBuilder final
+	{
+	public:
+		/*
+		 * Adds addr to name, addresses of a name keep the order they were added in and duplicates are ignored.
+		 * @return false if name is not a valid host name.
+		 */
+		bool add(const std::string& name, const IPAddress& addr);
+		/*
+		 * Adds every "address name [alias...]" line of a hosts file, '#' starts a comment.
+		 * @return number of lines skipped because the address or a name is invalid.
+		 */
+		size_t addHosts(std::istream& hosts);
+		/*
+		 * @return the table file contents.
+		 */
+		NODISCARD std::vector<uint8_t> build() const;
+		/*
+		 * Writes the table file.
+		 * throws std::runtime_error if the file can not be written.
+		 */
+		void write(const std::string& path) const;
+
+		NODISCARD size_t getNameCount() const noexcept { return mNames.size(); }
+	private:
+		//lower case name to addresses
+		std::map<std::string, std::vector<IPAddress>> mNames;
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "IPAddressV4.h"
 #include "IPAddressV6.h"
+#include <cassert>
 
 namespace ip_address
 {
@@ -17,34 +18,47 @@ namespace ip_address
 	};
 
 	class IPEndPoint;
+	class SockaddrView;
+	class PacketHeader;
+	class FlowKey;
 	/**
 	*	IPAddress class containing either ipv4 or ipv6 address.
+	*
+	*	The string constructors and parsers of IPAddress, IPAddressV4, IPAddressV6 and IPEndPoint resolve a string
+	*	that is not a literal as a host name with a blocking getaddrinfo. Use Resolver where blocking is not
+	*	acceptable.
 	*/
 	class IPAddress
 	{
 		friend class IPEndPoint;
 		friend class IPAddressV6;
 		friend class IPAddressV4;
+		friend class SockaddrView;
+		friend class PacketHeader;
+		friend class FlowKey;
 	public:
 		IPAddress() = default;
-		virtual ~IPAddress() = default;
-		IPAddress(const IPAddress& addr) noexcept { *this = addr; }
-		IPAddress(IPAddress&& addr) noexcept { *this = addr; }
+		~IPAddress() = default;
+		IPAddress(const IPAddress& addr) noexcept = default;
+		IPAddress(IPAddress&& addr) noexcept = default;
 
-		explicit IPAddress(const IPAddressV4& addr4) noexcept;
-		explicit IPAddress(const IPAddressV6& addr6) noexcept;
+		constexpr explicit IPAddress(const IPAddressV4& addr4) noexcept : IPAddress(addr4.bytes()) { }
+		constexpr explicit IPAddress(const IPAddressV6& addr6) noexcept : mAddr{ addr6 }, mVersion(IPVersion::kIPv6) { }
 
-		explicit IPAddress(IPAddressV4&& addr4) noexcept;
-		explicit IPAddress(IPAddressV6&& addr6) noexcept;
+		constexpr explicit IPAddress(IPAddressV4&& addr4) noexcept : IPAddress(addr4.bytes()) { }
+		constexpr explicit IPAddress(IPAddressV6&& addr6) noexcept : mAddr{ addr6 }, mVersion(IPVersion::kIPv6) { }
 
+		//a literal of either family, else a host name tried for IPv4 then IPv6 (blocking, see above)
 		explicit IPAddress(const char* ip);
 		explicit IPAddress(const std::string& ip);
 
-		explicit IPAddress(const ByteArray4&& addr4) noexcept;
-		explicit IPAddress(const ByteArray4& addr4) noexcept;
+		constexpr explicit IPAddress(const ByteArray4&& addr4) noexcept : IPAddress(addr4) { }
+		constexpr explicit IPAddress(const ByteArray4& addr4) noexcept :
+			mAddr{ IPAddressV6(ByteArray16{ addr4[0], addr4[1], addr4[2], addr4[3] }) }, mVersion(IPVersion::kIPv4) { }
 
-		explicit IPAddress(const ByteArray16&& addr6) noexcept;
-		explicit IPAddress(const ByteArray16& addr6) noexcept;
+		constexpr explicit IPAddress(const ByteArray16&& addr6) noexcept : IPAddress(addr6) { }
+		constexpr explicit IPAddress(const ByteArray16& addr6) noexcept : mAddr{ IPAddressV6(addr6) },
+			mVersion(IPVersion::kIPv6) { }
 
 		explicit IPAddress(const sockaddr_in& addr4);
 		explicit IPAddress(const sockaddr_in6& addr6);
@@ -56,23 +70,36 @@ namespace ip_address
 	public:
 		//Comparison operators
 		bool operator==(const IPEndPoint& rhs) const noexcept;
-		bool operator==(const IPAddress& ipAddr) const noexcept;
-		bool operator==(const IPAddressV4& ipAddr4) const noexcept;
-		bool operator==(const IPAddressV6& ipAddr6) const noexcept;
+		constexpr bool operator==(const IPAddress& ipAddr) const noexcept
+		{
+			if (this->isIPv4() && ipAddr.isIPv4())
+				return details::equal(this->getBytes(), ipAddr.getBytes(), 4);
+			if (this->isIPv6() && ipAddr.isIPv6())
+				return details::equal(this->getBytes(), ipAddr.getBytes());
+			return false; //IPAddress did not match getVersion
+		}
+		constexpr bool operator==(const IPAddressV4& ipAddr4) const noexcept
+		{
+			return this->isIPv4() && this->getIPv4() == ipAddr4;
+		}
+		constexpr bool operator==(const IPAddressV6& ipAddr6) const noexcept
+		{
+			return this->isIPv6() && details::equal(this->getBytes(), ipAddr6.bytes());
+		}
 		//Comparison operators
 		bool operator!=(const IPEndPoint& rhs) const noexcept;
-		bool operator!=(const IPAddress& ipAddr) const noexcept;
-		bool operator!=(const IPAddressV4& ipAddr4) const noexcept;
-		bool operator!=(const IPAddressV6& ipAddr6) const noexcept;
+		constexpr bool operator!=(const IPAddress& ipAddr) const noexcept { return !this->operator==(ipAddr); }
+		constexpr bool operator!=(const IPAddressV4& ipAddr4) const noexcept { return !this->operator==(ipAddr4); }
+		constexpr bool operator!=(const IPAddressV6& ipAddr6) const noexcept { return !this->operator==(ipAddr6); }
 		//Assignment operators
 		IPAddress& operator=(IPEndPoint& rhs) noexcept;
-		IPAddress& operator=(const IPAddress& ipAddr) noexcept;
-		IPAddress& operator=(const IPAddressV4& ipAddr4) noexcept;
-		IPAddress& operator=(const IPAddressV6& ipAddr6) noexcept;
+		IPAddress& operator=(const IPAddress& ipAddr) noexcept = default;
+		constexpr IPAddress& operator=(const IPAddressV4& ipAddr4) noexcept { return *this = IPAddress(ipAddr4); }
+		constexpr IPAddress& operator=(const IPAddressV6& ipAddr6) noexcept { return *this = IPAddress(ipAddr6); }
 		//Move operators
-		IPAddress& operator=(IPAddress&& ipAddr) noexcept;
-		IPAddress& operator=(IPAddressV4&& ipAddr4) noexcept;
-		IPAddress& operator=(IPAddressV6&& ipAddr6) noexcept;
+		IPAddress& operator=(IPAddress&& ipAddr) noexcept = default;
+		constexpr IPAddress& operator=(IPAddressV4&& ipAddr4) noexcept { return *this = IPAddress(ipAddr4); }
+		constexpr IPAddress& operator=(IPAddressV6&& ipAddr6) noexcept { return *this = IPAddress(ipAddr6); }
 
 	public:
 		/*
@@ -90,7 +117,7 @@ namespace ip_address
 		/*
 		* Return the fanmily of the address. The return value will be return Unknown if the IPVersion was not IPv4 or IPv6. IPv4OrIPv6, kIPv4AndIPv6 and are never returned by this method.
 		*/
-		NODISCARD IPVersion getVersion() const noexcept;
+		NODISCARD constexpr IPVersion getVersion() const noexcept { return mVersion; }
 		/*
 		* 
 		*/
@@ -98,43 +125,93 @@ namespace ip_address
 		/*
 		* @return true if IPVersion is kIPv6.
 		*/
-		NODISCARD bool isIPv6() const noexcept;
+		NODISCARD constexpr bool isIPv6() const noexcept { return mVersion == IPVersion::kIPv6; }
 		/*
 		* @return true if IPVersion is kIPv4. 
 		*/
-		NODISCARD bool isIPv4() const noexcept; 
+		NODISCARD constexpr bool isIPv4() const noexcept { return mVersion == IPVersion::kIPv4; }
 		/*
-		* 
+		* @return the address as IPAddressV6, the address must be IPv6.
 		*/
-		IPAddressV6& asIPv6() const;
-
-		IPAddressV4& asIPv4() const;
+		IPAddressV6& asIPv6();
+		const IPAddressV6& asIPv6() const;
+		/*
+		* @return the address as IPAddressV4, the address must be IPv4.
+		*/
+		IPAddressV4& asIPv4();
+		const IPAddressV4& asIPv4() const;
+		/*
+		* @return the address like asIPv4()/asIPv6(), these also work in constant expressions.
+		*/
+		NODISCARD constexpr IPAddressV4 getIPv4() const noexcept
+		{
+			return IPAddressV4(ByteArray4{ getBytes()[0], getBytes()[1], getBytes()[2], getBytes()[3] });
+		}
+		NODISCARD constexpr const IPAddressV6& getIPv6() const noexcept { return mAddr.mIpAddress6; }
 
 		std::string getString() const;
+		/*
+		* @return a copy of the address with every bit after prefixLength set to 0, the version is kept.
+		*/
+		NODISCARD constexpr IPAddress truncate(uint8_t prefixLength) const noexcept
+		{
+			assert(this->mVersion == IPVersion::kIPv4 || this->mVersion == IPVersion::kIPv6);
+			if (this->isIPv4())
+				return IPAddress(this->getIPv4().truncate(prefixLength));
+			return IPAddress(this->getIPv6().truncate(prefixLength));
+		}
 	public:
 		/*
 		* Only IPv4 addresses can be broadcast. Broadcast is an address with all bytes as 0.
 		*/
-		NODISCARD bool isBroadcast() const noexcept;
+		NODISCARD constexpr bool isBroadcast() const noexcept { return this->isIPv4() && this->getIPv4().isBroadcast(); }
 		/*
 		 * Wildcard is an address with all bytes as 0.
 		 */
-		NODISCARD bool isWildcard() const noexcept;
+		NODISCARD constexpr bool isWildcard() const noexcept
+		{
+			return (this->isIPv4() && this->getIPv4().isWildcard()) || (this->isIPv6() && this->getIPv6().isWildcard());
+		}
 		/*
-		* 
+		* 0.0.0.0 or ::, the same as isWildcard().
 		*/
-		NODISCARD bool isAny() const noexcept;
+		NODISCARD constexpr bool isAny() const noexcept { return this->isWildcard(); }
 		/*
 		* An unicast address is neither a wildcard, broadcast or multicast address.
 		*/
-		NODISCARD bool isUnicast() const noexcept;
+		NODISCARD constexpr bool isUnicast() const noexcept
+		{
+			return (this->isIPv4() || this->isIPv6()) && !this->isWildcard() && !this->isBroadcast() && !this->isMulticast();
+		}
+
+		NODISCARD constexpr bool isLoopback() const noexcept
+		{
+			return (this->isIPv4() && this->getIPv4().isLoopback()) || (this->isIPv6() && this->getIPv6().isLoopback());
+		}
+
+		NODISCARD constexpr bool isMulticast() const noexcept
+		{
+			return (this->isIPv4() && this->getIPv4().isMulticast()) || (this->isIPv6() && this->getIPv6().isMulticast());
+		}
+
+		NODISCARD constexpr bool isLinkLocal() const noexcept
+		{
+			return (this->isIPv4() && this->getIPv4().isLinkLocal()) || (this->isIPv6() && this->getIPv6().isLinkLocal());
+		}
 	public:
 		friend std::ostream& operator<<(std::ostream& rhs, const IPAddress& lhs);
 	protected:
+		/*
+		 * The constexpr constructors keep both families in mIpAddress6, an IPv4 address in its first 4 bytes, so
+		 * the constexpr members only read mIpAddress6. Runtime code may also write mIpAddress4, both start at the
+		 * first byte of the storage.
+		 */
+		constexpr const ByteArray16& getBytes() const noexcept { return mAddr.mIpAddress6.mAddr6.mBytes; }
+
 		union IPAddressStorage
 		{
-			mutable IPAddressV6 mIpAddress6;
-			mutable IPAddressV4 mIpAddress4;
+			IPAddressV6 mIpAddress6;
+			IPAddressV4 mIpAddress4;
 		} mAddr = {};
 
 		IPVersion mVersion = IPVersion::kUnknown;
@@ -30,6 +30,7 @@ namespace ip_address
 		case IPAddressV4Class::B: return "B";
 		case IPAddressV4Class::C: return "C";
 		case IPAddressV4Class::D: return "D";
+		case IPAddressV4Class::E: return "E";
 		default: return "Unknown";
 		}
 	};
@@ -50,35 +51,46 @@ namespace ip_address
 		IPAddressV4(const IPAddressV4& addr4) noexcept = default;
 		IPAddressV4(IPAddressV4&& addr4) noexcept = default;
 
+		//a dotted quad, else the first IPv4 address of a host name (blocking, see IPAddress)
 		explicit IPAddressV4(const char* ip);
 		explicit IPAddressV4(const std::string& ip);
-		explicit IPAddressV4(const ByteArray4& ip) noexcept { this->mAddr4.mBytes = ip; };
-		explicit IPAddressV4(const ByteArray4&& ip) noexcept { this->mAddr4.mBytes = ip; };
+		constexpr explicit IPAddressV4(const ByteArray4& ip) noexcept : mAddr4{ ip } { }
+		constexpr explicit IPAddressV4(const ByteArray4&& ip) noexcept : mAddr4{ ip } { }
 		explicit IPAddressV4(const sockaddr_in& addr);
 		explicit IPAddressV4(const in_addr& addr);
 		/* 127.0.0.1 */
-		static const IPAddressV4 loopback() { return IPAddressV4(ByteArray4({ 127, 0, 0, 1 })); }
+		static constexpr IPAddressV4 loopback() noexcept { return IPAddressV4(ByteArray4({ 127, 0, 0, 1 })); }
 		/*
 		* Any is 0.0.0.0 and is a non-routable meta-address used to designate an invalid, unknown or non-applicable target.
 		* It can also be used to specifie "any IPv4 address at all" when binded to a listening socket.
 		*/
-		static IPAddressV4 any() { return IPAddressV4(ByteArray4{ 0, 0, 0, 0 }); }
+		static constexpr IPAddressV4 any() noexcept { return IPAddressV4(ByteArray4{ 0, 0, 0, 0 }); }
 
-		static IPAddressV4 none() { return IPAddressV4(ByteArray4{ 255, 255, 255, 255 }); }
+		static constexpr IPAddressV4 none() noexcept { return IPAddressV4(ByteArray4{ 255, 255, 255, 255 }); }
 	public:
-		bool operator==(const IPAddressV4& addr4) const noexcept;
+		constexpr bool operator==(const IPAddressV4& addr4) const noexcept
+		{
+			return details::equal(this->mAddr4.mBytes, addr4.mAddr4.mBytes);
+		}
 		bool operator==(const IPAddress& addr) const noexcept;
 
-		bool operator!=(const IPAddressV4& addr4) const noexcept;
+		constexpr bool operator!=(const IPAddressV4& addr4) const noexcept { return !this->operator==(addr4); }
 		bool operator!=(const IPAddress& addr) const noexcept;
 
-		IPAddressV4& operator=(const IPAddressV4& addr4) noexcept;
+		IPAddressV4& operator=(const IPAddressV4& addr4) noexcept = default;
 		IPAddressV4& operator=(const IPAddress& addr) noexcept;
 
-		IPAddressV4& operator=(IPAddressV4&& addr4) noexcept;
+		IPAddressV4& operator=(IPAddressV4&& addr4) noexcept = default;
 	protected:
+		/*
+		 * Resolves a host name with getaddrinfo. Does not count a failure, the public parser that calls it does.
+		 */
+		static bool resolveIPAddressV4(IPAddressV4& addr4, const std::string& ip) noexcept;
 		/* used when sorting IPv4 addresses */
-		bool operator<(const IPAddressV4& rhs) const noexcept;
+		constexpr bool operator<(const IPAddressV4& rhs) const noexcept
+		{
+			return details::less(this->mAddr4.mBytes, rhs.mAddr4.mBytes);
+		}
 	public:
 		/*
 		 * parse an IPv4 address string into an IPAddressV4 object.
@@ -95,7 +107,7 @@ namespace ip_address
 		* @param addr4 [in] IPv4 address to be converted to IPv6
 		* @param addr6 [out] IPv6 mapped address
 		*/
-		NODISCARD static bool mapIPv4ToIPv6(IPAddressV4& addr4, IPAddressV6& addr6) noexcept;
+		NODISCARD static bool mapIPv4ToIPv6(const IPAddressV4& addr4, IPAddressV6& addr6) noexcept;
 
 		/*
 		* Converts an ipv4 address to ipv6.
@@ -112,7 +124,8 @@ namespace ip_address
 		/*
 		* @return ipv4 as a byte array.
 		*/
-		ByteArray4& bytes();
+		constexpr ByteArray4& bytes() noexcept { return this->mAddr4.mBytes; }
+		constexpr const ByteArray4& bytes() const noexcept { return this->mAddr4.mBytes; }
 		/*
 		* Specific sockaddr for IPv4
 		*/
@@ -121,6 +134,12 @@ namespace ip_address
 		* @return a string that contains each byte in an IP-address separated by a '.' e.g 192.168.1.66
 		*/
 		NODISCARD std::string getString() const;
+		/*
+		* Writes the text form of getString() without a terminator, the same text as inet_ntop.
+		* @param out [out] room for MAX_IPV4_ADDRESS_CHAR_MAX_COUNT characters.
+		* @return end of the written text.
+		*/
+		static char* writeString(const ByteArray4& bytes, char* out) noexcept;
 		/**
 		* @return size of IPAddressV4 in bytes
 		*/
@@ -130,62 +149,66 @@ namespace ip_address
 		* For IPv4, loopback is 127.0.0.1.
 		* For IPv6, loopback is ::1.
 		*/
-		NODISCARD bool isLoopback() const noexcept;
+		NODISCARD constexpr bool isLoopback() const noexcept;
 		/*
 		* Addresses between 224.0.0.0 and 239.255.255.255 are multicast
 		*/
-		NODISCARD bool isMulticast() const noexcept;
+		NODISCARD constexpr bool isMulticast() const noexcept;
 		/*
 		* An IPv4 unicast address is neither a broadcast or multicast address.
 		*/
-		NODISCARD bool isUnicast() const noexcept;
+		NODISCARD constexpr bool isUnicast() const noexcept;
 		/*
 		* Only IPv4 addresses can be broadcast. Broadcast is an address with all bytes as 0.
 		*/
-		NODISCARD bool isBroadcast() const noexcept;
+		NODISCARD constexpr bool isBroadcast() const noexcept;
 		/*
 		 * Wildcard is an address with all bytes as 0.
 		 */
-		NODISCARD bool isWildcard() const noexcept;
+		NODISCARD constexpr bool isWildcard() const noexcept;
 		/*
 		* IPv4 allows for a variation of the network and host segments of an IP address, known as subnetting, can be used to physically and logically design a network.
 		* Subnetwork addresses enhance local routing capabilities, while reducing the number of network addresses required.
 		*/
-		NODISCARD bool inSubnet() const noexcept;
+		NODISCARD constexpr bool inSubnet() const noexcept;
 		/*
 		* Link local is used when the host cannot find a DHCP server or are running into communication problems between the DHCP
 		* DHCP means the host can not access the internet but can still communicate with LAN devices.
 		* Link local packets are not "Not Forwarded" meaning
 		*/
-		NODISCARD bool isLinkLocal() const noexcept;
+		NODISCARD constexpr bool isLinkLocal() const noexcept;
 		/*
 		* Private IP addresses can not connect directly to the internet.
 		* Access to the internet must be brokered by a router or other such devices that supports NAT
 		*/
-		NODISCARD bool isPrivate() const noexcept;
+		NODISCARD constexpr bool isPrivate() const noexcept;
 		/*
 		*
 		*/
 		NODISCARD bool inSubnetWithMask(const IPAddressV4& addr, ByteArray4 maskAddr);
 		/*
-		*
+		* @return a copy of the address with every bit that is 0 in mask set to 0 e.g 10.1.2.3 masked with 255.0.0.0 is 10.0.0.0
 		*/
-		NODISCARD bool mask(const IPAddressV4& mask);
+		NODISCARD constexpr IPAddressV4 mask(const IPAddressV4& mask) const noexcept;
 		/*
 		*
 		*/
 		NODISCARD bool isMasked() const;
 		/*
+		* @return a copy of the address with every bit after prefixLength set to 0 e.g 10.1.2.3 truncated to 8 is 10.0.0.0
+		*/
+		NODISCARD constexpr IPAddressV4 truncate(uint8_t prefixLength) const noexcept;
+		/*
 		* Any is 0.0.0.0 and is a non-routable meta-address used to designate an invalid, unknown or non-applicable target.
 		* It can also be used to specifie "any IPv4 address at all" when binded to a listening socket.
 		*/
-		NODISCARD bool isAny() const;
+		NODISCARD constexpr bool isAny() const noexcept;
 		/*
 		 * Rotatable addresses are all addresses that are neither private addresses, loopback, multicast or experimental blocks.
 		 */
-		NODISCARD bool isRoutableAddress() const;
+		NODISCARD constexpr bool isRoutableAddress() const noexcept;
 		/* Return the IPv4 address class type IPAddressV4Class A, B, C, D or E */
-		NODISCARD IPAddressV4Class getIPAddressClass() const;
+		NODISCARD constexpr IPAddressV4Class getIPAddressClass() const noexcept;
 		/* Clears IPAddress to 0 */
 		void clear() noexcept;
 	public:
@@ -207,14 +230,13 @@ namespace ip_address
 	namespace details
 	{
 		template <typename T, size_t Size>
-		std::array<T, Size> mask(const std::array<T, Size>& x, const std::array<T, Size>& y)
+		constexpr std::array<T, Size> mask(const std::array<T, Size>& x, const std::array<T, Size>& y) noexcept
 		{
 			static_assert(Size > 0, "Can not mask empty array");
 			std::array<T, Size> res = { {0} };
-			const size_t size = x.size();
-			for (size_t i = 0; i < size; i++)
+			for (size_t i = 0; i < Size; i++)
 			{
-				res[i] = x[i] & y[i];
+				res[i] = static_cast<T>(x[i] & y[i]);
 			}
 			return res;
 		}
@@ -249,4 +271,116 @@ namespace ip_address
 			return res;
 		}
 	}
+
+	//"The loopback address is guaranteed to be 127.x.x.x(any will work, 0.0.1 is standard) on any IPv4 machine and ::1 on any IPv6 machine."
+	constexpr bool IPAddressV4::isLoopback() const noexcept
+	{
+		//127.0.0.0 to 127.255.255.255 reserved for loopback addresses according to https://en.wikipedia.org/wiki/Reserved_IP_addresses
+		//It is therefore only neccesery to check if it starts with 127.x.x.x.
+		return mAddr4.mBytes[0] == 127;
+	}
+
+	constexpr bool IPAddressV4::isMulticast() const noexcept
+	{
+		//"Addresses between 224.0.0.0 and 239.255.255.255 are multicast", the first 4 bits are 1110
+		return (this->mAddr4.mBytes[0] & 0xF0) == 0xE0;
+	}
+
+	constexpr bool IPAddressV4::isUnicast() const noexcept
+	{
+		//https://serverfault.com/questions/577045/how-to-determine-ip-address-is-unicast-or-anycast
+		//"Addresses between 0.0.0.0 and 223.255.255.255 are unicast"
+		return !this->isBroadcast() && !this->isMulticast();
+	}
+
+	constexpr bool IPAddressV4::isBroadcast() const noexcept
+	{
+		return *this == any();
+	}
+
+	constexpr bool IPAddressV4::isWildcard() const noexcept
+	{
+		//is the same for ipv4.... 
+		return this->isBroadcast();
+	}
+
+	//https://support.microsoft.com/en-us/help/164015/understanding-tcp-ip-addressing-and-subnetting-basics
+	constexpr bool IPAddressV4::inSubnet() const noexcept
+	{
+		//169.254.0.0-169.254.255.255 reserved for Subnet according to https://en.wikipedia.org/wiki/Reserved_IP_addresses
+		return mAddr4.mBytes[0] == 169 && mAddr4.mBytes[1] == 254;
+	}
+
+	constexpr bool IPAddressV4::isLinkLocal() const noexcept
+	{
+		/*
+		 * 169.254.0.0 - 169.254.255.255 or 169.254.0.0/16
+		 * https://datatracker.ietf.org/doc/html/rfc3927
+		 */
+		return mAddr4.mBytes[0] == 169 && mAddr4.mBytes[1] == 254;
+	}
+
+	constexpr bool IPAddressV4::isPrivate() const noexcept
+	{
+		/*
+		* Private Addresses
+		* Class A: 10.0.0.0 - 10.255.255.255
+		* Class B: 172.16.0.0 - 172.31.255.255
+		* Class C: 192.168.0.0 - 192.168.255.255
+		*/
+		return (mAddr4.mBytes[0] == 10) ||
+			(mAddr4.mBytes[0] == 172 && mAddr4.mBytes[1] >= 16 && mAddr4.mBytes[1] <= 31) ||
+			(mAddr4.mBytes[0] == 192 && mAddr4.mBytes[1] == 168);
+	}
+
+	constexpr IPAddressV4 IPAddressV4::mask(const IPAddressV4& mask) const noexcept
+	{
+		return IPAddressV4(details::mask(this->mAddr4.mBytes, mask.mAddr4.mBytes));
+	}
+
+	constexpr IPAddressV4 IPAddressV4::truncate(uint8_t prefixLength) const noexcept
+	{
+		assert(prefixLength <= 32);
+		ByteArray4 mask = { 0 };
+		for (size_t i = 0; i < mask.size(); i++)
+		{
+			const int bits = static_cast<int>(prefixLength) - static_cast<int>(i * 8);
+			mask[i] = bits >= 8 ? 0xFF : bits <= 0 ? 0 : static_cast<uint8_t>(0xFF << (8 - bits));
+		}
+		return this->mask(IPAddressV4(mask));
+	}
+
+	constexpr bool IPAddressV4::isAny() const noexcept
+	{
+		return *this == any();
+	}
+
+	constexpr bool IPAddressV4::isRoutableAddress() const noexcept
+	{
+		return !isPrivate() && !isLoopback() && !isMulticast();
+	}
+
+	constexpr IPAddressV4Class IPAddressV4::getIPAddressClass() const noexcept
+	{
+		/*
+		*  https://www.youtube.com/watch?v=vcArZIAmnYQ&list=PLSNNzog5eydt_plAtt3k_LYuIXrAS4aDZ&ab_channel=SunnyClassroom
+		* X is any combination!
+		*	Class A   0 - 127  0XXXXXXX
+		*	Class B 128 - 191  10XXXXXX
+		*	Class C 192 - 223  110XXXXX
+		*	Class D 224 - 239  1110XXXX
+		*	Class E 240 - 255  1111XXXX
+		* Note* that even 127 is class A, even though it's loopback.
+		*/
+		const uint8_t first = this->mAddr4.mBytes[0];
+		if (!CHECK_BIT(first, 7))
+			return IPAddressV4Class::A;
+		if (!CHECK_BIT(first, 6))
+			return IPAddressV4Class::B;
+		if (!CHECK_BIT(first, 5))
+			return IPAddressV4Class::C;
+		if (!CHECK_BIT(first, 4))
+			return IPAddressV4Class::D;
+		return IPAddressV4Class::E;
+	}
 }
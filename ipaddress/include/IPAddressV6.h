@@ -1,5 +1,6 @@
 #pragma once
 #include <array>
+#include <cassert>
 #include <ostream>
 #include <string>
 #include "IPVersion.h"
@@ -37,6 +38,32 @@ namespace ip_address
 	using WordArray8 = std::array<uint16_t, 8>;
 	class IPAddress;
 	class IPAddressV4;
+
+	namespace details
+	{
+		/* std::array comparisons are not constexpr before C++20 */
+		template <typename T, size_t Size>
+		constexpr bool equal(const std::array<T, Size>& x, const std::array<T, Size>& y, size_t count = Size) noexcept
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				if (x[i] != y[i])
+					return false;
+			}
+			return true;
+		}
+
+		template <typename T, size_t Size>
+		constexpr bool less(const std::array<T, Size>& x, const std::array<T, Size>& y) noexcept
+		{
+			for (size_t i = 0; i < Size; i++)
+			{
+				if (x[i] != y[i])
+					return x[i] < y[i];
+			}
+			return false;
+		}
+	}
 	//https://www.cisco.com/c/en/us/support/docs/ip/routing-information-protocol-rip/13788-3.html
 
 	/*
@@ -52,38 +79,49 @@ namespace ip_address
 		~IPAddressV6() = default;
 		IPAddressV6(const IPAddressV6& addr6) noexcept = default;
 		IPAddressV6(IPAddressV6&& addr6) noexcept = default;
+		//an IPv6 literal, else the first IPv6 address of a host name (blocking, see IPAddress)
 		explicit IPAddressV6(const char* ip);
 		explicit IPAddressV6(const std::string& ip);
-		explicit IPAddressV6(const ByteArray16& ip) noexcept { this->mAddr6.mBytes = ip; };
-		explicit IPAddressV6(const ByteArray16&& ip) noexcept { this->mAddr6.mBytes = ip; };
+		constexpr explicit IPAddressV6(const ByteArray16& ip) noexcept : mAddr6{ ip } { }
+		constexpr explicit IPAddressV6(const ByteArray16&& ip) noexcept : mAddr6{ ip } { }
 		explicit IPAddressV6(const sockaddr_in6& addr6);
 		explicit IPAddressV6(const in6_addr& addr6);
 
-		static const IPAddressV6 unspecified() { return IPAddressV6(ByteArray16{ 0 }); }
+		static constexpr IPAddressV6 unspecified() noexcept { return IPAddressV6(ByteArray16{ 0 }); }
 		//Is the same as ::1 and that can be used instead. 
-		static const IPAddressV6 loopback()
+		static constexpr IPAddressV6 loopback() noexcept
 		{
 			return IPAddressV6(ByteArray16({ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 }));
 		}
-
-		static const IPAddressV6 defaultRoute() { return IPAddressV6("::"); }
+		/* :: */
+		static constexpr IPAddressV6 defaultRoute() noexcept { return unspecified(); }
 	public:
-		bool operator==(const IPAddressV6& ipv6) const noexcept;
+		constexpr bool operator==(const IPAddressV6& ipv6) const noexcept
+		{
+			return details::equal(this->mAddr6.mBytes, ipv6.mAddr6.mBytes);
+		}
 		bool operator==(const IPAddressV4& ipv4) const noexcept;
 		bool operator==(const IPAddress& addr) const noexcept;
 
-		bool operator!=(const IPAddressV6& ipv6) const noexcept;
+		constexpr bool operator!=(const IPAddressV6& ipv6) const noexcept { return !this->operator==(ipv6); }
 		bool operator!=(const IPAddressV4& ipv4) const noexcept;
 		bool operator!=(const IPAddress& addr) const noexcept;
 
-		IPAddressV6& operator=(const IPAddressV6& ipv6) noexcept;
+		IPAddressV6& operator=(const IPAddressV6& ipv6) noexcept = default;
 		IPAddressV6& operator=(const IPAddressV4& ipv4) noexcept;
 		IPAddressV6& operator=(const IPAddress& addr) noexcept;
 
-		IPAddressV6& operator=(IPAddressV6&& ipv6) noexcept;
+		IPAddressV6& operator=(IPAddressV6&& ipv6) noexcept = default;
 	protected:
+		/*
+		 * Resolves a host name with getaddrinfo. Does not count a failure, the public parser that calls it does.
+		 */
+		static bool resolveIPAddressV6(IPAddressV6& addr6, const std::string& ip) noexcept;
 		/* used when sorting IPv6 addresses */
-		bool operator<(const IPAddressV6& rhs) const noexcept;
+		constexpr bool operator<(const IPAddressV6& rhs) const noexcept
+		{
+			return details::less(this->mAddr6.mBytes, rhs.mAddr6.mBytes);
+		}
 	public:
 		/*
 		 * parse an IPV6 string into a IPAdddressV6 object
@@ -99,7 +137,7 @@ namespace ip_address
 		* @param addr4 [in] IPv4 address to be converted to IPv6
 		* @param addr6 [out] IPv6 mapped address
 		*/
-		NODISCARD static bool mapIPv6ToIPv4(IPAddressV6& addr6, IPAddressV4& addr4) noexcept;
+		NODISCARD static bool mapIPv6ToIPv4(const IPAddressV6& addr6, IPAddressV4& addr4) noexcept;
 		/*
 		 * Convert IPAddressV6 to an IPAddressV4.
 		 * This conversation can only be used if the address was an IPAddressV4 that was converted over to an IPAddressV6.
@@ -112,14 +150,21 @@ namespace ip_address
 		/**
 		* @return a byte array
 		*/
-		ByteArray16& bytes();
+		constexpr ByteArray16& bytes() noexcept { return this->mAddr6.mBytes; }
+		constexpr const ByteArray16& bytes() const noexcept { return this->mAddr6.mBytes; }
 
 		//Specific sockaddr for IPv6
 		NODISCARD sockaddr_in6 getSockaddrIn6() const;
 		/*
-		* 
+		* @return the RFC 5952 text form e.g 2001:db8::1 or ::ffff:192.0.2.1, the same text as inet_ntop.
 		*/
 		NODISCARD std::string getString() const;
+		/*
+		* Writes the text form of getString() without a terminator.
+		* @param out [out] room for MAX_IPV6_ADDRESS_CHAR_MAX_COUNT characters.
+		* @return end of the written text.
+		*/
+		static char* writeString(const ByteArray16& bytes, char* out) noexcept;
 		/**
 		* @return size of an IPAddressV6 in bytes
 		*/
@@ -127,39 +172,39 @@ namespace ip_address
 		/*
 		* An IPv6 multicast address is an identifier for a group of interfaces (typically on different nodes).
 		*/
-		NODISCARD bool isMulticast() const noexcept;
+		NODISCARD constexpr bool isMulticast() const noexcept;
 		/*
 		* Wildcard is an IPv6 with the whole address set as 0.
 		*/
-		NODISCARD bool isWildcard() const noexcept;
+		NODISCARD constexpr bool isWildcard() const noexcept;
 		/*
 		*
 		*/
-		NODISCARD bool isGlobalUnicast() const noexcept;
+		NODISCARD constexpr bool isGlobalUnicast() const noexcept;
 		/*
-		*
+		* fc00::/7
 		*/
-		NODISCARD bool isUniqueLocal() const noexcept;
+		NODISCARD constexpr bool isUniqueLocal() const noexcept;
 		/*
-		*
+		* fe80::/10
 		*/
-		NODISCARD bool isLinkLocal() const noexcept;
+		NODISCARD constexpr bool isLinkLocal() const noexcept;
 		/*
 		*
 		*/
-		NODISCARD bool SiteLocal() const noexcept;
+		NODISCARD constexpr bool SiteLocal() const noexcept;
 		/*
-		*
+		* Subnet-Router anycast address of a /64, the interface identifier is 0.
 		*/
-		NODISCARD bool isAnyCast() const noexcept;
+		NODISCARD constexpr bool isAnyCast() const noexcept;
 		/*
 		* Checks if the address is an IPv4 to IPv6 mapped address.
 		*/
-		NODISCARD bool isIPv4Mapped() const noexcept;
+		NODISCARD constexpr bool isIPv4Mapped() const noexcept;
 		/*
-		* A loopbacck is an address to the local host and has the format "::/128".
+		* A loopbacck is an address to the local host and has the format "::1/128".
 		*/
-		NODISCARD bool isLoopback() const noexcept;
+		NODISCARD constexpr bool isLoopback() const noexcept;
 		/*
 		*
 		*/
@@ -169,13 +214,21 @@ namespace ip_address
 		*/
 		NODISCARD bool isMasked() const noexcept;
 		/*
+		* @return a copy of the address with every bit after prefixLength set to 0 e.g fe80::1 truncated to 10 is fe80::
+		*/
+		NODISCARD constexpr IPAddressV6 truncate(uint8_t prefixLength) const noexcept;
+		/*
+		* @return a copy of the address with every bit that is 0 in mask set to 0.
+		*/
+		NODISCARD constexpr IPAddressV6 mask(const IPAddressV6& mask) const noexcept;
+		/*
 		* ::/128
 		*/
-		NODISCARD bool isUnspecified() const noexcept;
+		NODISCARD constexpr bool isUnspecified() const noexcept;
 		/*
 		*
 		*/
-		NODISCARD bool isRoutable() const noexcept;
+		NODISCARD constexpr bool isRoutable() const noexcept;
 		/* Clears IPv6 address to 0 */
 		void clear() noexcept;
 	public:
@@ -206,4 +259,131 @@ namespace ip_address
 			in6_addr mIn6Addr;
 		} mAddr6 = { 0 };
 	};
+
+	constexpr bool IPAddressV6::isMulticast() const noexcept
+	{
+		//ff00::/8 https://datatracker.ietf.org/doc/html/rfc3513#section-2.7
+		return mAddr6.mBytes[0] == 0xFF;
+	}
+
+	constexpr bool IPAddressV6::isWildcard() const noexcept
+	{
+		return this->isUnspecified();
+	}
+
+	constexpr bool IPAddressV6::isGlobalUnicast() const noexcept
+	{
+		/*
+		*https://www.ietf.org/rfc/rfc3587.txt
+		| 3 |     45 bits         |  16 bits  |       64 bits              |
+		+---+---------------------+-----------+----------------------------+
+		|001|global routing prefix| subnet ID |       interface ID         |
+		+---+---------------------+-----------+----------------------------+
+		*/
+		return (this->mAddr6.mBytes[0] & 0b11100000) == 0b00100000;
+	}
+
+	constexpr bool IPAddressV6::isUniqueLocal() const noexcept
+	{
+		//Prefix is 1111 110 followed by the L bit, fd00::/8 are the locally assigned addresses https://datatracker.ietf.org/doc/html/rfc4193
+		return (mAddr6.mBytes[0] & 0b11111110) == 0b11111100;
+	}
+
+	constexpr bool IPAddressV6::isLinkLocal() const noexcept
+	{
+		/* Link-Local addresses have the following format:
+
+		|   10     |
+		|  bits    |         54 bits         |          64 bits           |
+		+----------+-------------------------+----------------------------+
+		|1111111010|           0             |       interface ID         |
+		+----------+-------------------------+----------------------------+
+		*/
+		return this->mAddr6.mBytes[0] == 0b11111110 && (this->mAddr6.mBytes[1] & 0b11000000) == 0b10000000;
+	}
+
+	constexpr bool IPAddressV6::SiteLocal() const noexcept
+	{
+		/*
+		|   10     |
+		|  bits    |         54 bits         |         64 bits            |
+		+----------+-------------------------+----------------------------+
+		|1111111011|        subnet ID        |       interface ID         |
+		+----------+-------------------------+----------------------------+
+		 */
+		return this->mAddr6.mBytes[0] == 0b11111110 && (this->mAddr6.mBytes[1] & 0b11000000) == 0b11000000;
+	}
+
+	constexpr bool IPAddressV6::isAnyCast() const noexcept
+	{
+		/*https://datatracker.ietf.org/doc/html/rfc4291#section-2.6.1
+		   |                         n bits                 |   128-n bits   |
+		   +------------------------------------------------+----------------+
+		   |                   subnet prefix                | 00000000000000 |
+		   +------------------------------------------------+----------------+
+		 */
+		for (size_t i = 8; i < this->mAddr6.mBytes.size(); i++)
+		{
+			if (this->mAddr6.mBytes[i] != 0)
+				return false;
+		}
+		return !this->isUnspecified();
+	}
+
+	// IPv4 mapped addresses have their first 10 mBytes set to 0, the next 2 mBytes
+	// set to 255 (0xff);
+	constexpr bool IPAddressV6::isIPv4Mapped() const noexcept
+	{
+		for (size_t i = 0; i < 10; i++)
+		{
+			if (mAddr6.mBytes[i] != 0x00)
+				return false;
+		}
+		return mAddr6.mBytes[10] == 0xff && mAddr6.mBytes[11] == 0xff;
+	}
+
+	constexpr bool IPAddressV6::isLoopback() const noexcept
+	{
+		return *this == loopback();
+	}
+
+	constexpr IPAddressV6 IPAddressV6::truncate(uint8_t prefixLength) const noexcept
+	{
+		assert(prefixLength <= 128);
+		IPAddressV6 addr6;
+		const size_t fullBytes = prefixLength / 8;
+		for (size_t i = 0; i < fullBytes; i++)
+		{
+			addr6.mAddr6.mBytes[i] = this->mAddr6.mBytes[i];
+		}
+		if (prefixLength % 8 != 0)
+		{
+			addr6.mAddr6.mBytes[fullBytes] = this->mAddr6.mBytes[fullBytes] & static_cast<uint8_t>(0xFF << (8 - prefixLength % 8));
+		}
+		return addr6;
+	}
+
+	constexpr IPAddressV6 IPAddressV6::mask(const IPAddressV6& mask) const noexcept
+	{
+		IPAddressV6 addr6;
+		for (size_t i = 0; i < addr6.mAddr6.mBytes.size(); i++)
+		{
+			addr6.mAddr6.mBytes[i] = this->mAddr6.mBytes[i] & mask.mAddr6.mBytes[i];
+		}
+		return addr6;
+	}
+
+	constexpr bool IPAddressV6::isUnspecified() const noexcept
+	{
+		/* https://datatracker.ietf.org/doc/html/rfc4291#section-2.5.2
+		 * The address 0:0:0:0:0:0:0:0 is called the unspecified address
+		 */
+		return *this == unspecified();
+	}
+
+	constexpr bool IPAddressV6::isRoutable() const noexcept
+	{
+		//TODO implement isRoutable() correctly
+		return !this->isUnspecified() && !this->isLoopback();
+	}
 }
@@ -44,12 +44,14 @@ namespace ip_address
 	class IPEndPoint final : public IPAddress
 	{
 		friend class IPAddress;
+		friend class PacketHeader;
 	public:
 		IPEndPoint() = default;
-		~IPEndPoint() override = default;
+		~IPEndPoint() = default;
 		IPEndPoint(const IPEndPoint& ipEnd) = default;
 		IPEndPoint(IPEndPoint&& ipEnd) = default;
 
+		//the address as IPAddress(const char*) takes it, host names included, without a port
 		explicit IPEndPoint(const char* const ip) : IPAddress(ip) { }
 
 		explicit IPEndPoint(const std::string& ip) : IPAddress(ip) { }
@@ -59,17 +61,17 @@ namespace ip_address
 		IPEndPoint(const std::string& ip, const port_network_byte_order_t port) : IPAddress(ip),
 			mPort(to_host_byte_order(port)) { }
 
-		explicit IPEndPoint(const ByteArray4& addr4, const port_host_byte_order_t port) noexcept : IPAddress(addr4),
-			mPort(port) { }
+		constexpr explicit IPEndPoint(const ByteArray4& addr4, const port_host_byte_order_t port) noexcept :
+			IPAddress(addr4), mPort(port) { }
 
-		explicit IPEndPoint(const ByteArray4&& addr4, const port_host_byte_order_t port) noexcept : IPAddress(addr4),
-			mPort(port) { }
+		constexpr explicit IPEndPoint(const ByteArray4&& addr4, const port_host_byte_order_t port) noexcept :
+			IPAddress(addr4), mPort(port) { }
 
-		explicit IPEndPoint(const ByteArray16& addr6, const port_host_byte_order_t port) noexcept : IPAddress(addr6),
-			mPort(port) { }
+		constexpr explicit IPEndPoint(const ByteArray16& addr6, const port_host_byte_order_t port) noexcept :
+			IPAddress(addr6), mPort(port) { }
 
-		explicit IPEndPoint(const ByteArray16&& addr6, const port_host_byte_order_t port) noexcept : IPAddress(addr6),
-			mPort(port) { }
+		constexpr explicit IPEndPoint(const ByteArray16&& addr6, const port_host_byte_order_t port) noexcept :
+			IPAddress(addr6), mPort(port) { }
 
 		explicit IPEndPoint(const ByteArray4& addr4, const port_network_byte_order_t port) noexcept : IPAddress(addr4),
 			mPort(to_host_byte_order(port)) { }
@@ -84,21 +86,21 @@ namespace ip_address
 		                    const port_network_byte_order_t port) noexcept : IPAddress(addr6),
 		                                                                     mPort(to_host_byte_order(port)) { }
 
-		explicit IPEndPoint(const ByteArray4& addr4) noexcept : IPAddress(addr4) { }
+		constexpr explicit IPEndPoint(const ByteArray4& addr4) noexcept : IPAddress(addr4) { }
 
-		explicit IPEndPoint(const ByteArray16& addr6) noexcept : IPAddress(addr6) { }
+		constexpr explicit IPEndPoint(const ByteArray16& addr6) noexcept : IPAddress(addr6) { }
 
 		explicit IPEndPoint(const sockaddr_in& addr4) : IPAddress(addr4), mPort(NetToHost16(addr4.sin_port)) { }
 
 		explicit IPEndPoint(const sockaddr_in6& addr6) : IPAddress(addr6), mPort(NetToHost16(addr6.sin6_port)) { }
 
-		IPEndPoint(const IPAddressV4& addr4,
-		           const port_host_byte_order_t port) noexcept : IPAddress(addr4), mPort(port) { }
+		constexpr IPEndPoint(const IPAddressV4& addr4,
+		                     const port_host_byte_order_t port) noexcept : IPAddress(addr4), mPort(port) { }
 
-		IPEndPoint(const IPAddressV6& addr6,
-		           const port_host_byte_order_t port) noexcept : IPAddress(addr6), mPort(port) { }
+		constexpr IPEndPoint(const IPAddressV6& addr6,
+		                     const port_host_byte_order_t port) noexcept : IPAddress(addr6), mPort(port) { }
 
-		IPEndPoint(const IPAddress& addr, const port_host_byte_order_t port) : IPAddress(addr), mPort(port) { }
+		constexpr IPEndPoint(const IPAddress& addr, const port_host_byte_order_t port) : IPAddress(addr), mPort(port) { }
 
 		IPEndPoint(const IPAddressV4& addr4, const port_network_byte_order_t port) noexcept : IPAddress(addr4),
 			mPort(to_host_byte_order(port)) { }
@@ -109,21 +111,24 @@ namespace ip_address
 		IPEndPoint(const IPAddress& addr, const port_network_byte_order_t port) : IPAddress(addr),
 			mPort(to_host_byte_order(port)) { }
 
-		explicit IPEndPoint(const IPAddressV4& addr4) noexcept : IPAddress(addr4) { }
+		constexpr explicit IPEndPoint(const IPAddressV4& addr4) noexcept : IPAddress(addr4) { }
 
-		explicit IPEndPoint(const IPAddressV6& addr6) noexcept : IPAddress(addr6) { }
+		constexpr explicit IPEndPoint(const IPAddressV6& addr6) noexcept : IPAddress(addr6) { }
 
-		explicit IPEndPoint(const IPAddress& addr) : IPAddress(addr) { }
+		constexpr explicit IPEndPoint(const IPAddress& addr) : IPAddress(addr) { }
 
 		explicit IPEndPoint(const sockaddr* addr) : IPAddress(addr) { }
 
 		explicit IPEndPoint(const sockaddr* addr, socklen_t addrLength);
 	public:
-		bool operator==(const IPEndPoint& rhs) const;
+		constexpr bool operator==(const IPEndPoint& rhs) const noexcept
+		{
+			return this->mPort == rhs.mPort && IPAddress::operator==(static_cast<const IPAddress&>(rhs));
+		}
 		bool operator==(port_host_byte_order_t rhs) const;
 		bool operator==(port_network_byte_order_t rhs) const;
 
-		bool operator!=(const IPEndPoint& rhs) const;
+		constexpr bool operator!=(const IPEndPoint& rhs) const noexcept { return !this->operator==(rhs); }
 		bool operator!=(port_host_byte_order_t rhs) const;
 		bool operator!=(port_network_byte_order_t rhs) const;
 
@@ -144,7 +149,7 @@ namespace ip_address
 	public:
 		IPAddress& ipAddress() const;
 		/* Port in host-byte order */
-		port_host_byte_order_t getPort() const;
+		constexpr port_host_byte_order_t getPort() const noexcept { return mPort; }
 		/* Port in network byte order */
 		port_network_byte_order_t getPortNetworkByteOrder() const;
 		/*
@@ -152,15 +157,33 @@ namespace ip_address
 		*/
 		IPAddress getIPAddress() const;
 		/*
-		* 
+		* @return the endpoint as sockaddr_in, the endpoint must be IPv4.
 		*/
 		sockaddr_in getAddressIPv4() const;
 		/*
-		* 
+		* @return the endpoint as sockaddr_in6, an IPv4 endpoint is returned as an IPv4-mapped address (::ffff:a.b.c.d)
+		* which is what a dual-stack AF_INET6 socket expects.
 		*/
 		sockaddr_in6 getAddressIPv6() const;
 		//FORMAT: x.x.x.x:port
 		std::string getStringWithPort() const;
+		/*
+		* Converts count socket addresses, e.g the names filled in by recvmmsg(), into endpoints.
+		* The family is turned into selects instead of branches so mixed IPv4/IPv6 batches do not mispredict,
+		* an address that is neither AF_INET nor AF_INET6 gives an endpoint with IPVersion::kUnknown.
+		*/
+		static void fromSockaddrs(const sockaddr_storage* addrs, size_t count, IPEndPoint* endpoints) noexcept;
+		/*
+		* Writes count endpoints as sockaddr_in or sockaddr_in6 into addrs and the matching sizes into lengths,
+		* e.g the names passed to sendmmsg(). lengths may be nullptr.
+		*/
+		static void toSockaddrs(const IPEndPoint* endpoints, size_t count, sockaddr_storage* addrs,
+		                        socklen_t* lengths) noexcept;
+		/*
+		* Writes the endpoint as sockaddr_in or sockaddr_in6 into storage and its size into length, ready for
+		* sendto()/connect()/bind(). Always copies one fixed sized block, the family only selects offsets.
+		*/
+		void writeSockaddr(sockaddr_storage& storage, socklen_t& length) const noexcept;
 		/**
 		* Clears IPAddress to 0x0, IPVersion to Unknown and sets port to DEFAULT_IP_ENDPOINT_PORT (default values)
 		*/
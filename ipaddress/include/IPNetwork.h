@@ -0,0 +1,88 @@
+#pragma once
+#include <string>
+#include "IPAddress.h"
+
+namespace ip_address
+{
+	/*
+	 * IPNetwork is an IPAddress together with a prefix length, written in CIDR notation e.g 10.0.0.0/8 or fe80::/10.
+	 * The stored address is always truncated to the prefix length so 10.1.2.3/8 and 10.0.0.0/8 are the same network.
+	 */
+	class IPNetwork final
+	{
+	public:
+		IPNetwork() = default;
+		~IPNetwork() = default;
+		IPNetwork(const IPNetwork& network) noexcept = default;
+		IPNetwork(IPNetwork&& network) noexcept = default;
+
+		constexpr IPNetwork(const IPAddress& addr, uint8_t prefixLength) noexcept :
+			mAddress(addr.truncate(prefixLength)), mPrefixLength(prefixLength) { }
+		constexpr IPNetwork(const IPAddressV4& addr4, uint8_t prefixLength) noexcept :
+			mAddress(addr4.truncate(prefixLength)), mPrefixLength(prefixLength) { }
+		constexpr IPNetwork(const IPAddressV6& addr6, uint8_t prefixLength) noexcept :
+			mAddress(addr6.truncate(prefixLength)), mPrefixLength(prefixLength) { }
+
+		explicit IPNetwork(const char* cidr);
+		explicit IPNetwork(const std::string& cidr);
+	public:
+		constexpr bool operator==(const IPNetwork& rhs) const noexcept
+		{
+			return this->mPrefixLength == rhs.mPrefixLength && this->mAddress == rhs.mAddress;
+		}
+		constexpr bool operator!=(const IPNetwork& rhs) const noexcept { return !this->operator==(rhs); }
+
+		IPNetwork& operator=(const IPNetwork& rhs) noexcept = default;
+		IPNetwork& operator=(IPNetwork&& rhs) noexcept = default;
+	public:
+		/*
+		 * parse a network in CIDR notation ("address/prefixLength") into an IPNetwork object.
+		 * A missing prefix length is treated as a host network (/32 or /128).
+		 * Unlike parseIPAddress this never resolves hostnames.
+		 * ...
+		 * @param network [out] result after parsing cidr string
+		 * @param cidr [in] string to be parsed
+		 * @return true if it succeeded
+		 */
+		NODISCARD static bool parseIPNetwork(IPNetwork& network, const std::string& cidr) noexcept;
+		/*
+		* @return the network address, every bit after the prefix length is 0.
+		*/
+		NODISCARD constexpr const IPAddress& getAddress() const noexcept { return mAddress; }
+
+		NODISCARD constexpr uint8_t getPrefixLength() const noexcept { return mPrefixLength; }
+
+		NODISCARD constexpr IPVersion getVersion() const noexcept { return mAddress.getVersion(); }
+		/*
+		* @return true if addr has the same version and its first getPrefixLength() bits are equal to the network address.
+		*/
+		NODISCARD constexpr bool contains(const IPAddress& addr) const noexcept
+		{
+			return addr.getVersion() == mAddress.getVersion() && addr.truncate(mPrefixLength) == mAddress;
+		}
+		NODISCARD constexpr bool contains(const IPAddressV4& addr4) const noexcept
+		{
+			return mAddress.isIPv4() && mAddress == addr4.truncate(mPrefixLength);
+		}
+		NODISCARD constexpr bool contains(const IPAddressV6& addr6) const noexcept
+		{
+			return mAddress.isIPv6() && mAddress == addr6.truncate(mPrefixLength);
+		}
+		/*
+		* @return true if network is equal to or a subnet of this network.
+		*/
+		NODISCARD constexpr bool contains(const IPNetwork& network) const noexcept
+		{
+			return network.mPrefixLength >= mPrefixLength && this->contains(network.mAddress);
+		}
+		/*
+		* FORMAT: address/prefixLength e.g 192.168.0.0/16
+		*/
+		NODISCARD std::string getString() const;
+	public:
+		friend std::ostream& operator<<(std::ostream& rhs, const IPNetwork& lhs);
+	private:
+		IPAddress mAddress;
+		uint8_t mPrefixLength = 0;
+	};
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "util/Config.h"
+
+namespace ip_address
+{
+	/*
+	 * Counters and latency histograms of the hot paths of the address types: string parsing, the getaddrinfo
+	 * fallback of the parsers, formatting and sockaddr conversion.
+	 *
+	 * The library records only when built with IPADDRESS_INSTRUMENTATION (cmake -DIPADDRESS_INSTRUMENTATION=ON),
+	 * otherwise the recording macros expand to nothing and the hot paths are unchanged. Each thread records
+	 * into its own slot with plain relaxed stores, there are no locks or read-modify-write instructions on the
+	 * recording path. snapshot() sums the slots of all threads, including threads that have exited, so every
+	 * count is monotonic like a Prometheus counter.
+	 *
+	 * Latencies are kept in log-linear buckets like HdrHistogram: values below 16ns exactly, above in 8 buckets
+	 * per power of two, so a bucket is at most 12.5% wide.
+	 */
+	class Instrumentation final
+	{
+	public:
+		enum class Operation : uint8_t
+		{
+			kParseV4,
+			kParseV6,
+			kParse,
+			kResolveV4,
+			kResolveV6,
+			kFormatV4,
+			kFormatV6,
+			kConvert,
+			kCount,
+		};
+		enum class Event : uint8_t
+		{
+			/* a string parser rejected its input */
+			kParseFailed,
+			/* getaddrinfo did not resolve a string that is not a literal */
+			kResolveFailed,
+			/* a string constructor threw */
+			kException,
+			kCount,
+		};
+		static constexpr size_t kOperations = static_cast<size_t>(Operation::kCount);
+		static constexpr size_t kEvents = static_cast<size_t>(Event::kCount);
+		static constexpr size_t kSubBuckets = 8;
+		static constexpr size_t kBuckets = 16 + (64 - 4) * kSubBuckets;
+
+		class Snapshot final
+		{
+		public:
+			NODISCARD uint64_t getCount(Event event) const noexcept;
+			NODISCARD uint64_t getCount(Operation operation) const noexcept;
+			NODISCARD uint64_t getTotalNanoseconds(Operation operation) const noexcept;
+			/*
+			 * @param quantile in [0, 1].
+			 * @return the highest latency in nanoseconds of the bucket holding the quantile, 0 without samples.
+			 */
+			NODISCARD uint64_t getQuantile(Operation operation, double quantile) const noexcept;
+			/*
+			 * Prometheus text exposition format, a counter per event and a histogram per operation with
+			 * power of two bucket bounds from 16ns to 1s.
+			 */
+			NODISCARD std::string getPrometheusText() const;
+			/*
+			 * Counts, totals, quantiles and the non-empty buckets as [lowest latency, count] pairs.
+			 */
+			NODISCARD std::string getJson() const;
+		private:
+			friend class Instrumentation;
+
+			std::array<uint64_t, kEvents> mEvents = {};
+			std::array<uint64_t, kOperations> mTotals = {};
+			std::array<std::array<uint64_t, kBuckets>, kOperations> mBuckets = {};
+		};
+
+		/*
+		 * Scope of a timed operation.
+		 */
+		class Timer final
+		{
+		public:
+			explicit Timer(Operation operation) noexcept : mOperation(operation),
+				mStart(std::chrono::steady_clock::now()) { }
+			~Timer()
+			{
+				record(mOperation, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - mStart).count()));
+			}
+			Timer(const Timer&) = delete;
+			Timer& operator=(const Timer&) = delete;
+		private:
+			Operation mOperation;
+			std::chrono::steady_clock::time_point mStart;
+		};
+	public:
+		/*
+		 * @return true if the library was built with IPADDRESS_INSTRUMENTATION.
+		 */
+		static constexpr bool isEnabled() noexcept
+		{
+#if defined(IPADDRESS_INSTRUMENTATION)
+			return true;
+#else
+			return false;
+#endif
+		}
+		static void count(Event event) noexcept;
+		static void record(Operation operation, uint64_t nanoseconds) noexcept;
+		NODISCARD static Snapshot snapshot();
+
+		NODISCARD static const char* getName(Operation operation) noexcept;
+		NODISCARD static const char* getName(Event event) noexcept;
+		NODISCARD static size_t getBucket(uint64_t nanoseconds) noexcept;
+		/*
+		 * @return lowest latency of a bucket.
+		 */
+		NODISCARD static uint64_t getBucketLowest(size_t bucket) noexcept;
+	};
+}
+
+#define IPADDRESS_CONCAT_INNER(a, b) a##b
+#define IPADDRESS_CONCAT(a, b) IPADDRESS_CONCAT_INNER(a, b)
+
+/*
+ * IPADDRESS_COUNT(kParseFailed) counts an event, IPADDRESS_TIME(kParseV4) times the rest of the scope.
+ */
+#if defined(IPADDRESS_INSTRUMENTATION)
+#define IPADDRESS_COUNT(event) ::ip_address::Instrumentation::count(::ip_address::Instrumentation::Event::event)
+#define IPADDRESS_TIME(operation) const ::ip_address::Instrumentation::Timer IPADDRESS_CONCAT(instrumentationTimer, \
+	__LINE__)(::ip_address::Instrumentation::Operation::operation)
+#else
+#define IPADDRESS_COUNT(event) ((void)0)
+#define IPADDRESS_TIME(operation) ((void)0)
+#endif
@@ -0,0 +1,304 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include "IPNetwork.h"
+
+namespace ip_address
+{
+	namespace details
+	{
+		constexpr int hexValue(char c) noexcept
+		{
+			if (c >= '0' && c <= '9')
+				return c - '0';
+			if (c >= 'a' && c <= 'f')
+				return c - 'a' + 10;
+			if (c >= 'A' && c <= 'F')
+				return c - 'A' + 10;
+			return -1;
+		}
+
+		/*
+		 * constexpr parsers of address literals, they accept the same text as inet_pton and never resolve hostnames.
+		 * @param text [in] size characters, no terminator needed
+		 * @param bytes [out] result, unspecified when the parser fails
+		 * @return true if it succeeded
+		 */
+		constexpr bool parseLiteralV4(const char* text, size_t size, ByteArray4& bytes) noexcept
+		{
+			size_t octet = 0;
+			size_t digits = 0;
+			unsigned value = 0;
+			for (size_t i = 0; i < size; i++)
+			{
+				const char c = text[i];
+				if (c >= '0' && c <= '9')
+				{
+					//inet_pton does not take leading zeros, 010 could be read as octal
+					if (digits == 1 && value == 0)
+						return false;
+					value = value * 10 + static_cast<unsigned>(c - '0');
+					if (value > 255)
+						return false;
+					digits++;
+				}
+				else if (c == '.' && digits != 0 && octet < 3)
+				{
+					bytes[octet++] = static_cast<uint8_t>(value);
+					value = 0;
+					digits = 0;
+				}
+				else
+				{
+					return false;
+				}
+			}
+			if (digits == 0 || octet != 3)
+				return false;
+			bytes[3] = static_cast<uint8_t>(value);
+			return true;
+		}
+
+		constexpr bool parseLiteralV6(const char* text, size_t size, ByteArray16& bytes) noexcept
+		{
+			ByteArray16 result = { 0 };
+			size_t length = 0;
+			//byte offset of "::", a "::" after all 8 groups is at offset 16
+			bool hasGap = false;
+			size_t gap = 0;
+			size_t i = 0;
+			if (size != 0 && text[0] == ':')
+			{
+				if (size < 2 || text[1] != ':')
+					return false;
+				i = 1;
+			}
+			size_t groupBegin = i;
+			size_t digits = 0;
+			unsigned value = 0;
+			for (; i < size; i++)
+			{
+				const char c = text[i];
+				const int hex = hexValue(c);
+				if (hex >= 0)
+				{
+					if (++digits > 4)
+						return false;
+					value = value << 4 | static_cast<unsigned>(hex);
+				}
+				else if (c == ':')
+				{
+					groupBegin = i + 1;
+					if (digits == 0)
+					{
+						if (hasGap)
+							return false;
+						hasGap = true;
+						gap = length;
+						continue;
+					}
+					if (i + 1 == size || length + 2 > 16)
+						return false;
+					result[length++] = static_cast<uint8_t>(value >> 8);
+					result[length++] = static_cast<uint8_t>(value);
+					digits = 0;
+					value = 0;
+				}
+				else if (c == '.' && length + 4 <= 16)
+				{
+					//dotted quad in the last 32 bits e.g ::ffff:192.0.2.1
+					ByteArray4 bytes4 = { 0 };
+					if (!parseLiteralV4(text + groupBegin, size - groupBegin, bytes4))
+						return false;
+					for (const uint8_t byte : bytes4)
+					{
+						result[length++] = byte;
+					}
+					digits = 0;
+					break;
+				}
+				else
+				{
+					return false;
+				}
+			}
+			if (digits != 0)
+			{
+				if (length + 2 > 16)
+					return false;
+				result[length++] = static_cast<uint8_t>(value >> 8);
+				result[length++] = static_cast<uint8_t>(value);
+			}
+			if (hasGap)
+			{
+				if (length == 16)
+					return false;
+				//move the groups after "::" to the end
+				const size_t tail = length - gap;
+				for (size_t j = 1; j <= tail; j++)
+				{
+					result[16 - j] = result[length - j];
+					result[length - j] = 0;
+				}
+				length = 16;
+			}
+			if (length != 16)
+				return false;
+			bytes = result;
+			return true;
+		}
+
+		/*
+		 * CIDR notation like IPNetwork::parseIPNetwork, a missing prefix length is a host network.
+		 */
+		constexpr bool parseLiteralNetwork(const char* text, size_t size, IPNetwork& network) noexcept
+		{
+			size_t slash = 0;
+			while (slash < size && text[slash] != '/')
+				slash++;
+			int prefixLength = -1;
+			if (slash != size)
+			{
+				if (size - slash - 1 == 0 || size - slash - 1 > 3)
+					return false;
+				prefixLength = 0;
+				for (size_t i = slash + 1; i < size; i++)
+				{
+					if (text[i] < '0' || text[i] > '9')
+						return false;
+					prefixLength = prefixLength * 10 + (text[i] - '0');
+				}
+			}
+			ByteArray4 bytes4 = { 0 };
+			if (parseLiteralV4(text, slash, bytes4))
+			{
+				if (prefixLength > 32)
+					return false;
+				network = IPNetwork(IPAddressV4(bytes4), static_cast<uint8_t>(prefixLength < 0 ? 32 : prefixLength));
+				return true;
+			}
+			ByteArray16 bytes6 = { 0 };
+			if (parseLiteralV6(text, slash, bytes6))
+			{
+				if (prefixLength > 128)
+					return false;
+				network = IPNetwork(IPAddressV6(bytes6), static_cast<uint8_t>(prefixLength < 0 ? 128 : prefixLength));
+				return true;
+			}
+			return false;
+		}
+
+		constexpr bool isLiteralV4(const char* text, size_t size) noexcept
+		{
+			ByteArray4 bytes = { 0 };
+			return parseLiteralV4(text, size, bytes);
+		}
+
+		constexpr bool isLiteralV6(const char* text, size_t size) noexcept
+		{
+			ByteArray16 bytes = { 0 };
+			return parseLiteralV6(text, size, bytes);
+		}
+
+		constexpr bool isLiteralNetwork(const char* text, size_t size) noexcept
+		{
+			IPNetwork network;
+			return parseLiteralNetwork(text, size, network);
+		}
+
+		constexpr IPAddressV4 makeLiteralV4(const char* text, size_t size)
+		{
+			ByteArray4 bytes = { 0 };
+			if (!parseLiteralV4(text, size, bytes))
+				throw std::runtime_error("invalid IPv4 literal");
+			return IPAddressV4(bytes);
+		}
+
+		constexpr IPAddressV6 makeLiteralV6(const char* text, size_t size)
+		{
+			ByteArray16 bytes = { 0 };
+			if (!parseLiteralV6(text, size, bytes))
+				throw std::runtime_error("invalid IPv6 literal");
+			return IPAddressV6(bytes);
+		}
+
+		constexpr IPNetwork makeLiteralNetwork(const char* text, size_t size)
+		{
+			IPNetwork network;
+			if (!parseLiteralNetwork(text, size, network))
+				throw std::runtime_error("invalid network literal");
+			return network;
+		}
+
+		template <typename Char, Char... Text>
+		struct LiteralText
+		{
+			static constexpr char kText[] = { static_cast<char>(Text)..., '\0' };
+			static constexpr size_t kSize = sizeof...(Text);
+		};
+	}
+
+	/*
+	 * Address literals that are parsed by the compiler, e.g
+	 *	using namespace ip_address::literals;
+	 *	constexpr IPAddressV4 gateway = "10.0.0.1"_ipv4;
+	 *	constexpr IPNetwork linkLocal = "fe80::/10"_net;
+	 *	static_assert(linkLocal.contains("fe80::1"_ipv6), "");
+	 * A literal that is not an address does not compile. GCC and Clang evaluate every literal at compile time,
+	 * other compilers only in constant expressions and throw std::runtime_error otherwise.
+	 */
+	namespace literals
+	{
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#if defined(__clang__)
+#pragma GCC diagnostic ignored "-Wgnu-string-literal-operator-template"
+#else
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+		//the string literal operator template is a GNU extension, it passes the text as template arguments
+		template <typename Char, Char... Text>
+		constexpr IPAddressV4 operator""_ipv4() noexcept
+		{
+			using Literal = details::LiteralText<Char, Text...>;
+			static_assert(details::isLiteralV4(Literal::kText, Literal::kSize), "invalid IPv4 literal");
+			constexpr IPAddressV4 addr4 = details::makeLiteralV4(Literal::kText, Literal::kSize);
+			return addr4;
+		}
+
+		template <typename Char, Char... Text>
+		constexpr IPAddressV6 operator""_ipv6() noexcept
+		{
+			using Literal = details::LiteralText<Char, Text...>;
+			static_assert(details::isLiteralV6(Literal::kText, Literal::kSize), "invalid IPv6 literal");
+			constexpr IPAddressV6 addr6 = details::makeLiteralV6(Literal::kText, Literal::kSize);
+			return addr6;
+		}
+
+		template <typename Char, Char... Text>
+		constexpr IPNetwork operator""_net() noexcept
+		{
+			using Literal = details::LiteralText<Char, Text...>;
+			static_assert(details::isLiteralNetwork(Literal::kText, Literal::kSize), "invalid network literal");
+			constexpr IPNetwork network = details::makeLiteralNetwork(Literal::kText, Literal::kSize);
+			return network;
+		}
+#pragma GCC diagnostic pop
+#else
+		constexpr IPAddressV4 operator""_ipv4(const char* text, size_t size)
+		{
+			return details::makeLiteralV4(text, size);
+		}
+
+		constexpr IPAddressV6 operator""_ipv6(const char* text, size_t size)
+		{
+			return details::makeLiteralV6(text, size);
+		}
+
+		constexpr IPNetwork operator""_net(const char* text, size_t size)
+		{
+			return details::makeLiteralNetwork(text, size);
+		}
+#endif
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "IPNetwork.h"
+#include "util/RcuPointer.h"
+
+namespace ip_address
+{
+	/*
+	 * Address assigned to a local interface.
+	 */
+	struct LocalAddress
+	{
+		IPAddress address;
+		/* prefix length of the on-link network of address */
+		uint8_t prefixLength = 0;
+		/* interface index, 0 if unknown */
+		uint32_t interfaceIndex = 0;
+
+		NODISCARD IPNetwork getNetwork() const noexcept { return IPNetwork(address, prefixLength); }
+		bool operator==(const LocalAddress& rhs) const noexcept;
+	};
+
+	/*
+	 * Set of the addresses and on-link prefixes of the local interfaces, answers isLocal() and getPrefix()
+	 * without system calls.
+	 *
+	 * The default constructor loads the addresses with a rtnetlink RTM_GETADDR dump and starts a thread that
+	 * listens for RTM_NEWADDR and RTM_DELADDR notifications. Each batch of notifications is applied to a copy
+	 * of the current snapshot which is then published, a lost notification (ENOBUFS) triggers a new dump.
+	 *
+	 * A snapshot indexes the addresses in one open addressing hash set per family (a probe is usually one
+	 * cache line) and keeps the prefixes in a small table sorted by prefix length, which is scanned for
+	 * getPrefix(). Readers pin the snapshot through an RcuPointer and never block, writers wait for the
+	 * readers of the old snapshot before freeing it. All methods are thread safe.
+	 */
+	class LocalAddressRegistry final
+	{
+	public:
+		/*
+		 * Loads the interface addresses over rtnetlink and keeps them up to date.
+		 * @throw std::runtime_error if the netlink socket can not be created or the dump fails.
+		 */
+		LocalAddressRegistry();
+		/*
+		 * Registry that holds addresses and only changes through add() and remove().
+		 */
+		explicit LocalAddressRegistry(const std::vector<LocalAddress>& addresses);
+		~LocalAddressRegistry();
+		LocalAddressRegistry(const LocalAddressRegistry&) = delete;
+		LocalAddressRegistry& operator=(const LocalAddressRegistry&) = delete;
+	public:
+		/*
+		 * @return true if addr is assigned to a local interface.
+		 */
+		NODISCARD bool isLocal(const IPAddress& addr) const noexcept;
+		NODISCARD bool isLocal(const IPAddressV4& addr4) const noexcept;
+		NODISCARD bool isLocal(const IPAddressV6& addr6) const noexcept;
+		/*
+		 * Finds the longest local on-link prefix containing addr.
+		 * @param network [out] the prefix.
+		 * @param interfaceIndex [out] optional, the interface of the prefix.
+		 * @return false if addr is not on a local network.
+		 */
+		NODISCARD bool getPrefix(const IPAddress& addr, IPNetwork& network,
+		                         uint32_t* interfaceIndex = nullptr) const noexcept;
+
+		NODISCARD std::vector<LocalAddress> getAddresses() const;
+		NODISCARD size_t size() const noexcept;
+		/*
+		 * @return number of snapshots published so far, changes with every applied update.
+		 */
+		NODISCARD uint64_t getGeneration() const noexcept;
+		/*
+		 * Adds or removes one address, an address is identified by address, prefix length and interface.
+		 * @return false if nothing changed.
+		 */
+		bool add(const LocalAddress& address);
+		bool remove(const LocalAddress& address);
+		/*
+		 * Replaces the addresses with a new rtnetlink dump.
+		 * @throw std::runtime_error if the dump fails.
+		 */
+		void refresh();
+	private:
+		struct Snapshot;
+		struct Change
+		{
+			LocalAddress address;
+			bool added;
+		};
+
+		size_t apply(const std::vector<Change>& changes);
+		void publish(std::vector<LocalAddress> addresses);
+		void monitor();
+	private:
+		details::RcuPointer<Snapshot> mSnapshot;
+		/* serializes the read-copy-update of add(), remove(), refresh() and the monitor thread */
+		std::mutex mUpdateMutex;
+		int mNetlink = -1;
+		int mWakeUp = -1;
+		std::thread mMonitor;
+	};
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "IPNetwork.h"
+#include "PrefixDatabase.h"
+
+namespace ip_address
+{
+	/*
+	 * Selects the lines of a log whose address field falls into a set of CIDR prefixes, or counts the lines per
+	 * prefix. Meant for files far larger than memory.
+	 *
+	 * The input is cut into chunks at line boundaries which a pool of threads processes in parallel. In a line
+	 * the field at the configured column is located and parsed in place with the AddressScanner parsers, an
+	 * endpoint form ("192.0.2.1:443", "[2001:db8::1]:443") is accepted. The prefixes are compiled into an
+	 * in-memory PrefixDatabase, so a line costs one longest prefix match. Matching lines are handed to the sink
+	 * chunk by chunk in input order, a bounded number of chunks is in flight at a time.
+	 */
+	class LogFilter final
+	{
+	public:
+		struct Options
+		{
+			/* zero based index of the field holding the address */
+			size_t column = 0;
+			/* field delimiter, 0 to split on runs of spaces and tabs */
+			char delimiter = 0;
+			/* worker threads, 0 for one per hardware thread */
+			size_t threads = 0;
+			/* bytes per chunk, a chunk is extended to the end of its last line */
+			size_t chunkSize = 4 << 20;
+		};
+		/*
+		 * Receives matching lines, each with its '\n' if the input had one.
+		 */
+		using Sink = std::function<void(std::string_view lines)>;
+
+		explicit LogFilter(const std::vector<IPNetwork>& prefixes);
+		LogFilter(const std::vector<IPNetwork>& prefixes, Options options);
+	public:
+		/*
+		 * @param prefix [out] index of the longest matching prefix.
+		 * @return false if the line has no address at the column or no prefix contains it.
+		 */
+		NODISCARD bool matchLine(std::string_view line, size_t& prefix) const noexcept;
+		/*
+		 * Passes the matching lines of text to sink in order.
+		 * @return number of matching lines.
+		 */
+		size_t filter(std::string_view text, const Sink& sink) const;
+		/*
+		 * Adds the number of lines matching each prefix to counts, which is resized to the number of prefixes.
+		 * A line counts for its longest matching prefix only.
+		 * @return number of matching lines.
+		 */
+		size_t count(std::string_view text, std::vector<uint64_t>& counts) const;
+		/*
+		 * filter() and count() over a mapped file.
+		 * throws std::runtime_error if the file can not be mapped.
+		 */
+		size_t filterFile(const std::string& path, const Sink& sink) const;
+		size_t countFile(const std::string& path, std::vector<uint64_t>& counts) const;
+
+		NODISCARD const std::vector<IPNetwork>& getPrefixes() const noexcept { return mPrefixes; }
+	private:
+		NODISCARD std::string_view getField(std::string_view line) const noexcept;
+	private:
+		std::vector<IPNetwork> mPrefixes;
+		Options mOptions;
+		/* values are the little endian uint32_t prefix indices */
+		std::unique_ptr<PrefixDatabase> mDatabase;
+	};
+}
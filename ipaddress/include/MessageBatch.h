@@ -0,0 +1,149 @@
+#pragma once
+#include "IPEndPoint.h"
+#include "util/Span.h"
+
+#ifdef __linux__
+#include <sys/uio.h>
+#include <ctime>
+
+namespace ip_address
+{
+	/*
+	 * Converts the names of count messages returned by recvmmsg() into endpoints.
+	 * Every msg_name must point to a sockaddr_storage (or at least sockaddr_in6 sized memory).
+	 */
+	void toEndPoints(const mmsghdr* messages, size_t count, IPEndPoint* endpoints) noexcept;
+	/*
+	 * Writes count endpoints into the names of messages passed to sendmmsg() and sets msg_namelen.
+	 * Every msg_name must point to a sockaddr_storage.
+	 */
+	void toMessageNames(const IPEndPoint* endpoints, size_t count, mmsghdr* messages) noexcept;
+
+	/*
+	 * Fixed size batch of UDP datagrams for recvmmsg()/sendmmsg() that keeps the sender or destination of every
+	 * datagram as an IPEndPoint. All storage lives inside the object, nothing is allocated on the heap.
+	 * The payload buffers are owned by the caller and set with setBuffer().
+	 *
+	 *	UdpMessageBatch<64> batch;
+	 *	for (size_t i = 0; i < batch.capacity(); i++) batch.setBuffer(i, buffers[i], sizeof(buffers[i]));
+	 *	const int received = batch.receive(fd);
+	 *	for (const IPEndPoint& sender : batch.getEndPoints()) { ... }
+	 */
+	template <size_t Capacity>
+	class UdpMessageBatch final
+	{
+		static_assert(Capacity > 0 && Capacity <= 1024, "sendmmsg()/recvmmsg() handle at most UIO_MAXIOV messages");
+	public:
+		UdpMessageBatch() noexcept
+		{
+			memset(mMessages, 0, sizeof(mMessages));
+			for (size_t i = 0; i < Capacity; i++)
+			{
+				mIov[i] = iovec{ nullptr, 0 };
+				mBufferSizes[i] = 0;
+				mMessages[i].msg_hdr.msg_name = &mNames[i];
+				mMessages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+				mMessages[i].msg_hdr.msg_iov = &mIov[i];
+				mMessages[i].msg_hdr.msg_iovlen = 1;
+			}
+		}
+		~UdpMessageBatch() = default;
+		//the messages point into the object itself
+		UdpMessageBatch(const UdpMessageBatch&) = delete;
+		UdpMessageBatch& operator=(const UdpMessageBatch&) = delete;
+	public:
+		/*
+		 * Sets the buffer message index is received into or sent from, size is also the length sent by send().
+		 */
+		void setBuffer(size_t index, void* data, size_t size) noexcept
+		{
+			assert(index < Capacity);
+			mIov[index].iov_base = data;
+			mIov[index].iov_len = size;
+			mBufferSizes[index] = size;
+		}
+		/*
+		 * Sets the destination of message index and how many bytes of its buffer send() transmits.
+		 */
+		void setMessage(size_t index, const IPEndPoint& destination, size_t length) noexcept
+		{
+			assert(index < Capacity);
+			mEndPoints[index] = destination;
+			mIov[index].iov_len = length;
+		}
+		/*
+		 * Receives up to capacity() datagrams with recvmmsg() and converts their senders into endpoints.
+		 * Every message receives into its whole buffer again, whatever length the last send() or reply() used.
+		 * @return number of received datagrams or -1 with errno set.
+		 */
+		int receive(int fd, int flags = 0, timespec* timeout = nullptr) noexcept
+		{
+			for (size_t i = 0; i < Capacity; i++)
+			{
+				mIov[i].iov_len = mBufferSizes[i];
+				mMessages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+			}
+			const int received = recvmmsg(fd, mMessages, Capacity, flags, timeout);
+			mCount = received > 0 ? static_cast<size_t>(received) : 0;
+			IPEndPoint::fromSockaddrs(mNames, mCount, mEndPoints);
+			return received;
+		}
+		/*
+		 * Sends the first count messages with sendmmsg() to the endpoints set with setMessage().
+		 * @return number of sent datagrams or -1 with errno set.
+		 */
+		int send(int fd, size_t count, int flags = 0) noexcept
+		{
+			assert(count <= Capacity);
+			socklen_t lengths[Capacity];
+			IPEndPoint::toSockaddrs(mEndPoints, count, mNames, lengths);
+			for (size_t i = 0; i < count; i++)
+			{
+				mMessages[i].msg_hdr.msg_namelen = lengths[i];
+			}
+			return sendmmsg(fd, mMessages, static_cast<unsigned int>(count), flags);
+		}
+		/*
+		 * Sends the first count received datagrams back to their senders, the raw names are reused without conversion.
+		 */
+		int reply(int fd, size_t count, int flags = 0) noexcept
+		{
+			assert(count <= mCount);
+			for (size_t i = 0; i < count; i++)
+			{
+				mIov[i].iov_len = mMessages[i].msg_len;
+			}
+			return sendmmsg(fd, mMessages, static_cast<unsigned int>(count), flags);
+		}
+		/*
+		 * @return the senders of the datagrams from the last receive().
+		 */
+		NODISCARD Span<const IPEndPoint> getEndPoints() const noexcept
+		{
+			return Span<const IPEndPoint>(mEndPoints, mCount);
+		}
+		/*
+		 * @return number of bytes received into the buffer of message index by the last receive().
+		 */
+		NODISCARD size_t getLength(size_t index) const noexcept
+		{
+			assert(index < mCount);
+			return mMessages[index].msg_len;
+		}
+		/*
+		 * @return the underlying messages for callers that issue recvmmsg()/sendmmsg() themselves.
+		 */
+		NODISCARD mmsghdr* getMessages() noexcept { return mMessages; }
+
+		NODISCARD static constexpr size_t capacity() noexcept { return Capacity; }
+	private:
+		mmsghdr mMessages[Capacity];
+		iovec mIov[Capacity];
+		/* the sizes given to setBuffer(), setMessage() and reply() shorten iov_len to the sent length */
+		size_t mBufferSizes[Capacity];
+		sockaddr_storage mNames[Capacity];
+		IPEndPoint mEndPoints[Capacity];
+		size_t mCount = 0;
+	};
+}
+#endif
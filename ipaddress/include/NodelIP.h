@@ -3,4 +3,8 @@
 #include "IPAddressV4.h"
 #include "IPAddressV6.h"
 #include "IPEndPoint.h"
+#include "IPNetwork.h"
+#include "Literals.h"
+#include "PrefixSet.h"
+#include "SockaddrView.h"
 #include "IPVersion.h"
\ No newline at end of file
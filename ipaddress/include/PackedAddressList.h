@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "IPAddressV4.h"
+#include "IPAddressV6.h"
+#include "util/AddressKey.h"
+#include "util/Span.h"
+
+namespace ip_address
+{
+	/*
+	 * Read-only view of a sorted address list in the compact binary form written by PackedAddressList::encode().
+	 *
+	 * The addresses are split into blocks of kBlockSize. A block stores its first address and the differences
+	 * between neighbours, minus the smallest difference of the block (frame of reference), bit-packed with the
+	 * width of the largest one. Clustered lists like blocklists or client sets need a few bits per address.
+	 *
+	 * A directory with the first address, reference, bit width and offset of every block follows the header,
+	 * so any block can be decoded on its own and contains() only decodes the one block that can hold the
+	 * address. IPv4 blocks are packed in 4 interleaved lanes (SIMD-BP128 layout) and decoded with SSE2,
+	 * unpacking and the prefix sum happen in registers. IPv6 blocks are unpacked from 64-bit words.
+	 *
+	 * Layout: 16 byte header (magic "IPAL", version, family, count, block count), the directory and the packed
+	 * blocks. The integers are stored in the byte order of the host that encoded the list, so a list is only portable
+	 * between hosts of the same byte order (every supported target is little endian). The view does not copy the
+	 * data, it has to outlive the view.
+	 */
+	class PackedAddressList final
+	{
+	public:
+		static constexpr size_t kBlockSize = 128;
+
+		/*
+		 * Encodes addresses, which have to be sorted ascending, duplicates are allowed.
+		 * throws std::runtime_error if the addresses are not sorted.
+		 */
+		NODISCARD static std::vector<uint8_t> encode(Span<const IPAddressV4> addresses);
+		NODISCARD static std::vector<uint8_t> encode(Span<const IPAddressV6> addresses);
+		/*
+		 * Checks the header and the directory of data.
+		 * throws std::runtime_error if data is not a valid encoded list.
+		 */
+		explicit PackedAddressList(Span<const uint8_t> data);
+	public:
+		NODISCARD bool isIPv6() const noexcept { return mIsIPv6; }
+		NODISCARD size_t size() const noexcept { return mCount; }
+		NODISCARD size_t getBlockCount() const noexcept { return mBlockCount; }
+		/*
+		 * Decodes one block as host byte order keys (see details::AddressKey).
+		 * @param keys [out] room for kBlockSize keys, all of them may be written.
+		 * @return number of addresses in the block.
+		 */
+		size_t decodeBlock(size_t block, uint32_t* keys) const noexcept;
+		size_t decodeBlock(size_t block, details::Uint128* keys) const noexcept;
+		/*
+		 * Appends all addresses to addresses, the list has to be of the matching family.
+		 */
+		void decode(std::vector<IPAddressV4>& addresses) const;
+		void decode(std::vector<IPAddressV6>& addresses) const;
+		/*
+		 * @return the first address of block.
+		 */
+		NODISCARD IPAddressV4 getFirstV4(size_t block) const noexcept;
+		NODISCARD IPAddressV6 getFirstV6(size_t block) const noexcept;
+
+		NODISCARD bool contains(const IPAddressV4& addr4) const noexcept;
+		NODISCARD bool contains(const IPAddressV6& addr6) const noexcept;
+	private:
+		const uint8_t* mDirectory = nullptr;
+		const uint8_t* mBlocks = nullptr;
+		size_t mCount = 0;
+		size_t mBlockCount = 0;
+		bool mIsIPv6 = false;
+	};
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "FlowKey.h"
+#include "IPNetwork.h"
+#include "util/AddressKey.h"
+#include "util/Span.h"
+
+namespace ip_address
+{
+	/*
+	 * Firewall rule over the five-tuple of a packet, every field is an inclusive range.
+	 */
+	struct PacketRule
+	{
+		/* a network without version (IPNetwork()) matches every address, the rule then applies to the version
+		 * of the other network or to both if neither has one */
+		IPNetwork source;
+		IPNetwork destination;
+		/* ports in host byte order */
+		port_host_byte_order_t sourcePortFirst = 0;
+		port_host_byte_order_t sourcePortLast = 65535;
+		port_host_byte_order_t destinationPortFirst = 0;
+		port_host_byte_order_t destinationPortLast = 65535;
+		uint8_t protocolFirst = 0;
+		uint8_t protocolLast = 255;
+		/* the matching rule with the lowest priority wins, then the one that comes first */
+		uint32_t priority = 0;
+	};
+
+	/*
+	 * Finds the rule that wins for a packet among thousands of PacketRules.
+	 *
+	 * The rules of each IP version are compiled into a HyperSplit decision tree: every node halves the space of one
+	 * field (address, port or protocol) at the point that best balances the rules on both sides, until at most
+	 * leafSize rules overlap the region of a node. A leaf lists its rules in priority order and is searched
+	 * linearly, rules hidden by a higher priority rule that covers the whole region are dropped. A lookup
+	 * is a walk of about 2 * log2(rules) nodes followed by a short leaf scan. The batch classify() walks a group of
+	 * flows through the tree level by level and prefetches the next nodes, so their cache misses overlap.
+	 */
+	class PacketClassifier final
+	{
+	public:
+		struct Options
+		{
+			/* rules in a leaf, smaller leaves make a deeper tree in which a rule is listed by more leaves */
+			size_t leafSize = 2;
+		};
+		/* rule index of a flow that no rule matches */
+		static constexpr size_t kNoMatch = SIZE_MAX;
+		/*
+		 * throws std::runtime_error if a rule has networks of different versions or an empty range.
+		 */
+		explicit PacketClassifier(const std::vector<PacketRule>& rules);
+		PacketClassifier(const std::vector<PacketRule>& rules, Options options);
+	public:
+		/*
+		 * @param rule [out] index in getRules() of the winning rule.
+		 * @return false if no rule matches, or source and destination have different versions.
+		 */
+		NODISCARD bool classify(const IPEndPoint& source, const IPEndPoint& destination, uint8_t protocol,
+		                        size_t& rule) const noexcept;
+		NODISCARD bool classify(const FlowKey& flow, size_t& rule) const noexcept;
+		/*
+		 * Classifies every flow, rules[i] is the rule index of flows[i] or kNoMatch.
+		 */
+		void classify(Span<const FlowKey> flows, Span<size_t> rules) const noexcept;
+
+		NODISCARD const std::vector<PacketRule>& getRules() const noexcept { return mRules; }
+		/*
+		 * @return number of tree nodes and of rule references in the leaves of both versions, to judge the memory use.
+		 */
+		NODISCARD size_t getNodeCount() const noexcept { return mTreeV4.nodes.size() + mTreeV6.nodes.size(); }
+		NODISCARD size_t getLeafEntryCount() const noexcept { return mTreeV4.leaves.size() + mTreeV6.leaves.size(); }
+	private:
+		/* source address, destination address, source port, destination port, protocol */
+		static constexpr size_t kFields = 5;
+
+		template <typename Key>
+		using Point = std::array<Key, kFields>;
+
+		template <typename Key>
+		struct Tree
+		{
+			struct Node
+			{
+				/* inner node: values up to split go to nodes[child], the others to nodes[child + 1],
+				 * leaf: leaves[child] to leaves[child + count] */
+				Key split;
+				uint32_t child;
+				uint32_t count;
+				/* kFields for a leaf */
+				uint8_t field;
+			};
+
+			/* rule as first value and span of each field, see details::isInRange */
+			struct Entry
+			{
+				Point<Key> first;
+				Point<Key> span;
+				uint32_t rule;
+			};
+
+			std::vector<Node> nodes;
+			/* the rules of this version in priority order */
+			std::vector<Entry> entries;
+			/* indices into entries, ascending in each leaf */
+			std::vector<uint32_t> leaves;
+		};
+
+		/* inclusive ranges of a rule or of the region of a node */
+		template <typename Key>
+		struct Box
+		{
+			Point<Key> first;
+			Point<Key> last;
+			uint32_t rule;
+		};
+
+		/*
+		 * @param boxes the rules in priority order
+		 */
+		template <typename Key>
+		static void build(Tree<Key>& tree, const std::vector<Box<Key>>& boxes, size_t leafSize);
+		/*
+		 * @param rules indices into boxes of the rules overlapping region, ascending
+		 */
+		template <typename Key>
+		static void build(Tree<Key>& tree, const std::vector<Box<Key>>& boxes, size_t node,
+		                  std::vector<uint32_t> rules, const Box<Key>& region, size_t leafSize, size_t depth);
+		static Point<uint32_t> getPointV4(const FlowKey& flow) noexcept;
+		static Point<details::Uint128> getPointV6(const FlowKey& flow) noexcept;
+		template <typename Key>
+		static size_t classify(const Tree<Key>& tree, const Point<Key>& point) noexcept;
+		template <typename Key>
+		static void classify(const Tree<Key>& tree, const Point<Key>* points, size_t count, size_t* rules) noexcept;
+	private:
+		std::vector<PacketRule> mRules;
+		Tree<uint32_t> mTreeV4;
+		Tree<details::Uint128> mTreeV6;
+	};
+}
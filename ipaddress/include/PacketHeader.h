@@ -0,0 +1,66 @@
+#pragma once
+#include "IPEndPoint.h"
+#include "util/Span.h"
+
+namespace ip_address
+{
+	/*
+	 * Addresses and ports decoded from the start of a raw IPv4 or IPv6 packet (layer 3, no link layer header),
+	 * e.g a frame from an AF_PACKET SOCK_DGRAM socket or a pcap record after its link layer header.
+	 * IPv6 extension headers (hop-by-hop, routing, fragment, destination options, AH, mobility, HIP, shim6)
+	 * are skipped to find the transport protocol. Ports are only decoded for TCP, UDP, UDP-Lite and SCTP
+	 * in the first fragment, otherwise both endpoints have port 0.
+	 * The endpoints are written straight from the on-wire bytes, the packet itself is not copied.
+	 */
+	class PacketHeader final
+	{
+	public:
+		PacketHeader() = default;
+		~PacketHeader() = default;
+		PacketHeader(const PacketHeader& header) noexcept = default;
+		PacketHeader& operator=(const PacketHeader& rhs) noexcept = default;
+	public:
+		/*
+		 * parse the network and transport headers of a raw IP packet.
+		 * ...
+		 * @param header [out] result after parsing, header.getVersion() is kUnknown when it fails
+		 * @param packet [in] first byte of the IP header
+		 * @param size [in] number of captured bytes, may be less than the packet length
+		 * @return true if the IP header was complete, a truncated transport header still returns true without ports
+		 */
+		NODISCARD static bool parsePacketHeader(PacketHeader& header, const uint8_t* packet, size_t size) noexcept;
+		NODISCARD static bool parsePacketHeader(PacketHeader& header, Span<const uint8_t> packet) noexcept;
+		/*
+		 * Decodes count packets, e.g the frames of one block of a TPACKET ring.
+		 * @return number of packets with a complete IP header, the others have getVersion() == kUnknown.
+		 */
+		static size_t parsePacketHeaders(const Span<const uint8_t>* packets, size_t count,
+		                                 PacketHeader* headers) noexcept;
+	public:
+		NODISCARD IPVersion getVersion() const noexcept { return mSource.getVersion(); }
+		/* Source address and port (0 if the transport has no ports or was not decoded) */
+		NODISCARD const IPEndPoint& getSource() const noexcept { return mSource; }
+		/* Destination address and port (0 if the transport has no ports or was not decoded) */
+		NODISCARD const IPEndPoint& getDestination() const noexcept { return mDestination; }
+		/* Transport protocol number e.g IPPROTO_TCP, after skipping IPv6 extension headers */
+		NODISCARD uint8_t getProtocol() const noexcept { return mProtocol; }
+		/* Offset of the transport header from the start of the packet */
+		NODISCARD uint16_t getTransportOffset() const noexcept { return mTransportOffset; }
+		/* true if the ports were decoded from a TCP/UDP/UDP-Lite/SCTP header */
+		NODISCARD bool hasPorts() const noexcept { return mHasPorts; }
+		/* true for a fragment that is not the first one, it carries no transport header */
+		NODISCARD bool isLaterFragment() const noexcept { return mLaterFragment; }
+	private:
+		void reset() noexcept;
+		bool parseIPv4(const uint8_t* packet, size_t size) noexcept;
+		bool parseIPv6(const uint8_t* packet, size_t size) noexcept;
+		void parsePorts(const uint8_t* packet, size_t size) noexcept;
+	private:
+		IPEndPoint mSource;
+		IPEndPoint mDestination;
+		uint16_t mTransportOffset = 0;
+		uint8_t mProtocol = 0;
+		bool mHasPorts = false;
+		bool mLaterFragment = false;
+	};
+}
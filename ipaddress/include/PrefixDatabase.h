@@ -0,0 +1,154 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "IPNetwork.h"
+#include "util/AddressKey.h"
+#include "util/Span.h"
+
+namespace ip_address
+{
+	namespace details
+	{
+		/*
+		 * Node of the multibit trie in a PrefixDatabase file, covers 6 bits of the address (Poptrie layout).
+		 */
+		struct PrefixDatabaseNode
+		{
+			/* bit i set if slot i continues in a child node */
+			uint64_t children;
+			/* bit i set if slot i starts a new run of equal leaves */
+			uint64_t leaves;
+			uint32_t childBase;
+			uint32_t leafBase;
+		};
+		static_assert(sizeof(PrefixDatabaseNode) == 24, "node layout is part of the file format");
+	}
+
+	/*
+	 * Read-only longest prefix match table from IPv4 and IPv6 prefixes to string values, used in place from a
+	 * file written by PrefixDatabaseBuilder.
+	 *
+	 * The file holds one multibit trie per family with a stride of 6 bits. A node has two 64-bit maps, one
+	 * for the slots that continue in a child node and one for the slots that start a run of equal leaves, and
+	 * the children and leaves of a node are stored contiguously, so the index of a child or leaf is a base
+	 * plus a popcount. Prefixes are pushed to the leaves when the file is built, a lookup walks at most 6
+	 * (IPv4) or 22 (IPv6) nodes and reads one leaf. Leaves point into a section of deduplicated values.
+	 *
+	 * All references in the file are offsets and indices, nothing is deserialized: opening a file maps it and
+	 * checks the header and section bounds, the pages are faulted in by the lookups that touch them. The
+	 * checksum over the sections is only computed by verify(), which should be called once for files that
+	 * come from untrusted storage since the lookups do not check the trie.
+	 *
+	 * The header, nodes and leaves are stored in the byte order of the host that built the file, so a file is only
+	 * portable between hosts of the same byte order. Values are opaque bytes and are stored as given.
+	 */
+	class PrefixDatabase final
+	{
+	public:
+		/*
+		 * Maps the database file.
+		 * throws std::runtime_error if the file can not be mapped or the header is invalid.
+		 */
+		explicit PrefixDatabase(const std::string& path);
+		/*
+		 * Uses a database that is already in memory, data has to outlive the database.
+		 * throws std::runtime_error if the header is invalid.
+		 */
+		explicit PrefixDatabase(Span<const uint8_t> data);
+		/*
+		 * Takes ownership of a database in memory, e.g. the result of PrefixDatabaseBuilder::build().
+		 * throws std::runtime_error if the header is invalid.
+		 */
+		explicit PrefixDatabase(std::vector<uint8_t> data);
+		~PrefixDatabase();
+		PrefixDatabase(const PrefixDatabase&) = delete;
+		PrefixDatabase& operator=(const PrefixDatabase&) = delete;
+	public:
+		/*
+		 * Finds the value of the longest prefix containing addr.
+		 * @param value [out] the value, it points into the database.
+		 * @param prefixLength [out] optional, length of the matching prefix.
+		 * @return false if no prefix contains addr.
+		 */
+		NODISCARD bool lookup(const IPAddressV4& addr4, std::string_view& value,
+		                      uint8_t* prefixLength = nullptr) const noexcept;
+		NODISCARD bool lookup(const IPAddressV6& addr6, std::string_view& value,
+		                      uint8_t* prefixLength = nullptr) const noexcept;
+		NODISCARD bool lookup(const IPAddress& addr, std::string_view& value,
+		                      uint8_t* prefixLength = nullptr) const noexcept;
+		/*
+		 * Computes the checksum of the file and checks every node and leaf reference.
+		 * @return false if the file is corrupt.
+		 */
+		NODISCARD bool verify() const noexcept;
+
+		NODISCARD size_t getPrefixCountV4() const noexcept { return mPrefixCountV4; }
+		NODISCARD size_t getPrefixCountV6() const noexcept { return mPrefixCountV6; }
+		NODISCARD size_t getSize() const noexcept { return mSize; }
+	private:
+		void load();
+	private:
+		const uint8_t* mData = nullptr;
+		size_t mSize = 0;
+		bool mMapped = false;
+		std::vector<uint8_t> mOwned;
+		const details::PrefixDatabaseNode* mNodesV4 = nullptr;
+		const uint64_t* mLeavesV4 = nullptr;
+		const details::PrefixDatabaseNode* mNodesV6 = nullptr;
+		const uint64_t* mLeavesV6 = nullptr;
+		const char* mValues = nullptr;
+		size_t mPrefixCountV4 = 0;
+		size_t mPrefixCountV6 = 0;
+	};
+
+	/*
+	 * Collects prefix to value entries and writes them as a PrefixDatabase file.
+	 */
+	class PrefixDatabaseBuilder final
+	{
+	public:
+		static constexpr size_t kMaxValueLength = (1 << 24) - 1;
+		/*
+		 * Adds network with value, adding the same network again replaces its value. Equal values are stored once.
+		 * @return false if value is longer than kMaxValueLength.
+		 */
+		bool add(const IPNetwork& network, std::string_view value);
+		/*
+		 * Adds every "prefix value" line, the value is the rest of the line after the prefix and the whitespace
+		 * following it, '#' at the start of a line marks a comment.
+		 * @return number of lines skipped because the prefix is invalid.
+		 */
+		size_t addLines(std::istream& lines);
+		/*
+		 * @return the database file contents.
+		 */
+		NODISCARD std::vector<uint8_t> build() const;
+		/*
+		 * Writes the database file.
+		 * throws std::runtime_error if the file can not be written.
+		 */
+		void write(const std::string& path) const;
+
+		NODISCARD size_t getPrefixCount() const noexcept { return mEntriesV4.size() + mEntriesV6.size(); }
+	private:
+		template <typename Key>
+		struct Entry
+		{
+			Key key;
+			uint8_t prefixLength;
+			/* leaf word of the value, see PrefixDatabase */
+			uint64_t leaf;
+		};
+	private:
+		uint64_t addValue(std::string_view value);
+	private:
+		std::vector<Entry<uint32_t>> mEntriesV4;
+		std::vector<Entry<details::Uint128>> mEntriesV6;
+		std::string mValues;
+		std::unordered_map<std::string, uint32_t> mValueOffsets;
+	};
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include "PrefixDatabase.h"
+#include "util/EpochPointer.h"
+
+namespace ip_address
+{
+	/*
+	 * Longest prefix lookups (IP to ASN, geo or any other string value) over a PrefixDatabase snapshot that is
+	 * replaced in the background while lookups continue.
+	 *
+	 * A reload thread calls the loader on requestReload() and periodically, and publishes the new database with
+	 * an atomic pointer swap. Lookups go through a Reader per thread: a lookup loads the epoch and the pointer
+	 * and reads the database, it never writes shared memory or waits. A replaced database is retired and freed
+	 * by the reload thread once every reader has done a lookup in a newer epoch or gone offline (see
+	 * details::EpochPointer). A failing loader keeps the current database.
+	 */
+	class PrefixLookupService final
+	{
+	public:
+		/*
+		 * Loads a database, may return nullptr to keep the current one (e.g. the source did not change).
+		 */
+		using Loader = std::function<std::unique_ptr<PrefixDatabase>()>;
+
+		/*
+		 * Lookup handle of one thread, lookups through the same reader must not run concurrently.
+		 */
+		class Reader
+		{
+		public:
+			/*
+			 * throws std::runtime_error if there are too many readers.
+			 */
+			explicit Reader(const PrefixLookupService& service) : mReader(service.mSnapshot) { }
+		public:
+			/*
+			 * Finds the value of the longest prefix containing addr in the current database.
+			 * @param value [out] the value, valid until the next lookup() or offline() of this reader.
+			 * @param prefixLength [out] optional, length of the matching prefix.
+			 * @return false if no prefix contains addr.
+			 */
+			NODISCARD bool lookup(const IPAddressV4& addr4, std::string_view& value,
+			                      uint8_t* prefixLength = nullptr) noexcept
+			{
+				return mReader.get()->lookup(addr4, value, prefixLength);
+			}
+			NODISCARD bool lookup(const IPAddressV6& addr6, std::string_view& value,
+			                      uint8_t* prefixLength = nullptr) noexcept
+			{
+				return mReader.get()->lookup(addr6, value, prefixLength);
+			}
+			NODISCARD bool lookup(const IPAddress& addr, std::string_view& value,
+			                      uint8_t* prefixLength = nullptr) noexcept
+			{
+				return mReader.get()->lookup(addr, value, prefixLength);
+			}
+			/*
+			 * Releases the database of the last lookup, an idle reader should call it so old databases can be freed.
+			 */
+			void offline() noexcept { mReader.offline(); }
+		private:
+			details::EpochPointer<PrefixDatabase>::Reader mReader;
+		};
+
+		/*
+		 * Loads the first database on the calling thread and starts the reload thread.
+		 * @param interval time between periodic reloads, 0 to only reload on requestReload().
+		 * throws std::runtime_error if the first load fails or returns nullptr.
+		 */
+		explicit PrefixLookupService(Loader loader, std::chrono::milliseconds interval = std::chrono::milliseconds(0));
+		/*
+		 * All readers have to be destroyed first.
+		 */
+		~PrefixLookupService();
+		PrefixLookupService(const PrefixLookupService&) = delete;
+		PrefixLookupService& operator=(const PrefixLookupService&) = delete;
+	public:
+		/*
+		 * Wakes the reload thread to load a new database, returns without waiting for it.
+		 */
+		void requestReload();
+
+		/*
+		 * @return number of databases published so far, 1 after construction.
+		 */
+		NODISCARD uint64_t getGeneration() const noexcept { return mGeneration.load(std::memory_order_acquire); }
+		NODISCARD uint64_t getFailedReloads() const noexcept { return mFailedReloads.load(std::memory_order_relaxed); }
+		/*
+		 * @return number of replaced databases that still wait for readers.
+		 */
+		NODISCARD size_t getRetiredCount() const noexcept { return mRetiredCount.load(std::memory_order_relaxed); }
+	private:
+		void run();
+		void reload();
+	private:
+		Loader mLoader;
+		std::chrono::milliseconds mInterval;
+		details::EpochPointer<PrefixDatabase> mSnapshot;
+		std::atomic<uint64_t> mGeneration{ 1 };
+		std::atomic<uint64_t> mFailedReloads{ 0 };
+		std::atomic<size_t> mRetiredCount{ 0 };
+		std::mutex mMutex;
+		std::condition_variable mWakeUp;
+		bool mReloadRequested = false;
+		bool mStopping = false;
+		std::thread mThread;
+	};
+}
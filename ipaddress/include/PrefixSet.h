@@ -0,0 +1,258 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include "IPNetwork.h"
+#include "util/AddressKey.h"
+
+namespace ip_address
+{
+	namespace details
+	{
+		/*
+		 * constexpr versions of AddressKey<>::toKey, the compilers turn them into a load and a byte swap.
+		 */
+		constexpr uint32_t toPrefixKey(const IPAddressV4& addr4) noexcept
+		{
+			const ByteArray4& bytes = addr4.bytes();
+			return uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 8 | uint32_t(bytes[3]);
+		}
+
+		constexpr uint64_t toPrefixKey(const ByteArray16& bytes, size_t offset) noexcept
+		{
+			return uint64_t(bytes[offset]) << 56 | uint64_t(bytes[offset + 1]) << 48 | uint64_t(bytes[offset + 2]) << 40 |
+				uint64_t(bytes[offset + 3]) << 32 | uint64_t(bytes[offset + 4]) << 24 | uint64_t(bytes[offset + 5]) << 16 |
+				uint64_t(bytes[offset + 6]) << 8 | uint64_t(bytes[offset + 7]);
+		}
+
+		constexpr Uint128 toPrefixKey(const IPAddressV6& addr6) noexcept
+		{
+			return { toPrefixKey(addr6.bytes(), 0), toPrefixKey(addr6.bytes(), 8) };
+		}
+
+		constexpr uint32_t getPrefixLast(uint32_t first, uint8_t prefixLength) noexcept
+		{
+			return prefixLength == 0 ? UINT32_MAX : prefixLength >= 32 ? first : first | (UINT32_MAX >> prefixLength);
+		}
+
+		constexpr Uint128 getPrefixLast(const Uint128& first, uint8_t prefixLength) noexcept
+		{
+			if (prefixLength < 64)
+				return { prefixLength == 0 ? UINT64_MAX : first.hi | (UINT64_MAX >> prefixLength), UINT64_MAX };
+			if (prefixLength == 64)
+				return { first.hi, UINT64_MAX };
+			return { first.hi, prefixLength >= 128 ? first.lo : first.lo | (UINT64_MAX >> (prefixLength - 64)) };
+		}
+
+		constexpr uint32_t subtract(uint32_t lhs, uint32_t rhs) noexcept { return lhs - rhs; }
+
+		constexpr Uint128 subtract(const Uint128& lhs, const Uint128& rhs) noexcept
+		{
+			return { lhs.hi - rhs.hi - static_cast<uint64_t>(lhs.lo < rhs.lo), lhs.lo - rhs.lo };
+		}
+
+		/*
+		 * Branchless key <= rhs and first <= key <= first + span. The unsigned difference wraps for keys
+		 * below first, so one compare checks both ends of the range.
+		 */
+		constexpr bool lessEqual(uint32_t lhs, uint32_t rhs) noexcept { return lhs <= rhs; }
+
+		constexpr bool lessEqual(const Uint128& lhs, const Uint128& rhs) noexcept
+		{
+			return (lhs.hi < rhs.hi) | ((lhs.hi == rhs.hi) & (lhs.lo <= rhs.lo));
+		}
+
+		constexpr bool isAdjacent(uint32_t last, uint32_t first) noexcept { return first - last == 1; }
+
+		constexpr bool isAdjacent(const Uint128& last, const Uint128& first) noexcept
+		{
+			return subtract(first, last) == Uint128{ 0, 1 };
+		}
+
+		template <typename Key>
+		constexpr bool isInRange(const Key& key, const Key& first, const Key& span) noexcept
+		{
+			return lessEqual(subtract(key, first), span);
+		}
+
+		template <typename Key>
+		struct PrefixRange
+		{
+			Key mFirst;
+			Key mLast;
+		};
+
+		/*
+		 * Disjoint and not adjacent ranges covering the networks of one version, sorted by address.
+		 */
+		template <typename Key, size_t Size>
+		struct PrefixRanges
+		{
+			std::array<PrefixRange<Key>, Size> mRanges = {};
+			size_t mCount = 0;
+		};
+
+		template <typename Key, size_t Size>
+		constexpr PrefixRanges<Key, Size> mergePrefixRanges(const IPNetwork (&networks)[Size], IPVersion version) noexcept
+		{
+			PrefixRanges<Key, Size> sorted;
+			for (size_t i = 0; i < Size; i++)
+			{
+				const IPNetwork& network = networks[i];
+				if (network.getVersion() != version)
+					continue;
+				Key first = {};
+				if constexpr (sizeof(Key) == sizeof(uint32_t))
+					first = toPrefixKey(network.getAddress().getIPv4());
+				else
+					first = toPrefixKey(network.getAddress().getIPv6());
+				//insertion sort, the lists are written by hand and short
+				size_t j = sorted.mCount++;
+				for (; j > 0 && first < sorted.mRanges[j - 1].mFirst; j--)
+				{
+					sorted.mRanges[j] = sorted.mRanges[j - 1];
+				}
+				sorted.mRanges[j] = { first, getPrefixLast(first, network.getPrefixLength()) };
+			}
+			PrefixRanges<Key, Size> merged;
+			for (size_t i = 0; i < sorted.mCount; i++)
+			{
+				const PrefixRange<Key>& range = sorted.mRanges[i];
+				PrefixRange<Key>& last = merged.mRanges[merged.mCount == 0 ? 0 : merged.mCount - 1];
+				//overlapping or adjacent, e.g 10.0.0.0/9 and 10.128.0.0/9 become 10.0.0.0/8
+				if (merged.mCount != 0 && (!(last.mLast < range.mFirst) || isAdjacent(last.mLast, range.mFirst)))
+				{
+					if (last.mLast < range.mLast)
+						last.mLast = range.mLast;
+				}
+				else
+				{
+					merged.mRanges[merged.mCount++] = range;
+				}
+			}
+			return merged;
+		}
+
+		/*
+		 * The linear search pads the ranges to whole vectors.
+		 */
+		constexpr size_t getPaddedCount(size_t count, size_t linear, size_t vector) noexcept
+		{
+			return count <= linear ? (count + vector - 1) / vector * vector : count;
+		}
+	}
+
+	/*
+	 * Set of IPv4 and IPv6 networks built by the compiler, for static allow and deny lists e.g
+	 *	using namespace ip_address::literals;
+	 *	static constexpr IPNetwork kPrivate[] = { "10.0.0.0/8"_net, "172.16.0.0/12"_net, "192.168.0.0/16"_net,
+	 *		"fc00::/7"_net };
+	 *	constexpr auto kPrivateSet = makePrefixSet<kPrivate>();
+	 *	static_assert(kPrivateSet.contains("172.20.0.1"_ipv4) && kPrivateSet.kCountV4 == 3, "");
+	 * The networks are sorted and merged into disjoint address ranges, their number is part of the type so a
+	 * list that grows by mistake can be caught with a static_assert. Up to kLinearV4/kLinearV6 ranges contains()
+	 * compares the address with every range without branches, which the compiler turns into a few vector
+	 * compares, longer lists use a branchless binary search. Use PrefixDatabase or LogFilter for lists that are
+	 * only known at runtime.
+	 */
+	template <size_t CountV4, size_t CountV6>
+	class PrefixSet final
+	{
+	public:
+		static constexpr size_t kCountV4 = CountV4;
+		static constexpr size_t kCountV6 = CountV6;
+		static constexpr size_t kLinearV4 = 16;
+		static constexpr size_t kLinearV6 = 8;
+
+		template <size_t Size>
+		constexpr PrefixSet(const details::PrefixRanges<uint32_t, Size>& rangesV4,
+		                    const details::PrefixRanges<details::Uint128, Size>& rangesV6) noexcept
+		{
+			for (size_t i = 0; i < kPaddedV4; i++)
+			{
+				//copies of the last range pad the linear search
+				const details::PrefixRange<uint32_t>& range = rangesV4.mRanges[i < CountV4 ? i : CountV4 - 1];
+				mFirstV4[i] = range.mFirst;
+				mSpanV4[i] = range.mLast - range.mFirst;
+			}
+			for (size_t i = 0; i < kPaddedV6; i++)
+			{
+				const details::PrefixRange<details::Uint128>& range = rangesV6.mRanges[i < CountV6 ? i : CountV6 - 1];
+				mFirstV6[i] = range.mFirst;
+				mSpanV6[i] = details::subtract(range.mLast, range.mFirst);
+			}
+		}
+
+		NODISCARD constexpr bool contains(const IPAddressV4& addr4) const noexcept
+		{
+			return find<CountV4, kLinearV4>(mFirstV4, mSpanV4, details::toPrefixKey(addr4));
+		}
+
+		NODISCARD constexpr bool contains(const IPAddressV6& addr6) const noexcept
+		{
+			return find<CountV6, kLinearV6>(mFirstV6, mSpanV6, details::toPrefixKey(addr6));
+		}
+
+		NODISCARD constexpr bool contains(const IPAddress& addr) const noexcept
+		{
+			if (addr.isIPv4())
+				return contains(addr.getIPv4());
+			return addr.isIPv6() && contains(addr.getIPv6());
+		}
+		/*
+		* @return the number of disjoint ranges, at most the number of networks the set was built from.
+		*/
+		NODISCARD static constexpr size_t getSize() noexcept { return CountV4 + CountV6; }
+	private:
+		static constexpr size_t kPaddedV4 = details::getPaddedCount(CountV4, kLinearV4, 8);
+		static constexpr size_t kPaddedV6 = details::getPaddedCount(CountV6, kLinearV6, 2);
+
+		template <size_t Count, size_t Linear, typename Key, size_t Padded>
+		static constexpr bool find(const std::array<Key, Padded>& first, const std::array<Key, Padded>& span,
+		                           const Key& key) noexcept
+		{
+			if constexpr (Count == 0)
+			{
+				return false;
+			}
+			else if constexpr (Count <= Linear)
+			{
+				unsigned found = 0;
+				for (size_t i = 0; i < Padded; i++)
+				{
+					found |= static_cast<unsigned>(details::isInRange(key, first[i], span[i]));
+				}
+				return found != 0;
+			}
+			else
+			{
+				//last range that starts at or before key, a key before the first range is not in its span either
+				size_t index = 0;
+				for (size_t length = Count; length > 1; length -= length / 2)
+				{
+					index = details::lessEqual(first[index + length / 2], key) ? index + length / 2 : index;
+				}
+				return details::isInRange(key, first[index], span[index]);
+			}
+		}
+
+		std::array<uint32_t, kPaddedV4> mFirstV4 = {};
+		std::array<uint32_t, kPaddedV4> mSpanV4 = {};
+		std::array<details::Uint128, kPaddedV6> mFirstV6 = {};
+		std::array<details::Uint128, kPaddedV6> mSpanV6 = {};
+	};
+
+	/*
+	 * @tparam Networks array of IPNetwork with static storage duration, e.g network literals.
+	 * @return PrefixSet of the networks, evaluated at compile time when assigned to a constexpr variable.
+	 */
+	template <const auto& Networks>
+	constexpr auto makePrefixSet() noexcept
+	{
+		constexpr auto rangesV4 = details::mergePrefixRanges<uint32_t>(Networks, IPVersion::kIPv4);
+		constexpr auto rangesV6 = details::mergePrefixRanges<details::Uint128>(Networks, IPVersion::kIPv6);
+		static_assert(rangesV4.mCount + rangesV6.mCount <= std::size(Networks), "merging never adds ranges");
+		return PrefixSet<rangesV4.mCount, rangesV6.mCount>(rangesV4, rangesV6);
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "IPAddress.h"
+
+namespace ip_address
+{
+	/*
+	 * Token bucket rate limiter table keyed by IPAddress, every client (or every client prefix) owns one bucket.
+	 *
+	 * A bucket is a single 64-bit word holding the theoretical arrival time (GCRA), the point in time at which
+	 * the bucket is full again. The token count and the last refill timestamp are both encoded in that value
+	 * (tokens = (now + burst * interval - word) / interval) so one compare-and-swap updates them together.
+	 *
+	 * Buckets live in a fixed size table of 64 byte aligned sets with kWays entries each, a key always maps
+	 * to one set so a lookup touches one cache line and the memory use never grows after construction.
+	 * When a set is full the most idle bucket is recycled. Buckets that are full again carry no state and are
+	 * removed by evictIdle(), which can run on a background thread with startEviction().
+	 *
+	 * Keys are stored as seeded 64-bit fingerprints of the (truncated) address, two clients share a bucket only
+	 * when their fingerprints collide. All methods except the constructor and destructor are thread safe.
+	 */
+	class RateLimiter final
+	{
+	public:
+		static constexpr size_t kWays = 4;
+		/*
+		 * @param ratePerSecond tokens added to a bucket per second.
+		 * @param burst maximum tokens in a bucket, also the number of requests a new client may send at once.
+		 * @param capacity maximum number of buckets, rounded up to a power of two.
+		 * @param prefixLengthV4 IPv4 addresses are truncated to this prefix before lookup e.g 24 for one bucket per /24.
+		 * @param prefixLengthV6 IPv6 addresses are truncated to this prefix before lookup e.g 64 for one bucket per /64.
+		 */
+		RateLimiter(double ratePerSecond, uint32_t burst, size_t capacity, uint8_t prefixLengthV4 = 32,
+		            uint8_t prefixLengthV6 = 128);
+		~RateLimiter();
+		RateLimiter(const RateLimiter&) = delete;
+		RateLimiter& operator=(const RateLimiter&) = delete;
+	public:
+		/*
+		 * Takes cost tokens from the bucket of addr.
+		 * @param now monotonic time in nanoseconds, see getTime().
+		 * @return true if the bucket held enough tokens and the request is admitted.
+		 */
+		NODISCARD bool admit(const IPAddress& addr, uint64_t now, uint32_t cost = 1) noexcept;
+		NODISCARD bool admit(const IPAddressV4& addr4, uint64_t now, uint32_t cost = 1) noexcept;
+		NODISCARD bool admit(const IPAddressV6& addr6, uint64_t now, uint32_t cost = 1) noexcept;
+		/*
+		 * Same as admit(addr, getTime(), cost)
+		 */
+		NODISCARD bool admit(const IPAddress& addr) noexcept;
+		/*
+		 * @return the tokens left in the bucket of addr at time now, burst if addr has no bucket.
+		 */
+		NODISCARD uint32_t getTokens(const IPAddress& addr, uint64_t now) const noexcept;
+		/*
+		 * Removes every bucket that has been refilled completely at time now.
+		 * @return number of removed buckets.
+		 */
+		size_t evictIdle(uint64_t now) noexcept;
+		/*
+		 * Starts a background thread calling evictIdle() every interval, stopped by stopEviction() or the destructor.
+		 */
+		void startEviction(std::chrono::milliseconds interval);
+
+		void stopEviction();
+		/*
+		 * @return number of buckets in use, walks the whole table.
+		 */
+		NODISCARD size_t size() const noexcept;
+
+		NODISCARD size_t capacity() const noexcept;
+		/*
+		 * @return number of times a bucket that was not full yet had to be recycled because its set was full.
+		 */
+		NODISCARD uint64_t getOverflowCount() const noexcept;
+		/*
+		 * @return steady clock time in nanoseconds.
+		 */
+		NODISCARD static uint64_t getTime() noexcept;
+	private:
+		struct Entry
+		{
+			std::atomic<uint64_t> mKey;
+			std::atomic<uint64_t> mState;
+		};
+
+		struct alignas(64) Set
+		{
+			Entry mEntries[kWays];
+		};
+
+		static_assert(sizeof(Set) == 64, "a set must fill exactly one cache line");
+
+		uint64_t fingerprint(const IPAddressV4& addr4) const noexcept;
+		uint64_t fingerprint(const IPAddressV6& addr6) const noexcept;
+		bool admitKey(uint64_t key, uint64_t now, uint32_t cost) noexcept;
+		bool evict(Entry& entry, uint64_t state) noexcept;
+
+		std::unique_ptr<Set[]> mSets;
+		size_t mSetMask;
+		uint64_t mInterval;
+		uint64_t mBurstTolerance;
+		uint8_t mPrefixLengthV4;
+		uint8_t mPrefixLengthV6;
+		uint64_t mSeed;
+		std::atomic<uint64_t> mOverflowCount{ 0 };
+
+		std::thread mEvictionThread;
+		std::mutex mEvictionMutex;
+		std::condition_variable mEvictionCondition;
+		bool mEvictionStop = false;
+	};
+}
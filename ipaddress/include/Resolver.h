@@ -0,0 +1,180 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "IPEndPoint.h"
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+#define IPADDRESS_HAS_COROUTINES 1
+#endif
+
+namespace ip_address
+{
+	enum class ResolveStatus : uint8_t
+	{
+		kOk,
+		//NXDOMAIN or no address of the requested family, cached for the negative TTL
+		kNotFound,
+		//no name server answered within the timeout on any attempt
+		kTimeout,
+		//no name server gave an answer and at least one replied with an error
+		kServerFailure
+	};
+
+	/*
+	 * Asynchronous DNS resolver for A and AAAA records, the non-blocking alternative to the host name fallback of
+	 * the IPAddress, IPAddressV4 and IPEndPoint string constructors which call getaddrinfo on the calling thread.
+	 *
+	 * Queries go over UDP straight to the configured name servers (/etc/resolv.conf by default) from a small pool of
+	 * worker threads, every attempt is bounded by a timeout. Answers are kept in a cache split into shards with their
+	 * own lock, entries expire after the smallest TTL of the answer records (clamped to maxTtl), NXDOMAIN and empty
+	 * answers are cached for the SOA minimum TTL (clamped to negativeTtl). Concurrent requests for a name that is
+	 * already being resolved wait for that query instead of sending another one.
+	 *
+	 * Numeric addresses complete immediately without a query. /etc/hosts is not consulted.
+	 * Callbacks run on a worker thread, or on the calling thread when the answer is cached.
+	 */
+	class Resolver final
+	{
+	public:
+		enum class Family : uint8_t
+		{
+			kAny,
+			kIPv4,
+			kIPv6
+		};
+
+		struct Options
+		{
+			//empty means the name servers of /etc/resolv.conf, 127.0.0.1:53 if there are none
+			std::vector<IPEndPoint> nameServers;
+			Family family = Family::kAny;
+			std::chrono::milliseconds timeout{ 1000 };
+			//attempts per name server
+			uint32_t attempts = 2;
+			uint32_t threads = 2;
+			uint32_t shards = 16;
+			//maximum cached names per shard
+			size_t shardCapacity = 4096;
+			std::chrono::seconds maxTtl{ 3600 };
+			std::chrono::seconds negativeTtl{ 30 };
+		};
+
+		using Callback = std::function<void(ResolveStatus status, const std::vector<IPAddress>& addresses)>;
+
+		Resolver();
+		explicit Resolver(Options options);
+		//stops the workers, callbacks of requests that are still queued are called with kTimeout
+		~Resolver();
+		Resolver(const Resolver&) = delete;
+		Resolver& operator=(const Resolver&) = delete;
+	public:
+		/*
+		 * Resolves name and calls callback exactly once with the result.
+		 */
+		void resolve(const std::string& name, Callback callback);
+		/*
+		 * @return a future of the addresses of name, empty for kNotFound.
+		 * The future holds a std::runtime_error for kTimeout and kServerFailure.
+		 */
+		NODISCARD std::future<std::vector<IPAddress>> resolve(const std::string& name);
+		/*
+		 * Looks name up in the cache only, never blocks on the network.
+		 * @param addresses [out] cached addresses, empty for a cached kNotFound.
+		 * @return false if name is not cached or expired.
+		 */
+		NODISCARD bool lookupCached(const std::string& name, std::vector<IPAddress>& addresses) const;
+		/*
+		 * Drops every cached name.
+		 */
+		void clearCache();
+		/*
+		 * @return number of queries sent to name servers, including retries.
+		 */
+		NODISCARD uint64_t getQueryCount() const noexcept { return mQueryCount.load(std::memory_order_relaxed); }
+
+#ifdef IPADDRESS_HAS_COROUTINES
+		/*
+		 * co_await resolver.resolveAsync(name) suspends until the addresses are known, errors are thrown as in the
+		 * future. The coroutine resumes on a worker thread unless the answer was cached.
+		 */
+		struct ResolveAwaiter
+		{
+			Resolver& resolver;
+			std::string name;
+			ResolveStatus status = ResolveStatus::kOk;
+			std::vector<IPAddress> addresses;
+
+			bool await_ready()
+			{
+				return resolver.lookupCached(name, addresses);
+			}
+			void await_suspend(std::coroutine_handle<> handle)
+			{
+				resolver.resolve(name, [this, handle](ResolveStatus result, const std::vector<IPAddress>& found)
+				{
+					status = result;
+					addresses = found;
+					handle.resume();
+				});
+			}
+			std::vector<IPAddress> await_resume()
+			{
+				if (status == ResolveStatus::kTimeout || status == ResolveStatus::kServerFailure)
+					throw std::runtime_error("Can not resolve " + name);
+				return std::move(addresses);
+			}
+		};
+		NODISCARD ResolveAwaiter resolveAsync(std::string name) { return ResolveAwaiter{ *this, std::move(name) }; }
+#endif
+	private:
+		struct CacheEntry
+		{
+			std::vector<IPAddress> addresses;
+			std::chrono::steady_clock::time_point expiry;
+			ResolveStatus status;
+		};
+
+		struct alignas(64) Shard
+		{
+			mutable std::mutex mutex;
+			std::unordered_map<std::string, CacheEntry> entries;
+			//callbacks waiting for a query in flight
+			std::unordered_map<std::string, std::vector<Callback>> pending;
+		};
+
+		struct Answer
+		{
+			ResolveStatus status = ResolveStatus::kServerFailure;
+			std::vector<IPAddress> addresses;
+			uint32_t ttl = 0;
+		};
+	private:
+		NODISCARD Shard& getShard(const std::string& name) const noexcept;
+		void runWorker();
+		void complete(const std::string& name, const Answer& answer);
+		NODISCARD Answer query(const std::string& name);
+		NODISCARD Answer query(const IPEndPoint& server, const std::string& name);
+	private:
+		Options mOptions;
+		std::unique_ptr<Shard[]> mShards;
+		std::atomic<uint64_t> mQueryCount{ 0 };
+		std::mutex mQueueMutex;
+		std::condition_variable mQueueCondition;
+		std::deque<std::string> mQueue;
+		bool mStopping = false;
+		std::vector<std::thread> mWorkers;
+	};
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include "IPAddress.h"
+#include "util/Span.h"
+
+namespace ip_address
+{
+	/* longest in-addr.arpa name without the terminating null e.g 255.255.255.255.in-addr.arpa */
+	constexpr size_t kMaxReverseNameLengthV4 = 28;
+	/* ip6.arpa names are always 32 nibble labels and the suffix */
+	constexpr size_t kMaxReverseNameLengthV6 = 72;
+
+	/*
+	 * Writes the PTR query name of an address, 1.2.0.192.in-addr.arpa for 192.0.2.1 and
+	 * b.a.9.8.7.6.5.0.4.0.0.0.3.0.0.0.2.0.0.0.1.0.0.0.0.0.0.0.1.2.3.4.ip6.arpa for 4321:0:1:2:3:4:567:89ab.
+	 * Octets and nibbles come from lookup tables, nothing is allocated.
+	 * @param buffer [out] receives the name and a terminating null, needs kMaxReverseNameLength* + 1 bytes.
+	 * @return length of the name without the terminating null, 0 for an IPAddress of unknown version.
+	 */
+	size_t to_reverse_name(const IPAddressV4& addr4, char* buffer) noexcept;
+	size_t to_reverse_name(const IPAddressV6& addr6, char* buffer) noexcept;
+	size_t to_reverse_name(const IPAddress& addr, char* buffer) noexcept;
+
+	/*
+	 * Writes the names of all addresses back to back into buffer, each followed by a null.
+	 * @param buffer [out] needs addresses.size() * (kMaxReverseNameLength* + 1) bytes.
+	 * @param offsets [out] start of every name in buffer, needs addresses.size() entries.
+	 * @return bytes written to buffer.
+	 */
+	size_t to_reverse_names(Span<const IPAddressV4> addresses, char* buffer, uint32_t* offsets) noexcept;
+	size_t to_reverse_names(Span<const IPAddressV6> addresses, char* buffer, uint32_t* offsets) noexcept;
+
+	/*
+	 * Parses a complete PTR query name, the suffix is matched case-insensitively and a trailing dot is allowed.
+	 * Classless delegation names and partial names (fewer than 4 octets or 32 nibbles) are rejected.
+	 * The IPAddress overload accepts both forms.
+	 * @param addr [out] the address the name points to.
+	 * @return true if name is a valid reverse name of that family.
+	 */
+	NODISCARD bool from_reverse_name(std::string_view name, IPAddressV4& addr4) noexcept;
+	NODISCARD bool from_reverse_name(std::string_view name, IPAddressV6& addr6) noexcept;
+	NODISCARD bool from_reverse_name(std::string_view name, IPAddress& addr) noexcept;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "IPEndPoint.h"
+
+namespace ip_address
+{
+	/*
+	 * Non-owning view over a socket address filled in by the kernel, e.g by accept(), recvfrom() or getsockname().
+	 * The family, port and address are read in place so checks and comparisons need no copy, an IPEndPoint is only
+	 * built when it is asked for. The viewed memory must outlive the view.
+	 *
+	 *	sockaddr_storage storage;
+	 *	socklen_t length = sizeof(storage);
+	 *	const int fd = accept(listener, reinterpret_cast<sockaddr*>(&storage), &length);
+	 *	const SockaddrView peer(storage, length);
+	 *	if (peer.isValid() && peer == allowed) { ... }
+	 */
+	class SockaddrView final
+	{
+	public:
+		SockaddrView() noexcept = default;
+		SockaddrView(const sockaddr* addr, socklen_t addrLength) noexcept : mAddr(addr), mLength(addrLength) { }
+		SockaddrView(const sockaddr_storage& storage, socklen_t addrLength) noexcept :
+			mAddr(reinterpret_cast<const sockaddr*>(&storage)), mLength(addrLength) { }
+		explicit SockaddrView(const sockaddr_in& addr4) noexcept :
+			mAddr(reinterpret_cast<const sockaddr*>(&addr4)), mLength(sizeof(addr4)) { }
+		explicit SockaddrView(const sockaddr_in6& addr6) noexcept :
+			mAddr(reinterpret_cast<const sockaddr*>(&addr6)), mLength(sizeof(addr6)) { }
+	public:
+		/*
+		 * Compares address family, address and port against the endpoint without converting the view.
+		 */
+		bool operator==(const IPEndPoint& rhs) const noexcept;
+		bool operator!=(const IPEndPoint& rhs) const noexcept;
+	public:
+		/*
+		 * @return true if the view holds an AF_INET or AF_INET6 address and is long enough for its family.
+		 */
+		NODISCARD bool isValid() const noexcept;
+		/*
+		 * @return kIPv4 or kIPv6, kUnknown if the view is not valid.
+		 */
+		NODISCARD IPVersion getVersion() const noexcept;
+		/* Port in host byte order, the view must be valid */
+		NODISCARD port_host_byte_order_t getPort() const noexcept;
+		/* Port in network byte order, the view must be valid */
+		NODISCARD port_network_byte_order_t getPortNetworkByteOrder() const noexcept;
+		/*
+		 * @return a copy of the address, IPVersion::kUnknown if the view is not valid.
+		 */
+		NODISCARD IPAddress getIPAddress() const noexcept;
+		/*
+		 * @return the viewed address as an endpoint, IPVersion::kUnknown if the view is not valid.
+		 */
+		NODISCARD IPEndPoint toEndPoint() const noexcept;
+		/*
+		 * Pointer and length to hand back to the kernel e.g sendto(fd, buf, len, 0, view.data(), view.size()).
+		 */
+		NODISCARD const sockaddr* data() const noexcept { return mAddr; }
+		NODISCARD socklen_t size() const noexcept { return mLength; }
+	private:
+		const sockaddr* mAddr = nullptr;
+		socklen_t mLength = 0;
+	};
+}
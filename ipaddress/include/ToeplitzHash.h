@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "FlowKey.h"
+#include "util/Span.h"
+
+namespace ip_address
+{
+	/*
+	 * Microsoft Toeplitz hash as computed by NICs for receive side scaling (RSS).
+	 *
+	 * For every set bit of the input the 32-bit window of the secret key starting at that bit is XORed into
+	 * the result. The windows are precomputed per input byte position and byte value, so hashing costs one
+	 * table lookup and XOR per input byte. With the same key and fields the result is bit for bit what the
+	 * NIC reports and the shard is indirectionTable[hash % tableSize], exactly as the NIC picks its queue.
+	 *
+	 * The symmetric key (0x6d5a repeated, Woo and Park) gives the same hash for both directions of a flow
+	 * because swapping source and destination moves bits by multiples of 16.
+	 */
+	class ToeplitzHash final
+	{
+	public:
+		/* The key shipped as the default by Microsoft and most NIC drivers */
+		static const std::array<uint8_t, 40> kMicrosoftKey;
+		/* 0x6d5a repeated, hash(a -> b) == hash(b -> a) */
+		static const std::array<uint8_t, 40> kSymmetricKey;
+
+		/*
+		 * @param key secret key as programmed into the NIC, at least 40 bytes are used (missing bytes count as 0)
+		 * @param includePorts hash the ports of TCP and UDP flows, other protocols always hash addresses only.
+		 * This matches NICs configured for 4-tuple TCP/UDP hashing, pass false for 2-tuple hashing.
+		 */
+		explicit ToeplitzHash(Span<const uint8_t> key, bool includePorts = true) noexcept;
+		explicit ToeplitzHash(const std::array<uint8_t, 40>& key = kMicrosoftKey, bool includePorts = true) noexcept;
+		/* ToeplitzHash(kSymmetricKey, includePorts) */
+		static ToeplitzHash symmetric(bool includePorts = true) noexcept;
+	public:
+		/*
+		 * Hashes size bytes of input, size must not exceed FlowKey::kMaxHashInputSize.
+		 */
+		NODISCARD uint32_t hash(const uint8_t* input, size_t size) const noexcept;
+		NODISCARD uint32_t hash(const FlowKey& key) const noexcept;
+		/*
+		 * Hashes every key, hashes must have room for keys.size() values.
+		 */
+		void hash(Span<const FlowKey> keys, uint32_t* hashes) const noexcept;
+		/*
+		 * Bit by bit reference implementation straight from the RSS specification, used to verify the tables.
+		 */
+		NODISCARD static uint32_t hashReference(Span<const uint8_t> key, const uint8_t* input, size_t size) noexcept;
+	private:
+		NODISCARD bool hashesPorts(const FlowKey& key) const noexcept;
+		template <size_t Size>
+		NODISCARD uint32_t hashFixed(const uint8_t* input) const noexcept;
+	private:
+		//mTable[i][v] = XOR of the key windows of the bits set in v when v is input byte i
+		std::array<std::array<uint32_t, 256>, FlowKey::kMaxHashInputSize> mTable;
+		bool mIncludePorts;
+	};
+}
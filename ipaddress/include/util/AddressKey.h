@@ -0,0 +1,118 @@
+#pragma once
+#include <cstdint>
+#include "IPAddressV4.h"
+#include "IPAddressV6.h"
+#include "Endianness.h"
+
+namespace ip_address
+{
+	namespace details
+	{
+		/*
+		 * 128-bit integer in host byte order, hi holds the first 8 on-wire bytes of an IPv6 address.
+		 */
+		struct Uint128
+		{
+			uint64_t hi;
+			uint64_t lo;
+
+			constexpr bool operator==(const Uint128& rhs) const noexcept { return hi == rhs.hi && lo == rhs.lo; }
+			constexpr bool operator!=(const Uint128& rhs) const noexcept { return !(*this == rhs); }
+			constexpr bool operator<(const Uint128& rhs) const noexcept { return hi < rhs.hi || (hi == rhs.hi && lo < rhs.lo); }
+		};
+
+		/*
+		 * splitmix64 finalizer, cheap and good enough to spread address bits over a power of two table.
+		 */
+		constexpr uint64_t mix64(uint64_t x) noexcept
+		{
+			x ^= x >> 30;
+			x *= 0xBF58476D1CE4E5B9ULL;
+			x ^= x >> 27;
+			x *= 0x94D049BB133111EBULL;
+			x ^= x >> 31;
+			return x;
+		}
+
+		/*
+		 * Maps an address family onto an integer key that can be masked to a prefix length with shifts,
+		 * used by containers that work on prefixes instead of full IPAddressV4/IPAddressV6 objects.
+		 */
+		template <typename Address>
+		struct AddressKey;
+
+		template <>
+		struct AddressKey<IPAddressV4>
+		{
+			using Key = uint32_t;
+			static constexpr uint8_t kBits = 32;
+			static constexpr uint8_t kDefaultMinPrefixLength = 8;
+
+			static Key toKey(const IPAddressV4& addr4) noexcept
+			{
+				return NetToHost32(addr4.getOnWireAddress().s_addr);
+			}
+
+			static IPAddressV4 toAddress(Key key) noexcept
+			{
+				in_addr addr = {};
+				addr.s_addr = HostToNet32(key);
+				return IPAddressV4(addr);
+			}
+
+			static Key truncate(Key key, uint8_t prefixLength) noexcept
+			{
+				return prefixLength == 0 ? 0 : key & (~Key(0) << (kBits - prefixLength));
+			}
+
+			static uint64_t hash(Key key) noexcept
+			{
+				return mix64(key);
+			}
+		};
+
+		template <>
+		struct AddressKey<IPAddressV6>
+		{
+			using Key = Uint128;
+			static constexpr uint8_t kBits = 128;
+			static constexpr uint8_t kDefaultMinPrefixLength = 16;
+
+			static Key toKey(const IPAddressV6& addr6) noexcept
+			{
+				const in6_addr addr = addr6.getOnWireAddress();
+				uint64_t hi;
+				uint64_t lo;
+				memcpy(&hi, &addr.s6_addr[0], sizeof(hi));
+				memcpy(&lo, &addr.s6_addr[8], sizeof(lo));
+				return Key{ NetToHost64(hi), NetToHost64(lo) };
+			}
+
+			static IPAddressV6 toAddress(const Key& key) noexcept
+			{
+				in6_addr addr = {};
+				const uint64_t hi = HostToNet64(key.hi);
+				const uint64_t lo = HostToNet64(key.lo);
+				memcpy(&addr.s6_addr[0], &hi, sizeof(hi));
+				memcpy(&addr.s6_addr[8], &lo, sizeof(lo));
+				return IPAddressV6(addr);
+			}
+
+			static Key truncate(const Key& key, uint8_t prefixLength) noexcept
+			{
+				if (prefixLength == 0)
+					return Key{ 0, 0 };
+				if (prefixLength <= 64)
+					return Key{ key.hi & (~uint64_t(0) << (64 - prefixLength)), 0 };
+				if (prefixLength == 128)
+					return key;
+				return Key{ key.hi, key.lo & (~uint64_t(0) << (128 - prefixLength)) };
+			}
+
+			static uint64_t hash(const Key& key) noexcept
+			{
+				return mix64(key.hi ^ mix64(key.lo));
+			}
+		};
+	}
+}
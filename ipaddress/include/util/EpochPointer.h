@@ -0,0 +1,178 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace ip_address
+{
+	namespace details
+	{
+		/*
+		 * Pointer to an immutable snapshot for readers that can not afford any shared writes, reclaimed with
+		 * quiescent state based epochs (QSBR).
+		 *
+		 * Every reading thread owns a Reader, which holds a slot with the last epoch the thread has seen. Calling
+		 * Reader::get() is a quiescent point: the thread promises that it no longer uses snapshots returned by
+		 * earlier calls. get() loads the global epoch and the pointer, and only writes its own slot when the epoch
+		 * has changed, so in steady state a read is two plain loads and no cache line is shared for writing.
+		 *
+		 * update() swaps the pointer, advances the epoch and retires the previous snapshot tagged with the new
+		 * epoch. A retired snapshot is destroyed by reclaim() once every slot has seen its epoch or is offline,
+		 * update() and reclaim() never wait for readers. A reader that stops reading for a while should go
+		 * offline(), otherwise it holds back reclamation.
+		 */
+		template <typename T>
+		class EpochPointer
+		{
+		public:
+			static constexpr uint32_t kMaxReaders = 256;
+
+			class Reader
+			{
+			public:
+				/*
+				 * Claims a reader slot, starts offline.
+				 * throws std::runtime_error if all kMaxReaders slots are in use.
+				 */
+				explicit Reader(const EpochPointer& owner) : mOwner(&owner)
+				{
+					for (Slot& slot : owner.mSlots)
+					{
+						uint64_t expected = kFree;
+						if (slot.mEpoch.compare_exchange_strong(expected, kOffline, std::memory_order_acq_rel))
+						{
+							mSlot = &slot.mEpoch;
+							return;
+						}
+					}
+					throw std::runtime_error("too many epoch readers");
+				}
+				~Reader() { mSlot->store(kFree, std::memory_order_release); }
+				Reader(const Reader&) = delete;
+				Reader& operator=(const Reader&) = delete;
+
+				/*
+				 * Releases the snapshots returned by earlier calls and returns the current one, which stays alive
+				 * until the next call of get() or offline() on this reader.
+				 */
+				const T* get() noexcept
+				{
+					const uint64_t epoch = mOwner->mEpoch.load(std::memory_order_acquire);
+					if (epoch != mEpoch)
+					{
+						const bool wasOffline = mEpoch == kOffline;
+						mSlot->store(epoch, std::memory_order_release);
+						//coming online has to be visible before the pointer is loaded, a writer that missed
+						//the store could free what the load returns; later changes only move the slot forward
+						if (wasOffline)
+							std::atomic_thread_fence(std::memory_order_seq_cst);
+						mEpoch = epoch;
+					}
+					return mOwner->mSnapshot.load(std::memory_order_acquire);
+				}
+				/*
+				 * Releases every snapshot returned by get(), the reader no longer holds back reclamation.
+				 */
+				void offline() noexcept
+				{
+					mSlot->store(kOffline, std::memory_order_release);
+					mEpoch = kOffline;
+				}
+			private:
+				const EpochPointer* mOwner;
+				std::atomic<uint64_t>* mSlot = nullptr;
+				uint64_t mEpoch = kOffline;
+			};
+
+			explicit EpochPointer(std::unique_ptr<T> initial) : mSnapshot(initial.release()) { }
+			/*
+			 * All readers have to be destroyed first.
+			 */
+			~EpochPointer() { delete mSnapshot.load(); }
+			EpochPointer(const EpochPointer&) = delete;
+			EpochPointer& operator=(const EpochPointer&) = delete;
+
+			/*
+			 * Publishes next and retires the previous snapshot, then reclaims what no reader can hold.
+			 */
+			void update(std::unique_ptr<T> next)
+			{
+				std::lock_guard<std::mutex> lock(mUpdateMutex);
+				std::unique_ptr<T> previous(mSnapshot.exchange(next.release(), std::memory_order_seq_cst));
+				const uint64_t epoch = mEpoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+				mRetired.push_back({ std::move(previous), epoch });
+				reclaimRetired();
+			}
+			/*
+			 * Destroys the retired snapshots that every reader has released.
+			 * @return number of snapshots that are still retired.
+			 */
+			size_t reclaim()
+			{
+				std::lock_guard<std::mutex> lock(mUpdateMutex);
+				return reclaimRetired();
+			}
+			/*
+			 * Waits until every retired snapshot is destroyed, which requires every online reader to call get().
+			 */
+			void synchronize()
+			{
+				while (this->reclaim() != 0)
+				{
+					std::this_thread::yield();
+				}
+			}
+			/*
+			 * Current snapshot for the updating thread, updates must be serialized by the caller.
+			 */
+			const T* getLatest() const noexcept { return mSnapshot.load(std::memory_order_acquire); }
+			NODISCARD uint64_t getEpoch() const noexcept { return mEpoch.load(std::memory_order_relaxed); }
+		private:
+			static constexpr uint64_t kFree = UINT64_MAX;
+			static constexpr uint64_t kOffline = UINT64_MAX - 1;
+
+			struct alignas(64) Slot
+			{
+				std::atomic<uint64_t> mEpoch{ kFree };
+			};
+
+			struct Retired
+			{
+				std::unique_ptr<T> snapshot;
+				/* first epoch in which the snapshot is no longer reachable */
+				uint64_t epoch;
+			};
+
+			size_t reclaimRetired()
+			{
+				if (mRetired.empty())
+					return 0;
+				uint64_t oldest = mEpoch.load(std::memory_order_seq_cst);
+				for (const Slot& slot : mSlots)
+				{
+					const uint64_t epoch = slot.mEpoch.load(std::memory_order_seq_cst);
+					if (epoch < oldest)
+						oldest = epoch;
+				}
+				//retired in epoch order, a snapshot is free once every online reader has seen its epoch
+				size_t freed = 0;
+				while (freed < mRetired.size() && mRetired[freed].epoch <= oldest)
+				{
+					freed++;
+				}
+				mRetired.erase(mRetired.begin(), mRetired.begin() + static_cast<ptrdiff_t>(freed));
+				return mRetired.size();
+			}
+
+			std::atomic<T*> mSnapshot;
+			std::atomic<uint64_t> mEpoch{ 0 };
+			mutable Slot mSlots[kMaxReaders];
+			std::vector<Retired> mRetired;
+			std::mutex mUpdateMutex;
+		};
+	}
+}
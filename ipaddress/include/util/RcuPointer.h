@@ -0,0 +1,135 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace ip_address
+{
+	namespace details
+	{
+		/*
+		 * Small dense index per thread, used to spread per-thread state over padded shards.
+		 */
+		inline uint32_t getThreadIndex() noexcept
+		{
+			static std::atomic<uint32_t> next{ 0 };
+			thread_local const uint32_t index = next.fetch_add(1, std::memory_order_relaxed);
+			return index;
+		}
+
+		/*
+		 * Pointer to an immutable snapshot that is read without locks and replaced by copy-update-swap (RCU).
+		 *
+		 * Readers pin the current snapshot with a ReadGuard, which increments a counter in a cache line owned by
+		 * a shard of threads and tagged with the current phase, so readers on different threads never write the
+		 * same cache line. A reader that sees the phase change under its increment undoes it and retries.
+		 * update() swaps the pointer, flips the phase and waits until every reader of the old phase has left
+		 * (the grace period) before the old snapshot is destroyed. Updates are serialized.
+		 */
+		template <typename T>
+		class RcuPointer
+		{
+		public:
+			static constexpr uint32_t kShards = 128;
+
+			class ReadGuard
+			{
+			public:
+				explicit ReadGuard(const RcuPointer& owner) noexcept
+				{
+					Shard& shard = owner.mShards[getThreadIndex() % kShards];
+					//an update that flips the phase between the load and the increment does not wait for this
+					//counter, the next one could then free the snapshot loaded below, so retry on a flip
+					for (;;)
+					{
+						const uint32_t phase = owner.mPhase.load(std::memory_order_seq_cst);
+						mCounter = &shard.mCounters[phase];
+						mCounter->fetch_add(1, std::memory_order_seq_cst);
+						if (owner.mPhase.load(std::memory_order_seq_cst) == phase)
+							break;
+						mCounter->fetch_sub(1, std::memory_order_release);
+					}
+					mSnapshot = owner.mSnapshot.load(std::memory_order_seq_cst);
+				}
+				~ReadGuard() { mCounter->fetch_sub(1, std::memory_order_release); }
+				ReadGuard(const ReadGuard&) = delete;
+				ReadGuard& operator=(const ReadGuard&) = delete;
+
+				const T* get() const noexcept { return mSnapshot; }
+				const T* operator->() const noexcept { return mSnapshot; }
+				const T& operator*() const noexcept { return *mSnapshot; }
+			private:
+				std::atomic<int64_t>* mCounter = nullptr;
+				const T* mSnapshot = nullptr;
+			};
+
+			explicit RcuPointer(std::unique_ptr<T> initial) : mSnapshot(initial.release()) { }
+			~RcuPointer() { delete mSnapshot.load(); }
+			RcuPointer(const RcuPointer&) = delete;
+			RcuPointer& operator=(const RcuPointer&) = delete;
+
+			/*
+			 * Pins the current snapshot, it stays alive until the guard is destroyed.
+			 */
+			ReadGuard read() const noexcept { return ReadGuard(*this); }
+			/*
+			 * Publishes next and waits for the readers of the previous snapshot, which is then destroyed.
+			 * update(modify) copies the current snapshot, applies modify to the copy and publishes it.
+			 */
+			void update(std::unique_ptr<T> next)
+			{
+				std::lock_guard<std::mutex> lock(mUpdateMutex);
+				publish(std::move(next));
+			}
+
+			template <typename Modify>
+			void modify(Modify&& modify)
+			{
+				std::lock_guard<std::mutex> lock(mUpdateMutex);
+				std::unique_ptr<T> next(new T(*mSnapshot.load(std::memory_order_relaxed)));
+				modify(*next);
+				publish(std::move(next));
+			}
+			/*
+			 * Waits until every reader that started before this call has finished.
+			 */
+			void synchronize() const
+			{
+				std::lock_guard<std::mutex> lock(mUpdateMutex);
+				waitForReaders();
+			}
+		private:
+			struct alignas(64) Shard
+			{
+				std::atomic<int64_t> mCounters[2] = { {0}, {0} };
+			};
+
+			void publish(std::unique_ptr<T> next)
+			{
+				std::unique_ptr<T> previous(mSnapshot.exchange(next.release(), std::memory_order_seq_cst));
+				waitForReaders();
+			}
+
+			void waitForReaders() const
+			{
+				//flip the phase so new readers stop adding to the old counters, then wait for those to drain
+				const uint32_t old = mPhase.load(std::memory_order_relaxed);
+				mPhase.store(old ^ 1, std::memory_order_seq_cst);
+				for (const Shard& shard : mShards)
+				{
+					while (shard.mCounters[old].load(std::memory_order_acquire) != 0)
+					{
+						std::this_thread::yield();
+					}
+				}
+			}
+
+			std::atomic<T*> mSnapshot;
+			mutable std::atomic<uint32_t> mPhase{ 0 };
+			mutable Shard mShards[kShards];
+			mutable std::mutex mUpdateMutex;
+		};
+	}
+}
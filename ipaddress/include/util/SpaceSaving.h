@@ -0,0 +1,248 @@
+#pragma once
+#include "Config.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace ip_address
+{
+	namespace details
+	{
+		/*
+		 * Space-Saving top-k counter (Metwally et al.) kept in a stream-summary so that every unit increment is O(1).
+		 * Counters with the same count share a bucket, buckets form a list sorted by count and the smallest bucket
+		 * is the one that is recycled when an untracked key arrives while all counters are in use.
+		 * Traits must provide static uint64_t hash(const Key&).
+		 */
+		template <typename Key, typename Traits>
+		class SpaceSaving final
+		{
+		public:
+			explicit SpaceSaving(size_t capacity) : mCounters(capacity), mBuckets(capacity)
+			{
+				assert(capacity > 0 && capacity < kNil && "Space-Saving capacity out of range");
+				size_t slots = 1;
+				while (slots < capacity * 2)
+					slots <<= 1;
+				mSlots.assign(slots, kNil);
+				this->clear();
+			}
+
+			void increment(const Key& key) noexcept
+			{
+				size_t slot = this->findSlot(key);
+				if (mSlots[slot] != kNil)
+				{
+					this->incrementCounter(mSlots[slot]);
+					return;
+				}
+				if (mSize < mCounters.size())
+				{
+					const uint32_t c = static_cast<uint32_t>(mSize++);
+					mCounters[c].key = key;
+					mCounters[c].error = 0;
+					mSlots[slot] = c;
+					if (mMinBucket != kNil && mBuckets[mMinBucket].count == 1)
+					{
+						this->attach(c, mMinBucket);
+					}
+					else
+					{
+						const uint32_t b = this->allocateBucket(1);
+						this->linkBucketAfter(b, kNil);
+						this->attach(c, b);
+					}
+					return;
+				}
+				//Replace the key with the smallest count and inherit its count as error
+				const uint32_t c = mBuckets[mMinBucket].head;
+				this->eraseSlot(this->findSlot(mCounters[c].key));
+				slot = this->findSlot(key);
+				mCounters[c].key = key;
+				mCounters[c].error = mBuckets[mMinBucket].count;
+				mSlots[slot] = c;
+				this->incrementCounter(c);
+			}
+
+			/*
+			 * @return the estimated count of key, 0 if key is not tracked. The estimate never underestimates.
+			 */
+			NODISCARD uint64_t count(const Key& key) const noexcept
+			{
+				const uint32_t c = mSlots[this->findSlot(key)];
+				return c == kNil ? 0 : mBuckets[mCounters[c].bucket].count;
+			}
+
+			/*
+			 * Calls func(key, count, error) for every tracked key, count - error is a guaranteed lower bound.
+			 */
+			template <typename Func>
+			void forEach(Func&& func) const
+			{
+				for (size_t i = 0; i < mSize; i++)
+				{
+					func(mCounters[i].key, mBuckets[mCounters[i].bucket].count, mCounters[i].error);
+				}
+			}
+
+			NODISCARD size_t size() const noexcept { return mSize; }
+
+			NODISCARD size_t capacity() const noexcept { return mCounters.size(); }
+
+			void clear() noexcept
+			{
+				std::fill(mSlots.begin(), mSlots.end(), kNil);
+				mSize = 0;
+				mMinBucket = kNil;
+				mFreeBucket = kNil;
+				for (size_t i = 0; i < mBuckets.size(); i++)
+				{
+					mBuckets[i].next = mFreeBucket;
+					mFreeBucket = static_cast<uint32_t>(i);
+				}
+			}
+		private:
+			static constexpr uint32_t kNil = std::numeric_limits<uint32_t>::max();
+
+			struct Counter
+			{
+				Key key;
+				uint64_t error;
+				uint32_t bucket;
+				uint32_t prev;
+				uint32_t next;
+			};
+
+			struct Bucket
+			{
+				uint64_t count;
+				uint32_t head;
+				uint32_t prev;
+				uint32_t next;
+			};
+
+			size_t findSlot(const Key& key) const noexcept
+			{
+				const size_t mask = mSlots.size() - 1;
+				size_t slot = static_cast<size_t>(Traits::hash(key)) & mask;
+				while (mSlots[slot] != kNil && !(mCounters[mSlots[slot]].key == key))
+				{
+					slot = (slot + 1) & mask;
+				}
+				return slot;
+			}
+
+			//backward shift deletion keeps linear probing chains intact without tombstones
+			void eraseSlot(size_t slot) noexcept
+			{
+				const size_t mask = mSlots.size() - 1;
+				size_t next = (slot + 1) & mask;
+				while (mSlots[next] != kNil)
+				{
+					const size_t home = static_cast<size_t>(Traits::hash(mCounters[mSlots[next]].key)) & mask;
+					if (((next - home) & mask) >= ((next - slot) & mask))
+					{
+						mSlots[slot] = mSlots[next];
+						slot = next;
+					}
+					next = (next + 1) & mask;
+				}
+				mSlots[slot] = kNil;
+			}
+
+			uint32_t allocateBucket(uint64_t count) noexcept
+			{
+				assert(mFreeBucket != kNil);
+				const uint32_t b = mFreeBucket;
+				mFreeBucket = mBuckets[b].next;
+				mBuckets[b].count = count;
+				mBuckets[b].head = kNil;
+				return b;
+			}
+
+			//links bucket b after bucket prev, kNil inserts it as the smallest bucket
+			void linkBucketAfter(uint32_t b, uint32_t prev) noexcept
+			{
+				const uint32_t next = prev == kNil ? mMinBucket : mBuckets[prev].next;
+				mBuckets[b].prev = prev;
+				mBuckets[b].next = next;
+				if (next != kNil)
+					mBuckets[next].prev = b;
+				if (prev == kNil)
+					mMinBucket = b;
+				else
+					mBuckets[prev].next = b;
+			}
+
+			void releaseBucket(uint32_t b) noexcept
+			{
+				const Bucket& bucket = mBuckets[b];
+				if (bucket.prev == kNil)
+					mMinBucket = bucket.next;
+				else
+					mBuckets[bucket.prev].next = bucket.next;
+				if (bucket.next != kNil)
+					mBuckets[bucket.next].prev = bucket.prev;
+				mBuckets[b].next = mFreeBucket;
+				mFreeBucket = b;
+			}
+
+			void attach(uint32_t c, uint32_t b) noexcept
+			{
+				Counter& counter = mCounters[c];
+				counter.bucket = b;
+				counter.prev = kNil;
+				counter.next = mBuckets[b].head;
+				if (counter.next != kNil)
+					mCounters[counter.next].prev = c;
+				mBuckets[b].head = c;
+			}
+
+			void detach(uint32_t c) noexcept
+			{
+				const Counter& counter = mCounters[c];
+				if (counter.prev == kNil)
+					mBuckets[counter.bucket].head = counter.next;
+				else
+					mCounters[counter.prev].next = counter.next;
+				if (counter.next != kNil)
+					mCounters[counter.next].prev = counter.prev;
+			}
+
+			void incrementCounter(uint32_t c) noexcept
+			{
+				const uint32_t b = mCounters[c].bucket;
+				const uint64_t count = mBuckets[b].count + 1;
+				const uint32_t next = mBuckets[b].next;
+				if (next != kNil && mBuckets[next].count == count)
+				{
+					this->detach(c);
+					this->attach(c, next);
+					if (mBuckets[b].head == kNil)
+						this->releaseBucket(b);
+				}
+				else if (mCounters[c].prev == kNil && mCounters[c].next == kNil)
+				{
+					//only counter in its bucket, the bucket can be bumped in place
+					mBuckets[b].count = count;
+				}
+				else
+				{
+					this->detach(c);
+					const uint32_t nb = this->allocateBucket(count);
+					this->linkBucketAfter(nb, b);
+					this->attach(c, nb);
+				}
+			}
+
+			std::vector<Counter> mCounters;
+			std::vector<Bucket> mBuckets;
+			std::vector<uint32_t> mSlots;
+			size_t mSize = 0;
+			uint32_t mMinBucket = kNil;
+			uint32_t mFreeBucket = kNil;
+		};
+	}
+}
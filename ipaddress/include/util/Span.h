@@ -0,0 +1,41 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+
+namespace ip_address
+{
+	/*
+	 * Non-owning view over a contiguous sequence of T, a small stand-in for std::span until the library moves past C++17.
+	 */
+	template <typename T>
+	class Span
+	{
+	public:
+		constexpr Span() noexcept = default;
+		constexpr Span(T* data, size_t size) noexcept : mData(data), mSize(size) { }
+
+		template <size_t Size>
+		constexpr Span(T (&data)[Size]) noexcept : mData(data), mSize(Size) { }
+
+		constexpr T* data() const noexcept { return mData; }
+		constexpr size_t size() const noexcept { return mSize; }
+		constexpr bool empty() const noexcept { return mSize == 0; }
+		constexpr T* begin() const noexcept { return mData; }
+		constexpr T* end() const noexcept { return mData + mSize; }
+
+		constexpr T& operator[](size_t index) const noexcept
+		{
+			assert(index < mSize);
+			return mData[index];
+		}
+
+		constexpr Span subspan(size_t offset, size_t count) const noexcept
+		{
+			assert(offset + count <= mSize);
+			return Span(mData + offset, count);
+		}
+	private:
+		T* mData = nullptr;
+		size_t mSize = 0;
+	};
+}
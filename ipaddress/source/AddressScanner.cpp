@@ -0,0 +1,443 @@
+#include "AddressScanner.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ip_address
+{
+	namespace
+	{
+		/* smallest default chunk of scanParallel(), large enough that a chunk boundary rarely splits a candidate */
+		constexpr size_t kMinChunkSize = 1 << 20;
+
+		enum CharClass : uint8_t
+		{
+			kCandidate = 1,
+			kSeparator = 2,
+			kWord = 4,
+		};
+
+		constexpr std::array<uint8_t, 256> makeCharClasses()
+		{
+			std::array<uint8_t, 256> classes = {};
+			for (int c = 0; c < 256; c++)
+			{
+				const bool digit = c >= '0' && c <= '9';
+				const bool hex = (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+				const bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+				if (digit || hex || c == '.' || c == ':')
+					classes[c] |= kCandidate;
+				if (c == '.' || c == ':')
+					classes[c] |= kSeparator;
+				if (digit || letter || c == '_')
+					classes[c] |= kWord;
+			}
+			return classes;
+		}
+
+		constexpr std::array<uint8_t, 256> kCharClasses = makeCharClasses();
+
+		inline bool hasClass(char c, CharClass charClass) noexcept
+		{
+			return (kCharClasses[static_cast<uint8_t>(c)] & charClass) != 0;
+		}
+
+#if defined(__SSE2__)
+		inline __m128i inRange(__m128i bytes, char low, char high) noexcept
+		{
+			//unsigned bytes - low <= high - low
+			const __m128i offset = _mm_sub_epi8(bytes, _mm_set1_epi8(low));
+			return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(static_cast<char>(high - low))), offset);
+		}
+
+		inline uint32_t getSeparatorMask(const char* p) noexcept
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			const __m128i separators = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('.')),
+			                                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8(':')));
+			return static_cast<uint32_t>(_mm_movemask_epi8(separators));
+		}
+
+		inline uint32_t getCandidateMask(const char* p) noexcept
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			//'0'..'9' and ':' are adjacent, hex letters of both cases fold to 'a'..'f'
+			const __m128i digitsAndColon = inRange(bytes, '0', ':');
+			const __m128i hexLetters = inRange(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 'f');
+			const __m128i dots = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('.'));
+			return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(digitsAndColon, hexLetters), dots)));
+		}
+#endif
+
+		/*
+		 * @return the first '.' or ':' in [p, last), or last.
+		 */
+		const char* findSeparator(const char* p, const char* last) noexcept
+		{
+#if defined(__SSE2__)
+			for (; last - p >= 16; p += 16)
+			{
+				const uint32_t mask = getSeparatorMask(p);
+				if (mask != 0)
+					return p + __builtin_ctz(mask);
+			}
+#endif
+			while (p < last && !hasClass(*p, kSeparator))
+				p++;
+			return p;
+		}
+
+		/*
+		 * @return the first character in [p, last) that can not be part of an address, or last.
+		 */
+		const char* findRunEnd(const char* p, const char* last) noexcept
+		{
+#if defined(__SSE2__)
+			for (; last - p >= 16; p += 16)
+			{
+				const uint32_t mask = ~getCandidateMask(p) & 0xFFFF;
+				if (mask != 0)
+					return p + __builtin_ctz(mask);
+			}
+#endif
+			while (p < last && hasClass(*p, kCandidate))
+				p++;
+			return p;
+		}
+
+		std::string_view trimDots(std::string_view text) noexcept
+		{
+			while (!text.empty() && text.back() == '.')
+				text.remove_suffix(1);
+			return text;
+		}
+
+		/*
+		 * Validates the maximal candidate run [runBegin, runEnd) of [first, last) and appends its addresses.
+		 */
+		void addCandidate(const char* first, const char* last, const char* runBegin, const char* runEnd,
+		                  std::vector<AddressMatch>& matches)
+		{
+			if (static_cast<size_t>(runEnd - runBegin) > AddressScanner::kMaxCandidateLength)
+				return;
+			const bool wordBefore = runBegin > first && hasClass(runBegin[-1], kWord);
+			const bool wordAfter = runEnd < last && hasClass(*runEnd, kWord);
+			const std::string_view run = trimDots(std::string_view(runBegin, static_cast<size_t>(runEnd - runBegin)));
+			const auto add = [&matches, first, run](size_t offset, size_t length, const auto& addr)
+			{
+				matches.push_back({ static_cast<size_t>(run.data() - first) + offset, length, IPAddress(addr) });
+			};
+			if (run.find(':') == std::string_view::npos)
+			{
+				IPAddressV4 addr4;
+				if (!wordBefore && !wordAfter && AddressScanner::parseIPv4(run, addr4))
+					add(0, run.size(), addr4);
+				return;
+			}
+			IPAddressV6 addr6;
+			if (!wordBefore && !wordAfter)
+			{
+				if (AddressScanner::parseIPv6(run, addr6))
+				{
+					add(0, run.size(), addr6);
+					return;
+				}
+				//"fe80::1: message"
+				const size_t size = run.size();
+				if (size >= 2 && run[size - 1] == ':' && run[size - 2] != ':' &&
+					AddressScanner::parseIPv6(run.substr(0, size - 1), addr6))
+				{
+					add(0, size - 1, addr6);
+					return;
+				}
+			}
+			//dotted quads between colons, e.g. the endpoint "192.0.2.1:443" or "client:192.0.2.1"
+			for (size_t start = 0; start <= run.size();)
+			{
+				size_t colon = run.find(':', start);
+				if (colon == std::string_view::npos)
+					colon = run.size();
+				const std::string_view segment = trimDots(run.substr(start, colon - start));
+				const bool blocked = (start == 0 && wordBefore) || (colon == run.size() && wordAfter);
+				IPAddressV4 addr4;
+				if (!blocked && segment.find('.') != std::string_view::npos && AddressScanner::parseIPv4(segment, addr4))
+					add(start, segment.size(), addr4);
+				start = colon + 1;
+			}
+		}
+
+		/*
+		 * Appends the matches of the candidate runs that start in [begin, end) of text, runs may end after end.
+		 */
+		void scanRange(std::string_view text, size_t begin, size_t end, std::vector<AddressMatch>& matches)
+		{
+			const char* first = text.data();
+			const char* last = first + text.size();
+			const char* stop = first + end;
+			const char* p = first + begin;
+			//a run crossing begin belongs to the previous chunk
+			if (begin > 0 && hasClass(p[-1], kCandidate))
+				p = findRunEnd(p, last);
+			while (p < stop)
+			{
+				//the first separator of a run starting before stop is at most kMaxCandidateLength behind it
+				const char* searchEnd = static_cast<size_t>(last - stop) > AddressScanner::kMaxCandidateLength ?
+					stop + AddressScanner::kMaxCandidateLength : last;
+				const char* separator = findSeparator(p, searchEnd);
+				if (separator == searchEnd)
+					break;
+				//p follows a character that is not part of a run
+				const char* runBegin = separator;
+				while (runBegin > p && hasClass(runBegin[-1], kCandidate))
+					runBegin--;
+				if (runBegin >= stop)
+					break;
+				const char* runEnd = findRunEnd(separator + 1, last);
+				addCandidate(first, last, runBegin, runEnd, matches);
+				p = runEnd;
+			}
+		}
+	}
+
+	bool AddressScanner::parseIPv4(std::string_view text, IPAddressV4& addr4) noexcept
+	{
+		if (text.size() < 7 || text.size() > 15)
+			return false;
+		ByteArray4 bytes = {};
+		size_t part = 0;
+		uint32_t value = 0;
+		size_t digits = 0;
+		for (const char c : text)
+		{
+			if (c == '.')
+			{
+				if (digits == 0 || part == 3)
+					return false;
+				bytes[part++] = static_cast<uint8_t>(value);
+				value = 0;
+				digits = 0;
+			}
+			else if (c >= '0' && c <= '9')
+			{
+				//leading zeros are octal for inet_aton, reject them like inet_pton
+				if (digits == 1 && value == 0)
+					return false;
+				value = value * 10 + static_cast<uint32_t>(c - '0');
+				if (++digits > 3 || value > 255)
+					return false;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		if (part != 3 || digits == 0)
+			return false;
+		bytes[3] = static_cast<uint8_t>(value);
+		addr4 = IPAddressV4(bytes);
+		return true;
+	}
+
+	bool AddressScanner::parseIPv6(std::string_view text, IPAddressV6& addr6) noexcept
+	{
+		const size_t size = text.size();
+		if (size < 2 || size > 45)
+			return false;
+		uint16_t groups[8] = {};
+		size_t count = 0;
+		//index of the first group after "::", -1 without "::"
+		int gap = -1;
+		size_t i = 0;
+		if (text[0] == ':')
+		{
+			if (text[1] != ':')
+				return false;
+			gap = 0;
+			i = 2;
+		}
+		while (i < size)
+		{
+			const size_t start = i;
+			uint32_t value = 0;
+			size_t digits = 0;
+			for (; i < size && digits < 5; i++, digits++)
+			{
+				const char c = text[i];
+				if (c >= '0' && c <= '9')
+					value = value << 4 | static_cast<uint32_t>(c - '0');
+				else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+					value = value << 4 | static_cast<uint32_t>((c | 0x20) - 'a' + 10);
+				else
+					break;
+			}
+			if (i < size && text[i] == '.')
+			{
+				//embedded IPv4 address in the last 32 bits
+				IPAddressV4 addr4;
+				if (count > 6 || !parseIPv4(text.substr(start), addr4))
+					return false;
+				const ByteArray4& bytes4 = addr4.bytes();
+				groups[count++] = static_cast<uint16_t>(bytes4[0] << 8 | bytes4[1]);
+				groups[count++] = static_cast<uint16_t>(bytes4[2] << 8 | bytes4[3]);
+				break;
+			}
+			if (digits == 0 || digits > 4 || count == 8)
+				return false;
+			groups[count++] = static_cast<uint16_t>(value);
+			if (i == size)
+				break;
+			if (text[i] != ':' || ++i == size)
+				return false;
+			if (text[i] == ':')
+			{
+				if (gap >= 0)
+					return false;
+				gap = static_cast<int>(count);
+				i++;
+			}
+		}
+		if (gap < 0 ? count != 8 : count > 7)
+			return false;
+		ByteArray16 bytes = {};
+		const size_t head = gap < 0 ? count : static_cast<size_t>(gap);
+		for (size_t g = 0; g < count; g++)
+		{
+			const size_t index = g < head ? g : 8 - count + g;
+			bytes[index * 2] = static_cast<uint8_t>(groups[g] >> 8);
+			bytes[index * 2 + 1] = static_cast<uint8_t>(groups[g]);
+		}
+		addr6 = IPAddressV6(bytes);
+		return true;
+	}
+
+	bool AddressScanner::parse(std::string_view text, IPAddress& addr) noexcept
+	{
+		IPAddressV4 addr4;
+		if (parseIPv4(text, addr4))
+		{
+			addr = IPAddress(addr4);
+			return true;
+		}
+		IPAddressV6 addr6;
+		if (parseIPv6(text, addr6))
+		{
+			addr = IPAddress(addr6);
+			return true;
+		}
+		return false;
+	}
+
+	size_t AddressScanner::scan(std::string_view text, std::vector<AddressMatch>& matches)
+	{
+		const size_t previous = matches.size();
+		scanRange(text, 0, text.size(), matches);
+		return matches.size() - previous;
+	}
+
+	size_t AddressScanner::scanParallel(std::string_view text, std::vector<AddressMatch>& matches, size_t threads,
+	                                    size_t chunkSize)
+	{
+		if (threads == 0)
+			threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+		if (chunkSize == 0)
+			chunkSize = std::max<size_t>(kMinChunkSize, (text.size() + threads * 8 - 1) / (threads * 8));
+		const size_t chunkCount = (text.size() + chunkSize - 1) / chunkSize;
+		threads = std::min(threads, chunkCount);
+		if (threads <= 1)
+			return scan(text, matches);
+
+		//threads take chunks in order, the matches of each chunk are kept apart and merged at the end
+		std::vector<std::vector<AddressMatch>> chunkMatches(chunkCount);
+		std::atomic<size_t> nextChunk{ 0 };
+		std::exception_ptr error;
+		std::mutex errorMutex;
+		const auto work = [&]()
+		{
+			try
+			{
+				for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+				{
+					const size_t begin = chunk * chunkSize;
+					scanRange(text, begin, std::min(text.size(), begin + chunkSize), chunkMatches[chunk]);
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(errorMutex);
+				error = std::current_exception();
+				nextChunk = chunkCount;
+			}
+		};
+		std::vector<std::thread> workers;
+		for (size_t t = 1; t < threads; t++)
+		{
+			workers.emplace_back(work);
+		}
+		work();
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+		if (error)
+			std::rethrow_exception(error);
+
+		const size_t previous = matches.size();
+		size_t total = previous;
+		for (const std::vector<AddressMatch>& chunk : chunkMatches)
+		{
+			total += chunk.size();
+		}
+		matches.reserve(total);
+		for (const std::vector<AddressMatch>& chunk : chunkMatches)
+		{
+			matches.insert(matches.end(), chunk.begin(), chunk.end());
+		}
+		return matches.size() - previous;
+	}
+
+	size_t AddressScanner::scanFile(const std::string& path, std::vector<AddressMatch>& matches, size_t threads)
+	{
+		const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			throw std::runtime_error("can not open file");
+		struct stat info = {};
+		if (fstat(fd, &info) != 0)
+		{
+			close(fd);
+			throw std::runtime_error("can not open file");
+		}
+		const auto size = static_cast<size_t>(info.st_size);
+		if (size == 0)
+		{
+			close(fd);
+			return 0;
+		}
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (mapped == MAP_FAILED)
+			throw std::runtime_error("can not map file");
+		madvise(mapped, size, MADV_SEQUENTIAL);
+		try
+		{
+			const size_t count = scanParallel(std::string_view(static_cast<const char*>(mapped), size), matches, threads);
+			munmap(mapped, size);
+			return count;
+		}
+		catch (...)
+		{
+			munmap(mapped, size);
+			throw;
+		}
+	}
+}
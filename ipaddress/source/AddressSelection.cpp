@@ -0,0 +1,258 @@
+#include "AddressSelection.h"
+#include <algorithm>
+#include <ifaddrs.h>
+
+namespace ip_address
+{
+	namespace
+	{
+		struct PolicyEntry
+		{
+			ByteArray16 prefix;
+			uint8_t prefixLength;
+			uint8_t precedence;
+			uint8_t label;
+		};
+
+		//RFC 6724 section 2.1 default policy table, longest prefixes first so the first match is the best match
+		constexpr PolicyEntry kPolicyTable[] = {
+			{ { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 }, 128, 50, 0 }, //::1/128
+			{ { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 0, 0, 0, 0 }, 96, 35, 4 }, //::ffff:0:0/96
+			{ { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }, 96, 1, 3 }, //::/96
+			{ { 0x20, 0x01, 0, 0 }, 32, 5, 5 }, //2001::/32
+			{ { 0x20, 0x02 }, 16, 30, 2 }, //2002::/16
+			{ { 0x3f, 0xfe }, 16, 1, 12 }, //3ffe::/16
+			{ { 0xfe, 0xc0 }, 10, 1, 11 }, //fec0::/10
+			{ { 0xfc }, 7, 3, 13 }, //fc00::/7
+			{ {}, 0, 40, 1 }, //::/0
+		};
+
+		//IPv4 addresses are looked up as IPv4-mapped IPv6 addresses
+		ByteArray16 toBytes(const IPAddress& addr) noexcept
+		{
+			ByteArray16 bytes = {};
+			if (addr.isIPv4())
+			{
+				const in_addr address = addr.asIPv4().getOnWireAddress();
+				bytes[10] = 0xff;
+				bytes[11] = 0xff;
+				memcpy(&bytes[12], &address, sizeof(address));
+			}
+			else if (addr.isIPv6())
+			{
+				const in6_addr address = addr.asIPv6().getOnWireAddress();
+				memcpy(bytes.data(), &address, sizeof(address));
+			}
+			return bytes;
+		}
+
+		uint8_t getCommonPrefixLength(const ByteArray16& lhs, const ByteArray16& rhs) noexcept
+		{
+			for (size_t i = 0; i < lhs.size(); i++)
+			{
+				const uint8_t difference = lhs[i] ^ rhs[i];
+				if (difference != 0)
+					return static_cast<uint8_t>(i * 8 + static_cast<size_t>(__builtin_clz(difference)) - 24);
+			}
+			return 128;
+		}
+
+		const PolicyEntry& getPolicy(const ByteArray16& bytes) noexcept
+		{
+			for (const PolicyEntry& entry : kPolicyTable)
+			{
+				if (getCommonPrefixLength(bytes, entry.prefix) >= entry.prefixLength)
+					return entry;
+			}
+			return kPolicyTable[sizeof(kPolicyTable) / sizeof(kPolicyTable[0]) - 1];
+		}
+
+		uint8_t getScope(const ByteArray16& bytes, bool isIPv4) noexcept
+		{
+			if (isIPv4)
+			{
+				//RFC 6724 section 3.2: loopback and auto-configuration addresses are link-local
+				if (bytes[12] == 127 || (bytes[12] == 169 && bytes[13] == 254))
+					return AddressSorter::kScopeLinkLocal;
+				return AddressSorter::kScopeGlobal;
+			}
+			if (bytes[0] == 0xff)
+				return bytes[1] & 0x0f;
+			if (bytes[0] == 0xfe && (bytes[1] & 0xc0) == 0x80)
+				return AddressSorter::kScopeLinkLocal;
+			if (bytes[0] == 0xfe && (bytes[1] & 0xc0) == 0xc0)
+				return AddressSorter::kScopeSiteLocal;
+			static constexpr ByteArray16 kLoopback = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+			if (bytes == kLoopback)
+				return AddressSorter::kScopeLinkLocal;
+			return AddressSorter::kScopeGlobal;
+		}
+
+		std::vector<IPAddress> getInterfaceAddresses()
+		{
+			std::vector<IPAddress> addresses;
+			ifaddrs* interfaces = nullptr;
+			if (getifaddrs(&interfaces) != 0)
+				return addresses;
+			for (const ifaddrs* current = interfaces; current != nullptr; current = current->ifa_next)
+			{
+				if (current->ifa_addr == nullptr)
+					continue;
+				if (current->ifa_addr->sa_family == AF_INET)
+					addresses.emplace_back(*reinterpret_cast<const sockaddr_in*>(current->ifa_addr));
+				else if (current->ifa_addr->sa_family == AF_INET6)
+					addresses.emplace_back(*reinterpret_cast<const sockaddr_in6*>(current->ifa_addr));
+			}
+			freeifaddrs(interfaces);
+			return addresses;
+		}
+
+		struct SourceCandidate
+		{
+			const IPAddress* addr;
+			ByteArray16 bytes;
+			uint8_t scope;
+			uint8_t label;
+		};
+	}
+
+	AddressSorter::AddressSorter() : AddressSorter(getInterfaceAddresses()) { }
+
+	AddressSorter::AddressSorter(std::vector<IPAddress> sources) : mSources(std::move(sources)) { }
+
+	void AddressSorter::sort(std::vector<IPAddress>& destinations) const
+	{
+		sortAddresses(destinations);
+	}
+
+	void AddressSorter::sort(std::vector<IPEndPoint>& destinations) const
+	{
+		sortAddresses(destinations);
+	}
+
+	bool AddressSorter::getSource(const IPAddress& destination, IPAddress& source) const noexcept
+	{
+		const ByteArray16 bytes = toBytes(destination);
+		const uint8_t scope = ip_address::getScope(bytes, destination.isIPv4());
+		const uint8_t label = getPolicy(bytes).label;
+		bool found = false;
+		SourceCandidate selected = {};
+		for (const IPAddress& candidate : mSources)
+		{
+			if (candidate.isIPv4() != destination.isIPv4() || !(candidate.isIPv4() || candidate.isIPv6()))
+				continue;
+			SourceCandidate current = { &candidate, toBytes(candidate), 0, 0 };
+			current.scope = ip_address::getScope(current.bytes, candidate.isIPv4());
+			current.label = getPolicy(current.bytes).label;
+			if (!found)
+			{
+				selected = current;
+				found = true;
+				continue;
+			}
+			//rule 1: prefer the same address
+			if (selected.bytes == bytes)
+				break;
+			if (current.bytes == bytes)
+			{
+				selected = current;
+				break;
+			}
+			//rule 2: prefer the smallest scope that still reaches the destination
+			if (current.scope != selected.scope)
+			{
+				const bool better = current.scope < selected.scope ? current.scope >= scope : selected.scope < scope;
+				if (better)
+					selected = current;
+				continue;
+			}
+			//rule 6: prefer a matching label
+			const bool currentLabel = current.label == label;
+			const bool selectedLabel = selected.label == label;
+			if (currentLabel != selectedLabel)
+			{
+				if (currentLabel)
+					selected = current;
+				continue;
+			}
+			//rule 8: prefer the longest matching prefix
+			if (getCommonPrefixLength(current.bytes, bytes) > getCommonPrefixLength(selected.bytes, bytes))
+				selected = current;
+		}
+		if (!found)
+			return false;
+		source = *selected.addr;
+		return true;
+	}
+
+	uint8_t AddressSorter::getPrecedence(const IPAddress& addr) noexcept
+	{
+		return getPolicy(toBytes(addr)).precedence;
+	}
+
+	uint8_t AddressSorter::getLabel(const IPAddress& addr) noexcept
+	{
+		return getPolicy(toBytes(addr)).label;
+	}
+
+	uint8_t AddressSorter::getScope(const IPAddress& addr) noexcept
+	{
+		return ip_address::getScope(toBytes(addr), addr.isIPv4());
+	}
+
+	AddressSorter::Key AddressSorter::makeKey(const IPAddress& destination, uint32_t index) const noexcept
+	{
+		Key key = {};
+		key.index = index;
+		key.isIPv6 = destination.isIPv6();
+		const ByteArray16 bytes = toBytes(destination);
+		const PolicyEntry& policy = getPolicy(bytes);
+		key.precedence = policy.precedence;
+		key.scope = ip_address::getScope(bytes, destination.isIPv4());
+		IPAddress source;
+		key.usable = getSource(destination, source);
+		if (key.usable)
+		{
+			const ByteArray16 sourceBytes = toBytes(source);
+			key.matchingScope = ip_address::getScope(sourceBytes, source.isIPv4()) == key.scope;
+			key.matchingLabel = getPolicy(sourceBytes).label == policy.label;
+			//rule 9 compares at most the interface identifier boundary
+			key.commonPrefix = std::min<uint8_t>(getCommonPrefixLength(bytes, sourceBytes), 64);
+		}
+		return key;
+	}
+
+	template <typename Address>
+	void AddressSorter::sortAddresses(std::vector<Address>& destinations) const
+	{
+		std::vector<Key> keys;
+		keys.reserve(destinations.size());
+		for (size_t i = 0; i < destinations.size(); i++)
+		{
+			keys.push_back(makeKey(destinations[i], static_cast<uint32_t>(i)));
+		}
+		std::stable_sort(keys.begin(), keys.end(), [](const Key& lhs, const Key& rhs)
+		{
+			if (lhs.usable != rhs.usable)
+				return lhs.usable;
+			if (lhs.matchingScope != rhs.matchingScope)
+				return lhs.matchingScope;
+			if (lhs.matchingLabel != rhs.matchingLabel)
+				return lhs.matchingLabel;
+			if (lhs.precedence != rhs.precedence)
+				return lhs.precedence > rhs.precedence;
+			if (lhs.scope != rhs.scope)
+				return lhs.scope < rhs.scope;
+			if (lhs.isIPv6 && rhs.isIPv6 && lhs.commonPrefix != rhs.commonPrefix)
+				return lhs.commonPrefix > rhs.commonPrefix;
+			return false;
+		});
+		std::vector<Address> sorted;
+		sorted.reserve(destinations.size());
+		for (const Key& key : keys)
+		{
+			sorted.push_back(destinations[key.index]);
+		}
+		destinations = std::move(sorted);
+	}
+}
@@ -0,0 +1,559 @@
+#include "CaptureReader.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ip_address
+{
+	namespace
+	{
+		constexpr uint32_t kPcapMagic = 0xA1B2C3D4;
+		constexpr uint32_t kPcapMagicNanoseconds = 0xA1B23C4D;
+		constexpr uint32_t kPcapNgSectionHeader = 0x0A0D0D0A;
+		constexpr uint32_t kPcapNgByteOrderMagic = 0x1A2B3C4D;
+		constexpr uint32_t kPcapNgInterface = 1;
+		constexpr uint32_t kPcapNgPacket = 2;
+		constexpr uint32_t kPcapNgSimplePacket = 3;
+		constexpr uint32_t kPcapNgEnhancedPacket = 6;
+		constexpr size_t kPcapFileHeaderSize = 24;
+		constexpr size_t kPcapRecordHeaderSize = 16;
+		//consumed pages are dropped in steps of this size
+		constexpr size_t kReleaseSize = 64 << 20;
+		//number of consecutive headers that must be plausible before a split point is accepted
+		constexpr int kBoundaryChain = 4;
+
+		//link types from https://www.tcpdump.org/linktypes.html
+		enum LinkType : uint16_t
+		{
+			kNull = 0,
+			kEthernet = 1,
+			kRawOpenBsd = 12,
+			kRawBsd = 14,
+			kRaw = 101,
+			kLoop = 108,
+			kLinuxSll = 113,
+			kIPv4 = 228,
+			kIPv6 = 229,
+			kLinuxSll2 = 276,
+		};
+
+		constexpr uint64_t kPowersOf10[] = {
+			1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+			1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+			100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+			1000000000000000000ull, 10000000000000000000ull,
+		};
+
+		inline uint16_t readBigEndian16(const uint8_t* data) noexcept
+		{
+			uint16_t value;
+			memcpy(&value, data, sizeof(value));
+			return NetToHost16(value);
+		}
+
+		/*
+		 * Moves data/length past the link layer header.
+		 * @return false if the frame does not carry IPv4 or IPv6.
+		 */
+		bool toNetworkLayer(uint16_t linkType, const uint8_t*& data, size_t& length) noexcept
+		{
+			size_t offset;
+			uint16_t etherType;
+			switch (linkType)
+			{
+			case kEthernet:
+				offset = 12;
+				if (length < offset + 2)
+					return false;
+				etherType = readBigEndian16(data + offset);
+				//802.1Q, 802.1ad and QinQ tags
+				while ((etherType == 0x8100 || etherType == 0x88A8 || etherType == 0x9100) && length >= offset + 6)
+				{
+					offset += 4;
+					etherType = readBigEndian16(data + offset);
+				}
+				offset += 2;
+				break;
+			case kLinuxSll:
+				offset = 16;
+				if (length < offset)
+					return false;
+				etherType = readBigEndian16(data + 14);
+				break;
+			case kLinuxSll2:
+				offset = 20;
+				if (length < offset)
+					return false;
+				etherType = readBigEndian16(data);
+				break;
+			case kNull:
+			case kLoop:
+				//4 byte address family in an unspecified byte order, the version nibble decides
+				offset = 4;
+				etherType = 0;
+				break;
+			case kRaw:
+			case kRawOpenBsd:
+			case kRawBsd:
+			case kIPv4:
+			case kIPv6:
+				offset = 0;
+				etherType = 0;
+				break;
+			default:
+				return false;
+			}
+			if (etherType != 0 && etherType != 0x0800 && etherType != 0x86DD)
+				return false;
+			if (length < offset)
+				return false;
+			data += offset;
+			length -= offset;
+			return true;
+		}
+
+		bool toRecord(CaptureRecord& record, uint16_t linkType, const uint8_t* data, size_t length) noexcept
+		{
+			if (!toNetworkLayer(linkType, data, length))
+				return false;
+			PacketHeader header;
+			if (!PacketHeader::parsePacketHeader(header, data, length))
+				return false;
+			record.source = header.getSource();
+			record.destination = header.getDestination();
+			record.protocol = header.getProtocol();
+			record.packet = Span<const uint8_t>(data, length);
+			return true;
+		}
+	}
+
+	CaptureReader::CaptureReader(const std::string& path)
+	{
+		const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			throw std::runtime_error("can not open capture file");
+		struct stat info = {};
+		if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(kPcapFileHeaderSize))
+		{
+			close(fd);
+			throw std::runtime_error("invalid capture file");
+		}
+		mSize = static_cast<size_t>(info.st_size);
+		void* mapped = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (mapped == MAP_FAILED)
+			throw std::runtime_error("can not map capture file");
+		mData = static_cast<const uint8_t*>(mapped);
+		madvise(mapped, mSize, MADV_SEQUENTIAL);
+
+		uint32_t magic;
+		memcpy(&magic, mData, sizeof(magic));
+		if (magic == kPcapMagic || magic == ByteSwap(kPcapMagic) || magic == kPcapMagicNanoseconds
+			|| magic == ByteSwap(kPcapMagicNanoseconds))
+		{
+			mFormat = CaptureFormat::kPcap;
+			mFirst.swapped = magic == ByteSwap(kPcapMagic) || magic == ByteSwap(kPcapMagicNanoseconds);
+			mNanoseconds = magic == kPcapMagicNanoseconds || magic == ByteSwap(kPcapMagicNanoseconds);
+			mSnapLength = read32(16, mFirst.swapped);
+			Interface interface;
+			//the upper 16 bits hold the FCS length
+			interface.linkType = static_cast<uint16_t>(read32(20, mFirst.swapped));
+			interface.exponent = mNanoseconds ? 9 : 6;
+			mFirst.interfaces.push_back(interface);
+			mFirst.offset = kPcapFileHeaderSize;
+		}
+		else if (magic == kPcapNgSectionHeader)
+		{
+			mFormat = CaptureFormat::kPcapNg;
+			//read the section header and interface descriptions up to the first packet
+			mFirst.end = mSize;
+			while (mFirst.offset + 12 <= mSize)
+			{
+				const uint32_t type = read32(mFirst.offset, mFirst.swapped);
+				if (type == kPcapNgEnhancedPacket || type == kPcapNgSimplePacket || type == kPcapNgPacket)
+					break;
+				CaptureRecord ignored;
+				bool done = false;
+				readPcapNgBlock(mFirst, ignored, done);
+				if (done)
+					break;
+			}
+			if (mFirst.offset == 0)
+			{
+				munmap(mapped, mSize);
+				throw std::runtime_error("invalid capture file");
+			}
+		}
+		else
+		{
+			munmap(mapped, mSize);
+			throw std::runtime_error("invalid capture file");
+		}
+		mFirst.end = mSize;
+		mFirst.released = 0;
+		mCursor = mFirst;
+	}
+
+	CaptureReader::~CaptureReader()
+	{
+		munmap(const_cast<uint8_t*>(mData), mSize);
+	}
+
+	size_t CaptureReader::readBatch(CaptureRecord* records, size_t capacity) noexcept
+	{
+		return read(mCursor, records, capacity);
+	}
+
+	void CaptureReader::rewind() noexcept
+	{
+		mCursor = mFirst;
+	}
+
+	void CaptureReader::readParallel(size_t threadCount,
+	                                 const std::function<void(size_t, const CaptureRecord*, size_t)>& callback,
+	                                 size_t batchSize) const
+	{
+		threadCount = std::max<size_t>(threadCount, 1);
+		batchSize = std::max<size_t>(batchSize, 1);
+		const size_t first = mFirst.offset;
+		std::vector<size_t> boundaries(threadCount + 1, mSize);
+		boundaries[0] = first;
+		for (size_t i = 1; i < threadCount; i++)
+		{
+			const size_t nominal = first + (mSize - first) / threadCount * i;
+			boundaries[i] = std::max(boundaries[i - 1], findRecordBoundary(nominal, mFirst));
+		}
+
+		const auto forEachPart = [threadCount](const std::function<void(size_t)>& work)
+		{
+			std::vector<std::thread> threads;
+			threads.reserve(threadCount - 1);
+			for (size_t i = 1; i < threadCount; i++)
+			{
+				threads.emplace_back(work, i);
+			}
+			work(0);
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+		};
+
+		//a pcapng file can start a section or describe an interface after its first packet, a part then starts
+		//with the interfaces described by the blocks of the parts before it
+		std::vector<Cursor> starts(threadCount, mFirst);
+		if (mFormat == CaptureFormat::kPcapNg && threadCount > 1)
+		{
+			std::vector<std::vector<size_t>> descriptions(threadCount);
+			forEachPart([&](size_t part)
+			{
+				findDescriptions(boundaries[part], boundaries[part + 1], mFirst.swapped, descriptions[part]);
+			});
+			for (size_t part = 1; part < threadCount; part++)
+			{
+				starts[part] = starts[part - 1];
+				for (const size_t offset : descriptions[part - 1])
+				{
+					starts[part].offset = offset;
+					starts[part].end = mSize;
+					CaptureRecord ignored;
+					bool done = false;
+					readPcapNgBlock(starts[part], ignored, done);
+				}
+			}
+		}
+
+		forEachPart([&](size_t part)
+		{
+			Cursor cursor = starts[part];
+			cursor.offset = boundaries[part];
+			cursor.end = boundaries[part + 1];
+			cursor.released = cursor.offset;
+			std::vector<CaptureRecord> records(batchSize);
+			while (const size_t count = read(cursor, records.data(), batchSize))
+			{
+				callback(part, records.data(), count);
+			}
+		});
+	}
+
+	void CaptureReader::findDescriptions(size_t offset, size_t end, bool swapped, std::vector<size_t>& descriptions) const
+	{
+		//only the block headers are read, the same checks as readPcapNgBlock() end the walk
+		while (offset < end && offset + 12 <= mSize)
+		{
+			uint32_t type;
+			memcpy(&type, mData + offset, sizeof(type));
+			if (type == kPcapNgSectionHeader)
+			{
+				uint32_t byteOrder;
+				memcpy(&byteOrder, mData + offset + 8, sizeof(byteOrder));
+				if (byteOrder != kPcapNgByteOrderMagic && byteOrder != ByteSwap(kPcapNgByteOrderMagic))
+					return;
+				swapped = byteOrder != kPcapNgByteOrderMagic;
+			}
+			type = read32(offset, swapped);
+			const size_t length = read32(offset + 4, swapped);
+			if (length < 12 || length % 4 != 0 || length > mSize - offset)
+				return;
+			if (type == kPcapNgSectionHeader || type == kPcapNgInterface)
+				descriptions.push_back(offset);
+			offset += length;
+		}
+	}
+
+	size_t CaptureReader::read(Cursor& cursor, CaptureRecord* records, size_t capacity) const noexcept
+	{
+		size_t count = 0;
+		bool done = false;
+		while (count < capacity && !done)
+		{
+			const bool decoded = mFormat == CaptureFormat::kPcap
+				                     ? readPcapRecord(cursor, records[count], done)
+				                     : readPcapNgBlock(cursor, records[count], done);
+			count += decoded;
+		}
+		release(cursor);
+		return count;
+	}
+
+	bool CaptureReader::readPcapRecord(Cursor& cursor, CaptureRecord& record, bool& done) const noexcept
+	{
+		const size_t offset = cursor.offset;
+		if (offset >= cursor.end || offset + kPcapRecordHeaderSize > mSize)
+		{
+			done = true;
+			return false;
+		}
+		const uint32_t seconds = read32(offset, cursor.swapped);
+		const uint32_t fraction = read32(offset + 4, cursor.swapped);
+		const size_t captured = read32(offset + 8, cursor.swapped);
+		if (captured > mSize - offset - kPcapRecordHeaderSize)
+		{
+			done = true;
+			return false;
+		}
+		cursor.offset = offset + kPcapRecordHeaderSize + captured;
+		if (!toRecord(record, cursor.interfaces[0].linkType, mData + offset + kPcapRecordHeaderSize, captured))
+			return false;
+		record.timestamp = seconds * 1000000000ull + (mNanoseconds ? fraction : fraction * 1000ull);
+		return true;
+	}
+
+	bool CaptureReader::readPcapNgBlock(Cursor& cursor, CaptureRecord& record, bool& done) const noexcept
+	{
+		const size_t offset = cursor.offset;
+		if (offset >= cursor.end || offset + 12 > mSize)
+		{
+			done = true;
+			return false;
+		}
+		uint32_t type;
+		memcpy(&type, mData + offset, sizeof(type));
+		if (type == kPcapNgSectionHeader)
+		{
+			//the byte order magic decides how the rest of the section, including this block length, is read
+			if (offset + 28 > mSize)
+			{
+				done = true;
+				return false;
+			}
+			uint32_t byteOrder;
+			memcpy(&byteOrder, mData + offset + 8, sizeof(byteOrder));
+			if (byteOrder != kPcapNgByteOrderMagic && byteOrder != ByteSwap(kPcapNgByteOrderMagic))
+			{
+				done = true;
+				return false;
+			}
+			cursor.swapped = byteOrder != kPcapNgByteOrderMagic;
+			cursor.interfaces.clear();
+		}
+		type = read32(offset, cursor.swapped);
+		const size_t length = read32(offset + 4, cursor.swapped);
+		if (length < 12 || length % 4 != 0 || length > mSize - offset)
+		{
+			done = true;
+			return false;
+		}
+		cursor.offset = offset + length;
+
+		const size_t body = offset + 8;
+		const size_t bodyLength = length - 12;
+		switch (type)
+		{
+		case kPcapNgInterface:
+			readInterface(cursor, body, bodyLength);
+			return false;
+		case kPcapNgEnhancedPacket:
+			{
+				if (bodyLength < 20)
+					return false;
+				const uint32_t interfaceId = read32(body, cursor.swapped);
+				const size_t captured = read32(body + 12, cursor.swapped);
+				if (interfaceId >= cursor.interfaces.size() || captured > bodyLength - 20)
+					return false;
+				const Interface& interface = cursor.interfaces[interfaceId];
+				if (!toRecord(record, interface.linkType, mData + body + 20, captured))
+					return false;
+				uint64_t ticks = static_cast<uint64_t>(read32(body + 4, cursor.swapped)) << 32
+					| read32(body + 8, cursor.swapped);
+				if (interface.binary)
+				{
+					//ticks of 2^-exponent seconds, keep the multiplication below 64 bits
+					uint8_t exponent = interface.exponent;
+					if (exponent > 30)
+					{
+						ticks >>= exponent - 30;
+						exponent = 30;
+					}
+					const uint64_t mask = (1ull << exponent) - 1;
+					record.timestamp = (ticks >> exponent) * 1000000000ull + ((ticks & mask) * 1000000000ull >> exponent);
+				}
+				else if (interface.exponent <= 9)
+				{
+					record.timestamp = ticks * kPowersOf10[9 - interface.exponent];
+				}
+				else
+				{
+					record.timestamp = ticks / kPowersOf10[std::min<size_t>(interface.exponent - 9, 19)];
+				}
+				return true;
+			}
+		case kPcapNgSimplePacket:
+			{
+				//no timestamp, always interface 0, the captured length is whatever fits in the block
+				if (bodyLength < 4 || cursor.interfaces.empty())
+					return false;
+				const size_t captured = std::min<size_t>(read32(body, cursor.swapped), bodyLength - 4);
+				if (!toRecord(record, cursor.interfaces[0].linkType, mData + body + 4, captured))
+					return false;
+				record.timestamp = 0;
+				return true;
+			}
+		default:
+			return false;
+		}
+	}
+
+	bool CaptureReader::readInterface(Cursor& cursor, size_t body, size_t bodyLength) const noexcept
+	{
+		if (bodyLength < 8)
+			return false;
+		Interface interface;
+		interface.linkType = read16(body, cursor.swapped);
+		size_t option = body + 8;
+		const size_t end = body + bodyLength;
+		while (option + 4 <= end)
+		{
+			const uint16_t code = read16(option, cursor.swapped);
+			const size_t length = read16(option + 2, cursor.swapped);
+			if (code == 0 || option + 4 + length > end)
+				break;
+			//if_tsresol
+			if (code == 9 && length >= 1)
+			{
+				const uint8_t resolution = mData[option + 4];
+				interface.binary = (resolution & 0x80) != 0;
+				interface.exponent = resolution & 0x7F;
+			}
+			option += 4 + ((length + 3) & ~size_t(3));
+		}
+		cursor.interfaces.push_back(interface);
+		return true;
+	}
+
+	size_t CaptureReader::findRecordBoundary(size_t offset, const Cursor& initial) const noexcept
+	{
+		if (mFormat == CaptureFormat::kPcap)
+		{
+			for (size_t candidate = offset; candidate + kPcapRecordHeaderSize <= mSize; candidate++)
+			{
+				if (isPcapRecord(candidate))
+					return candidate;
+			}
+			return mSize;
+		}
+		//blocks are 32-bit aligned relative to the start of the file
+		for (size_t candidate = (offset + 3) & ~size_t(3); candidate + 12 <= mSize; candidate += 4)
+		{
+			if (isPcapNgBlock(candidate, initial.swapped))
+				return candidate;
+		}
+		return mSize;
+	}
+
+	bool CaptureReader::isPcapRecord(size_t offset) const noexcept
+	{
+		//a record header is plausible when its lengths and fraction are in range and the next one is plausible too
+		const uint32_t maxFraction = mNanoseconds ? 1000000000u : 1000000u;
+		const size_t maxCaptured = mSnapLength != 0 ? mSnapLength : 262144;
+		for (int i = 0; i < kBoundaryChain; i++)
+		{
+			if (offset == mSize)
+				return true;
+			if (offset + kPcapRecordHeaderSize > mSize)
+				return false;
+			const uint32_t fraction = read32(offset + 4, mFirst.swapped);
+			const size_t captured = read32(offset + 8, mFirst.swapped);
+			const size_t original = read32(offset + 12, mFirst.swapped);
+			if (fraction >= maxFraction || captured > maxCaptured || captured > original || captured == 0)
+				return false;
+			offset += kPcapRecordHeaderSize + captured;
+			if (offset > mSize)
+				return false;
+		}
+		return true;
+	}
+
+	bool CaptureReader::isPcapNgBlock(size_t offset, bool swapped) const noexcept
+	{
+		//the block length is repeated at the end of every block
+		for (int i = 0; i < kBoundaryChain; i++)
+		{
+			if (offset == mSize)
+				return true;
+			if (offset + 12 > mSize)
+				return false;
+			const uint32_t type = read32(offset, swapped);
+			const size_t length = read32(offset + 4, swapped);
+			if (type == kPcapNgSectionHeader || type == 0 || type > 0x0000FFFF)
+				return false;
+			if (length < 12 || length % 4 != 0 || length > mSize - offset)
+				return false;
+			if (read32(offset + length - 4, swapped) != length)
+				return false;
+			offset += length;
+		}
+		return true;
+	}
+
+	void CaptureReader::release(Cursor& cursor) const noexcept
+	{
+		if (cursor.offset - cursor.released < kReleaseSize)
+			return;
+		const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		const size_t begin = (cursor.released + page - 1) & ~(page - 1);
+		const size_t end = cursor.offset & ~(page - 1);
+		if (end > begin)
+			madvise(const_cast<uint8_t*>(mData) + begin, end - begin, MADV_DONTNEED);
+		cursor.released = end;
+	}
+
+	uint32_t CaptureReader::read32(size_t offset, bool swapped) const noexcept
+	{
+		uint32_t value;
+		memcpy(&value, mData + offset, sizeof(value));
+		return swapped ? ByteSwap(value) : value;
+	}
+
+	uint16_t CaptureReader::read16(size_t offset, bool swapped) const noexcept
+	{
+		uint16_t value;
+		memcpy(&value, mData + offset, sizeof(value));
+		return swapped ? ByteSwap(value) : value;
+	}
+}
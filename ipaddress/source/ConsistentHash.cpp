@@ -0,0 +1,311 @@
+#include "ConsistentHash.h"
+#include <algorithm>
+#include <limits>
+#include "util/AddressKey.h"
+
+namespace ip_address
+{
+	namespace
+	{
+		constexpr uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+		constexpr size_t kBatchSize = 32;
+
+		uint64_t hashAddress(const IPAddress& addr, uint64_t seed) noexcept
+		{
+			uint64_t hash = 0;
+			if (addr.isIPv4())
+				hash = details::AddressKey<IPAddressV4>::hash(details::AddressKey<IPAddressV4>::toKey(addr.asIPv4()));
+			else if (addr.isIPv6())
+				hash = details::AddressKey<IPAddressV6>::hash(details::AddressKey<IPAddressV6>::toKey(addr.asIPv6()));
+			return details::mix64(hash ^ seed);
+		}
+
+		bool isPrime(uint32_t n) noexcept
+		{
+			if (n < 2)
+				return false;
+			for (uint32_t i = 2; static_cast<uint64_t>(i) * i <= n; i++)
+			{
+				if (n % i == 0)
+					return false;
+			}
+			return true;
+		}
+
+		uint32_t nextPrime(uint32_t n) noexcept
+		{
+			while (!isPrime(n))
+				n++;
+			return n;
+		}
+
+		//x^-1 mod prime, by Fermat's little theorem
+		uint32_t inverse(uint32_t x, uint32_t prime) noexcept
+		{
+			uint64_t result = 1;
+			uint64_t base = x % prime;
+			for (uint32_t e = prime - 2; e != 0; e >>= 1)
+			{
+				if (e & 1)
+					result = result * base % prime;
+				base = base * base % prime;
+			}
+			return static_cast<uint32_t>(result);
+		}
+	}
+
+	uint32_t jumpConsistentHash(uint64_t key, uint32_t buckets) noexcept
+	{
+		assert(buckets > 0);
+		int64_t b = -1;
+		int64_t j = 0;
+		while (j < static_cast<int64_t>(buckets))
+		{
+			b = j;
+			key = key * 2862933555777941757ULL + 1;
+			j = static_cast<int64_t>(static_cast<double>(b + 1) * (static_cast<double>(1LL << 31)
+				/ static_cast<double>((key >> 33) + 1)));
+		}
+		return static_cast<uint32_t>(b);
+	}
+
+	uint32_t jumpConsistentHash(const IPAddress& client, uint32_t buckets, uint64_t seed) noexcept
+	{
+		return jumpConsistentHash(hashAddress(client, seed), buckets);
+	}
+
+	MaglevTable::MaglevTable(uint32_t tableSize, uint64_t seed) : mTableSize(nextPrime(std::max<uint32_t>(tableSize, 3))),
+		mSeed(seed), mTable(mTableSize, kEmpty) { }
+
+	void MaglevTable::setBackends(Span<const IPEndPoint> backends)
+	{
+		mBackends.clear();
+		mBackends.reserve(backends.size());
+		for (const IPEndPoint& endpoint : backends)
+		{
+			mBackends.push_back(makeBackend(endpoint));
+		}
+		//ordering by hash makes the table independent of the order the backends were given in
+		std::sort(mBackends.begin(), mBackends.end(), [](const Backend& lhs, const Backend& rhs)
+		{
+			return lhs.hash < rhs.hash;
+		});
+		size_t unique = 0;
+		for (size_t i = 0; i < mBackends.size(); i++)
+		{
+			bool duplicate = false;
+			for (size_t j = unique; j-- > 0 && mBackends[j].hash == mBackends[i].hash;)
+			{
+				duplicate |= mBackends[j].endpoint == mBackends[i].endpoint;
+			}
+			if (!duplicate)
+				mBackends[unique++] = mBackends[i];
+		}
+		mBackends.erase(mBackends.begin() + static_cast<std::ptrdiff_t>(unique), mBackends.end());
+		populate();
+	}
+
+	bool MaglevTable::addBackend(const IPEndPoint& backend)
+	{
+		if (find(backend) != mBackends.size())
+			return false;
+		const auto index = static_cast<uint32_t>(mBackends.size());
+		mBackends.push_back(makeBackend(backend));
+		Backend& added = mBackends.back();
+		if (index == 0)
+		{
+			std::fill(mTable.begin(), mTable.end(), 0);
+			added.slots = mTableSize;
+			return true;
+		}
+		//take the most preferred slots from backends above their share until this one has its share
+		const std::vector<uint32_t> shares = getShares();
+		for (uint32_t j = 0; j < mTableSize && added.slots < shares[index]; j++)
+		{
+			const uint32_t slot = getSlot(added, j);
+			const uint32_t owner = mTable[slot];
+			if (mBackends[owner].slots > shares[owner])
+			{
+				mBackends[owner].slots--;
+				added.slots++;
+				mTable[slot] = index;
+			}
+		}
+		return true;
+	}
+
+	bool MaglevTable::removeBackend(const IPEndPoint& backend)
+	{
+		const size_t removed = find(backend);
+		if (removed == mBackends.size())
+			return false;
+		const size_t last = mBackends.size() - 1;
+		if (last == 0)
+		{
+			mBackends.clear();
+			std::fill(mTable.begin(), mTable.end(), kEmpty);
+			return true;
+		}
+		//collect the freed slots and move the last backend into the removed index
+		std::vector<uint32_t> freed;
+		freed.reserve(mBackends[removed].slots);
+		for (uint32_t slot = 0; slot < mTableSize; slot++)
+		{
+			if (mTable[slot] == removed)
+				freed.push_back(slot);
+			else if (mTable[slot] == last)
+				mTable[slot] = static_cast<uint32_t>(removed);
+		}
+		mBackends[removed] = mBackends[last];
+		mBackends.pop_back();
+
+		//every freed slot goes to the backend that ranks it highest among those below their share
+		const std::vector<uint32_t> shares = getShares();
+		const auto count = static_cast<uint32_t>(mBackends.size());
+		for (const uint32_t slot : freed)
+		{
+			uint32_t best = kEmpty;
+			uint32_t bestRank = kEmpty;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (mBackends[i].slots >= shares[i])
+					continue;
+				const uint32_t rank = getRank(mBackends[i], slot);
+				if (rank < bestRank)
+				{
+					bestRank = rank;
+					best = i;
+				}
+			}
+			mTable[slot] = best;
+			mBackends[best].slots++;
+		}
+		return true;
+	}
+
+	const IPEndPoint* MaglevTable::lookup(const IPAddress& client) const noexcept
+	{
+		if (mBackends.empty())
+			return nullptr;
+		return &mBackends[mTable[getSlotIndex(client)]].endpoint;
+	}
+
+	void MaglevTable::lookup(Span<const IPAddress> clients, const IPEndPoint** backends) const noexcept
+	{
+		if (mBackends.empty())
+		{
+			std::fill(backends, backends + clients.size(), nullptr);
+			return;
+		}
+		//hash a block first so the table reads of the block are independent of each other
+		uint32_t slots[kBatchSize];
+		for (size_t begin = 0; begin < clients.size(); begin += kBatchSize)
+		{
+			const size_t count = std::min(kBatchSize, clients.size() - begin);
+			for (size_t i = 0; i < count; i++)
+			{
+				slots[i] = getSlotIndex(clients[begin + i]);
+			}
+			for (size_t i = 0; i < count; i++)
+			{
+				backends[begin + i] = &mBackends[mTable[slots[i]]].endpoint;
+			}
+		}
+	}
+
+	uint32_t MaglevTable::getSlotCount(const IPEndPoint& backend) const noexcept
+	{
+		const size_t index = find(backend);
+		return index == mBackends.size() ? 0 : mBackends[index].slots;
+	}
+
+	std::vector<uint32_t> MaglevTable::getShares() const
+	{
+		//tableSize / count slots each, the remainder goes to the backends that own the most slots right now
+		const auto count = static_cast<uint32_t>(mBackends.size());
+		std::vector<uint32_t> shares(count, mTableSize / count);
+		std::vector<uint32_t> order(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			order[i] = i;
+		}
+		const uint32_t remainder = mTableSize % count;
+		std::partial_sort(order.begin(), order.begin() + remainder, order.end(), [this](uint32_t lhs, uint32_t rhs)
+		{
+			return mBackends[lhs].slots > mBackends[rhs].slots || (mBackends[lhs].slots == mBackends[rhs].slots && lhs < rhs);
+		});
+		for (uint32_t i = 0; i < remainder; i++)
+		{
+			shares[order[i]]++;
+		}
+		return shares;
+	}
+
+	MaglevTable::Backend MaglevTable::makeBackend(const IPEndPoint& endpoint) const noexcept
+	{
+		const uint64_t hash = hashAddress(endpoint, mSeed ^ details::mix64(endpoint.getPort() + 1));
+		Backend backend{ endpoint, hash, 0, 0, 0, 0 };
+		backend.offset = static_cast<uint32_t>(hash % mTableSize);
+		backend.skip = static_cast<uint32_t>(details::mix64(hash) % (mTableSize - 1)) + 1;
+		backend.skipInverse = inverse(backend.skip, mTableSize);
+		return backend;
+	}
+
+	uint32_t MaglevTable::getSlot(const Backend& backend, uint64_t j) const noexcept
+	{
+		return static_cast<uint32_t>((backend.offset + j * backend.skip) % mTableSize);
+	}
+
+	uint32_t MaglevTable::getRank(const Backend& backend, uint32_t slot) const noexcept
+	{
+		const uint64_t distance = (static_cast<uint64_t>(slot) + mTableSize - backend.offset) % mTableSize;
+		return static_cast<uint32_t>(distance * backend.skipInverse % mTableSize);
+	}
+
+	uint32_t MaglevTable::getSlotIndex(const IPAddress& client) const noexcept
+	{
+		//multiply-shift range reduction instead of a modulo
+		const auto hash = static_cast<uint32_t>(hashAddress(client, mSeed));
+		return static_cast<uint32_t>(static_cast<uint64_t>(hash) * mTableSize >> 32);
+	}
+
+	size_t MaglevTable::find(const IPEndPoint& endpoint) const noexcept
+	{
+		const uint64_t hash = makeBackend(endpoint).hash;
+		for (size_t i = 0; i < mBackends.size(); i++)
+		{
+			if (mBackends[i].hash == hash && mBackends[i].endpoint == endpoint)
+				return i;
+		}
+		return mBackends.size();
+	}
+
+	void MaglevTable::populate()
+	{
+		std::fill(mTable.begin(), mTable.end(), kEmpty);
+		for (Backend& backend : mBackends)
+		{
+			backend.slots = 0;
+		}
+		if (mBackends.empty())
+			return;
+		std::vector<uint64_t> next(mBackends.size(), 0);
+		uint32_t filled = 0;
+		while (true)
+		{
+			for (size_t i = 0; i < mBackends.size(); i++)
+			{
+				uint32_t slot = getSlot(mBackends[i], next[i]);
+				while (mTable[slot] != kEmpty)
+				{
+					slot = getSlot(mBackends[i], ++next[i]);
+				}
+				mTable[slot] = static_cast<uint32_t>(i);
+				mBackends[i].slots++;
+				next[i]++;
+				if (++filled == mTableSize)
+					return;
+			}
+		}
+	}
+}
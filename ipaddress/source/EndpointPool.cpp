@@ -0,0 +1,194 @@
+#include "EndpointPool.h"
+#include <algorithm>
+#include "util/AddressKey.h"
+
+namespace ip_address
+{
+	namespace
+	{
+		//xorshift64* per thread, seeded from the thread index so threads do not pick in lockstep
+		uint64_t nextRandom() noexcept
+		{
+			thread_local uint64_t state = details::mix64(details::getThreadIndex() + 0x9E3779B97F4A7C15ULL) | 1;
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1DULL;
+		}
+
+		uint32_t reduce(uint32_t x, size_t range) noexcept
+		{
+			return static_cast<uint32_t>(static_cast<uint64_t>(x) * range >> 32);
+		}
+	}
+
+	EndpointPool::Lease& EndpointPool::Lease::operator=(Lease&& other) noexcept
+	{
+		if (this != &other)
+		{
+			release();
+			mBackend = other.mBackend;
+			mDecay = other.mDecay;
+			other.mBackend = nullptr;
+		}
+		return *this;
+	}
+
+	void EndpointPool::Lease::complete(uint64_t latency) noexcept
+	{
+		if (mBackend == nullptr)
+			return;
+		//a plain load and store, concurrent samples may overwrite each other which only drops samples
+		const uint64_t average = mBackend->latency.load(std::memory_order_relaxed);
+		const int64_t delta = static_cast<int64_t>(latency - average) >> mDecay;
+		mBackend->latency.store(average + static_cast<uint64_t>(delta), std::memory_order_relaxed);
+		release();
+	}
+
+	void EndpointPool::Lease::release() noexcept
+	{
+		if (mBackend == nullptr)
+			return;
+		mBackend->inFlight.fetch_sub(1, std::memory_order_release);
+		mBackend = nullptr;
+	}
+
+	EndpointPool::EndpointPool(uint64_t initialLatency, uint8_t decayShift) : mInitialLatency(std::max<uint64_t>(initialLatency, 1)),
+		mDecayShift(std::min<uint8_t>(decayShift, 31)), mSnapshot(std::unique_ptr<Snapshot>(new Snapshot())) { }
+
+	EndpointPool::~EndpointPool() = default;
+
+	void EndpointPool::setBackends(Span<const IPEndPoint> backends)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		std::vector<std::unique_ptr<Backend>> next;
+		next.reserve(backends.size());
+		for (const IPEndPoint& endpoint : backends)
+		{
+			//entries of mBackends that were already moved into next are empty
+			const auto same = [&endpoint](const std::unique_ptr<Backend>& backend)
+			{
+				return backend && backend->endpoint == endpoint;
+			};
+			if (std::any_of(next.begin(), next.end(), same))
+				continue;
+			const auto existing = std::find_if(mBackends.begin(), mBackends.end(), same);
+			if (existing != mBackends.end())
+				next.push_back(std::move(*existing));
+			else
+				next.emplace_back(new Backend(endpoint, mInitialLatency));
+		}
+		for (auto& backend : mBackends)
+		{
+			if (backend)
+				mRetired.push_back(std::move(backend));
+		}
+		mBackends = std::move(next);
+		publish();
+	}
+
+	bool EndpointPool::addBackend(const IPEndPoint& backend)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (const auto& owned : mBackends)
+		{
+			if (owned->endpoint == backend)
+				return false;
+		}
+		mBackends.emplace_back(new Backend(backend, mInitialLatency));
+		publish();
+		return true;
+	}
+
+	bool EndpointPool::removeBackend(const IPEndPoint& backend)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		const auto it = std::find_if(mBackends.begin(), mBackends.end(), [&backend](const std::unique_ptr<Backend>& owned)
+		{
+			return owned->endpoint == backend;
+		});
+		if (it == mBackends.end())
+			return false;
+		mRetired.push_back(std::move(*it));
+		mBackends.erase(it);
+		publish();
+		return true;
+	}
+
+	EndpointPool::Lease EndpointPool::acquire() noexcept
+	{
+		const auto snapshot = mSnapshot.read();
+		const std::vector<Backend*>& backends = snapshot->backends;
+		const size_t count = backends.size();
+		if (count == 0)
+			return Lease();
+		Backend* chosen = backends[0];
+		if (count > 1)
+		{
+			//two distinct indices from one random number
+			const uint64_t random = nextRandom();
+			const uint32_t first = reduce(static_cast<uint32_t>(random), count);
+			uint32_t second = reduce(static_cast<uint32_t>(random >> 32), count - 1);
+			second += second >= first ? 1 : 0;
+			Backend* a = backends[first];
+			Backend* b = backends[second];
+			const uint64_t loadA = (a->inFlight.load(std::memory_order_relaxed) + 1ULL) * a->latency.load(std::memory_order_relaxed);
+			const uint64_t loadB = (b->inFlight.load(std::memory_order_relaxed) + 1ULL) * b->latency.load(std::memory_order_relaxed);
+			chosen = loadA <= loadB ? a : b;
+		}
+		//counted while the snapshot is pinned, so publish() sees it after the grace period
+		chosen->inFlight.fetch_add(1, std::memory_order_acq_rel);
+		return Lease(chosen, mDecayShift);
+	}
+
+	size_t EndpointPool::getBackendCount() const noexcept
+	{
+		return mSnapshot.read()->backends.size();
+	}
+
+	bool EndpointPool::contains(const IPEndPoint& backend) const noexcept
+	{
+		const auto snapshot = mSnapshot.read();
+		return find(*snapshot, backend) != nullptr;
+	}
+
+	uint32_t EndpointPool::getInFlight(const IPEndPoint& backend) const noexcept
+	{
+		const auto snapshot = mSnapshot.read();
+		const Backend* found = find(*snapshot, backend);
+		return found == nullptr ? 0 : found->inFlight.load(std::memory_order_relaxed);
+	}
+
+	uint64_t EndpointPool::getLatency(const IPEndPoint& backend) const noexcept
+	{
+		const auto snapshot = mSnapshot.read();
+		const Backend* found = find(*snapshot, backend);
+		return found == nullptr ? 0 : found->latency.load(std::memory_order_relaxed);
+	}
+
+	const EndpointPool::Backend* EndpointPool::find(const Snapshot& snapshot, const IPEndPoint& backend) noexcept
+	{
+		for (const Backend* candidate : snapshot.backends)
+		{
+			if (candidate->endpoint == backend)
+				return candidate;
+		}
+		return nullptr;
+	}
+
+	void EndpointPool::publish()
+	{
+		std::unique_ptr<Snapshot> next(new Snapshot());
+		next->backends.reserve(mBackends.size());
+		for (const auto& backend : mBackends)
+		{
+			next->backends.push_back(backend.get());
+		}
+		//returns after every acquire() on the old snapshot has finished and counted its lease
+		mSnapshot.update(std::move(next));
+		mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(), [](const std::unique_ptr<Backend>& backend)
+		{
+			return backend->inFlight.load(std::memory_order_acquire) == 0;
+		}), mRetired.end());
+	}
+}
@@ -0,0 +1,73 @@
+#include "FlowKey.h"
+
+namespace ip_address
+{
+	FlowKey::FlowKey(const IPEndPoint& source, const IPEndPoint& destination, uint8_t protocol) noexcept :
+		mSource(source.mAddr.mIpAddress6), mDestination(destination.mAddr.mIpAddress6),
+		mSourcePort(source.getPort()), mDestinationPort(destination.getPort()), mProtocol(protocol),
+		mVersion(source.getVersion())
+	{
+		assert(source.getVersion() == destination.getVersion());
+		if (mVersion == IPVersion::kIPv4)
+		{
+			//an IPv4 address is the first 4 bytes, the rest may be left from an earlier IPv6 value of the storage
+			const ByteArray16& sourceBytes = mSource.bytes();
+			const ByteArray16& destinationBytes = mDestination.bytes();
+			mSource = IPAddressV6(ByteArray16{ sourceBytes[0], sourceBytes[1], sourceBytes[2], sourceBytes[3] });
+			mDestination = IPAddressV6(ByteArray16{ destinationBytes[0], destinationBytes[1], destinationBytes[2],
+				destinationBytes[3] });
+		}
+	}
+
+	bool FlowKey::operator==(const FlowKey& rhs) const noexcept
+	{
+		return mVersion == rhs.mVersion && mProtocol == rhs.mProtocol && mSourcePort == rhs.mSourcePort
+			&& mDestinationPort == rhs.mDestinationPort && mSource == rhs.mSource && mDestination == rhs.mDestination;
+	}
+
+	bool FlowKey::operator!=(const FlowKey& rhs) const noexcept
+	{
+		return !this->operator==(rhs);
+	}
+
+	IPEndPoint FlowKey::getSource() const
+	{
+		IPEndPoint endpoint;
+		endpoint.mAddr.mIpAddress6 = mSource;
+		endpoint.mVersion = mVersion;
+		endpoint = mSourcePort;
+		return endpoint;
+	}
+
+	IPEndPoint FlowKey::getDestination() const
+	{
+		IPEndPoint endpoint;
+		endpoint.mAddr.mIpAddress6 = mDestination;
+		endpoint.mVersion = mVersion;
+		endpoint = mDestinationPort;
+		return endpoint;
+	}
+
+	FlowKey FlowKey::reversed() const noexcept
+	{
+		FlowKey key(*this);
+		std::swap(key.mSource, key.mDestination);
+		std::swap(key.mSourcePort, key.mDestinationPort);
+		return key;
+	}
+
+	size_t FlowKey::getHashInput(uint8_t* out, bool includePorts) const noexcept
+	{
+		const size_t addressSize = mVersion == IPVersion::kIPv6 ? 16 : 4;
+		memcpy(out, &mSource, addressSize);
+		memcpy(out + addressSize, &mDestination, addressSize);
+		size_t size = addressSize * 2;
+		if (includePorts)
+		{
+			const uint16_t ports[2] = { HostToNet16(mSourcePort), HostToNet16(mDestinationPort) };
+			memcpy(out + size, ports, sizeof(ports));
+			size += sizeof(ports);
+		}
+		return size;
+	}
+}
@@ -0,0 +1,168 @@
+#include "HappyEyeballs.h"
+#include <algorithm>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace ip_address
+{
+	namespace
+	{
+		constexpr int kMaxEvents = 16;
+
+		std::chrono::steady_clock::time_point now() noexcept
+		{
+			return std::chrono::steady_clock::now();
+		}
+
+		int getMilliseconds(std::chrono::steady_clock::duration duration) noexcept
+		{
+			//rounded up so a wait never ends just before its deadline
+			const auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(duration).count();
+			return static_cast<int>(std::max<int64_t>(milliseconds, 0));
+		}
+
+		struct Attempt
+		{
+			int fd;
+			size_t index;
+		};
+	}
+
+	HappyEyeballsConnector::HappyEyeballsConnector() : HappyEyeballsConnector(Options()) { }
+
+	HappyEyeballsConnector::HappyEyeballsConnector(Options options) : HappyEyeballsConnector(options, AddressSorter()) { }
+
+	HappyEyeballsConnector::HappyEyeballsConnector(Options options, AddressSorter sorter) : mOptions(options),
+		mSorter(std::move(sorter)) { }
+
+	ConnectResult HappyEyeballsConnector::connect(const std::vector<IPEndPoint>& endpoints) const
+	{
+		std::vector<IPEndPoint> ordered(endpoints);
+		if (!mOptions.keepOrder)
+			mSorter.sort(ordered);
+		ordered = interleave(ordered);
+		return race(Span<const IPEndPoint>(ordered.data(), ordered.size()));
+	}
+
+	std::vector<IPEndPoint> HappyEyeballsConnector::interleave(const std::vector<IPEndPoint>& sorted)
+	{
+		if (sorted.empty())
+			return sorted;
+		std::vector<IPEndPoint> first;
+		std::vector<IPEndPoint> second;
+		const bool firstIsIPv6 = sorted.front().isIPv6();
+		for (const IPEndPoint& endpoint : sorted)
+		{
+			(endpoint.isIPv6() == firstIsIPv6 ? first : second).push_back(endpoint);
+		}
+		std::vector<IPEndPoint> result;
+		result.reserve(sorted.size());
+		for (size_t i = 0; i < std::max(first.size(), second.size()); i++)
+		{
+			if (i < first.size())
+				result.push_back(first[i]);
+			if (i < second.size())
+				result.push_back(second[i]);
+		}
+		return result;
+	}
+
+	ConnectResult HappyEyeballsConnector::race(Span<const IPEndPoint> endpoints) const
+	{
+		ConnectResult result;
+		result.error = ETIMEDOUT;
+		const int epoll = epoll_create1(EPOLL_CLOEXEC);
+		if (epoll < 0)
+		{
+			result.error = errno;
+			return result;
+		}
+
+		std::vector<Attempt> active;
+		size_t next = 0;
+		const auto deadline = now() + mOptions.timeout;
+		auto nextAttempt = now();
+		while (result.fd < 0)
+		{
+			const auto time = now();
+			if (time >= deadline)
+			{
+				result.error = ETIMEDOUT;
+				break;
+			}
+			//start the next attempt when its delay has passed or nothing else is in flight
+			if (next < endpoints.size() && (time >= nextAttempt || active.empty()))
+			{
+				const IPEndPoint& endpoint = endpoints[next];
+				const size_t index = next++;
+				result.attempts++;
+				nextAttempt = time + mOptions.attemptDelay;
+				sockaddr_storage address;
+				socklen_t addressLength;
+				endpoint.writeSockaddr(address, addressLength);
+				const int fd = socket(address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+				if (fd < 0)
+				{
+					result.error = errno;
+					continue;
+				}
+				if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), addressLength) == 0)
+				{
+					result.fd = fd;
+					result.endpoint = endpoint;
+					break;
+				}
+				epoll_event event = {};
+				event.events = EPOLLOUT;
+				event.data.fd = fd;
+				if (errno != EINPROGRESS || epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+				{
+					result.error = errno;
+					close(fd);
+					continue;
+				}
+				active.push_back({ fd, index });
+				continue;
+			}
+			if (active.empty())
+				break;
+
+			const auto wakeUp = next < endpoints.size() ? std::min(deadline, nextAttempt) : deadline;
+			epoll_event events[kMaxEvents];
+			const int count = epoll_wait(epoll, events, kMaxEvents, getMilliseconds(wakeUp - time));
+			for (int i = 0; i < count && result.fd < 0; i++)
+			{
+				const int fd = events[i].data.fd;
+				const auto attempt = std::find_if(active.begin(), active.end(), [fd](const Attempt& current)
+				{
+					return current.fd == fd;
+				});
+				int error = 0;
+				socklen_t errorLength = sizeof(error);
+				if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &errorLength) != 0)
+					error = errno;
+				epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+				if (error == 0)
+				{
+					result.fd = fd;
+					result.endpoint = endpoints[attempt->index];
+				}
+				else
+				{
+					//a failed attempt starts the next one right away
+					result.error = error;
+					close(fd);
+					nextAttempt = now();
+				}
+				active.erase(attempt);
+			}
+		}
+		for (const Attempt& attempt : active)
+		{
+			close(attempt.fd);
+		}
+		close(epoll);
+		return result;
+	}
+}
@@ -0,0 +1,138 @@
+#include "HierarchicalHeavyHitters.h"
+#include <cmath>
+
+namespace ip_address
+{
+	template <typename Address>
+	HierarchicalHeavyHitters<Address>::HierarchicalHeavyHitters(size_t countersPerLevel, uint8_t minPrefixLength,
+	                                                            uint8_t granularity, double confidenceZ,
+	                                                            uint64_t seed) :
+		mConfidenceZ(confidenceZ), mRandomState(seed == 0 ? 1 : seed)
+	{
+		assert(granularity > 0 && "granularity must be at least 1 bit");
+		assert(minPrefixLength <= Traits::kBits);
+		for (int prefixLength = Traits::kBits; prefixLength >= minPrefixLength; prefixLength -= granularity)
+		{
+			mPrefixLengths.push_back(static_cast<uint8_t>(prefixLength));
+		}
+		mLevels.reserve(mPrefixLengths.size());
+		for (size_t i = 0; i < mPrefixLengths.size(); i++)
+		{
+			mLevels.emplace_back(countersPerLevel);
+		}
+	}
+
+	template <typename Address>
+	uint32_t HierarchicalHeavyHitters<Address>::nextLevel() noexcept
+	{
+		//xorshift64* followed by a multiply-shift range reduction, avoids a division per packet
+		mRandomState ^= mRandomState >> 12;
+		mRandomState ^= mRandomState << 25;
+		mRandomState ^= mRandomState >> 27;
+		const uint32_t random = static_cast<uint32_t>((mRandomState * 0x2545F4914F6CDD1DULL) >> 32);
+		return static_cast<uint32_t>((static_cast<uint64_t>(random) * mLevels.size()) >> 32);
+	}
+
+	template <typename Address>
+	void HierarchicalHeavyHitters<Address>::update(const Address& addr) noexcept
+	{
+		mPacketCount++;
+		const uint32_t level = this->nextLevel();
+		mLevels[level].increment(Traits::truncate(Traits::toKey(addr), mPrefixLengths[level]));
+	}
+
+	template <typename Address>
+	std::vector<HeavyHitter> HierarchicalHeavyHitters<Address>::query(double phi) const
+	{
+		struct Reported
+		{
+			Key key;
+			uint8_t prefixLength;
+			uint64_t lowerBound;
+		};
+
+		std::vector<HeavyHitter> result;
+		std::vector<Reported> reported;
+		std::vector<size_t> descendants;
+
+		const double levelCount = static_cast<double>(mLevels.size());
+		const double threshold = phi * static_cast<double>(mPacketCount);
+		const double correction = 2.0 * mConfidenceZ * std::sqrt(static_cast<double>(mPacketCount) * levelCount);
+		const uint64_t scale = mLevels.size();
+
+		for (size_t level = 0; level < mLevels.size(); level++)
+		{
+			const uint8_t prefixLength = mPrefixLengths[level];
+			//prefixes reported at this level are appended as they are found, only the ones before reportedBelow are
+			//discounted so siblings never discount each other
+			const size_t reportedBelow = reported.size();
+			mLevels[level].forEach([&](const Key& key, uint64_t count, uint64_t error)
+			{
+				const uint64_t upperBound = count * scale;
+				const uint64_t lowerBound = (count - error) * scale;
+				if (static_cast<double>(upperBound) + correction < threshold)
+					return;
+
+				//closest reported descendants, i.e descendants that are not inside another reported descendant
+				descendants.clear();
+				for (size_t i = 0; i < reportedBelow; i++)
+				{
+					if (Traits::truncate(reported[i].key, prefixLength) == key)
+						descendants.push_back(i);
+				}
+				double conditioned = static_cast<double>(upperBound) + correction;
+				for (const size_t i : descendants)
+				{
+					bool closest = true;
+					for (const size_t j : descendants)
+					{
+						if (reported[j].prefixLength < reported[i].prefixLength &&
+							Traits::truncate(reported[i].key, reported[j].prefixLength) == reported[j].key)
+						{
+							closest = false;
+							break;
+						}
+					}
+					if (closest)
+						conditioned -= static_cast<double>(reported[i].lowerBound);
+				}
+				if (conditioned < threshold)
+					return;
+
+				reported.push_back(Reported{ key, prefixLength, lowerBound });
+				HeavyHitter hitter;
+				hitter.network = IPNetwork(Traits::toAddress(key), prefixLength);
+				hitter.lowerBound = lowerBound;
+				hitter.upperBound = upperBound;
+				hitter.conditionedCount = conditioned - correction > 0.0 ? static_cast<uint64_t>(conditioned - correction) : 0;
+				result.push_back(hitter);
+			});
+		}
+		return result;
+	}
+
+	template <typename Address>
+	uint64_t HierarchicalHeavyHitters<Address>::getPacketCount() const noexcept
+	{
+		return mPacketCount;
+	}
+
+	template <typename Address>
+	const std::vector<uint8_t>& HierarchicalHeavyHitters<Address>::getPrefixLengths() const noexcept
+	{
+		return mPrefixLengths;
+	}
+
+	template <typename Address>
+	void HierarchicalHeavyHitters<Address>::clear() noexcept
+	{
+		for (auto& level : mLevels)
+		{
+			level.clear();
+		}
+		mPacketCount = 0;
+	}
+
+	template class HierarchicalHeavyHitters<IPAddressV4>;
+	template class HierarchicalHeavyHitters<IPAddressV6>;
+}
@@ -0,0 +1,397 @@
+#include "HostTable.h"
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "util/AddressKey.h"
+
+namespace ip_address
+{
+	/*
+	 * File layout, native byte order:
+	 *	FileHeader
+	 *	uint32_t seeds[bucketCount], padded to 8 bytes
+	 *	HostTableSlot slots[nameCount]
+	 *	FileAddress addresses[addressCount]
+	 *	char names[namesSize]
+	 */
+	namespace
+	{
+		using Slot = details::HostTableSlot;
+
+		constexpr char kMagic[8] = { 'I', 'P', 'H', 'O', 'S', 'T', 'S', '\0' };
+		constexpr uint32_t kFormatVersion = 1;
+		//average names per bucket, higher makes the seed array smaller and the build slower
+		constexpr uint32_t kBucketLoad = 4;
+		constexpr uint32_t kMaxAddressesPerName = UINT16_MAX;
+
+		struct FileHeader
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t nameCount;
+			uint32_t bucketCount;
+			uint32_t addressCount;
+			uint64_t namesSize;
+		};
+		static_assert(sizeof(FileHeader) == 32, "header layout is part of the file format");
+
+		struct FileAddress
+		{
+			uint8_t version;
+			uint8_t reserved[3];
+			uint8_t bytes[16];
+		};
+		static_assert(sizeof(FileAddress) == 20, "address layout is part of the file format");
+
+		char toLower(char c) noexcept
+		{
+			return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+		}
+
+		std::string_view trimName(std::string_view name) noexcept
+		{
+			if (!name.empty() && name.back() == '.')
+				name.remove_suffix(1);
+			return name;
+		}
+
+		//ASCII lower case of 8 bytes at once, only 'A'..'Z' change
+		uint64_t toLower8(uint64_t word) noexcept
+		{
+			constexpr uint64_t kHigh = 0x8080808080808080ULL;
+			const uint64_t heptets = word & ~kHigh;
+			const uint64_t aboveA = heptets + 0x3F3F3F3F3F3F3F3FULL;
+			const uint64_t aboveZ = heptets + 0x2525252525252525ULL;
+			const uint64_t upper = (aboveA ^ aboveZ) & ~word & kHigh;
+			return word | (upper >> 2);
+		}
+
+		//8 byte words of name in lower case, the last one zero padded
+		uint64_t loadWord(std::string_view name, size_t offset) noexcept
+		{
+			uint64_t word = 0;
+			memcpy(&word, name.data() + offset, std::min<size_t>(8, name.size() - offset));
+			return toLower8(word);
+		}
+
+		uint64_t hashName(std::string_view name) noexcept
+		{
+			uint64_t hash = name.size() * 0x9E3779B97F4A7C15ULL;
+			for (size_t offset = 0; offset < name.size(); offset += 8)
+			{
+				hash = (hash ^ loadWord(name, offset)) * 0xBF58476D1CE4E5B9ULL;
+				hash ^= hash >> 29;
+			}
+			return details::mix64(hash);
+		}
+
+		uint32_t reduce(uint64_t hash, uint32_t range) noexcept
+		{
+			return static_cast<uint32_t>((hash >> 32) * range >> 32);
+		}
+
+		uint32_t getBucket(uint64_t hash, uint32_t bucketCount) noexcept
+		{
+			return reduce(hash, bucketCount);
+		}
+
+		uint32_t getSlot(uint64_t hash, uint32_t seed, uint32_t slotCount) noexcept
+		{
+			return reduce(details::mix64(hash ^ (seed * 0x9E3779B97F4A7C15ULL)), slotCount);
+		}
+
+		//stored names are lower case already
+		bool equalsIgnoreCase(std::string_view lhs, const char* rhs) noexcept
+		{
+			for (size_t offset = 0; offset < lhs.size(); offset += 8)
+			{
+				const size_t size = std::min<size_t>(8, lhs.size() - offset);
+				uint64_t stored = 0;
+				memcpy(&stored, rhs + offset, size);
+				if (loadWord(lhs, offset) != stored)
+					return false;
+			}
+			return true;
+		}
+
+		size_t align8(size_t size) noexcept
+		{
+			return (size + 7) & ~size_t(7);
+		}
+
+		bool isValidName(const std::string& name) noexcept
+		{
+			if (name.empty() || name.size() > 253 || name.front() == '.' || name.find("..") != std::string::npos)
+				return false;
+			return std::all_of(name.begin(), name.end(), [](char c) { return static_cast<unsigned char>(c) > ' '; });
+		}
+
+		bool parseAddress(const std::string& text, IPAddress& addr)
+		{
+			ByteArray4 bytes4;
+			ByteArray16 bytes6;
+			if (inet_pton(AF_INET, text.c_str(), bytes4.data()) == 1)
+				addr = IPAddress(bytes4);
+			else if (inet_pton(AF_INET6, text.c_str(), bytes6.data()) == 1)
+				addr = IPAddress(bytes6);
+			else
+				return false;
+			return true;
+		}
+	}
+
+	HostTable::HostTable(const std::string& path)
+	{
+		const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			throw std::runtime_error("can not open host table");
+		struct stat info = {};
+		if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader)))
+		{
+			close(fd);
+			throw std::runtime_error("invalid host table");
+		}
+		mSize = static_cast<size_t>(info.st_size);
+		void* mapped = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (mapped == MAP_FAILED)
+			throw std::runtime_error("can not map host table");
+		mData = static_cast<const uint8_t*>(mapped);
+
+		FileHeader header;
+		memcpy(&header, mData, sizeof(header));
+		const size_t seedsSize = align8(static_cast<size_t>(header.bucketCount) * sizeof(uint32_t));
+		const size_t slotsSize = static_cast<size_t>(header.nameCount) * sizeof(Slot);
+		const size_t addressesSize = static_cast<size_t>(header.addressCount) * sizeof(FileAddress);
+		if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFormatVersion ||
+			header.bucketCount == 0 || sizeof(FileHeader) + seedsSize + slotsSize + addressesSize + header.namesSize != mSize)
+		{
+			munmap(mapped, mSize);
+			throw std::runtime_error("invalid host table");
+		}
+		mNameCount = header.nameCount;
+		mBucketCount = header.bucketCount;
+		mSeeds = reinterpret_cast<const uint32_t*>(mData + sizeof(FileHeader));
+		mSlots = reinterpret_cast<const Slot*>(mData + sizeof(FileHeader) + seedsSize);
+		const auto* addresses = reinterpret_cast<const FileAddress*>(mData + sizeof(FileHeader) + seedsSize + slotsSize);
+		mNames = reinterpret_cast<const char*>(addresses + header.addressCount);
+
+		for (uint32_t i = 0; i < mNameCount; i++)
+		{
+			const Slot& slot = mSlots[i];
+			if (slot.nameOffset + static_cast<uint64_t>(slot.nameLength) > header.namesSize ||
+				slot.firstAddress + static_cast<uint64_t>(slot.addressCount) > header.addressCount)
+			{
+				munmap(mapped, mSize);
+				throw std::runtime_error("invalid host table");
+			}
+		}
+		mAddresses.reserve(header.addressCount);
+		for (uint32_t i = 0; i < header.addressCount; i++)
+		{
+			const FileAddress& address = addresses[i];
+			if (address.version == 4)
+				mAddresses.emplace_back(ByteArray4{ address.bytes[0], address.bytes[1], address.bytes[2], address.bytes[3] });
+			else
+			{
+				ByteArray16 bytes;
+				memcpy(bytes.data(), address.bytes, bytes.size());
+				mAddresses.emplace_back(bytes);
+			}
+		}
+	}
+
+	HostTable::~HostTable()
+	{
+		munmap(const_cast<uint8_t*>(mData), mSize);
+	}
+
+	Span<const IPAddress> HostTable::lookup(std::string_view name) const noexcept
+	{
+		name = trimName(name);
+		if (mNameCount == 0)
+			return Span<const IPAddress>();
+		const uint64_t hash = hashName(name);
+		const Slot& slot = mSlots[getSlot(hash, mSeeds[getBucket(hash, mBucketCount)], mNameCount)];
+		if (slot.tag != static_cast<uint32_t>(hash) || slot.nameLength != name.size() ||
+			!equalsIgnoreCase(name, mNames + slot.nameOffset))
+			return Span<const IPAddress>();
+		return Span<const IPAddress>(mAddresses.data() + slot.firstAddress, slot.addressCount);
+	}
+
+	bool HostTableBuilder::add(const std::string& name, const IPAddress& addr)
+	{
+		std::string key(trimName(name));
+		if (!isValidName(key) || !(addr.isIPv4() || addr.isIPv6()))
+			return false;
+		std::transform(key.begin(), key.end(), key.begin(), toLower);
+		std::vector<IPAddress>& addresses = mNames[key];
+		if (addresses.size() < kMaxAddressesPerName && std::find(addresses.begin(), addresses.end(), addr) == addresses.end())
+			addresses.push_back(addr);
+		return true;
+	}
+
+	size_t HostTableBuilder::addHosts(std::istream& hosts)
+	{
+		size_t skipped = 0;
+		std::string line;
+		while (std::getline(hosts, line))
+		{
+			line.erase(std::find(line.begin(), line.end(), '#'), line.end());
+			std::istringstream words(line);
+			std::string address;
+			if (!(words >> address))
+				continue;
+			IPAddress addr;
+			std::string name;
+			bool valid = parseAddress(address, addr);
+			bool named = false;
+			while (valid && words >> name)
+			{
+				valid = add(name, addr);
+				named = true;
+			}
+			if (!valid || !named)
+				skipped++;
+		}
+		return skipped;
+	}
+
+	std::vector<uint8_t> HostTableBuilder::build() const
+	{
+		const auto nameCount = static_cast<uint32_t>(mNames.size());
+		const uint32_t bucketCount = nameCount / kBucketLoad + 1;
+
+		//names grouped by bucket, the largest buckets pick their seeds first while most slots are still free
+		std::vector<std::pair<uint64_t, const std::string*>> hashes;
+		hashes.reserve(nameCount);
+		for (const auto& entry : mNames)
+		{
+			hashes.emplace_back(hashName(entry.first), &entry.first);
+		}
+		std::vector<std::vector<uint32_t>> buckets(bucketCount);
+		for (uint32_t i = 0; i < nameCount; i++)
+		{
+			buckets[getBucket(hashes[i].first, bucketCount)].push_back(i);
+		}
+		std::vector<uint32_t> order(bucketCount);
+		for (uint32_t i = 0; i < bucketCount; i++)
+		{
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t lhs, uint32_t rhs)
+		{
+			return buckets[lhs].size() > buckets[rhs].size();
+		});
+
+		std::vector<uint32_t> seeds(bucketCount, 0);
+		//name index per slot
+		std::vector<uint32_t> slotNames(nameCount, UINT32_MAX);
+		std::vector<uint32_t> candidate;
+		for (const uint32_t bucket : order)
+		{
+			const std::vector<uint32_t>& members = buckets[bucket];
+			if (members.empty())
+				break;
+			for (uint32_t seed = 0;; seed++)
+			{
+				candidate.clear();
+				bool placed = true;
+				for (const uint32_t member : members)
+				{
+					const uint32_t slot = getSlot(hashes[member].first, seed, nameCount);
+					if (slotNames[slot] != UINT32_MAX || std::find(candidate.begin(), candidate.end(), slot) != candidate.end())
+					{
+						placed = false;
+						break;
+					}
+					candidate.push_back(slot);
+				}
+				if (!placed)
+					continue;
+				for (size_t i = 0; i < members.size(); i++)
+				{
+					slotNames[candidate[i]] = members[i];
+				}
+				seeds[bucket] = seed;
+				break;
+			}
+		}
+
+		//addresses and names are laid out in name order, which keeps the output deterministic
+		std::vector<Slot> nameSlots(nameCount);
+		std::vector<FileAddress> addresses;
+		std::string names;
+		uint32_t index = 0;
+		for (const auto& entry : mNames)
+		{
+			Slot& slot = nameSlots[index];
+			slot.tag = static_cast<uint32_t>(hashes[index].first);
+			slot.nameOffset = static_cast<uint32_t>(names.size());
+			slot.nameLength = static_cast<uint16_t>(entry.first.size());
+			slot.firstAddress = static_cast<uint32_t>(addresses.size());
+			slot.addressCount = static_cast<uint16_t>(entry.second.size());
+			names += entry.first;
+			for (const IPAddress& addr : entry.second)
+			{
+				FileAddress address = {};
+				if (addr.isIPv4())
+				{
+					address.version = 4;
+					memcpy(address.bytes, addr.asIPv4().bytes().data(), 4);
+				}
+				else
+				{
+					address.version = 6;
+					memcpy(address.bytes, addr.asIPv6().bytes().data(), 16);
+				}
+				addresses.push_back(address);
+			}
+			index++;
+		}
+
+		FileHeader header = {};
+		memcpy(header.magic, kMagic, sizeof(kMagic));
+		header.version = kFormatVersion;
+		header.nameCount = nameCount;
+		header.bucketCount = bucketCount;
+		header.addressCount = static_cast<uint32_t>(addresses.size());
+		header.namesSize = names.size();
+
+		const size_t seedsSize = align8(bucketCount * sizeof(uint32_t));
+		std::vector<uint8_t> file(sizeof(header) + seedsSize + nameCount * sizeof(Slot) +
+		                          addresses.size() * sizeof(FileAddress) + names.size(), 0);
+		uint8_t* out = file.data();
+		memcpy(out, &header, sizeof(header));
+		out += sizeof(header);
+		memcpy(out, seeds.data(), bucketCount * sizeof(uint32_t));
+		out += seedsSize;
+		for (uint32_t slot = 0; slot < nameCount; slot++)
+		{
+			memcpy(out, &nameSlots[slotNames[slot]], sizeof(Slot));
+			out += sizeof(Slot);
+		}
+		if (!addresses.empty())
+			memcpy(out, addresses.data(), addresses.size() * sizeof(FileAddress));
+		out += addresses.size() * sizeof(FileAddress);
+		if (!names.empty())
+			memcpy(out, names.data(), names.size());
+		return file;
+	}
+
+	void HostTableBuilder::write(const std::string& path) const
+	{
+		const std::vector<uint8_t> file = build();
+		FILE* out = fopen(path.c_str(), "wb");
+		if (out == nullptr)
+			throw std::runtime_error("can not create host table");
+		const bool written = fwrite(file.data(), 1, file.size(), out) == file.size();
+		if (fclose(out) != 0 || !written)
+			throw std::runtime_error("can not write host table");
+	}
+}
@@ -1,36 +1,56 @@
 #include "IPEndPoint.h"
+#include <cstddef>
+#include "Instrumentation.h"
 
 namespace ip_address
 {
+	namespace
+	{
+		static_assert(offsetof(sockaddr_in, sin_port) == offsetof(sockaddr_in6, sin6_port),
+		              "batch conversion reads the port of both families from the same offset");
+
+		/* indexed by "is IPv6", used to turn the address family into table lookups instead of branches */
+		constexpr size_t kAddressOffset[2] = { offsetof(sockaddr_in, sin_addr), offsetof(sockaddr_in6, sin6_addr) };
+		constexpr socklen_t kSockaddrLength[2] = { sizeof(sockaddr_in), sizeof(sockaddr_in6) };
+		alignas(16) constexpr uint8_t kAddressMask[2][16] = {
+			{ 0xFF, 0xFF, 0xFF, 0xFF },
+			{ 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF },
+		};
+
+		//copies the 16 byte address window and clears the bytes that do not belong to the address
+		inline void copyAddressWindow(uint8_t* dst, const uint8_t* src, size_t is6) noexcept
+		{
+			uint64_t window[2];
+			uint64_t mask[2];
+			memcpy(window, src, sizeof(window));
+			memcpy(mask, kAddressMask[is6], sizeof(mask));
+			window[0] &= mask[0];
+			window[1] &= mask[1];
+			memcpy(dst, window, sizeof(window));
+		}
+	}
+
 	IPEndPoint::IPEndPoint(const sockaddr* addr, socklen_t addrLength)
 	{
+		IPADDRESS_TIME(kConvert);
 		assert(addr != nullptr);
 		assert(addr->sa_family == AF_INET || addr->sa_family == AF_INET6);
-		if (addr->sa_family == AF_INET)
+		if (addr->sa_family == AF_INET && addrLength >= sizeof(sockaddr_in))
 		{
-			const auto* addr4 = reinterpret_cast<const sockaddr_in*>(&addr);
+			const auto* addr4 = reinterpret_cast<const sockaddr_in*>(addr);
 			memcpy(&this->mAddr.mIpAddress4.mAddr4.mBytes[0], &addr4->sin_addr, sizeof(in_addr));
 			this->mPort = ntohs(addr4->sin_port);
 			this->mVersion = IPVersion::kIPv4;
 		}
-		else if (addr->sa_family == AF_INET6)
+		else if (addr->sa_family == AF_INET6 && addrLength >= sizeof(sockaddr_in6))
 		{
-			const auto* addr6 = reinterpret_cast<const sockaddr_in6*>(&addr);
+			const auto* addr6 = reinterpret_cast<const sockaddr_in6*>(addr);
 			memcpy(&this->mAddr.mIpAddress6.mAddr6.mBytes[0], &addr6->sin6_addr, sizeof(in6_addr));
 			this->mPort = ntohs(addr6->sin6_port);
 			this->mVersion = IPVersion::kIPv6;
 		}
 	}
 
-	bool IPEndPoint::operator==(const IPEndPoint& rhs) const
-	{
-		if (this->mPort != rhs.mPort)
-			return false;
-		if (static_cast<IPAddress>(*this) != static_cast<IPAddress>(rhs))
-			return false;
-		return true;
-	}
-
 	bool IPEndPoint::operator==(const port_host_byte_order_t rhs) const
 	{
 		return this->mPort == rhs;
@@ -41,11 +61,6 @@ namespace ip_address
 		return this->mPort == to_host_byte_order(rhs);
 	}
 
-	bool IPEndPoint::operator!=(const IPEndPoint& rhs) const
-	{
-		return !this->operator==(rhs);
-	}
-
 	bool IPEndPoint::operator!=(const port_host_byte_order_t rhs) const
 	{
 		return !this->operator==(rhs);
@@ -59,8 +74,8 @@ namespace ip_address
 	IPEndPoint& IPEndPoint::operator=(const IPEndPoint& rhs)
 	{
 		this->mPort = rhs.mPort;
-		std::copy(this->mAddr.mIpAddress6.mAddr6.mBytes.begin(), this->mAddr.mIpAddress6.mAddr6.mBytes.end(),
-		          rhs.mAddr.mIpAddress6.mAddr6.mBytes.begin());
+		this->mVersion = rhs.mVersion;
+		this->mAddr.mIpAddress6 = rhs.mAddr.mIpAddress6;
 		return *this;
 	}
 
@@ -72,13 +87,14 @@ namespace ip_address
 
 	IPEndPoint& IPEndPoint::operator=(const IPAddressV4& rhs)
 	{
-		this->mAddr.mIpAddress4 = rhs;
+		//through IPAddress, which sets the version and clears the bytes after the IPv4 address
+		*this = IPAddress(rhs);
 		return *this;
 	}
 
 	IPEndPoint& IPEndPoint::operator=(const IPAddressV6& rhs)
 	{
-		this->mAddr.mIpAddress6 = rhs;
+		*this = IPAddress(rhs);
 		return *this;
 	}
 
@@ -114,8 +130,7 @@ namespace ip_address
 
 	IPEndPoint& IPEndPoint::operator=(IPAddressV6&& rhs) noexcept
 	{
-		this->mAddr.mIpAddress6 = rhs;
-		this->mVersion = IPVersion::kIPv6;
+		*this = IPAddress(rhs);
 		return *this;
 	}
 
@@ -136,11 +151,6 @@ namespace ip_address
 		return const_cast<IPEndPoint&>(*this);
 	}
 
-	port_host_byte_order_t IPEndPoint::getPort() const
-	{
-		return mPort;
-	}
-
 	port_network_byte_order_t IPEndPoint::getPortNetworkByteOrder() const
 	{
 		return to_network_byte_order(mPort);
@@ -167,7 +177,17 @@ namespace ip_address
 	{
 		assert(mVersion == IPVersion::kIPv6 || mVersion == IPVersion::kIPv4);
 		sockaddr_in6 addr6In = {};
-		memcpy(&addr6In.sin6_addr, &mAddr.mIpAddress6, sizeof(mAddr.mIpAddress6));
+		if (mVersion == IPVersion::kIPv4)
+		{
+			//the storage of an IPv4 endpoint only holds 4 valid bytes, map it to ::ffff:a.b.c.d
+			addr6In.sin6_addr.s6_addr[10] = 0xFF;
+			addr6In.sin6_addr.s6_addr[11] = 0xFF;
+			memcpy(&addr6In.sin6_addr.s6_addr[12], &mAddr.mIpAddress4, sizeof(mAddr.mIpAddress4));
+		}
+		else
+		{
+			memcpy(&addr6In.sin6_addr, &mAddr.mIpAddress6, sizeof(mAddr.mIpAddress6));
+		}
 		addr6In.sin6_port = to_integer(to_network_byte_order(mPort)); // host to network-byte order
 		addr6In.sin6_family = AF_INET6;
 		return addr6In;
@@ -181,6 +201,50 @@ namespace ip_address
 	}
 
 
+	void IPEndPoint::fromSockaddrs(const sockaddr_storage* addrs, size_t count, IPEndPoint* endpoints) noexcept
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const auto* bytes = reinterpret_cast<const uint8_t*>(&addrs[i]);
+			const sa_family_t family = addrs[i].ss_family;
+			const size_t is6 = family == AF_INET6;
+			const bool valid = is6 | (family == AF_INET);
+			IPEndPoint& endpoint = endpoints[i];
+			//sockaddr_storage is large enough to read 16 bytes from the IPv4 address offset
+			copyAddressWindow(&endpoint.mAddr.mIpAddress6.mAddr6.mBytes[0], bytes + kAddressOffset[is6], is6);
+			uint16_t port;
+			memcpy(&port, bytes + offsetof(sockaddr_in, sin_port), sizeof(port));
+			endpoint.mPort = NetToHost16(port);
+			endpoint.mVersion = valid ? static_cast<IPVersion>(family) : IPVersion::kUnknown;
+		}
+	}
+
+	void IPEndPoint::toSockaddrs(const IPEndPoint* endpoints, size_t count, sockaddr_storage* addrs,
+	                             socklen_t* lengths) noexcept
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const IPEndPoint& endpoint = endpoints[i];
+			assert(endpoint.mVersion == IPVersion::kIPv4 || endpoint.mVersion == IPVersion::kIPv6);
+			const size_t is6 = static_cast<int>(endpoint.mVersion) == AF_INET6;
+			auto* bytes = reinterpret_cast<uint8_t*>(&addrs[i]);
+			//clears sin_zero, sin6_flowinfo and sin6_scope_id
+			memset(bytes, 0, sizeof(sockaddr_in6));
+			copyAddressWindow(bytes + kAddressOffset[is6], &endpoint.mAddr.mIpAddress6.mAddr6.mBytes[0], is6);
+			addrs[i].ss_family = static_cast<sa_family_t>(endpoint.mVersion);
+			const uint16_t port = HostToNet16(endpoint.mPort);
+			memcpy(bytes + offsetof(sockaddr_in, sin_port), &port, sizeof(port));
+			if (lengths != nullptr)
+				lengths[i] = kSockaddrLength[is6];
+		}
+	}
+
+	void IPEndPoint::writeSockaddr(sockaddr_storage& storage, socklen_t& length) const noexcept
+	{
+		IPADDRESS_TIME(kConvert);
+		toSockaddrs(this, 1, &storage, &length);
+	}
+
 	void IPEndPoint::clear() noexcept
 	{
 		static_assert(sizeof(this->mAddr.mIpAddress6) > sizeof(this->mAddr.mIpAddress4)); //sanity check for memset
@@ -0,0 +1,64 @@
+#include "IPNetwork.h"
+
+namespace ip_address
+{
+	IPNetwork::IPNetwork(const char* cidr)
+	{
+		if (!parseIPNetwork(*this, cidr))
+			throw std::runtime_error("invalid parser input");
+	}
+
+	IPNetwork::IPNetwork(const std::string& cidr)
+	{
+		if (!parseIPNetwork(*this, cidr))
+			throw std::runtime_error("invalid parser input");
+	}
+
+	bool IPNetwork::parseIPNetwork(IPNetwork& network, const std::string& cidr) noexcept
+	{
+		const size_t slash = cidr.find('/');
+		const std::string ip = cidr.substr(0, slash);
+		int prefixLength = -1;
+		if (slash != std::string::npos)
+		{
+			const std::string prefix = cidr.substr(slash + 1);
+			if (prefix.empty() || prefix.size() > 3)
+				return false;
+			prefixLength = 0;
+			for (const char c : prefix)
+			{
+				if (c < '0' || c > '9')
+					return false;
+				prefixLength = prefixLength * 10 + (c - '0');
+			}
+		}
+
+		in_addr inAddr4;
+		if (inet_pton(AF_INET, ip.c_str(), &inAddr4) == 1)
+		{
+			if (prefixLength > 32)
+				return false;
+			network = IPNetwork(IPAddressV4(inAddr4), static_cast<uint8_t>(prefixLength < 0 ? 32 : prefixLength));
+			return true;
+		}
+		in6_addr inAddr6;
+		if (inet_pton(AF_INET6, ip.c_str(), &inAddr6) == 1)
+		{
+			if (prefixLength > 128)
+				return false;
+			network = IPNetwork(IPAddressV6(inAddr6), static_cast<uint8_t>(prefixLength < 0 ? 128 : prefixLength));
+			return true;
+		}
+		return false;
+	}
+
+	std::string IPNetwork::getString() const
+	{
+		return mAddress.getString() + "/" + std::to_string(mPrefixLength);
+	}
+
+	std::ostream& operator<<(std::ostream& rhs, const IPNetwork& lhs)
+	{
+		return rhs << lhs.getString();
+	}
+}
@@ -0,0 +1,250 @@
+#include "Instrumentation.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+
+namespace ip_address
+{
+	namespace
+	{
+		/*
+		 * Counts of one thread, only the owning thread writes. A slot outlives its thread and is handed to the
+		 * next new thread, so nothing recorded is lost and the number of slots is bounded by the peak number
+		 * of threads.
+		 */
+		struct Slot
+		{
+			std::atomic<uint64_t> events[Instrumentation::kEvents] = {};
+			std::atomic<uint64_t> totals[Instrumentation::kOperations] = {};
+			std::atomic<uint64_t> buckets[Instrumentation::kOperations][Instrumentation::kBuckets] = {};
+			std::atomic<bool> owned{ true };
+			Slot* next = nullptr;
+		};
+
+		std::atomic<Slot*> gSlots{ nullptr };
+
+		Slot* acquireSlot()
+		{
+			for (Slot* slot = gSlots.load(std::memory_order_acquire); slot != nullptr; slot = slot->next)
+			{
+				bool owned = false;
+				if (!slot->owned.load(std::memory_order_relaxed) &&
+					slot->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+					return slot;
+			}
+			Slot* slot = new Slot();
+			slot->next = gSlots.load(std::memory_order_relaxed);
+			while (!gSlots.compare_exchange_weak(slot->next, slot, std::memory_order_release, std::memory_order_relaxed))
+			{
+			}
+			return slot;
+		}
+
+		class SlotOwner
+		{
+		public:
+			SlotOwner() : mSlot(acquireSlot()) { }
+			~SlotOwner() { mSlot->owned.store(false, std::memory_order_release); }
+			SlotOwner(const SlotOwner&) = delete;
+			SlotOwner& operator=(const SlotOwner&) = delete;
+
+			Slot& getSlot() const noexcept { return *mSlot; }
+		private:
+			Slot* mSlot;
+		};
+
+		Slot& getSlot()
+		{
+			thread_local SlotOwner owner;
+			return owner.getSlot();
+		}
+
+		/* single writer, so a load and a store replace the locked add */
+		inline void add(std::atomic<uint64_t>& value, uint64_t amount) noexcept
+		{
+			value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+		}
+
+		constexpr const char* kOperationNames[Instrumentation::kOperations] = { "parse_v4", "parse_v6", "parse",
+			"resolve_v4", "resolve_v6", "format_v4", "format_v6", "convert" };
+		constexpr const char* kEventNames[Instrumentation::kEvents] = { "parse_failed", "resolve_failed", "exception" };
+		/* highest power of two bucket bound of the Prometheus histograms, 2^30ns ~ 1s */
+		constexpr size_t kPrometheusBounds = 30;
+	}
+
+	void Instrumentation::count(Event event) noexcept
+	{
+		add(getSlot().events[static_cast<size_t>(event)], 1);
+	}
+
+	void Instrumentation::record(Operation operation, uint64_t nanoseconds) noexcept
+	{
+		Slot& slot = getSlot();
+		const auto index = static_cast<size_t>(operation);
+		add(slot.totals[index], nanoseconds);
+		add(slot.buckets[index][getBucket(nanoseconds)], 1);
+	}
+
+	Instrumentation::Snapshot Instrumentation::snapshot()
+	{
+		Snapshot snapshot;
+		for (Slot* slot = gSlots.load(std::memory_order_acquire); slot != nullptr; slot = slot->next)
+		{
+			for (size_t event = 0; event < kEvents; event++)
+			{
+				snapshot.mEvents[event] += slot->events[event].load(std::memory_order_relaxed);
+			}
+			for (size_t operation = 0; operation < kOperations; operation++)
+			{
+				snapshot.mTotals[operation] += slot->totals[operation].load(std::memory_order_relaxed);
+				for (size_t bucket = 0; bucket < kBuckets; bucket++)
+				{
+					snapshot.mBuckets[operation][bucket] += slot->buckets[operation][bucket].load(std::memory_order_relaxed);
+				}
+			}
+		}
+		return snapshot;
+	}
+
+	const char* Instrumentation::getName(Operation operation) noexcept
+	{
+		return kOperationNames[static_cast<size_t>(operation)];
+	}
+
+	const char* Instrumentation::getName(Event event) noexcept
+	{
+		return kEventNames[static_cast<size_t>(event)];
+	}
+
+	size_t Instrumentation::getBucket(uint64_t nanoseconds) noexcept
+	{
+		if (nanoseconds < 16)
+			return static_cast<size_t>(nanoseconds);
+		const size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(nanoseconds));
+		return 16 + (exponent - 4) * kSubBuckets + static_cast<size_t>(nanoseconds >> (exponent - 3) & (kSubBuckets - 1));
+	}
+
+	uint64_t Instrumentation::getBucketLowest(size_t bucket) noexcept
+	{
+		if (bucket < 16)
+			return bucket;
+		const size_t exponent = (bucket - 16) / kSubBuckets + 4;
+		return static_cast<uint64_t>(kSubBuckets + (bucket - 16) % kSubBuckets) << (exponent - 3);
+	}
+
+	uint64_t Instrumentation::Snapshot::getCount(Event event) const noexcept
+	{
+		return mEvents[static_cast<size_t>(event)];
+	}
+
+	uint64_t Instrumentation::Snapshot::getCount(Operation operation) const noexcept
+	{
+		uint64_t count = 0;
+		for (const uint64_t bucket : mBuckets[static_cast<size_t>(operation)])
+		{
+			count += bucket;
+		}
+		return count;
+	}
+
+	uint64_t Instrumentation::Snapshot::getTotalNanoseconds(Operation operation) const noexcept
+	{
+		return mTotals[static_cast<size_t>(operation)];
+	}
+
+	uint64_t Instrumentation::Snapshot::getQuantile(Operation operation, double quantile) const noexcept
+	{
+		const uint64_t count = this->getCount(operation);
+		if (count == 0)
+			return 0;
+		//rank of the sample in 1..count
+		const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count))));
+		const auto& buckets = mBuckets[static_cast<size_t>(operation)];
+		uint64_t seen = 0;
+		for (size_t bucket = 0; bucket < kBuckets; bucket++)
+		{
+			seen += buckets[bucket];
+			if (seen >= rank)
+				return bucket + 1 == kBuckets ? UINT64_MAX : getBucketLowest(bucket + 1) - 1;
+		}
+		return UINT64_MAX;
+	}
+
+	std::string Instrumentation::Snapshot::getPrometheusText() const
+	{
+		std::string text;
+		char line[256];
+		text += "# HELP ipaddress_events_total Events of the address parsers and constructors.\n";
+		text += "# TYPE ipaddress_events_total counter\n";
+		for (size_t event = 0; event < kEvents; event++)
+		{
+			snprintf(line, sizeof(line), "ipaddress_events_total{event=\"%s\"} %llu\n", kEventNames[event],
+			         static_cast<unsigned long long>(mEvents[event]));
+			text += line;
+		}
+		text += "# HELP ipaddress_operation_duration_seconds Latency of address operations.\n";
+		text += "# TYPE ipaddress_operation_duration_seconds histogram\n";
+		for (size_t operation = 0; operation < kOperations; operation++)
+		{
+			const char* name = kOperationNames[operation];
+			//a power of two is the lowest value of a bucket, so the cumulative counts are exact
+			uint64_t cumulative = 0;
+			size_t bucket = 0;
+			for (size_t exponent = 4; exponent <= kPrometheusBounds; exponent++)
+			{
+				const uint64_t bound = uint64_t(1) << exponent;
+				for (; getBucketLowest(bucket) < bound; bucket++)
+				{
+					cumulative += mBuckets[operation][bucket];
+				}
+				snprintf(line, sizeof(line), "ipaddress_operation_duration_seconds_bucket{operation=\"%s\",le=\"%.9g\"} %llu\n",
+				         name, static_cast<double>(bound) * 1e-9, static_cast<unsigned long long>(cumulative));
+				text += line;
+			}
+			const Operation op = static_cast<Operation>(operation);
+			snprintf(line, sizeof(line), "ipaddress_operation_duration_seconds_bucket{operation=\"%s\",le=\"+Inf\"} %llu\n"
+			         "ipaddress_operation_duration_seconds_sum{operation=\"%s\"} %.9g\n"
+			         "ipaddress_operation_duration_seconds_count{operation=\"%s\"} %llu\n",
+			         name, static_cast<unsigned long long>(this->getCount(op)), name,
+			         static_cast<double>(mTotals[operation]) * 1e-9, name,
+			         static_cast<unsigned long long>(this->getCount(op)));
+			text += line;
+		}
+		return text;
+	}
+
+	std::string Instrumentation::Snapshot::getJson() const
+	{
+		std::string json = "{\"enabled\":";
+		json += isEnabled() ? "true" : "false";
+		json += ",\"events\":{";
+		for (size_t event = 0; event < kEvents; event++)
+		{
+			json += (event == 0 ? "\"" : ",\"") + std::string(kEventNames[event]) + "\":" + std::to_string(mEvents[event]);
+		}
+		json += "},\"operations\":{";
+		for (size_t operation = 0; operation < kOperations; operation++)
+		{
+			const Operation op = static_cast<Operation>(operation);
+			json += (operation == 0 ? "\"" : ",\"") + std::string(kOperationNames[operation]) + "\":{";
+			json += "\"count\":" + std::to_string(this->getCount(op));
+			json += ",\"total_ns\":" + std::to_string(mTotals[operation]);
+			json += ",\"p50_ns\":" + std::to_string(this->getQuantile(op, 0.5));
+			json += ",\"p99_ns\":" + std::to_string(this->getQuantile(op, 0.99));
+			json += ",\"p999_ns\":" + std::to_string(this->getQuantile(op, 0.999));
+			json += ",\"buckets\":[";
+			bool first = true;
+			for (size_t bucket = 0; bucket < kBuckets; bucket++)
+			{
+				if (mBuckets[operation][bucket] == 0)
+					continue;
+				json += first ? "[" : ",[";
+				json += std::to_string(getBucketLowest(bucket)) + "," + std::to_string(mBuckets[operation][bucket]) + "]";
+				first = false;
+			}
+			json += "]}";
+		}
+		json += "}}";
+		return json;
+	}
+}
@@ -0,0 +1,487 @@
+#include "LocalAddressRegistry.h"
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "util/AddressKey.h"
+
+namespace ip_address
+{
+	namespace
+	{
+		constexpr size_t kReceiveBufferSize = 32 * 1024;
+
+		/*
+		 * Open addressing hash set of address keys with linear probing, the zero key (0.0.0.0, ::) marks empty
+		 * slots and is tracked separately.
+		 */
+		template <typename Address>
+		class AddressSet
+		{
+		public:
+			using Traits = details::AddressKey<Address>;
+			using Key = typename Traits::Key;
+
+			void build(const std::vector<Key>& keys)
+			{
+				size_t capacity = 8;
+				while (capacity < keys.size() * 2)
+					capacity <<= 1;
+				mSlots.assign(capacity, Key{});
+				mMask = capacity - 1;
+				for (const Key& key : keys)
+				{
+					if (key == Key{})
+					{
+						mHasZero = true;
+						continue;
+					}
+					size_t index = Traits::hash(key) & mMask;
+					while (mSlots[index] != Key{} && mSlots[index] != key)
+						index = (index + 1) & mMask;
+					mSlots[index] = key;
+				}
+			}
+
+			bool contains(const Address& addr) const noexcept
+			{
+				const Key key = Traits::toKey(addr);
+				if (key == Key{})
+					return mHasZero;
+				for (size_t index = Traits::hash(key) & mMask;; index = (index + 1) & mMask)
+				{
+					if (mSlots[index] == key)
+						return true;
+					if (mSlots[index] == Key{})
+						return false;
+				}
+			}
+		private:
+			std::vector<Key> mSlots;
+			size_t mMask = 0;
+			bool mHasZero = false;
+		};
+
+		/*
+		 * On-link prefixes of one family, longest first so the first match is the longest match.
+		 */
+		template <typename Address>
+		class PrefixTable
+		{
+		public:
+			using Traits = details::AddressKey<Address>;
+			using Key = typename Traits::Key;
+
+			struct Entry
+			{
+				Key network;
+				uint8_t prefixLength;
+				uint32_t interfaceIndex;
+			};
+
+			void add(const Address& addr, uint8_t prefixLength, uint32_t interfaceIndex)
+			{
+				prefixLength = std::min(prefixLength, Traits::kBits);
+				mEntries.push_back({ Traits::truncate(Traits::toKey(addr), prefixLength), prefixLength, interfaceIndex });
+			}
+
+			void sort()
+			{
+				std::stable_sort(mEntries.begin(), mEntries.end(), [](const Entry& lhs, const Entry& rhs)
+				{
+					return lhs.prefixLength > rhs.prefixLength;
+				});
+			}
+
+			const Entry* find(const Address& addr) const noexcept
+			{
+				const Key key = Traits::toKey(addr);
+				for (const Entry& entry : mEntries)
+				{
+					if (Traits::truncate(key, entry.prefixLength) == entry.network)
+						return &entry;
+				}
+				return nullptr;
+			}
+		private:
+			std::vector<Entry> mEntries;
+		};
+
+		template <typename Address>
+		bool findPrefix(const PrefixTable<Address>& table, const Address& addr, IPNetwork& network,
+		                uint32_t* interfaceIndex) noexcept
+		{
+			const auto* entry = table.find(addr);
+			if (entry == nullptr)
+				return false;
+			network = IPNetwork(PrefixTable<Address>::Traits::toAddress(entry->network), entry->prefixLength);
+			if (interfaceIndex != nullptr)
+				*interfaceIndex = entry->interfaceIndex;
+			return true;
+		}
+
+		int openNetlink(uint32_t groups)
+		{
+			const int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+			if (fd < 0)
+				throw std::runtime_error("Failed to create netlink socket, errno " + std::to_string(errno));
+			sockaddr_nl local = {};
+			local.nl_family = AF_NETLINK;
+			local.nl_groups = groups;
+			if (bind(fd, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0)
+			{
+				const int error = errno;
+				close(fd);
+				throw std::runtime_error("Failed to bind netlink socket, errno " + std::to_string(error));
+			}
+			return fd;
+		}
+
+		bool parseAddressMessage(const nlmsghdr* header, LocalAddress& address) noexcept
+		{
+			if (header->nlmsg_len < NLMSG_LENGTH(sizeof(ifaddrmsg)))
+				return false;
+			const auto* message = static_cast<const ifaddrmsg*>(NLMSG_DATA(header));
+			int length = static_cast<int>(IFA_PAYLOAD(header));
+			const rtattr* local = nullptr;
+			const rtattr* peer = nullptr;
+			for (const rtattr* attribute = IFA_RTA(message); RTA_OK(attribute, length);
+			     attribute = RTA_NEXT(attribute, length))
+			{
+				if (attribute->rta_type == IFA_LOCAL)
+					local = attribute;
+				else if (attribute->rta_type == IFA_ADDRESS)
+					peer = attribute;
+			}
+			//IFA_ADDRESS is the peer on point-to-point links, IFA_LOCAL is then the local address
+			const rtattr* attribute = local != nullptr ? local : peer;
+			if (attribute == nullptr)
+				return false;
+			if (message->ifa_family == AF_INET && RTA_PAYLOAD(attribute) == sizeof(ByteArray4))
+			{
+				ByteArray4 bytes;
+				memcpy(bytes.data(), RTA_DATA(attribute), bytes.size());
+				address.address = IPAddress(bytes);
+			}
+			else if (message->ifa_family == AF_INET6 && RTA_PAYLOAD(attribute) == sizeof(ByteArray16))
+			{
+				ByteArray16 bytes;
+				memcpy(bytes.data(), RTA_DATA(attribute), bytes.size());
+				address.address = IPAddress(bytes);
+			}
+			else
+			{
+				return false;
+			}
+			address.prefixLength = message->ifa_prefixlen;
+			address.interfaceIndex = message->ifa_index;
+			return true;
+		}
+
+		std::vector<LocalAddress> dumpAddresses()
+		{
+			const int fd = openNetlink(0);
+			struct
+			{
+				nlmsghdr header;
+				ifaddrmsg message;
+			} request = {};
+			request.header.nlmsg_len = NLMSG_LENGTH(sizeof(ifaddrmsg));
+			request.header.nlmsg_type = RTM_GETADDR;
+			request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+			request.header.nlmsg_seq = 1;
+			request.message.ifa_family = AF_UNSPEC;
+			if (send(fd, &request, request.header.nlmsg_len, 0) < 0)
+			{
+				const int error = errno;
+				close(fd);
+				throw std::runtime_error("Failed to request address dump, errno " + std::to_string(error));
+			}
+
+			std::vector<LocalAddress> addresses;
+			std::vector<char> buffer(kReceiveBufferSize);
+			for (bool done = false; !done;)
+			{
+				const ssize_t received = recv(fd, buffer.data(), buffer.size(), 0);
+				if (received < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					const int error = errno;
+					close(fd);
+					throw std::runtime_error("Failed to receive address dump, errno " + std::to_string(error));
+				}
+				auto length = static_cast<uint32_t>(received);
+				for (const auto* header = reinterpret_cast<const nlmsghdr*>(buffer.data()); NLMSG_OK(header, length);
+				     header = NLMSG_NEXT(header, length))
+				{
+					if (header->nlmsg_type == NLMSG_DONE)
+					{
+						done = true;
+						break;
+					}
+					if (header->nlmsg_type == NLMSG_ERROR)
+					{
+						close(fd);
+						throw std::runtime_error("Address dump failed");
+					}
+					LocalAddress address;
+					if (header->nlmsg_type == RTM_NEWADDR && parseAddressMessage(header, address))
+						addresses.push_back(address);
+				}
+			}
+			close(fd);
+			return addresses;
+		}
+	}
+
+	bool LocalAddress::operator==(const LocalAddress& rhs) const noexcept
+	{
+		return address == rhs.address && prefixLength == rhs.prefixLength && interfaceIndex == rhs.interfaceIndex;
+	}
+
+	struct LocalAddressRegistry::Snapshot
+	{
+		explicit Snapshot(std::vector<LocalAddress> localAddresses, uint64_t generation) :
+			addresses(std::move(localAddresses)), generation(generation)
+		{
+			std::vector<details::AddressKey<IPAddressV4>::Key> keys4;
+			std::vector<details::AddressKey<IPAddressV6>::Key> keys6;
+			for (const LocalAddress& local : addresses)
+			{
+				if (local.address.isIPv4())
+				{
+					keys4.push_back(details::AddressKey<IPAddressV4>::toKey(local.address.asIPv4()));
+					prefixes4.add(local.address.asIPv4(), local.prefixLength, local.interfaceIndex);
+				}
+				else if (local.address.isIPv6())
+				{
+					keys6.push_back(details::AddressKey<IPAddressV6>::toKey(local.address.asIPv6()));
+					prefixes6.add(local.address.asIPv6(), local.prefixLength, local.interfaceIndex);
+				}
+			}
+			set4.build(keys4);
+			set6.build(keys6);
+			prefixes4.sort();
+			prefixes6.sort();
+		}
+
+		std::vector<LocalAddress> addresses;
+		AddressSet<IPAddressV4> set4;
+		AddressSet<IPAddressV6> set6;
+		PrefixTable<IPAddressV4> prefixes4;
+		PrefixTable<IPAddressV6> prefixes6;
+		uint64_t generation;
+	};
+
+	LocalAddressRegistry::LocalAddressRegistry() :
+		mSnapshot(std::unique_ptr<Snapshot>(new Snapshot({}, 0)))
+	{
+		//subscribe before the dump so no change between the two is lost, replaying one twice is harmless
+		mNetlink = openNetlink(RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR);
+		mWakeUp = eventfd(0, EFD_CLOEXEC);
+		if (mWakeUp < 0)
+		{
+			close(mNetlink);
+			throw std::runtime_error("Failed to create eventfd, errno " + std::to_string(errno));
+		}
+		try
+		{
+			this->refresh();
+		}
+		catch (...)
+		{
+			close(mNetlink);
+			close(mWakeUp);
+			throw;
+		}
+		mMonitor = std::thread([this]() { this->monitor(); });
+	}
+
+	LocalAddressRegistry::LocalAddressRegistry(const std::vector<LocalAddress>& addresses) :
+		mSnapshot(std::unique_ptr<Snapshot>(new Snapshot({}, 0)))
+	{
+		std::vector<Change> changes;
+		for (const LocalAddress& address : addresses)
+		{
+			changes.push_back({ address, true });
+		}
+		this->apply(changes);
+	}
+
+	LocalAddressRegistry::~LocalAddressRegistry()
+	{
+		if (mMonitor.joinable())
+		{
+			const uint64_t value = 1;
+			const ssize_t written = write(mWakeUp, &value, sizeof(value));
+			(void)written;
+			mMonitor.join();
+		}
+		if (mNetlink >= 0)
+			close(mNetlink);
+		if (mWakeUp >= 0)
+			close(mWakeUp);
+	}
+
+	bool LocalAddressRegistry::isLocal(const IPAddress& addr) const noexcept
+	{
+		if (addr.isIPv4())
+			return this->isLocal(addr.asIPv4());
+		if (addr.isIPv6())
+			return this->isLocal(addr.asIPv6());
+		return false;
+	}
+
+	bool LocalAddressRegistry::isLocal(const IPAddressV4& addr4) const noexcept
+	{
+		const auto snapshot = mSnapshot.read();
+		return snapshot->set4.contains(addr4);
+	}
+
+	bool LocalAddressRegistry::isLocal(const IPAddressV6& addr6) const noexcept
+	{
+		const auto snapshot = mSnapshot.read();
+		return snapshot->set6.contains(addr6);
+	}
+
+	bool LocalAddressRegistry::getPrefix(const IPAddress& addr, IPNetwork& network,
+	                                     uint32_t* interfaceIndex) const noexcept
+	{
+		const auto snapshot = mSnapshot.read();
+		if (addr.isIPv4())
+			return findPrefix(snapshot->prefixes4, addr.asIPv4(), network, interfaceIndex);
+		if (addr.isIPv6())
+			return findPrefix(snapshot->prefixes6, addr.asIPv6(), network, interfaceIndex);
+		return false;
+	}
+
+	std::vector<LocalAddress> LocalAddressRegistry::getAddresses() const
+	{
+		const auto snapshot = mSnapshot.read();
+		return snapshot->addresses;
+	}
+
+	size_t LocalAddressRegistry::size() const noexcept
+	{
+		const auto snapshot = mSnapshot.read();
+		return snapshot->addresses.size();
+	}
+
+	uint64_t LocalAddressRegistry::getGeneration() const noexcept
+	{
+		const auto snapshot = mSnapshot.read();
+		return snapshot->generation;
+	}
+
+	bool LocalAddressRegistry::add(const LocalAddress& address)
+	{
+		return this->apply({ { address, true } }) != 0;
+	}
+
+	bool LocalAddressRegistry::remove(const LocalAddress& address)
+	{
+		return this->apply({ { address, false } }) != 0;
+	}
+
+	void LocalAddressRegistry::refresh()
+	{
+		std::vector<LocalAddress> addresses = dumpAddresses();
+		std::lock_guard<std::mutex> lock(mUpdateMutex);
+		std::vector<LocalAddress> unique;
+		for (const LocalAddress& address : addresses)
+		{
+			if (std::find(unique.begin(), unique.end(), address) == unique.end())
+				unique.push_back(address);
+		}
+		this->publish(std::move(unique));
+	}
+
+	size_t LocalAddressRegistry::apply(const std::vector<Change>& changes)
+	{
+		std::lock_guard<std::mutex> lock(mUpdateMutex);
+		std::vector<LocalAddress> addresses = this->getAddresses();
+		size_t applied = 0;
+		for (const Change& change : changes)
+		{
+			const auto found = std::find(addresses.begin(), addresses.end(), change.address);
+			if (change.added && found == addresses.end())
+			{
+				addresses.push_back(change.address);
+				applied++;
+			}
+			else if (!change.added && found != addresses.end())
+			{
+				addresses.erase(found);
+				applied++;
+			}
+		}
+		if (applied != 0)
+			this->publish(std::move(addresses));
+		return applied;
+	}
+
+	void LocalAddressRegistry::publish(std::vector<LocalAddress> addresses)
+	{
+		//the guard of getGeneration() has to be gone before update() waits for the readers
+		const uint64_t generation = this->getGeneration() + 1;
+		mSnapshot.update(std::unique_ptr<Snapshot>(new Snapshot(std::move(addresses), generation)));
+	}
+
+	void LocalAddressRegistry::monitor()
+	{
+		std::vector<char> buffer(kReceiveBufferSize);
+		pollfd fds[2] = { { mNetlink, POLLIN, 0 }, { mWakeUp, POLLIN, 0 } };
+		while (true)
+		{
+			if (poll(fds, 2, -1) < 0)
+				continue;
+			if (fds[1].revents != 0)
+				return;
+			std::vector<Change> changes;
+			bool lost = false;
+			while (true)
+			{
+				const ssize_t received = recv(mNetlink, buffer.data(), buffer.size(), MSG_DONTWAIT);
+				if (received < 0)
+				{
+					//the socket buffer overflowed and notifications were dropped
+					lost |= errno == ENOBUFS;
+					if (errno == EINTR || errno == ENOBUFS)
+						continue;
+					break;
+				}
+				auto length = static_cast<uint32_t>(received);
+				for (const auto* header = reinterpret_cast<const nlmsghdr*>(buffer.data()); NLMSG_OK(header, length);
+				     header = NLMSG_NEXT(header, length))
+				{
+					LocalAddress address;
+					if ((header->nlmsg_type == RTM_NEWADDR || header->nlmsg_type == RTM_DELADDR) &&
+						parseAddressMessage(header, address))
+						changes.push_back({ address, header->nlmsg_type == RTM_NEWADDR });
+				}
+			}
+			if (lost)
+			{
+				try
+				{
+					this->refresh();
+				}
+				catch (const std::exception&)
+				{
+					//the next notification or overflow tries again
+				}
+			}
+			else if (!changes.empty())
+			{
+				this->apply(changes);
+			}
+		}
+	}
+}
@@ -0,0 +1,365 @@
+#include "LogFilter.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "AddressScanner.h"
+
+namespace ip_address
+{
+	namespace
+	{
+		/* chunks each worker may be ahead of the consumer */
+		constexpr size_t kChunksPerThread = 4;
+
+		/*
+		 * Cuts text into chunks of about chunkSize that end after a '\n' or at the end of text.
+		 */
+		std::vector<std::string_view> splitChunks(std::string_view text, size_t chunkSize)
+		{
+			std::vector<std::string_view> chunks;
+			size_t begin = 0;
+			while (begin < text.size())
+			{
+				size_t end = text.size();
+				if (text.size() - begin > chunkSize)
+				{
+					const size_t newline = text.find('\n', begin + chunkSize - 1);
+					if (newline != std::string_view::npos)
+						end = newline + 1;
+				}
+				chunks.push_back(text.substr(begin, end - begin));
+				begin = end;
+			}
+			return chunks;
+		}
+
+		/*
+		 * Runs process(chunk, result) for the chunks on threads and consume(result) on the calling thread in
+		 * chunk order, at most kChunksPerThread chunks per thread are processed ahead of consume.
+		 */
+		template <typename Result, typename Process, typename Consume>
+		void processInOrder(const std::vector<std::string_view>& chunks, size_t threads, const Process& process,
+		                    const Consume& consume)
+		{
+			threads = std::min(threads, chunks.size());
+			if (threads <= 1)
+			{
+				for (const std::string_view& chunk : chunks)
+				{
+					Result result;
+					process(chunk, result);
+					consume(result);
+				}
+				return;
+			}
+			std::vector<Result> results(chunks.size());
+			std::vector<uint8_t> done(chunks.size(), 0);
+			std::mutex mutex;
+			std::condition_variable changed;
+			size_t next = 0;
+			size_t consumed = 0;
+			bool stopping = false;
+			std::exception_ptr error;
+			const size_t window = threads * kChunksPerThread;
+			const auto work = [&]()
+			{
+				while (true)
+				{
+					size_t chunk;
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						changed.wait(lock, [&]() { return stopping || next == chunks.size() || next < consumed + window; });
+						if (stopping || next == chunks.size())
+							return;
+						chunk = next++;
+					}
+					try
+					{
+						process(chunks[chunk], results[chunk]);
+					}
+					catch (...)
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						if (!error)
+							error = std::current_exception();
+						stopping = true;
+					}
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						done[chunk] = 1;
+					}
+					changed.notify_all();
+				}
+			};
+			std::vector<std::thread> workers;
+			for (size_t t = 0; t < threads; t++)
+			{
+				workers.emplace_back(work);
+			}
+			try
+			{
+				for (size_t chunk = 0; chunk < chunks.size(); chunk++)
+				{
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						changed.wait(lock, [&]() { return done[chunk] != 0 || stopping; });
+						if (stopping)
+							break;
+					}
+					consume(results[chunk]);
+					Result().swap(results[chunk]);
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						consumed = chunk + 1;
+					}
+					changed.notify_all();
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!error)
+					error = std::current_exception();
+				stopping = true;
+			}
+			changed.notify_all();
+			for (std::thread& worker : workers)
+			{
+				worker.join();
+			}
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+		/*
+		 * Read-only mapping of a whole file.
+		 */
+		class MappedFile
+		{
+		public:
+			explicit MappedFile(const std::string& path)
+			{
+				const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+				if (fd < 0)
+					throw std::runtime_error("can not open file");
+				struct stat info = {};
+				if (fstat(fd, &info) != 0)
+				{
+					close(fd);
+					throw std::runtime_error("can not open file");
+				}
+				mSize = static_cast<size_t>(info.st_size);
+				if (mSize != 0)
+				{
+					void* mapped = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+					if (mapped == MAP_FAILED)
+					{
+						close(fd);
+						throw std::runtime_error("can not map file");
+					}
+					mData = static_cast<const char*>(mapped);
+					madvise(mapped, mSize, MADV_SEQUENTIAL);
+				}
+				close(fd);
+			}
+			~MappedFile()
+			{
+				if (mData != nullptr)
+					munmap(const_cast<char*>(mData), mSize);
+			}
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			std::string_view getText() const noexcept { return std::string_view(mData, mSize); }
+		private:
+			const char* mData = nullptr;
+			size_t mSize = 0;
+		};
+
+		inline bool isBlank(char c) noexcept
+		{
+			return c == ' ' || c == '\t';
+		}
+	}
+
+	LogFilter::LogFilter(const std::vector<IPNetwork>& prefixes) : LogFilter(prefixes, Options()) { }
+
+	LogFilter::LogFilter(const std::vector<IPNetwork>& prefixes, Options options) : mPrefixes(prefixes),
+		mOptions(options)
+	{
+		if (mOptions.threads == 0)
+			mOptions.threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+		if (mOptions.chunkSize == 0)
+			mOptions.chunkSize = Options().chunkSize;
+		if (mPrefixes.size() > UINT32_MAX)
+			throw std::runtime_error("too many prefixes");
+		PrefixDatabaseBuilder builder;
+		for (size_t i = 0; i < mPrefixes.size(); i++)
+		{
+			const char index[4] = { static_cast<char>(i), static_cast<char>(i >> 8), static_cast<char>(i >> 16),
+				static_cast<char>(i >> 24) };
+			builder.add(mPrefixes[i], std::string_view(index, sizeof(index)));
+		}
+		mDatabase = std::make_unique<PrefixDatabase>(builder.build());
+	}
+
+	std::string_view LogFilter::getField(std::string_view line) const noexcept
+	{
+		size_t begin = 0;
+		size_t end = 0;
+		if (mOptions.delimiter == 0)
+		{
+			for (size_t column = 0;; column++)
+			{
+				while (begin < line.size() && isBlank(line[begin]))
+					begin++;
+				end = begin;
+				while (end < line.size() && !isBlank(line[end]))
+					end++;
+				if (begin == end)
+					return {};
+				if (column == mOptions.column)
+					break;
+				begin = end;
+			}
+		}
+		else
+		{
+			for (size_t column = 0;; column++)
+			{
+				const size_t delimiter = line.find(mOptions.delimiter, begin);
+				end = delimiter == std::string_view::npos ? line.size() : delimiter;
+				if (column == mOptions.column)
+					break;
+				if (delimiter == std::string_view::npos)
+					return {};
+				begin = delimiter + 1;
+			}
+		}
+		return line.substr(begin, end - begin);
+	}
+
+	bool LogFilter::matchLine(std::string_view line, size_t& prefix) const noexcept
+	{
+		if (!line.empty() && line.back() == '\n')
+			line.remove_suffix(1);
+		if (!line.empty() && line.back() == '\r')
+			line.remove_suffix(1);
+		const std::string_view field = this->getField(line);
+		if (field.empty())
+			return false;
+		std::string_view value;
+		IPAddressV4 addr4;
+		IPAddressV6 addr6;
+		if (field.front() == '[')
+		{
+			//"[2001:db8::1]" or "[2001:db8::1]:443"
+			const size_t bracket = field.find(']');
+			if (bracket == std::string_view::npos || !AddressScanner::parseIPv6(field.substr(1, bracket - 1), addr6) ||
+				!mDatabase->lookup(addr6, value))
+				return false;
+		}
+		else if (AddressScanner::parseIPv4(field, addr4))
+		{
+			if (!mDatabase->lookup(addr4, value))
+				return false;
+		}
+		else if (AddressScanner::parseIPv6(field, addr6))
+		{
+			if (!mDatabase->lookup(addr6, value))
+				return false;
+		}
+		else
+		{
+			//"192.0.2.1:443"
+			const size_t colon = field.find(':');
+			if (colon == std::string_view::npos || field.find(':', colon + 1) != std::string_view::npos ||
+				!AddressScanner::parseIPv4(field.substr(0, colon), addr4) || !mDatabase->lookup(addr4, value))
+				return false;
+		}
+		const auto* bytes = reinterpret_cast<const uint8_t*>(value.data());
+		prefix = static_cast<size_t>(bytes[0]) | static_cast<size_t>(bytes[1]) << 8 |
+			static_cast<size_t>(bytes[2]) << 16 | static_cast<size_t>(bytes[3]) << 24;
+		return true;
+	}
+
+	size_t LogFilter::filter(std::string_view text, const Sink& sink) const
+	{
+		size_t matched = 0;
+		const auto process = [this](std::string_view chunk, std::pair<std::string, size_t>& result)
+		{
+			size_t begin = 0;
+			while (begin < chunk.size())
+			{
+				const auto* newline = static_cast<const char*>(memchr(chunk.data() + begin, '\n', chunk.size() - begin));
+				const size_t end = newline == nullptr ? chunk.size() : static_cast<size_t>(newline - chunk.data()) + 1;
+				size_t prefix;
+				if (this->matchLine(chunk.substr(begin, end - begin), prefix))
+				{
+					result.first.append(chunk.data() + begin, end - begin);
+					result.second++;
+				}
+				begin = end;
+			}
+		};
+		const auto consume = [&sink, &matched](const std::pair<std::string, size_t>& result)
+		{
+			if (!result.first.empty())
+				sink(result.first);
+			matched += result.second;
+		};
+		processInOrder<std::pair<std::string, size_t>>(splitChunks(text, mOptions.chunkSize), mOptions.threads,
+		                                               process, consume);
+		return matched;
+	}
+
+	size_t LogFilter::count(std::string_view text, std::vector<uint64_t>& counts) const
+	{
+		counts.resize(mPrefixes.size(), 0);
+		size_t matched = 0;
+		//a chunk records the prefix index of each matching line, which are counted in order afterwards
+		const auto process = [this](std::string_view chunk, std::vector<uint32_t>& result)
+		{
+			size_t begin = 0;
+			while (begin < chunk.size())
+			{
+				const auto* newline = static_cast<const char*>(memchr(chunk.data() + begin, '\n', chunk.size() - begin));
+				const size_t end = newline == nullptr ? chunk.size() : static_cast<size_t>(newline - chunk.data()) + 1;
+				size_t prefix;
+				if (this->matchLine(chunk.substr(begin, end - begin), prefix))
+					result.push_back(static_cast<uint32_t>(prefix));
+				begin = end;
+			}
+		};
+		const auto consume = [&counts, &matched](const std::vector<uint32_t>& result)
+		{
+			for (const uint32_t prefix : result)
+			{
+				counts[prefix]++;
+			}
+			matched += result.size();
+		};
+		processInOrder<std::vector<uint32_t>>(splitChunks(text, mOptions.chunkSize), mOptions.threads, process, consume);
+		return matched;
+	}
+
+	size_t LogFilter::filterFile(const std::string& path, const Sink& sink) const
+	{
+		const MappedFile file(path);
+		return this->filter(file.getText(), sink);
+	}
+
+	size_t LogFilter::countFile(const std::string& path, std::vector<uint64_t>& counts) const
+	{
+		const MappedFile file(path);
+		return this->count(file.getText(), counts);
+	}
+}
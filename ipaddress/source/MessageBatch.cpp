@@ -0,0 +1,24 @@
+#include "MessageBatch.h"
+
+#ifdef __linux__
+namespace ip_address
+{
+	void toEndPoints(const mmsghdr* messages, size_t count, IPEndPoint* endpoints) noexcept
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			IPEndPoint::fromSockaddrs(static_cast<const sockaddr_storage*>(messages[i].msg_hdr.msg_name), 1,
+			                          &endpoints[i]);
+		}
+	}
+
+	void toMessageNames(const IPEndPoint* endpoints, size_t count, mmsghdr* messages) noexcept
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			IPEndPoint::toSockaddrs(&endpoints[i], 1, static_cast<sockaddr_storage*>(messages[i].msg_hdr.msg_name),
+			                        &messages[i].msg_hdr.msg_namelen);
+		}
+	}
+}
+#endif
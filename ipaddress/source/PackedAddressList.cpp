@@ -0,0 +1,502 @@
+#include "PackedAddressList.h"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ip_address
+{
+	namespace
+	{
+		using Key4 = details::AddressKey<IPAddressV4>;
+		using Key6 = details::AddressKey<IPAddressV6>;
+		using uint128 = unsigned __int128;
+
+		constexpr char kMagic[4] = { 'I', 'P', 'A', 'L' };
+		constexpr uint8_t kVersion = 1;
+		constexpr size_t kBlockSize = PackedAddressList::kBlockSize;
+		/* IPv4 blocks are 4 lanes of 32 values */
+		constexpr size_t kLanes = 4;
+		constexpr size_t kRows = kBlockSize / kLanes;
+
+		struct FileHeader
+		{
+			char magic[4];
+			uint8_t version;
+			uint8_t family;
+			uint16_t reserved;
+			uint32_t count;
+			uint32_t blockCount;
+		};
+		static_assert(sizeof(FileHeader) == 16, "header layout is part of the format");
+
+		struct BlockEntryV4
+		{
+			uint32_t first;
+			uint32_t reference;
+			uint32_t offset;
+			uint8_t bitWidth;
+			uint8_t reserved[3];
+		};
+		static_assert(sizeof(BlockEntryV4) == 16, "directory layout is part of the format");
+
+		struct BlockEntryV6
+		{
+			uint64_t firstHi;
+			uint64_t firstLo;
+			uint64_t referenceHi;
+			uint64_t referenceLo;
+			uint32_t offset;
+			uint8_t bitWidth;
+			uint8_t reserved[3];
+		};
+		static_assert(sizeof(BlockEntryV6) == 40, "directory layout is part of the format");
+
+		/* a block of width w takes 128 * w bits */
+		constexpr size_t getBlockBytes(uint32_t bitWidth) noexcept
+		{
+			return kBlockSize / 8 * bitWidth;
+		}
+
+		uint128 toInteger(const details::Uint128& key) noexcept
+		{
+			return static_cast<uint128>(key.hi) << 64 | key.lo;
+		}
+
+		details::Uint128 toKey(uint128 value) noexcept
+		{
+			return details::Uint128{ static_cast<uint64_t>(value >> 64), static_cast<uint64_t>(value) };
+		}
+
+		uint32_t getBitWidth(uint32_t value) noexcept
+		{
+			return value == 0 ? 0 : 32 - static_cast<uint32_t>(__builtin_clz(value));
+		}
+
+		uint32_t getBitWidth(uint128 value) noexcept
+		{
+			const auto hi = static_cast<uint64_t>(value >> 64);
+			const auto lo = static_cast<uint64_t>(value);
+			if (hi != 0)
+				return 128 - static_cast<uint32_t>(__builtin_clzll(hi));
+			return lo == 0 ? 0 : 64 - static_cast<uint32_t>(__builtin_clzll(lo));
+		}
+
+		template <typename Entry>
+		Entry readEntry(const uint8_t* directory, size_t block) noexcept
+		{
+			Entry entry;
+			memcpy(&entry, directory + block * sizeof(Entry), sizeof(entry));
+			return entry;
+		}
+
+		/*
+		 * Splits values into blocks and computes the frame of reference deltas of each, packed[0] is always 0.
+		 */
+		template <typename Value, typename Pack, typename Write>
+		std::vector<uint8_t> encodeBlocks(const std::vector<Value>& values, uint8_t family, size_t entrySize, Pack pack,
+		                                  Write writeEntry)
+		{
+			for (size_t i = 1; i < values.size(); i++)
+			{
+				if (values[i] < values[i - 1])
+					throw std::runtime_error("addresses are not sorted");
+			}
+			const size_t blockCount = (values.size() + kBlockSize - 1) / kBlockSize;
+			std::vector<uint8_t> data(sizeof(FileHeader) + blockCount * entrySize);
+			FileHeader header = {};
+			memcpy(header.magic, kMagic, sizeof(kMagic));
+			header.version = kVersion;
+			header.family = family;
+			header.count = static_cast<uint32_t>(values.size());
+			header.blockCount = static_cast<uint32_t>(blockCount);
+			memcpy(data.data(), &header, sizeof(header));
+
+			size_t offset = 0;
+			for (size_t block = 0; block < blockCount; block++)
+			{
+				const size_t begin = block * kBlockSize;
+				const size_t count = std::min(kBlockSize, values.size() - begin);
+				Value reference = count > 1 ? ~Value(0) : Value(0);
+				for (size_t i = 1; i < count; i++)
+				{
+					reference = std::min<Value>(reference, values[begin + i] - values[begin + i - 1]);
+				}
+				Value packed[kBlockSize] = {};
+				Value largest = 0;
+				for (size_t i = 1; i < count; i++)
+				{
+					packed[i] = values[begin + i] - values[begin + i - 1] - reference;
+					largest = std::max(largest, packed[i]);
+				}
+				const uint32_t bitWidth = getBitWidth(largest);
+				writeEntry(data.data() + sizeof(FileHeader) + block * entrySize, values[begin], reference,
+				           static_cast<uint32_t>(offset), bitWidth);
+				data.resize(data.size() + getBlockBytes(bitWidth));
+				pack(packed, bitWidth, data.data() + data.size() - getBlockBytes(bitWidth));
+				offset += getBlockBytes(bitWidth);
+			}
+			return data;
+		}
+
+		/*
+		 * Lane l holds the values l, l + 4, l + 8, ... bit-packed into bitWidth words, word k of lane l is the
+		 * 32-bit word 4 * k + l of the block.
+		 */
+		void packV4(const uint32_t* values, uint32_t bitWidth, uint8_t* out) noexcept
+		{
+			if (bitWidth == 0)
+				return;
+			std::vector<uint32_t> words(kLanes * bitWidth);
+			for (size_t lane = 0; lane < kLanes; lane++)
+			{
+				for (size_t row = 0; row < kRows; row++)
+				{
+					const uint32_t value = values[row * kLanes + lane];
+					const size_t bit = row * bitWidth;
+					const size_t word = bit / 32;
+					const uint32_t shift = bit % 32;
+					words[word * kLanes + lane] |= value << shift;
+					if (shift + bitWidth > 32)
+						words[(word + 1) * kLanes + lane] |= value >> (32 - shift);
+				}
+			}
+			memcpy(out, words.data(), words.size() * sizeof(uint32_t));
+		}
+
+		/*
+		 * Values are packed one after another into 64-bit words in host byte order, the low bits first.
+		 */
+		void packV6(const uint128* values, uint32_t bitWidth, uint8_t* out) noexcept
+		{
+			if (bitWidth == 0)
+				return;
+			std::vector<uint64_t> words(bitWidth * 2);
+			for (size_t i = 0; i < kBlockSize; i++)
+			{
+				const size_t bit = i * bitWidth;
+				const size_t index = bit / 64;
+				const uint32_t shift = bit % 64;
+				words[index] |= static_cast<uint64_t>(values[i] << shift);
+				if (shift + bitWidth > 64)
+				{
+					const uint128 rest = values[i] >> (64 - shift);
+					words[index + 1] |= static_cast<uint64_t>(rest);
+					if (shift + bitWidth > 128)
+						words[index + 2] |= static_cast<uint64_t>(rest >> 64);
+				}
+			}
+			memcpy(out, words.data(), getBlockBytes(bitWidth));
+		}
+
+#if defined(__SSE2__)
+		template <uint32_t W, uint32_t Row>
+		inline __m128i unpackRow(const uint8_t* in) noexcept
+		{
+			constexpr uint32_t bit = Row * W;
+			constexpr uint32_t word = bit / 32;
+			constexpr uint32_t shift = bit % 32;
+			__m128i value = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + word), shift);
+			if constexpr (shift + W > 32)
+				value = _mm_or_si128(value, _mm_slli_epi32(
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + word + 1), 32 - shift));
+			if constexpr (W < 32)
+				value = _mm_and_si128(value, _mm_set1_epi32(static_cast<int>((1u << W) - 1)));
+			return value;
+		}
+
+		/*
+		 * Unpacks one row of 4 consecutive deltas, adds the reference and turns them into addresses with an
+		 * in-register prefix sum continued from the last address of the previous row.
+		 */
+		template <uint32_t W, uint32_t Row>
+		inline void decodeRow(const uint8_t* in, __m128i reference, __m128i& carry, uint32_t* out) noexcept
+		{
+			__m128i value = _mm_setzero_si128();
+			if constexpr (W != 0)
+				value = unpackRow<W, Row>(in);
+			value = _mm_add_epi32(value, reference);
+			value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+			value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+			value = _mm_add_epi32(value, carry);
+			carry = _mm_shuffle_epi32(value, 0xFF);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out) + Row, value);
+		}
+
+		template <uint32_t W, uint32_t... Rows>
+		void decodeRows(const uint8_t* in, uint32_t first, uint32_t reference, uint32_t* out,
+		                std::integer_sequence<uint32_t, Rows...>) noexcept
+		{
+			const __m128i references = _mm_set1_epi32(static_cast<int>(reference));
+			//the first packed delta is 0, starting at first - reference makes the first address first
+			__m128i carry = _mm_set1_epi32(static_cast<int>(first - reference));
+			(decodeRow<W, Rows>(in, references, carry, out), ...);
+		}
+
+		template <uint32_t W>
+		void decodeBlockV4(const uint8_t* in, uint32_t first, uint32_t reference, uint32_t* out) noexcept
+		{
+			decodeRows<W>(in, first, reference, out, std::make_integer_sequence<uint32_t, kRows>());
+		}
+
+		using DecodeV4 = void (*)(const uint8_t*, uint32_t, uint32_t, uint32_t*) noexcept;
+
+		template <uint32_t... Widths>
+		constexpr std::array<DecodeV4, sizeof...(Widths)> makeDecoders(std::integer_sequence<uint32_t, Widths...>) noexcept
+		{
+			return { &decodeBlockV4<Widths>... };
+		}
+
+		/* one fully unrolled decoder per bit width */
+		constexpr auto kDecodersV4 = makeDecoders(std::make_integer_sequence<uint32_t, 33>());
+#else
+
+		void decodeBlockV4Scalar(const uint8_t* in, uint32_t bitWidth, uint32_t first, uint32_t reference,
+		                         uint32_t* out) noexcept
+		{
+			const uint32_t mask = bitWidth == 32 ? ~0u : (1u << bitWidth) - 1;
+			uint32_t previous = first - reference;
+			for (size_t row = 0; row < kRows; row++)
+			{
+				const size_t bit = row * bitWidth;
+				const size_t word = bit / 32;
+				const uint32_t shift = bit % 32;
+				for (size_t lane = 0; lane < kLanes; lane++)
+				{
+					uint32_t value = 0;
+					if (bitWidth != 0)
+					{
+						uint32_t words[2] = {};
+						memcpy(&words[0], in + (word * kLanes + lane) * 4, 4);
+						if (shift + bitWidth > 32)
+							memcpy(&words[1], in + ((word + 1) * kLanes + lane) * 4, 4);
+						value = words[0] >> shift;
+						if (shift != 0)
+							value |= words[1] << (32 - shift);
+						value &= mask;
+					}
+					previous += value + reference;
+					out[row * kLanes + lane] = previous;
+				}
+			}
+		}
+#endif
+
+		uint128 readBits(const uint8_t* in, size_t bit, uint32_t bitWidth) noexcept
+		{
+			const size_t index = bit / 64;
+			const uint32_t shift = bit % 64;
+			uint64_t word;
+			memcpy(&word, in + index * 8, 8);
+			uint128 value = word >> shift;
+			uint32_t available = 64 - shift;
+			for (size_t next = index + 1; available < bitWidth; next++, available += 64)
+			{
+				memcpy(&word, in + next * 8, 8);
+				value |= static_cast<uint128>(word) << available;
+			}
+			return bitWidth == 128 ? value : value & ((static_cast<uint128>(1) << bitWidth) - 1);
+		}
+	}
+
+	std::vector<uint8_t> PackedAddressList::encode(Span<const IPAddressV4> addresses)
+	{
+		std::vector<uint32_t> values;
+		values.reserve(addresses.size());
+		for (const IPAddressV4& addr4 : addresses)
+		{
+			values.push_back(Key4::toKey(addr4));
+		}
+		return encodeBlocks(values, 4, sizeof(BlockEntryV4), packV4,
+		                    [](uint8_t* out, uint32_t first, uint32_t reference, uint32_t offset, uint32_t bitWidth)
+		{
+			BlockEntryV4 entry = {};
+			entry.first = first;
+			entry.reference = reference;
+			entry.offset = offset;
+			entry.bitWidth = static_cast<uint8_t>(bitWidth);
+			memcpy(out, &entry, sizeof(entry));
+		});
+	}
+
+	std::vector<uint8_t> PackedAddressList::encode(Span<const IPAddressV6> addresses)
+	{
+		std::vector<uint128> values;
+		values.reserve(addresses.size());
+		for (const IPAddressV6& addr6 : addresses)
+		{
+			values.push_back(toInteger(Key6::toKey(addr6)));
+		}
+		return encodeBlocks(values, 6, sizeof(BlockEntryV6), packV6,
+		                    [](uint8_t* out, uint128 first, uint128 reference, uint32_t offset, uint32_t bitWidth)
+		{
+			BlockEntryV6 entry = {};
+			entry.firstHi = static_cast<uint64_t>(first >> 64);
+			entry.firstLo = static_cast<uint64_t>(first);
+			entry.referenceHi = static_cast<uint64_t>(reference >> 64);
+			entry.referenceLo = static_cast<uint64_t>(reference);
+			entry.offset = offset;
+			entry.bitWidth = static_cast<uint8_t>(bitWidth);
+			memcpy(out, &entry, sizeof(entry));
+		});
+	}
+
+	PackedAddressList::PackedAddressList(Span<const uint8_t> data)
+	{
+		FileHeader header;
+		if (data.size() < sizeof(header))
+			throw std::runtime_error("invalid packed address list");
+		memcpy(&header, data.data(), sizeof(header));
+		if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+			(header.family != 4 && header.family != 6) ||
+			header.blockCount != (uint64_t(header.count) + kBlockSize - 1) / kBlockSize)
+			throw std::runtime_error("invalid packed address list");
+		mIsIPv6 = header.family == 6;
+		mCount = header.count;
+		mBlockCount = header.blockCount;
+		const size_t entrySize = mIsIPv6 ? sizeof(BlockEntryV6) : sizeof(BlockEntryV4);
+		if ((data.size() - sizeof(header)) / entrySize < mBlockCount)
+			throw std::runtime_error("invalid packed address list");
+		mDirectory = data.data() + sizeof(header);
+		mBlocks = mDirectory + mBlockCount * entrySize;
+		const size_t blocksSize = data.size() - sizeof(header) - mBlockCount * entrySize;
+		for (size_t block = 0; block < mBlockCount; block++)
+		{
+			size_t offset;
+			uint32_t bitWidth;
+			if (mIsIPv6)
+			{
+				const auto entry = readEntry<BlockEntryV6>(mDirectory, block);
+				offset = entry.offset;
+				bitWidth = entry.bitWidth;
+			}
+			else
+			{
+				const auto entry = readEntry<BlockEntryV4>(mDirectory, block);
+				offset = entry.offset;
+				bitWidth = entry.bitWidth;
+			}
+			if (bitWidth > (mIsIPv6 ? 128u : 32u) || offset > blocksSize || blocksSize - offset < getBlockBytes(bitWidth))
+				throw std::runtime_error("invalid packed address list");
+		}
+	}
+
+	size_t PackedAddressList::decodeBlock(size_t block, uint32_t* keys) const noexcept
+	{
+		assert(!mIsIPv6 && block < mBlockCount);
+		const auto entry = readEntry<BlockEntryV4>(mDirectory, block);
+#if defined(__SSE2__)
+		kDecodersV4[entry.bitWidth](mBlocks + entry.offset, entry.first, entry.reference, keys);
+#else
+		decodeBlockV4Scalar(mBlocks + entry.offset, entry.bitWidth, entry.first, entry.reference, keys);
+#endif
+		return std::min(kBlockSize, mCount - block * kBlockSize);
+	}
+
+	size_t PackedAddressList::decodeBlock(size_t block, details::Uint128* keys) const noexcept
+	{
+		assert(mIsIPv6 && block < mBlockCount);
+		const auto entry = readEntry<BlockEntryV6>(mDirectory, block);
+		const uint8_t* in = mBlocks + entry.offset;
+		const uint128 reference = static_cast<uint128>(entry.referenceHi) << 64 | entry.referenceLo;
+		uint128 previous = (static_cast<uint128>(entry.firstHi) << 64 | entry.firstLo) - reference;
+		const size_t count = std::min(kBlockSize, mCount - block * kBlockSize);
+		for (size_t i = 0; i < count; i++)
+		{
+			const uint128 delta = entry.bitWidth == 0 ? 0 : readBits(in, i * entry.bitWidth, entry.bitWidth);
+			previous += delta + reference;
+			keys[i] = toKey(previous);
+		}
+		return count;
+	}
+
+	void PackedAddressList::decode(std::vector<IPAddressV4>& addresses) const
+	{
+		assert(!mIsIPv6);
+		size_t index = addresses.size();
+		addresses.resize(index + mCount);
+		uint32_t keys[kBlockSize];
+		for (size_t block = 0; block < mBlockCount; block++)
+		{
+			const size_t count = this->decodeBlock(block, keys);
+			for (size_t i = 0; i < count; i++)
+			{
+				addresses[index++] = Key4::toAddress(keys[i]);
+			}
+		}
+	}
+
+	void PackedAddressList::decode(std::vector<IPAddressV6>& addresses) const
+	{
+		assert(mIsIPv6);
+		size_t index = addresses.size();
+		addresses.resize(index + mCount);
+		details::Uint128 keys[kBlockSize];
+		for (size_t block = 0; block < mBlockCount; block++)
+		{
+			const size_t count = this->decodeBlock(block, keys);
+			for (size_t i = 0; i < count; i++)
+			{
+				addresses[index++] = Key6::toAddress(keys[i]);
+			}
+		}
+	}
+
+	IPAddressV4 PackedAddressList::getFirstV4(size_t block) const noexcept
+	{
+		assert(!mIsIPv6 && block < mBlockCount);
+		return Key4::toAddress(readEntry<BlockEntryV4>(mDirectory, block).first);
+	}
+
+	IPAddressV6 PackedAddressList::getFirstV6(size_t block) const noexcept
+	{
+		assert(mIsIPv6 && block < mBlockCount);
+		const auto entry = readEntry<BlockEntryV6>(mDirectory, block);
+		return Key6::toAddress(details::Uint128{ entry.firstHi, entry.firstLo });
+	}
+
+	bool PackedAddressList::contains(const IPAddressV4& addr4) const noexcept
+	{
+		if (mIsIPv6 || mBlockCount == 0)
+			return false;
+		const uint32_t key = Key4::toKey(addr4);
+		//last block starting at or before key
+		size_t low = 0;
+		size_t high = mBlockCount;
+		while (high - low > 1)
+		{
+			const size_t middle = (low + high) / 2;
+			if (readEntry<BlockEntryV4>(mDirectory, middle).first <= key)
+				low = middle;
+			else
+				high = middle;
+		}
+		uint32_t keys[kBlockSize];
+		const size_t count = this->decodeBlock(low, keys);
+		return std::binary_search(keys, keys + count, key);
+	}
+
+	bool PackedAddressList::contains(const IPAddressV6& addr6) const noexcept
+	{
+		if (!mIsIPv6 || mBlockCount == 0)
+			return false;
+		const details::Uint128 key = Key6::toKey(addr6);
+		size_t low = 0;
+		size_t high = mBlockCount;
+		while (high - low > 1)
+		{
+			const size_t middle = (low + high) / 2;
+			const auto entry = readEntry<BlockEntryV6>(mDirectory, middle);
+			if (!(key < details::Uint128{ entry.firstHi, entry.firstLo }))
+				low = middle;
+			else
+				high = middle;
+		}
+		details::Uint128 keys[kBlockSize];
+		const size_t count = this->decodeBlock(low, keys);
+		return std::binary_search(keys, keys + count, key);
+	}
+}
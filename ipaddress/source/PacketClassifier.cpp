@@ -0,0 +1,415 @@
+#include "PacketClassifier.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include "PrefixSet.h"
+
+namespace ip_address
+{
+	namespace
+	{
+		/* flows walked through a tree together by the batch classify */
+		constexpr size_t kBatch = 16;
+		/* a node at this depth becomes a leaf whatever its rule count */
+		constexpr size_t kMaxDepth = 64;
+
+		template <typename Key>
+		Key makeKey(uint32_t value) noexcept;
+
+		template <>
+		uint32_t makeKey(uint32_t value) noexcept { return value; }
+
+		template <>
+		details::Uint128 makeKey(uint32_t value) noexcept { return { 0, value }; }
+
+		uint32_t getMaxKey(uint32_t) noexcept { return UINT32_MAX; }
+		details::Uint128 getMaxKey(const details::Uint128&) noexcept { return { UINT64_MAX, UINT64_MAX }; }
+
+		uint32_t increment(uint32_t key) noexcept { return key + 1; }
+
+		details::Uint128 increment(const details::Uint128& key) noexcept
+		{
+			return { key.hi + static_cast<uint64_t>(key.lo == UINT64_MAX), key.lo + 1 };
+		}
+
+		template <typename Key>
+		const Key& getMin(const Key& lhs, const Key& rhs) noexcept { return rhs < lhs ? rhs : lhs; }
+
+		template <typename Key>
+		const Key& getMax(const Key& lhs, const Key& rhs) noexcept { return lhs < rhs ? rhs : lhs; }
+
+		uint32_t getKeyV4(const ByteArray16& bytes) noexcept
+		{
+			return uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 8 | uint32_t(bytes[3]);
+		}
+
+		template <typename Entry, typename Point>
+		bool matches(const Entry& entry, const Point& point) noexcept
+		{
+			bool match = true;
+			for (size_t i = 0; i < point.size(); i++)
+			{
+				match &= details::isInRange(point[i], entry.first[i], entry.span[i]);
+			}
+			return match;
+		}
+
+		template <typename Point>
+		void setRange(Point& first, Point& last, size_t field, uint32_t rangeFirst, uint32_t rangeLast)
+		{
+			using Key = typename Point::value_type;
+			if (rangeFirst > rangeLast)
+				throw std::runtime_error("empty port or protocol range in rule");
+			first[field] = makeKey<Key>(rangeFirst);
+			last[field] = makeKey<Key>(rangeLast);
+		}
+
+		template <typename Point>
+		void setNetwork(Point& first, Point& last, size_t field, const IPNetwork& network)
+		{
+			using Key = typename Point::value_type;
+			if (network.getVersion() == IPVersion::kUnknown)
+			{
+				first[field] = Key{};
+				last[field] = getMaxKey(Key{});
+				return;
+			}
+			if constexpr (sizeof(Key) == sizeof(uint32_t))
+				first[field] = details::toPrefixKey(network.getAddress().getIPv4());
+			else
+				first[field] = details::toPrefixKey(network.getAddress().getIPv6());
+			last[field] = details::getPrefixLast(first[field], network.getPrefixLength());
+		}
+
+		template <typename Box>
+		Box makeBox(const PacketRule& rule, uint32_t index)
+		{
+			Box box = {};
+			box.rule = index;
+			setNetwork(box.first, box.last, 0, rule.source);
+			setNetwork(box.first, box.last, 1, rule.destination);
+			setRange(box.first, box.last, 2, rule.sourcePortFirst, rule.sourcePortLast);
+			setRange(box.first, box.last, 3, rule.destinationPortFirst, rule.destinationPortLast);
+			setRange(box.first, box.last, 4, rule.protocolFirst, rule.protocolLast);
+			return box;
+		}
+
+		void prefetch(const void* address) noexcept
+		{
+#if defined(__GNUC__)
+			__builtin_prefetch(address);
+#else
+			(void)address;
+#endif
+		}
+	}
+
+	PacketClassifier::PacketClassifier(const std::vector<PacketRule>& rules) : PacketClassifier(rules, Options())
+	{
+	}
+
+	PacketClassifier::PacketClassifier(const std::vector<PacketRule>& rules, Options options) : mRules(rules)
+	{
+		if (rules.size() > UINT32_MAX)
+			throw std::runtime_error("too many rules");
+		std::vector<uint32_t> order(rules.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&rules](uint32_t lhs, uint32_t rhs)
+		{
+			return rules[lhs].priority < rules[rhs].priority;
+		});
+		std::vector<Box<uint32_t>> boxesV4;
+		std::vector<Box<details::Uint128>> boxesV6;
+		for (const uint32_t index : order)
+		{
+			const PacketRule& rule = rules[index];
+			const IPVersion source = rule.source.getVersion();
+			const IPVersion destination = rule.destination.getVersion();
+			if (source != IPVersion::kUnknown && destination != IPVersion::kUnknown && source != destination)
+				throw std::runtime_error("rule networks have different versions");
+			const IPVersion version = source != IPVersion::kUnknown ? source : destination;
+			if (version != IPVersion::kIPv6)
+				boxesV4.push_back(makeBox<Box<uint32_t>>(rule, index));
+			if (version != IPVersion::kIPv4)
+				boxesV6.push_back(makeBox<Box<details::Uint128>>(rule, index));
+		}
+		const size_t leafSize = std::max<size_t>(options.leafSize, 1);
+		build(mTreeV4, boxesV4, leafSize);
+		build(mTreeV6, boxesV6, leafSize);
+	}
+
+	template <typename Key>
+	void PacketClassifier::build(Tree<Key>& tree, const std::vector<Box<Key>>& boxes, size_t leafSize)
+	{
+		if (boxes.empty())
+			return;
+		std::vector<uint32_t> rules;
+		for (const Box<Key>& box : boxes)
+		{
+			typename Tree<Key>::Entry entry = {};
+			entry.rule = box.rule;
+			entry.first = box.first;
+			for (size_t field = 0; field < kFields; field++)
+			{
+				entry.span[field] = details::subtract(box.last[field], box.first[field]);
+			}
+			rules.push_back(static_cast<uint32_t>(tree.entries.size()));
+			tree.entries.push_back(entry);
+		}
+		Box<Key> region = {};
+		region.last.fill(getMaxKey(Key{}));
+		tree.nodes.emplace_back();
+		build(tree, boxes, 0, std::move(rules), region, leafSize, 0);
+	}
+
+	template <typename Key>
+	void PacketClassifier::build(Tree<Key>& tree, const std::vector<Box<Key>>& boxes, size_t node,
+	                             std::vector<uint32_t> rules, const Box<Key>& region, size_t leafSize, size_t depth)
+	{
+		//a rule covering the whole region hides the rules after it
+		for (size_t i = 0; i < rules.size(); i++)
+		{
+			const Box<Key>& box = boxes[rules[i]];
+			bool covers = true;
+			for (size_t field = 0; field < kFields; field++)
+			{
+				covers = covers && !(region.first[field] < box.first[field]) && !(box.last[field] < region.last[field]);
+			}
+			if (covers)
+			{
+				rules.resize(i + 1);
+				break;
+			}
+		}
+
+		//split point with the fewest rules on the larger side, the rules are clipped to the region
+		size_t bestCost = rules.size();
+		size_t bestTotal = 0;
+		size_t bestField = kFields;
+		Key bestSplit = {};
+		if (rules.size() > leafSize && depth < kMaxDepth)
+		{
+			std::vector<Key> firsts(rules.size());
+			std::vector<Key> lasts(rules.size());
+			for (size_t field = 0; field < kFields; field++)
+			{
+				for (size_t i = 0; i < rules.size(); i++)
+				{
+					firsts[i] = getMax(boxes[rules[i]].first[field], region.first[field]);
+					lasts[i] = getMin(boxes[rules[i]].last[field], region.last[field]);
+				}
+				std::sort(firsts.begin(), firsts.end());
+				std::sort(lasts.begin(), lasts.end());
+				const auto evaluate = [&](const Key& split)
+				{
+					const auto left = static_cast<size_t>(std::upper_bound(firsts.begin(), firsts.end(), split) - firsts.begin());
+					const auto right = rules.size() - static_cast<size_t>(std::upper_bound(lasts.begin(), lasts.end(), split) - lasts.begin());
+					const size_t cost = std::max(left, right);
+					if (cost < bestCost || (cost == bestCost && bestField != kFields && left + right < bestTotal))
+					{
+						bestCost = cost;
+						bestTotal = left + right;
+						bestField = field;
+						bestSplit = split;
+					}
+				};
+				//a split after the end of a rule or before the start of one
+				for (size_t i = 0; i < rules.size(); i++)
+				{
+					if ((i == 0 || lasts[i - 1] != lasts[i]) && lasts[i] < region.last[field])
+						evaluate(lasts[i]);
+					if ((i == 0 || firsts[i - 1] != firsts[i]) && region.first[field] < firsts[i])
+						evaluate(details::subtract(firsts[i], makeKey<Key>(1)));
+				}
+			}
+		}
+
+		if (bestField == kFields)
+		{
+			typename Tree<Key>::Node& leaf = tree.nodes[node];
+			leaf.child = static_cast<uint32_t>(tree.leaves.size());
+			leaf.count = static_cast<uint32_t>(rules.size());
+			leaf.field = static_cast<uint8_t>(kFields);
+			tree.leaves.insert(tree.leaves.end(), rules.begin(), rules.end());
+			return;
+		}
+
+		const auto child = static_cast<uint32_t>(tree.nodes.size());
+		tree.nodes.resize(tree.nodes.size() + 2);
+		tree.nodes[node].split = bestSplit;
+		tree.nodes[node].child = child;
+		tree.nodes[node].field = static_cast<uint8_t>(bestField);
+		std::vector<uint32_t> left;
+		std::vector<uint32_t> right;
+		for (const uint32_t rule : rules)
+		{
+			if (!(bestSplit < boxes[rule].first[bestField]))
+				left.push_back(rule);
+			if (bestSplit < boxes[rule].last[bestField])
+				right.push_back(rule);
+		}
+		rules.clear();
+		rules.shrink_to_fit();
+		Box<Key> leftRegion = region;
+		leftRegion.last[bestField] = bestSplit;
+		Box<Key> rightRegion = region;
+		rightRegion.first[bestField] = increment(bestSplit);
+		build(tree, boxes, child, std::move(left), leftRegion, leafSize, depth + 1);
+		build(tree, boxes, child + 1, std::move(right), rightRegion, leafSize, depth + 1);
+	}
+
+	PacketClassifier::Point<uint32_t> PacketClassifier::getPointV4(const FlowKey& flow) noexcept
+	{
+		return { getKeyV4(flow.mSource.bytes()), getKeyV4(flow.mDestination.bytes()), flow.mSourcePort,
+			flow.mDestinationPort, flow.mProtocol };
+	}
+
+	PacketClassifier::Point<details::Uint128> PacketClassifier::getPointV6(const FlowKey& flow) noexcept
+	{
+		return { details::toPrefixKey(flow.mSource), details::toPrefixKey(flow.mDestination),
+			makeKey<details::Uint128>(flow.mSourcePort), makeKey<details::Uint128>(flow.mDestinationPort),
+			makeKey<details::Uint128>(flow.mProtocol) };
+	}
+
+	template <typename Key>
+	size_t PacketClassifier::classify(const Tree<Key>& tree, const Point<Key>& point) noexcept
+	{
+		if (tree.nodes.empty())
+			return kNoMatch;
+		const typename Tree<Key>::Node* node = tree.nodes.data();
+		while (node->field != kFields)
+		{
+			node = &tree.nodes[node->child + (details::lessEqual(point[node->field], node->split) ? 0 : 1)];
+		}
+		for (uint32_t i = node->child; i < node->child + node->count; i++)
+		{
+			const typename Tree<Key>::Entry& entry = tree.entries[tree.leaves[i]];
+			if (matches(entry, point))
+				return entry.rule;
+		}
+		return kNoMatch;
+	}
+
+	template <typename Key>
+	void PacketClassifier::classify(const Tree<Key>& tree, const Point<Key>* points, size_t count,
+	                                size_t* rules) noexcept
+	{
+		if (tree.nodes.empty())
+		{
+			std::fill(rules, rules + count, kNoMatch);
+			return;
+		}
+		//every flow moves one level per round, the prefetches of a round overlap
+		uint32_t nodes[kBatch] = {};
+		for (bool walking = true; walking;)
+		{
+			walking = false;
+			for (size_t i = 0; i < count; i++)
+			{
+				const typename Tree<Key>::Node& node = tree.nodes[nodes[i]];
+				if (node.field == kFields)
+					continue;
+				nodes[i] = node.child + (details::lessEqual(points[i][node.field], node.split) ? 0 : 1);
+				prefetch(&tree.nodes[nodes[i]]);
+				walking = true;
+			}
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			prefetch(&tree.leaves[tree.nodes[nodes[i]].child]);
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			const typename Tree<Key>::Node& leaf = tree.nodes[nodes[i]];
+			rules[i] = kNoMatch;
+			for (uint32_t j = leaf.child; j < leaf.child + leaf.count; j++)
+			{
+				const typename Tree<Key>::Entry& entry = tree.entries[tree.leaves[j]];
+				if (matches(entry, points[i]))
+				{
+					rules[i] = entry.rule;
+					break;
+				}
+			}
+		}
+	}
+
+	bool PacketClassifier::classify(const IPEndPoint& source, const IPEndPoint& destination, uint8_t protocol,
+	                                size_t& rule) const noexcept
+	{
+		if (source.isIPv4() && destination.isIPv4())
+		{
+			const Point<uint32_t> point = { details::toPrefixKey(source.getIPv4()),
+				details::toPrefixKey(destination.getIPv4()), source.getPort(), destination.getPort(), protocol };
+			rule = classify(mTreeV4, point);
+		}
+		else if (source.isIPv6() && destination.isIPv6())
+		{
+			const Point<details::Uint128> point = { details::toPrefixKey(source.getIPv6()),
+				details::toPrefixKey(destination.getIPv6()), makeKey<details::Uint128>(source.getPort()),
+				makeKey<details::Uint128>(destination.getPort()), makeKey<details::Uint128>(protocol) };
+			rule = classify(mTreeV6, point);
+		}
+		else
+		{
+			rule = kNoMatch;
+		}
+		return rule != kNoMatch;
+	}
+
+	bool PacketClassifier::classify(const FlowKey& flow, size_t& rule) const noexcept
+	{
+		if (flow.mVersion == IPVersion::kIPv4)
+			rule = classify(mTreeV4, getPointV4(flow));
+		else if (flow.mVersion == IPVersion::kIPv6)
+			rule = classify(mTreeV6, getPointV6(flow));
+		else
+			rule = kNoMatch;
+		return rule != kNoMatch;
+	}
+
+	void PacketClassifier::classify(Span<const FlowKey> flows, Span<size_t> rules) const noexcept
+	{
+		assert(flows.size() == rules.size());
+		Point<uint32_t> pointsV4[kBatch];
+		Point<details::Uint128> pointsV6[kBatch];
+		size_t indicesV4[kBatch];
+		size_t indicesV6[kBatch];
+		size_t resultsV4[kBatch];
+		size_t resultsV6[kBatch];
+		for (size_t begin = 0; begin < flows.size(); begin += kBatch)
+		{
+			const size_t end = std::min(flows.size(), begin + kBatch);
+			size_t countV4 = 0;
+			size_t countV6 = 0;
+			for (size_t i = begin; i < end; i++)
+			{
+				const FlowKey& flow = flows[i];
+				if (flow.mVersion == IPVersion::kIPv4)
+				{
+					pointsV4[countV4] = getPointV4(flow);
+					indicesV4[countV4++] = i;
+				}
+				else if (flow.mVersion == IPVersion::kIPv6)
+				{
+					pointsV6[countV6] = getPointV6(flow);
+					indicesV6[countV6++] = i;
+				}
+				else
+				{
+					rules[i] = kNoMatch;
+				}
+			}
+			classify(mTreeV4, pointsV4, countV4, resultsV4);
+			classify(mTreeV6, pointsV6, countV6, resultsV6);
+			for (size_t i = 0; i < countV4; i++)
+			{
+				rules[indicesV4[i]] = resultsV4[i];
+			}
+			for (size_t i = 0; i < countV6; i++)
+			{
+				rules[indicesV6[i]] = resultsV6[i];
+			}
+		}
+	}
+}
@@ -0,0 +1,155 @@
+#include "PacketHeader.h"
+
+namespace ip_address
+{
+	namespace
+	{
+		constexpr size_t kIPv4HeaderSize = 20;
+		constexpr size_t kIPv6HeaderSize = 40;
+		//hop limit on the number of IPv6 extension headers, guards against crafted chains
+		constexpr int kMaxExtensionHeaders = 8;
+
+		inline uint16_t readUint16(const uint8_t* data) noexcept
+		{
+			uint16_t value;
+			memcpy(&value, data, sizeof(value));
+			return NetToHost16(value);
+		}
+
+		inline bool isPortProtocol(uint8_t protocol) noexcept
+		{
+			return protocol == IPPROTO_TCP || protocol == IPPROTO_UDP || protocol == IPPROTO_UDPLITE
+				|| protocol == IPPROTO_SCTP;
+		}
+	}
+
+	bool PacketHeader::parsePacketHeader(PacketHeader& header, const uint8_t* packet, size_t size) noexcept
+	{
+		header.reset();
+		if (packet == nullptr || size == 0)
+			return false;
+		switch (packet[0] >> 4)
+		{
+		case 4:
+			return header.parseIPv4(packet, size);
+		case 6:
+			return header.parseIPv6(packet, size);
+		default:
+			return false;
+		}
+	}
+
+	bool PacketHeader::parsePacketHeader(PacketHeader& header, Span<const uint8_t> packet) noexcept
+	{
+		return parsePacketHeader(header, packet.data(), packet.size());
+	}
+
+	size_t PacketHeader::parsePacketHeaders(const Span<const uint8_t>* packets, size_t count,
+	                                        PacketHeader* headers) noexcept
+	{
+		size_t parsed = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			parsed += parsePacketHeader(headers[i], packets[i].data(), packets[i].size());
+		}
+		return parsed;
+	}
+
+	void PacketHeader::reset() noexcept
+	{
+		mSource.mVersion = IPVersion::kUnknown;
+		mDestination.mVersion = IPVersion::kUnknown;
+		mSource.mPort = 0;
+		mDestination.mPort = 0;
+		mTransportOffset = 0;
+		mProtocol = 0;
+		mHasPorts = false;
+		mLaterFragment = false;
+	}
+
+	bool PacketHeader::parseIPv4(const uint8_t* packet, size_t size) noexcept
+	{
+		const size_t headerSize = static_cast<size_t>(packet[0] & 0x0F) * 4;
+		if (size < kIPv4HeaderSize || headerSize < kIPv4HeaderSize || headerSize > size)
+			return false;
+		//the unused bytes of the storage are cleared so the endpoints compare equal to parsed addresses
+		mSource.mAddr.mIpAddress6 = IPAddressV6();
+		mDestination.mAddr.mIpAddress6 = IPAddressV6();
+		memcpy(&mSource.mAddr.mIpAddress4, packet + 12, 4);
+		memcpy(&mDestination.mAddr.mIpAddress4, packet + 16, 4);
+		mSource.mVersion = IPVersion::kIPv4;
+		mDestination.mVersion = IPVersion::kIPv4;
+		mProtocol = packet[9];
+		mTransportOffset = static_cast<uint16_t>(headerSize);
+		mLaterFragment = (readUint16(packet + 6) & 0x1FFF) != 0;
+		if (!mLaterFragment)
+			parsePorts(packet, size);
+		return true;
+	}
+
+	bool PacketHeader::parseIPv6(const uint8_t* packet, size_t size) noexcept
+	{
+		if (size < kIPv6HeaderSize)
+			return false;
+		memcpy(&mSource.mAddr.mIpAddress6, packet + 8, 16);
+		memcpy(&mDestination.mAddr.mIpAddress6, packet + 24, 16);
+		mSource.mVersion = IPVersion::kIPv6;
+		mDestination.mVersion = IPVersion::kIPv6;
+
+		//extension header cut off by the capture length, addresses are valid but the transport is unknown
+		const auto truncated = [this]()
+		{
+			mProtocol = IPPROTO_NONE;
+			return true;
+		};
+		uint8_t next = packet[6];
+		size_t offset = kIPv6HeaderSize;
+		for (int i = 0; i < kMaxExtensionHeaders; i++)
+		{
+			size_t length;
+			switch (next)
+			{
+			case IPPROTO_HOPOPTS:
+			case IPPROTO_ROUTING:
+			case IPPROTO_DSTOPTS:
+			case 135: //mobility
+			case 139: //HIP
+			case 140: //shim6
+				if (offset + 2 > size)
+					return truncated();
+				length = (static_cast<size_t>(packet[offset + 1]) + 1) * 8;
+				break;
+			case IPPROTO_FRAGMENT:
+				if (offset + 8 > size)
+					return truncated();
+				mLaterFragment = (readUint16(packet + offset + 2) & 0xFFF8) != 0;
+				length = 8;
+				break;
+			case IPPROTO_AH:
+				if (offset + 2 > size)
+					return truncated();
+				length = (static_cast<size_t>(packet[offset + 1]) + 2) * 4;
+				break;
+			default:
+				mProtocol = next;
+				mTransportOffset = static_cast<uint16_t>(offset);
+				if (!mLaterFragment)
+					parsePorts(packet, size);
+				return true;
+			}
+			next = packet[offset];
+			offset += length;
+		}
+		//too many extension headers
+		return truncated();
+	}
+
+	void PacketHeader::parsePorts(const uint8_t* packet, size_t size) noexcept
+	{
+		if (!isPortProtocol(mProtocol) || mTransportOffset + 4u > size)
+			return;
+		mSource.mPort = readUint16(packet + mTransportOffset);
+		mDestination.mPort = readUint16(packet + mTransportOffset + 2);
+		mHasPorts = true;
+	}
+}
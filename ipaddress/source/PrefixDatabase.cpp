@@ -0,0 +1,559 @@
+#include "PrefixDatabase.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ip_address
+{
+	namespace
+	{
+		using Node = details::PrefixDatabaseNode;
+		using Key4 = details::AddressKey<IPAddressV4>;
+		using Key6 = details::AddressKey<IPAddressV6>;
+
+		constexpr char kMagic[8] = { 'I', 'P', 'P', 'R', 'E', 'F', 'X', '\0' };
+		constexpr uint32_t kFormatVersion = 1;
+		constexpr uint32_t kStride = 6;
+		constexpr size_t kSectionAlignment = 64;
+
+		enum Section
+		{
+			kNodesV4,
+			kLeavesV4,
+			kNodesV6,
+			kLeavesV6,
+			kValues,
+			kSectionCount
+		};
+
+		struct SectionEntry
+		{
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		struct FileHeader
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t headerSize;
+			uint64_t fileSize;
+			/* checksum of everything after the header */
+			uint64_t checksum;
+			uint64_t prefixCountV4;
+			uint64_t prefixCountV6;
+			SectionEntry sections[kSectionCount];
+			uint8_t reserved[8];
+		};
+		static_assert(sizeof(FileHeader) == 136, "header layout is part of the file format");
+
+		/*
+		 * Leaf word: value offset in the low 32 bits, value length in the next 24 and prefix length + 1 in the top
+		 * 8 bits, a zero leaf means no prefix matches.
+		 */
+		constexpr uint64_t kNoMatch = 0;
+
+		constexpr uint64_t makeLeaf(uint64_t value, uint8_t prefixLength) noexcept
+		{
+			return value | (static_cast<uint64_t>(prefixLength) + 1) << 56;
+		}
+
+		constexpr uint64_t rotateLeft(uint64_t value, uint32_t count) noexcept
+		{
+			return value << count | value >> (64 - count);
+		}
+
+		/*
+		 * 64-bit checksum with four independent multiply-rotate lanes (the round of xxHash64) so it runs at
+		 * memory speed, the tail is mixed in bytewise.
+		 */
+		uint64_t getChecksum(const uint8_t* data, size_t size) noexcept
+		{
+			constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+			constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+			uint64_t lanes[4] = { kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1 };
+			size_t i = 0;
+			for (; i + 32 <= size; i += 32)
+			{
+				for (size_t lane = 0; lane < 4; lane++)
+				{
+					uint64_t word;
+					memcpy(&word, data + i + lane * 8, sizeof(word));
+					lanes[lane] = rotateLeft(lanes[lane] + word * kPrime2, 31) * kPrime1;
+				}
+			}
+			uint64_t hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) +
+				rotateLeft(lanes[3], 18) + size;
+			for (; i < size; i++)
+			{
+				hash = rotateLeft(hash ^ (data[i] * kPrime1), 11) * kPrime2;
+			}
+			return details::mix64(hash);
+		}
+
+		/*
+		 * kStride bits of key starting at bit depth (0 is the most significant), bits past the address are 0.
+		 */
+		inline uint32_t getChunk(uint32_t key, uint32_t depth) noexcept
+		{
+			return static_cast<uint32_t>((static_cast<uint64_t>(key) << 32) >> (64 - kStride - depth)) & 63;
+		}
+
+		inline uint32_t getChunk(const details::Uint128& key, uint32_t depth) noexcept
+		{
+			if (depth + kStride <= 64)
+				return static_cast<uint32_t>(key.hi >> (64 - kStride - depth)) & 63;
+			if (depth < 64)
+				return static_cast<uint32_t>(key.hi << (depth + kStride - 64) | key.lo >> (128 - kStride - depth)) & 63;
+			if (depth + kStride <= 128)
+				return static_cast<uint32_t>(key.lo >> (128 - kStride - depth)) & 63;
+			return static_cast<uint32_t>(key.lo << (depth + kStride - 128)) & 63;
+		}
+
+		template <typename Key>
+		uint64_t lookupLeaf(const Node* nodes, const uint64_t* leaves, const Key& key) noexcept
+		{
+			const Node* node = nodes;
+			for (uint32_t depth = 0;; depth += kStride)
+			{
+				const uint32_t chunk = getChunk(key, depth);
+				const uint64_t bit = uint64_t(1) << chunk;
+				if ((node->children & bit) == 0)
+				{
+					//the run containing chunk starts at the last leaf bit at or below it
+					const uint64_t runs = node->leaves & ((bit << 1) - 1);
+					return leaves[node->leafBase + static_cast<uint32_t>(__builtin_popcountll(runs)) - 1];
+				}
+				node = nodes + node->childBase + static_cast<uint32_t>(__builtin_popcountll(node->children & (bit - 1)));
+			}
+		}
+
+		template <typename Key>
+		bool isOrdered(const Key& lhs, uint8_t lhsLength, const Key& rhs, uint8_t rhsLength) noexcept
+		{
+			return lhs < rhs || (lhs == rhs && lhsLength < rhsLength);
+		}
+
+		/*
+		 * Writes the trie of entries, which are sorted by key and prefix length and contain one entry per prefix.
+		 */
+		template <typename Entry>
+		class TrieWriter
+		{
+		public:
+			explicit TrieWriter(const std::vector<Entry>& entries) : mEntries(entries) { }
+
+			void write(std::vector<Node>& nodes, std::vector<uint64_t>& leaves)
+			{
+				mNodes = &nodes;
+				mLeaves = &leaves;
+				if (mEntries.empty())
+					return;
+				//a /0 is not stored below the root, it is the default of every slot
+				size_t begin = 0;
+				uint64_t root = kNoMatch;
+				while (begin < mEntries.size() && mEntries[begin].prefixLength == 0)
+					root = mEntries[begin++].leaf;
+				nodes.emplace_back();
+				this->writeNode(0, begin, mEntries.size(), 0, root);
+			}
+		private:
+			/*
+			 * Entries [begin, end) share the first depth bits and are longer than depth.
+			 */
+			void writeNode(size_t index, size_t begin, size_t end, uint32_t depth, uint64_t inherited)
+			{
+				uint64_t values[64];
+				std::fill(values, values + 64, inherited);
+				std::vector<const Entry*> shorter;
+				size_t childBegin[64];
+				size_t childEnd[64];
+				uint64_t children = 0;
+				for (size_t i = begin; i < end;)
+				{
+					const uint32_t chunk = getChunk(mEntries[i].key, depth);
+					//entries shorter than depth + kStride cover several slots, they sort first within a chunk
+					for (; i < end && getChunk(mEntries[i].key, depth) == chunk &&
+					     mEntries[i].prefixLength < depth + kStride; i++)
+						shorter.push_back(&mEntries[i]);
+					//an exact match is applied after the shorter ones
+					if (i < end && getChunk(mEntries[i].key, depth) == chunk && mEntries[i].prefixLength == depth + kStride)
+						i++;
+					const size_t first = i;
+					while (i < end && getChunk(mEntries[i].key, depth) == chunk)
+						i++;
+					if (i != first)
+					{
+						children |= uint64_t(1) << chunk;
+						childBegin[chunk] = first;
+						childEnd[chunk] = i;
+					}
+				}
+				//shorter prefixes are nested or disjoint, applying them from short to long leaves the longest match
+				std::stable_sort(shorter.begin(), shorter.end(), [](const Entry* lhs, const Entry* rhs)
+				{
+					return lhs->prefixLength < rhs->prefixLength;
+				});
+				for (const Entry* entry : shorter)
+				{
+					const uint32_t first = getChunk(entry->key, depth);
+					const uint32_t count = 1u << (depth + kStride - entry->prefixLength);
+					std::fill(values + first, values + first + count, entry->leaf);
+				}
+				for (size_t i = begin; i < end; i++)
+				{
+					if (mEntries[i].prefixLength == depth + kStride)
+						values[getChunk(mEntries[i].key, depth)] = mEntries[i].leaf;
+				}
+
+				Node node = {};
+				node.children = children;
+				node.childBase = static_cast<uint32_t>(mNodes->size());
+				node.leafBase = static_cast<uint32_t>(mLeaves->size());
+				bool first = true;
+				uint64_t previous = kNoMatch;
+				for (uint32_t chunk = 0; chunk < 64; chunk++)
+				{
+					if ((children >> chunk & 1) != 0)
+						continue;
+					if (first || values[chunk] != previous)
+					{
+						node.leaves |= uint64_t(1) << chunk;
+						mLeaves->push_back(values[chunk]);
+						previous = values[chunk];
+						first = false;
+					}
+				}
+				mNodes->resize(mNodes->size() + static_cast<size_t>(__builtin_popcountll(children)));
+				(*mNodes)[index] = node;
+				uint32_t child = node.childBase;
+				for (uint32_t chunk = 0; chunk < 64; chunk++)
+				{
+					if ((children >> chunk & 1) != 0)
+						this->writeNode(child++, childBegin[chunk], childEnd[chunk], depth + kStride, values[chunk]);
+				}
+			}
+		private:
+			const std::vector<Entry>& mEntries;
+			std::vector<Node>* mNodes = nullptr;
+			std::vector<uint64_t>* mLeaves = nullptr;
+		};
+
+		/*
+		 * Sorts by key and prefix length, of equal prefixes the one added last is kept.
+		 */
+		template <typename Entry>
+		std::vector<Entry> getSortedEntries(const std::vector<Entry>& entries)
+		{
+			std::vector<Entry> sorted(entries);
+			std::stable_sort(sorted.begin(), sorted.end(), [](const Entry& lhs, const Entry& rhs)
+			{
+				return isOrdered(lhs.key, lhs.prefixLength, rhs.key, rhs.prefixLength);
+			});
+			std::vector<Entry> unique;
+			unique.reserve(sorted.size());
+			for (const Entry& entry : sorted)
+			{
+				if (!unique.empty() && unique.back().key == entry.key && unique.back().prefixLength == entry.prefixLength)
+					unique.back() = entry;
+				else
+					unique.push_back(entry);
+			}
+			return unique;
+		}
+
+		size_t alignSection(size_t offset) noexcept
+		{
+			return (offset + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+		}
+
+		bool verifyTrie(const Node* nodes, size_t nodeCount, const uint64_t* leaves, size_t leafCount, uint32_t bits,
+		                size_t valuesSize)
+		{
+			for (size_t leaf = 0; leaf < leafCount; leaf++)
+			{
+				const uint64_t word = leaves[leaf];
+				const uint64_t offset = word & 0xFFFFFFFF;
+				const uint64_t length = word >> 32 & 0xFFFFFF;
+				if (word != kNoMatch && (offset + length > valuesSize || (word >> 56) - 1 > bits))
+					return false;
+			}
+			//children are stored after their parent, so depths can be computed in one pass and every path ends
+			std::vector<uint32_t> depths(nodeCount, 0);
+			for (size_t i = 0; i < nodeCount; i++)
+			{
+				const Node& node = nodes[i];
+				const auto childCount = static_cast<uint32_t>(__builtin_popcountll(node.children));
+				const auto leafRuns = static_cast<uint32_t>(__builtin_popcountll(node.leaves));
+				//the first leaf slot has to start a run
+				const uint64_t leafSlots = ~node.children;
+				const uint64_t firstLeafSlot = leafSlots & (0 - leafSlots);
+				if ((node.children & node.leaves) != 0 || (node.leaves & firstLeafSlot) != firstLeafSlot)
+					return false;
+				if (uint64_t(node.leafBase) + leafRuns > leafCount)
+					return false;
+				if (childCount == 0)
+					continue;
+				if (depths[i] + kStride >= bits || node.childBase <= i || uint64_t(node.childBase) + childCount > nodeCount)
+					return false;
+				for (uint32_t child = 0; child < childCount; child++)
+				{
+					depths[node.childBase + child] = std::max(depths[node.childBase + child], depths[i] + kStride);
+				}
+			}
+			return true;
+		}
+	}
+
+	PrefixDatabase::PrefixDatabase(const std::string& path)
+	{
+		const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			throw std::runtime_error("can not open prefix database");
+		struct stat info = {};
+		if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader)))
+		{
+			close(fd);
+			throw std::runtime_error("invalid prefix database");
+		}
+		mSize = static_cast<size_t>(info.st_size);
+		void* mapped = mmap(nullptr, mSize, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (mapped == MAP_FAILED)
+			throw std::runtime_error("can not map prefix database");
+		mData = static_cast<const uint8_t*>(mapped);
+		mMapped = true;
+		try
+		{
+			this->load();
+		}
+		catch (...)
+		{
+			munmap(mapped, mSize);
+			throw;
+		}
+	}
+
+	PrefixDatabase::PrefixDatabase(Span<const uint8_t> data) : mData(data.data()), mSize(data.size())
+	{
+		this->load();
+	}
+
+	PrefixDatabase::PrefixDatabase(std::vector<uint8_t> data) : mOwned(std::move(data))
+	{
+		mData = mOwned.data();
+		mSize = mOwned.size();
+		this->load();
+	}
+
+	PrefixDatabase::~PrefixDatabase()
+	{
+		if (mMapped)
+			munmap(const_cast<uint8_t*>(mData), mSize);
+	}
+
+	void PrefixDatabase::load()
+	{
+		FileHeader header;
+		if (mSize < sizeof(header))
+			throw std::runtime_error("invalid prefix database");
+		memcpy(&header, mData, sizeof(header));
+		if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFormatVersion ||
+			header.headerSize != sizeof(FileHeader) || header.fileSize != mSize)
+			throw std::runtime_error("invalid prefix database");
+		for (const SectionEntry& section : header.sections)
+		{
+			if (section.offset < sizeof(FileHeader) || section.offset % kSectionAlignment != 0 ||
+				section.offset > mSize || section.size > mSize - section.offset)
+				throw std::runtime_error("invalid prefix database");
+		}
+		const SectionEntry* sections = header.sections;
+		if (sections[kNodesV4].size % sizeof(Node) != 0 || sections[kNodesV6].size % sizeof(Node) != 0 ||
+			sections[kLeavesV4].size % sizeof(uint64_t) != 0 || sections[kLeavesV6].size % sizeof(uint64_t) != 0)
+			throw std::runtime_error("invalid prefix database");
+		//an empty trie has no root, a non empty one has a leaf or a child in every node
+		if ((sections[kNodesV4].size == 0) != (header.prefixCountV4 == 0) ||
+			(sections[kNodesV6].size == 0) != (header.prefixCountV6 == 0))
+			throw std::runtime_error("invalid prefix database");
+		mNodesV4 = reinterpret_cast<const Node*>(mData + sections[kNodesV4].offset);
+		mLeavesV4 = reinterpret_cast<const uint64_t*>(mData + sections[kLeavesV4].offset);
+		mNodesV6 = reinterpret_cast<const Node*>(mData + sections[kNodesV6].offset);
+		mLeavesV6 = reinterpret_cast<const uint64_t*>(mData + sections[kLeavesV6].offset);
+		mValues = reinterpret_cast<const char*>(mData + sections[kValues].offset);
+		mPrefixCountV4 = header.prefixCountV4;
+		mPrefixCountV6 = header.prefixCountV6;
+	}
+
+	bool PrefixDatabase::lookup(const IPAddressV4& addr4, std::string_view& value, uint8_t* prefixLength) const noexcept
+	{
+		if (mPrefixCountV4 == 0)
+			return false;
+		const uint64_t leaf = lookupLeaf(mNodesV4, mLeavesV4, Key4::toKey(addr4));
+		if (leaf == kNoMatch)
+			return false;
+		value = std::string_view(mValues + (leaf & 0xFFFFFFFF), leaf >> 32 & 0xFFFFFF);
+		if (prefixLength != nullptr)
+			*prefixLength = static_cast<uint8_t>((leaf >> 56) - 1);
+		return true;
+	}
+
+	bool PrefixDatabase::lookup(const IPAddressV6& addr6, std::string_view& value, uint8_t* prefixLength) const noexcept
+	{
+		if (mPrefixCountV6 == 0)
+			return false;
+		const uint64_t leaf = lookupLeaf(mNodesV6, mLeavesV6, Key6::toKey(addr6));
+		if (leaf == kNoMatch)
+			return false;
+		value = std::string_view(mValues + (leaf & 0xFFFFFFFF), leaf >> 32 & 0xFFFFFF);
+		if (prefixLength != nullptr)
+			*prefixLength = static_cast<uint8_t>((leaf >> 56) - 1);
+		return true;
+	}
+
+	bool PrefixDatabase::lookup(const IPAddress& addr, std::string_view& value, uint8_t* prefixLength) const noexcept
+	{
+		if (addr.isIPv4())
+			return this->lookup(addr.asIPv4(), value, prefixLength);
+		if (addr.isIPv6())
+			return this->lookup(addr.asIPv6(), value, prefixLength);
+		return false;
+	}
+
+	bool PrefixDatabase::verify() const noexcept
+	{
+		FileHeader header;
+		memcpy(&header, mData, sizeof(header));
+		if (getChecksum(mData + sizeof(header), mSize - sizeof(header)) != header.checksum)
+			return false;
+		const SectionEntry* sections = header.sections;
+		try
+		{
+			return verifyTrie(mNodesV4, sections[kNodesV4].size / sizeof(Node), mLeavesV4,
+			                  sections[kLeavesV4].size / sizeof(uint64_t), 32, sections[kValues].size) &&
+				verifyTrie(mNodesV6, sections[kNodesV6].size / sizeof(Node), mLeavesV6,
+				           sections[kLeavesV6].size / sizeof(uint64_t), 128, sections[kValues].size);
+		}
+		catch (const std::bad_alloc&)
+		{
+			return false;
+		}
+	}
+
+	uint64_t PrefixDatabaseBuilder::addValue(std::string_view value)
+	{
+		const auto found = mValueOffsets.find(std::string(value));
+		if (found != mValueOffsets.end())
+			return found->second | static_cast<uint64_t>(value.size()) << 32;
+		if (mValues.size() + value.size() > UINT32_MAX)
+			throw std::runtime_error("prefix database values exceed 4 GiB");
+		const auto offset = static_cast<uint32_t>(mValues.size());
+		mValues.append(value);
+		mValueOffsets.emplace(std::string(value), offset);
+		return offset | static_cast<uint64_t>(value.size()) << 32;
+	}
+
+	bool PrefixDatabaseBuilder::add(const IPNetwork& network, std::string_view value)
+	{
+		if (value.size() > kMaxValueLength)
+			return false;
+		const IPAddress& addr = network.getAddress();
+		const uint8_t prefixLength = network.getPrefixLength();
+		if (addr.isIPv4() && prefixLength <= 32)
+		{
+			const uint32_t key = Key4::truncate(Key4::toKey(addr.asIPv4()), prefixLength);
+			mEntriesV4.push_back({ key, prefixLength, makeLeaf(this->addValue(value), prefixLength) });
+			return true;
+		}
+		if (addr.isIPv6() && prefixLength <= 128)
+		{
+			const details::Uint128 key = Key6::truncate(Key6::toKey(addr.asIPv6()), prefixLength);
+			mEntriesV6.push_back({ key, prefixLength, makeLeaf(this->addValue(value), prefixLength) });
+			return true;
+		}
+		return false;
+	}
+
+	size_t PrefixDatabaseBuilder::addLines(std::istream& lines)
+	{
+		size_t skipped = 0;
+		std::string line;
+		while (std::getline(lines, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			const size_t start = line.find_first_not_of(" \t");
+			if (start == std::string::npos || line[start] == '#')
+				continue;
+			const size_t prefixEnd = line.find_first_of(" \t", start);
+			const size_t valueStart = prefixEnd == std::string::npos ? line.size() :
+				std::min(line.size(), line.find_first_not_of(" \t", prefixEnd));
+			IPNetwork network;
+			if (!IPNetwork::parseIPNetwork(network, line.substr(start, prefixEnd - start)) ||
+				!this->add(network, std::string_view(line).substr(valueStart)))
+				skipped++;
+		}
+		return skipped;
+	}
+
+	std::vector<uint8_t> PrefixDatabaseBuilder::build() const
+	{
+		std::vector<Node> nodesV4;
+		std::vector<uint64_t> leavesV4;
+		std::vector<Node> nodesV6;
+		std::vector<uint64_t> leavesV6;
+		const auto entriesV4 = getSortedEntries(mEntriesV4);
+		const auto entriesV6 = getSortedEntries(mEntriesV6);
+		TrieWriter<Entry<uint32_t>>(entriesV4).write(nodesV4, leavesV4);
+		TrieWriter<Entry<details::Uint128>>(entriesV6).write(nodesV6, leavesV6);
+		if (nodesV4.size() > UINT32_MAX || nodesV6.size() > UINT32_MAX || leavesV4.size() > UINT32_MAX ||
+			leavesV6.size() > UINT32_MAX)
+			throw std::runtime_error("prefix database is too large");
+
+		FileHeader header = {};
+		memcpy(header.magic, kMagic, sizeof(kMagic));
+		header.version = kFormatVersion;
+		header.headerSize = sizeof(FileHeader);
+		header.prefixCountV4 = entriesV4.size();
+		header.prefixCountV6 = entriesV6.size();
+		const std::pair<const void*, size_t> contents[kSectionCount] = {
+			{ nodesV4.data(), nodesV4.size() * sizeof(Node) },
+			{ leavesV4.data(), leavesV4.size() * sizeof(uint64_t) },
+			{ nodesV6.data(), nodesV6.size() * sizeof(Node) },
+			{ leavesV6.data(), leavesV6.size() * sizeof(uint64_t) },
+			{ mValues.data(), mValues.size() },
+		};
+		size_t offset = sizeof(FileHeader);
+		for (size_t section = 0; section < kSectionCount; section++)
+		{
+			offset = alignSection(offset);
+			header.sections[section] = { offset, contents[section].second };
+			offset += contents[section].second;
+		}
+		header.fileSize = offset;
+		std::vector<uint8_t> file(offset);
+		for (size_t section = 0; section < kSectionCount; section++)
+		{
+			if (contents[section].second != 0)
+				memcpy(file.data() + header.sections[section].offset, contents[section].first, contents[section].second);
+		}
+		header.checksum = getChecksum(file.data() + sizeof(FileHeader), file.size() - sizeof(FileHeader));
+		memcpy(file.data(), &header, sizeof(header));
+		return file;
+	}
+
+	void PrefixDatabaseBuilder::write(const std::string& path) const
+	{
+		const std::vector<uint8_t> file = build();
+		FILE* out = fopen(path.c_str(), "wb");
+		if (out == nullptr)
+			throw std::runtime_error("can not create prefix database");
+		const bool written = fwrite(file.data(), 1, file.size(), out) == file.size();
+		if (fclose(out) != 0 || !written)
+			throw std::runtime_error("can not write prefix database");
+	}
+}
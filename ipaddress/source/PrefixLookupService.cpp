@@ -0,0 +1,93 @@
+#include "PrefixLookupService.h"
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+namespace ip_address
+{
+	namespace
+	{
+		/* how often the reload thread retries freeing retired databases */
+		constexpr std::chrono::milliseconds kReclaimInterval(10);
+
+		std::unique_ptr<PrefixDatabase> loadFirst(const PrefixLookupService::Loader& loader)
+		{
+			std::unique_ptr<PrefixDatabase> database = loader();
+			if (database == nullptr)
+				throw std::runtime_error("prefix lookup loader returned no database");
+			return database;
+		}
+	}
+
+	PrefixLookupService::PrefixLookupService(Loader loader, std::chrono::milliseconds interval) :
+		mLoader(std::move(loader)), mInterval(interval), mSnapshot(loadFirst(mLoader))
+	{
+		mThread = std::thread([this]() { this->run(); });
+	}
+
+	PrefixLookupService::~PrefixLookupService()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStopping = true;
+		}
+		mWakeUp.notify_one();
+		mThread.join();
+	}
+
+	void PrefixLookupService::requestReload()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mReloadRequested = true;
+		}
+		mWakeUp.notify_one();
+	}
+
+	void PrefixLookupService::reload()
+	{
+		try
+		{
+			std::unique_ptr<PrefixDatabase> database = mLoader();
+			if (database == nullptr)
+				return;
+			mSnapshot.update(std::move(database));
+			mGeneration.fetch_add(1, std::memory_order_release);
+		}
+		catch (const std::exception&)
+		{
+			mFailedReloads.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void PrefixLookupService::run()
+	{
+		using Clock = std::chrono::steady_clock;
+		Clock::time_point nextReload = Clock::now() + mInterval;
+		std::unique_lock<std::mutex> lock(mMutex);
+		while (true)
+		{
+			const auto woken = [this]() { return mStopping || mReloadRequested; };
+			Clock::time_point wakeUp = Clock::now() + kReclaimInterval;
+			if (mInterval.count() > 0 && (mRetiredCount.load(std::memory_order_relaxed) == 0 || nextReload < wakeUp))
+				wakeUp = nextReload;
+			if (mInterval.count() > 0 || mRetiredCount.load(std::memory_order_relaxed) != 0)
+				mWakeUp.wait_until(lock, wakeUp, woken);
+			else
+				mWakeUp.wait(lock, woken);
+			if (mStopping)
+				return;
+			const bool requested = mReloadRequested;
+			mReloadRequested = false;
+			lock.unlock();
+
+			if (requested || (mInterval.count() > 0 && Clock::now() >= nextReload))
+			{
+				this->reload();
+				nextReload = Clock::now() + mInterval;
+			}
+			mRetiredCount.store(mSnapshot.reclaim(), std::memory_order_relaxed);
+			lock.lock();
+		}
+	}
+}
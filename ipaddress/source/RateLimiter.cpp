@@ -0,0 +1,263 @@
+#include "RateLimiter.h"
+#include <algorithm>
+#include <random>
+#include "util/AddressKey.h"
+
+namespace ip_address
+{
+	namespace
+	{
+		constexpr uint64_t kEmptyKey = 0;
+		/* state of an entry that is being claimed or evicted, admit() retries until it changes */
+		constexpr uint64_t kLocked = ~uint64_t(0);
+	}
+
+	RateLimiter::RateLimiter(double ratePerSecond, uint32_t burst, size_t capacity, uint8_t prefixLengthV4,
+	                         uint8_t prefixLengthV6) :
+		mPrefixLengthV4(prefixLengthV4), mPrefixLengthV6(prefixLengthV6)
+	{
+		assert(ratePerSecond > 0.0 && burst > 0 && capacity > 0);
+		assert(prefixLengthV4 <= 32 && prefixLengthV6 <= 128);
+		mInterval = std::max<uint64_t>(1, static_cast<uint64_t>(1e9 / ratePerSecond));
+		mBurstTolerance = mInterval * burst;
+
+		size_t sets = 1;
+		while (sets * kWays < capacity)
+			sets <<= 1;
+		mSetMask = sets - 1;
+		mSets.reset(new Set[sets]);
+		for (size_t i = 0; i < sets; i++)
+		{
+			for (auto& entry : mSets[i].mEntries)
+			{
+				entry.mKey.store(kEmptyKey, std::memory_order_relaxed);
+				entry.mState.store(kLocked, std::memory_order_relaxed);
+			}
+		}
+		//a random seed keeps clients from choosing addresses that collide on purpose
+		std::random_device device;
+		mSeed = (static_cast<uint64_t>(device()) << 32) ^ device() ^ getTime();
+	}
+
+	RateLimiter::~RateLimiter()
+	{
+		this->stopEviction();
+	}
+
+	uint64_t RateLimiter::fingerprint(const IPAddressV4& addr4) const noexcept
+	{
+		using Traits = details::AddressKey<IPAddressV4>;
+		const uint64_t key = Traits::truncate(Traits::toKey(addr4), mPrefixLengthV4) | (uint64_t(AF_INET) << 32);
+		const uint64_t fp = details::mix64(key ^ mSeed);
+		return fp == kEmptyKey ? 1 : fp;
+	}
+
+	uint64_t RateLimiter::fingerprint(const IPAddressV6& addr6) const noexcept
+	{
+		using Traits = details::AddressKey<IPAddressV6>;
+		const auto key = Traits::truncate(Traits::toKey(addr6), mPrefixLengthV6);
+		const uint64_t fp = details::mix64(key.hi ^ mSeed ^ details::mix64(key.lo + AF_INET6));
+		return fp == kEmptyKey ? 1 : fp;
+	}
+
+	bool RateLimiter::evict(Entry& entry, uint64_t state) noexcept
+	{
+		if (state == kLocked || !entry.mState.compare_exchange_strong(state, kLocked, std::memory_order_acq_rel))
+			return false;
+		entry.mKey.store(kEmptyKey, std::memory_order_release);
+		return true;
+	}
+
+	bool RateLimiter::admitKey(uint64_t key, uint64_t now, uint32_t cost) noexcept
+	{
+		const uint64_t charge = mInterval * cost;
+		Set& set = mSets[key & mSetMask];
+		for (;;)
+		{
+			Entry* found = nullptr;
+			for (auto& entry : set.mEntries)
+			{
+				if (entry.mKey.load(std::memory_order_acquire) == key)
+				{
+					found = &entry;
+					break;
+				}
+			}
+
+			if (found == nullptr)
+			{
+				//a thread that raced this one may have claimed a slot for the same key since the scan above
+				for (auto& entry : set.mEntries)
+				{
+					uint64_t expected = entry.mKey.load(std::memory_order_acquire);
+					if (expected == key)
+					{
+						found = &entry;
+						break;
+					}
+					if (expected != kEmptyKey)
+						continue;
+					if (entry.mKey.compare_exchange_strong(expected, key, std::memory_order_acq_rel))
+					{
+						//a new bucket is full, charge it directly instead of publishing a full state first
+						const bool admitted = charge <= mBurstTolerance;
+						entry.mState.store(admitted ? now + charge : now, std::memory_order_release);
+						return admitted;
+					}
+					if (expected == key)
+					{
+						found = &entry;
+						break;
+					}
+				}
+			}
+
+			if (found == nullptr)
+			{
+				//set is full, recycle the bucket with the oldest theoretical arrival time
+				Entry* victim = nullptr;
+				uint64_t victimState = kLocked;
+				for (auto& entry : set.mEntries)
+				{
+					const uint64_t state = entry.mState.load(std::memory_order_acquire);
+					if (state < victimState)
+					{
+						victim = &entry;
+						victimState = state;
+					}
+				}
+				if (victim != nullptr && this->evict(*victim, victimState) && victimState > now)
+				{
+					mOverflowCount.fetch_add(1, std::memory_order_relaxed);
+				}
+				continue;
+			}
+
+			uint64_t state = found->mState.load(std::memory_order_acquire);
+			while (state != kLocked)
+			{
+				const uint64_t next = std::max(state, now) + charge;
+				if (next - now > mBurstTolerance)
+					return false;
+				if (found->mState.compare_exchange_weak(state, next, std::memory_order_acq_rel))
+					return true;
+			}
+			//entry is being evicted or claimed, look it up again
+		}
+	}
+
+	bool RateLimiter::admit(const IPAddressV4& addr4, uint64_t now, uint32_t cost) noexcept
+	{
+		return this->admitKey(this->fingerprint(addr4), now, cost);
+	}
+
+	bool RateLimiter::admit(const IPAddressV6& addr6, uint64_t now, uint32_t cost) noexcept
+	{
+		return this->admitKey(this->fingerprint(addr6), now, cost);
+	}
+
+	bool RateLimiter::admit(const IPAddress& addr, uint64_t now, uint32_t cost) noexcept
+	{
+		assert(addr.isIPv4() || addr.isIPv6());
+		if (addr.isIPv4())
+			return this->admit(addr.asIPv4(), now, cost);
+		return this->admit(addr.asIPv6(), now, cost);
+	}
+
+	bool RateLimiter::admit(const IPAddress& addr) noexcept
+	{
+		return this->admit(addr, getTime());
+	}
+
+	uint32_t RateLimiter::getTokens(const IPAddress& addr, uint64_t now) const noexcept
+	{
+		assert(addr.isIPv4() || addr.isIPv6());
+		const uint64_t key = addr.isIPv4() ? this->fingerprint(addr.asIPv4()) : this->fingerprint(addr.asIPv6());
+		const Set& set = mSets[key & mSetMask];
+		for (const auto& entry : set.mEntries)
+		{
+			if (entry.mKey.load(std::memory_order_acquire) != key)
+				continue;
+			const uint64_t state = entry.mState.load(std::memory_order_acquire);
+			if (state == kLocked)
+				break;
+			return static_cast<uint32_t>((now + mBurstTolerance - std::max(state, now)) / mInterval);
+		}
+		return static_cast<uint32_t>(mBurstTolerance / mInterval);
+	}
+
+	size_t RateLimiter::evictIdle(uint64_t now) noexcept
+	{
+		size_t evicted = 0;
+		for (size_t i = 0; i <= mSetMask; i++)
+		{
+			for (auto& entry : mSets[i].mEntries)
+			{
+				if (entry.mKey.load(std::memory_order_relaxed) == kEmptyKey)
+					continue;
+				const uint64_t state = entry.mState.load(std::memory_order_acquire);
+				if (state <= now && this->evict(entry, state))
+					evicted++;
+			}
+		}
+		return evicted;
+	}
+
+	void RateLimiter::startEviction(std::chrono::milliseconds interval)
+	{
+		this->stopEviction();
+		mEvictionStop = false;
+		mEvictionThread = std::thread([this, interval]()
+		{
+			std::unique_lock<std::mutex> lock(mEvictionMutex);
+			while (!mEvictionCondition.wait_for(lock, interval, [this]() { return mEvictionStop; }))
+			{
+				lock.unlock();
+				this->evictIdle(getTime());
+				lock.lock();
+			}
+		});
+	}
+
+	void RateLimiter::stopEviction()
+	{
+		if (!mEvictionThread.joinable())
+			return;
+		{
+			std::lock_guard<std::mutex> lock(mEvictionMutex);
+			mEvictionStop = true;
+		}
+		mEvictionCondition.notify_all();
+		mEvictionThread.join();
+	}
+
+	size_t RateLimiter::size() const noexcept
+	{
+		size_t count = 0;
+		for (size_t i = 0; i <= mSetMask; i++)
+		{
+			for (const auto& entry : mSets[i].mEntries)
+			{
+				if (entry.mKey.load(std::memory_order_relaxed) != kEmptyKey)
+					count++;
+			}
+		}
+		return count;
+	}
+
+	size_t RateLimiter::capacity() const noexcept
+	{
+		return (mSetMask + 1) * kWays;
+	}
+
+	uint64_t RateLimiter::getOverflowCount() const noexcept
+	{
+		return mOverflowCount.load(std::memory_order_relaxed);
+	}
+
+	uint64_t RateLimiter::getTime() noexcept
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+}
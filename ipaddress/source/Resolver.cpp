@@ -0,0 +1,502 @@
+#include "Resolver.h"
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <poll.h>
+#include <unistd.h>
+
+namespace ip_address
+{
+	namespace
+	{
+		constexpr uint16_t kTypeA = 1;
+		constexpr uint16_t kTypeSoa = 6;
+		constexpr uint16_t kTypeAaaa = 28;
+		constexpr uint16_t kClassIn = 1;
+		constexpr uint8_t kRcodeNameError = 3;
+		constexpr size_t kHeaderSize = 12;
+		constexpr size_t kMaxNameSize = 253;
+		constexpr size_t kMaxMessageSize = 4096;
+
+		uint16_t read16(const uint8_t* data) noexcept
+		{
+			return static_cast<uint16_t>(data[0] << 8 | data[1]);
+		}
+
+		uint32_t read32(const uint8_t* data) noexcept
+		{
+			return static_cast<uint32_t>(read16(data)) << 16 | read16(data + 2);
+		}
+
+		void write16(std::vector<uint8_t>& out, uint16_t value)
+		{
+			out.push_back(static_cast<uint8_t>(value >> 8));
+			out.push_back(static_cast<uint8_t>(value));
+		}
+
+		//lower case without the trailing dot, empty if name is not a valid host name
+		std::string normalizeName(const std::string& name)
+		{
+			std::string result(name);
+			if (!result.empty() && result.back() == '.')
+				result.pop_back();
+			if (result.empty() || result.size() > kMaxNameSize)
+				return std::string();
+			size_t label = 0;
+			for (char& c : result)
+			{
+				if (c == '.')
+				{
+					if (label == 0)
+						return std::string();
+					label = 0;
+					continue;
+				}
+				if (++label > 63 || static_cast<unsigned char>(c) <= ' ')
+					return std::string();
+				if (c >= 'A' && c <= 'Z')
+					c = static_cast<char>(c - 'A' + 'a');
+			}
+			return label == 0 ? std::string() : result;
+		}
+
+		bool parseNumeric(const std::string& name, IPAddress& addr)
+		{
+			ByteArray4 bytes4;
+			ByteArray16 bytes6;
+			if (inet_pton(AF_INET, name.c_str(), bytes4.data()) == 1)
+				addr = IPAddress(bytes4);
+			else if (inet_pton(AF_INET6, name.c_str(), bytes6.data()) == 1)
+				addr = IPAddress(bytes6);
+			else
+				return false;
+			return true;
+		}
+
+		std::vector<IPEndPoint> readResolvConf()
+		{
+			std::vector<IPEndPoint> servers;
+			std::ifstream file("/etc/resolv.conf");
+			std::string line;
+			while (std::getline(file, line))
+			{
+				std::istringstream words(line);
+				std::string keyword;
+				std::string server;
+				IPAddress addr;
+				if (words >> keyword >> server && keyword == "nameserver" && parseNumeric(server, addr))
+					servers.emplace_back(addr, port_host_byte_order_t(53));
+			}
+			if (servers.empty())
+				servers.emplace_back(IPAddressV4::loopback(), port_host_byte_order_t(53));
+			return servers;
+		}
+
+		std::vector<uint8_t> buildQuery(uint16_t id, const std::string& name, uint16_t type)
+		{
+			std::vector<uint8_t> query;
+			query.reserve(kHeaderSize + name.size() + 6);
+			write16(query, id);
+			write16(query, 0x0100); //recursion desired
+			write16(query, 1);
+			write16(query, 0);
+			write16(query, 0);
+			write16(query, 0);
+			size_t begin = 0;
+			while (begin <= name.size())
+			{
+				size_t end = name.find('.', begin);
+				if (end == std::string::npos)
+					end = name.size();
+				query.push_back(static_cast<uint8_t>(end - begin));
+				query.insert(query.end(), name.begin() + static_cast<std::ptrdiff_t>(begin),
+				             name.begin() + static_cast<std::ptrdiff_t>(end));
+				begin = end + 1;
+			}
+			query.push_back(0);
+			write16(query, type);
+			write16(query, kClassIn);
+			return query;
+		}
+
+		bool skipName(const uint8_t* data, size_t size, size_t& offset) noexcept
+		{
+			while (offset < size)
+			{
+				const uint8_t length = data[offset];
+				if (length == 0)
+				{
+					offset++;
+					return true;
+				}
+				if ((length & 0xC0) == 0xC0)
+				{
+					offset += 2;
+					return offset <= size;
+				}
+				if ((length & 0xC0) != 0)
+					return false;
+				offset += 1 + length;
+			}
+			return false;
+		}
+
+		struct Response
+		{
+			uint8_t rcode = 0;
+			//smallest TTL of the address records
+			uint32_t ttl = UINT32_MAX;
+			//SOA minimum of the authority section, for negative caching
+			uint32_t negativeTtl = UINT32_MAX;
+			std::vector<IPAddress> addresses;
+		};
+
+		/*
+		 * Parses the response to query id of type, the address records of the whole CNAME chain are taken.
+		 * @return false if the message is not a valid response to that query.
+		 */
+		bool parseResponse(const uint8_t* data, size_t size, uint16_t id, uint16_t type, Response& response)
+		{
+			if (size < kHeaderSize || read16(data) != id || (data[2] & 0x80) == 0)
+				return false;
+			response.rcode = data[3] & 0x0F;
+			const uint16_t questions = read16(data + 4);
+			const uint16_t answers = read16(data + 6);
+			const uint16_t authorities = read16(data + 8);
+			size_t offset = kHeaderSize;
+			for (uint16_t i = 0; i < questions; i++)
+			{
+				if (!skipName(data, size, offset) || offset + 4 > size || read16(data + offset) != type)
+					return false;
+				offset += 4;
+			}
+			for (uint32_t i = 0; i < static_cast<uint32_t>(answers) + authorities; i++)
+			{
+				if (!skipName(data, size, offset) || offset + 10 > size)
+					return false;
+				const uint16_t recordType = read16(data + offset);
+				const uint16_t recordClass = read16(data + offset + 2);
+				const uint32_t ttl = read32(data + offset + 4);
+				const uint16_t length = read16(data + offset + 8);
+				offset += 10;
+				if (offset + length > size)
+					return false;
+				const uint8_t* rdata = data + offset;
+				if (i < answers && recordClass == kClassIn && recordType == type)
+				{
+					if (type == kTypeA && length == 4)
+						response.addresses.emplace_back(ByteArray4{ rdata[0], rdata[1], rdata[2], rdata[3] });
+					else if (type == kTypeAaaa && length == 16)
+					{
+						ByteArray16 bytes;
+						memcpy(bytes.data(), rdata, bytes.size());
+						response.addresses.emplace_back(bytes);
+					}
+					else
+						return false;
+					response.ttl = std::min(response.ttl, ttl);
+				}
+				else if (i >= answers && recordType == kTypeSoa)
+				{
+					size_t soa = offset;
+					if (skipName(data, offset + length, soa) && skipName(data, offset + length, soa) && soa + 20 <= offset + length)
+						response.negativeTtl = std::min(ttl, read32(data + soa + 16));
+				}
+				offset += length;
+			}
+			return true;
+		}
+
+		std::chrono::steady_clock::time_point now() noexcept
+		{
+			return std::chrono::steady_clock::now();
+		}
+	}
+
+	Resolver::Resolver() : Resolver(Options()) { }
+
+	Resolver::Resolver(Options options) : mOptions(std::move(options))
+	{
+		if (mOptions.nameServers.empty())
+			mOptions.nameServers = readResolvConf();
+		mOptions.shards = std::max<uint32_t>(mOptions.shards, 1);
+		mOptions.threads = std::max<uint32_t>(mOptions.threads, 1);
+		mOptions.attempts = std::max<uint32_t>(mOptions.attempts, 1);
+		mShards.reset(new Shard[mOptions.shards]);
+		for (uint32_t i = 0; i < mOptions.threads; i++)
+		{
+			mWorkers.emplace_back(&Resolver::runWorker, this);
+		}
+	}
+
+	Resolver::~Resolver()
+	{
+		std::deque<std::string> abandoned;
+		{
+			std::lock_guard<std::mutex> lock(mQueueMutex);
+			mStopping = true;
+			abandoned.swap(mQueue);
+		}
+		mQueueCondition.notify_all();
+		for (std::thread& worker : mWorkers)
+		{
+			worker.join();
+		}
+		Answer timeout;
+		timeout.status = ResolveStatus::kTimeout;
+		for (const std::string& name : abandoned)
+		{
+			complete(name, timeout);
+		}
+	}
+
+	void Resolver::resolve(const std::string& name, Callback callback)
+	{
+		IPAddress numeric;
+		if (parseNumeric(name, numeric))
+		{
+			callback(ResolveStatus::kOk, std::vector<IPAddress>{ numeric });
+			return;
+		}
+		const std::string key = normalizeName(name);
+		if (key.empty())
+		{
+			callback(ResolveStatus::kNotFound, std::vector<IPAddress>());
+			return;
+		}
+		Shard& shard = getShard(key);
+		{
+			std::unique_lock<std::mutex> lock(shard.mutex);
+			const auto cached = shard.entries.find(key);
+			if (cached != shard.entries.end() && cached->second.expiry > now())
+			{
+				const CacheEntry entry = cached->second;
+				lock.unlock();
+				callback(entry.status, entry.addresses);
+				return;
+			}
+			//the first request for a name sends the query, the others wait for its answer
+			std::vector<Callback>& waiting = shard.pending[key];
+			waiting.push_back(std::move(callback));
+			if (waiting.size() > 1)
+				return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mQueueMutex);
+			mQueue.push_back(key);
+		}
+		mQueueCondition.notify_one();
+	}
+
+	std::future<std::vector<IPAddress>> Resolver::resolve(const std::string& name)
+	{
+		const auto promise = std::make_shared<std::promise<std::vector<IPAddress>>>();
+		std::future<std::vector<IPAddress>> future = promise->get_future();
+		resolve(name, [promise, name](ResolveStatus status, const std::vector<IPAddress>& addresses)
+		{
+			if (status == ResolveStatus::kTimeout)
+				promise->set_exception(std::make_exception_ptr(std::runtime_error("DNS query timed out for " + name)));
+			else if (status == ResolveStatus::kServerFailure)
+				promise->set_exception(std::make_exception_ptr(std::runtime_error("DNS server failure for " + name)));
+			else
+				promise->set_value(addresses);
+		});
+		return future;
+	}
+
+	bool Resolver::lookupCached(const std::string& name, std::vector<IPAddress>& addresses) const
+	{
+		IPAddress numeric;
+		if (parseNumeric(name, numeric))
+		{
+			addresses.assign(1, numeric);
+			return true;
+		}
+		const std::string key = normalizeName(name);
+		if (key.empty())
+			return false;
+		const Shard& shard = getShard(key);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		const auto cached = shard.entries.find(key);
+		if (cached == shard.entries.end() || cached->second.expiry <= now())
+			return false;
+		addresses = cached->second.addresses;
+		return true;
+	}
+
+	void Resolver::clearCache()
+	{
+		for (uint32_t i = 0; i < mOptions.shards; i++)
+		{
+			std::lock_guard<std::mutex> lock(mShards[i].mutex);
+			mShards[i].entries.clear();
+		}
+	}
+
+	Resolver::Shard& Resolver::getShard(const std::string& name) const noexcept
+	{
+		return mShards[std::hash<std::string>()(name) % mOptions.shards];
+	}
+
+	void Resolver::runWorker()
+	{
+		while (true)
+		{
+			std::string name;
+			{
+				std::unique_lock<std::mutex> lock(mQueueMutex);
+				mQueueCondition.wait(lock, [this]() { return mStopping || !mQueue.empty(); });
+				if (mStopping)
+					return;
+				name = std::move(mQueue.front());
+				mQueue.pop_front();
+			}
+			complete(name, query(name));
+		}
+	}
+
+	void Resolver::complete(const std::string& name, const Answer& answer)
+	{
+		Shard& shard = getShard(name);
+		std::vector<Callback> waiting;
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			if (answer.status == ResolveStatus::kOk || answer.status == ResolveStatus::kNotFound)
+			{
+				const auto limit = answer.status == ResolveStatus::kOk ? mOptions.maxTtl : mOptions.negativeTtl;
+				const auto ttl = std::min<std::chrono::seconds>(std::chrono::seconds(answer.ttl), limit);
+				if (ttl.count() > 0)
+				{
+					if (shard.entries.size() >= mOptions.shardCapacity)
+					{
+						//drop the expired entries, or an arbitrary one if nothing expired
+						const auto time = now();
+						for (auto it = shard.entries.begin(); it != shard.entries.end();)
+							it = it->second.expiry <= time ? shard.entries.erase(it) : std::next(it);
+						if (shard.entries.size() >= mOptions.shardCapacity)
+							shard.entries.erase(shard.entries.begin());
+					}
+					shard.entries[name] = CacheEntry{ answer.addresses, now() + ttl, answer.status };
+				}
+			}
+			const auto pending = shard.pending.find(name);
+			if (pending != shard.pending.end())
+			{
+				waiting = std::move(pending->second);
+				shard.pending.erase(pending);
+			}
+		}
+		for (Callback& callback : waiting)
+		{
+			callback(answer.status, answer.addresses);
+		}
+	}
+
+	Resolver::Answer Resolver::query(const std::string& name)
+	{
+		Answer answer;
+		answer.status = ResolveStatus::kTimeout;
+		for (uint32_t attempt = 0; attempt < mOptions.attempts; attempt++)
+		{
+			for (const IPEndPoint& server : mOptions.nameServers)
+			{
+				Answer result = query(server, name);
+				if (result.status == ResolveStatus::kOk || result.status == ResolveStatus::kNotFound)
+					return result;
+				//a server that answered with an error is worth reporting over one that did not answer
+				if (result.status == ResolveStatus::kServerFailure)
+					answer.status = result.status;
+			}
+		}
+		return answer;
+	}
+
+	Resolver::Answer Resolver::query(const IPEndPoint& server, const std::string& name)
+	{
+		Answer answer;
+		answer.status = ResolveStatus::kTimeout;
+		sockaddr_storage address;
+		socklen_t addressLength;
+		server.writeSockaddr(address, addressLength);
+		const int fd = socket(address.ss_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+		if (fd < 0)
+			return answer;
+		if (connect(fd, reinterpret_cast<const sockaddr*>(&address), addressLength) != 0)
+		{
+			close(fd);
+			return answer;
+		}
+
+		thread_local std::mt19937 random(std::random_device{}());
+		struct Question
+		{
+			uint16_t id;
+			uint16_t type;
+			bool answered;
+		};
+		std::vector<Question> questions;
+		if (mOptions.family != Family::kIPv6)
+			questions.push_back({ static_cast<uint16_t>(random()), kTypeA, false });
+		if (mOptions.family != Family::kIPv4)
+			questions.push_back({ static_cast<uint16_t>(random()), kTypeAaaa, false });
+		for (const Question& question : questions)
+		{
+			const std::vector<uint8_t> message = buildQuery(question.id, name, question.type);
+			send(fd, message.data(), message.size(), 0);
+			mQueryCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		uint32_t ttl = UINT32_MAX;
+		uint32_t negativeTtl = UINT32_MAX;
+		bool nameError = false;
+		bool failure = false;
+		size_t answered = 0;
+		const auto deadline = now() + mOptions.timeout;
+		uint8_t buffer[kMaxMessageSize];
+		while (answered < questions.size())
+		{
+			const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now()).count();
+			pollfd descriptor = { fd, POLLIN, 0 };
+			if (remaining <= 0 || poll(&descriptor, 1, static_cast<int>(remaining)) <= 0)
+				break;
+			const ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+			if (received <= 0)
+				continue;
+			for (Question& question : questions)
+			{
+				Response response;
+				if (question.answered || !parseResponse(buffer, static_cast<size_t>(received), question.id, question.type, response))
+					continue;
+				question.answered = true;
+				answered++;
+				if (response.rcode == kRcodeNameError)
+					nameError = true;
+				else if (response.rcode != 0)
+					failure = true;
+				answer.addresses.insert(answer.addresses.end(), response.addresses.begin(), response.addresses.end());
+				if (!response.addresses.empty())
+					ttl = std::min(ttl, response.ttl);
+				negativeTtl = std::min(negativeTtl, response.negativeTtl);
+				break;
+			}
+		}
+		close(fd);
+
+		if (!answer.addresses.empty())
+		{
+			//a missing AAAA answer does not hold back the A records
+			answer.status = ResolveStatus::kOk;
+			answer.ttl = ttl;
+		}
+		else if (nameError || (answered == questions.size() && !failure))
+		{
+			answer.status = ResolveStatus::kNotFound;
+			answer.ttl = negativeTtl;
+		}
+		else if (failure)
+			answer.status = ResolveStatus::kServerFailure;
+		return answer;
+	}
+}
@@ -0,0 +1,224 @@
+#include "ReverseName.h"
+#include <array>
+
+namespace ip_address
+{
+	namespace
+	{
+		constexpr char kSuffixV4[] = ".in-addr.arpa";
+		constexpr char kSuffixV6[] = ".ip6.arpa";
+		constexpr size_t kSuffixLengthV4 = sizeof(kSuffixV4) - 1;
+		constexpr size_t kSuffixLengthV6 = sizeof(kSuffixV6) - 1;
+		constexpr char kHexDigits[] = "0123456789abcdef";
+		constexpr uint8_t kInvalidNibble = 0xFF;
+
+		//"255." in text, length includes the dot
+		struct OctetLabel
+		{
+			char text[4];
+			uint8_t length;
+		};
+
+		struct Tables
+		{
+			std::array<OctetLabel, 256> octets{};
+			//"l.h." for a byte with low nibble l and high nibble h, the order of ip6.arpa
+			std::array<std::array<char, 4>, 256> nibbles{};
+			std::array<uint8_t, 256> hexValues{};
+		};
+
+		constexpr Tables makeTables() noexcept
+		{
+			Tables tables;
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				OctetLabel& octet = tables.octets[i];
+				uint8_t length = 0;
+				if (i >= 100)
+					octet.text[length++] = static_cast<char>('0' + i / 100);
+				if (i >= 10)
+					octet.text[length++] = static_cast<char>('0' + i / 10 % 10);
+				octet.text[length++] = static_cast<char>('0' + i % 10);
+				octet.text[length++] = '.';
+				octet.length = length;
+
+				tables.nibbles[i] = { kHexDigits[i & 0xF], '.', kHexDigits[i >> 4], '.' };
+				tables.hexValues[i] = kInvalidNibble;
+			}
+			for (uint8_t i = 0; i < 10; i++)
+			{
+				tables.hexValues['0' + i] = i;
+			}
+			for (uint8_t i = 0; i < 6; i++)
+			{
+				tables.hexValues['a' + i] = static_cast<uint8_t>(10 + i);
+				tables.hexValues['A' + i] = static_cast<uint8_t>(10 + i);
+			}
+			return tables;
+		}
+
+		constexpr Tables kTables = makeTables();
+
+		bool endsWithIgnoreCase(std::string_view name, const char* suffix, size_t length) noexcept
+		{
+			if (name.size() < length)
+				return false;
+			const char* tail = name.data() + name.size() - length;
+			for (size_t i = 0; i < length; i++)
+			{
+				char c = tail[i];
+				if (c >= 'A' && c <= 'Z')
+					c = static_cast<char>(c - 'A' + 'a');
+				if (c != suffix[i])
+					return false;
+			}
+			return true;
+		}
+
+		std::string_view trimDot(std::string_view name) noexcept
+		{
+			if (!name.empty() && name.back() == '.')
+				name.remove_suffix(1);
+			return name;
+		}
+
+		size_t writeV4(const uint8_t* bytes, char* buffer) noexcept
+		{
+			char* out = buffer;
+			for (int i = 3; i >= 0; i--)
+			{
+				const OctetLabel& label = kTables.octets[bytes[i]];
+				memcpy(out, label.text, 4);
+				out += label.length;
+			}
+			//the suffix starts with a dot which the last label already wrote
+			memcpy(out, kSuffixV4 + 1, kSuffixLengthV4);
+			return static_cast<size_t>(out - buffer) + kSuffixLengthV4 - 1;
+		}
+
+		size_t writeV6(const uint8_t* bytes, char* buffer) noexcept
+		{
+			char* out = buffer;
+			for (int i = 15; i >= 0; i--)
+			{
+				memcpy(out, kTables.nibbles[bytes[i]].data(), 4);
+				out += 4;
+			}
+			memcpy(out, kSuffixV6 + 1, kSuffixLengthV6);
+			return kMaxReverseNameLengthV6;
+		}
+
+		template <typename Address>
+		size_t writeNames(Span<const Address> addresses, char* buffer, uint32_t* offsets) noexcept
+		{
+			size_t size = 0;
+			for (size_t i = 0; i < addresses.size(); i++)
+			{
+				offsets[i] = static_cast<uint32_t>(size);
+				size += to_reverse_name(addresses[i], buffer + size) + 1;
+			}
+			return size;
+		}
+	}
+
+	size_t to_reverse_name(const IPAddressV4& addr4, char* buffer) noexcept
+	{
+		const in_addr address = addr4.getOnWireAddress();
+		return writeV4(reinterpret_cast<const uint8_t*>(&address), buffer);
+	}
+
+	size_t to_reverse_name(const IPAddressV6& addr6, char* buffer) noexcept
+	{
+		const in6_addr address = addr6.getOnWireAddress();
+		return writeV6(reinterpret_cast<const uint8_t*>(&address), buffer);
+	}
+
+	size_t to_reverse_name(const IPAddress& addr, char* buffer) noexcept
+	{
+		if (addr.isIPv4())
+			return to_reverse_name(addr.asIPv4(), buffer);
+		if (addr.isIPv6())
+			return to_reverse_name(addr.asIPv6(), buffer);
+		buffer[0] = '\0';
+		return 0;
+	}
+
+	size_t to_reverse_names(Span<const IPAddressV4> addresses, char* buffer, uint32_t* offsets) noexcept
+	{
+		return writeNames(addresses, buffer, offsets);
+	}
+
+	size_t to_reverse_names(Span<const IPAddressV6> addresses, char* buffer, uint32_t* offsets) noexcept
+	{
+		return writeNames(addresses, buffer, offsets);
+	}
+
+	bool from_reverse_name(std::string_view name, IPAddressV4& addr4) noexcept
+	{
+		name = trimDot(name);
+		if (!endsWithIgnoreCase(name, kSuffixV4, kSuffixLengthV4))
+			return false;
+		name.remove_suffix(kSuffixLengthV4);
+
+		ByteArray4 bytes = {};
+		size_t position = 0;
+		for (int i = 3; i >= 0; i--)
+		{
+			//1 to 3 digits without leading zeros, then a dot unless it is the last label
+			uint32_t value = 0;
+			const size_t begin = position;
+			while (position < name.size() && name[position] >= '0' && name[position] <= '9' && position - begin < 3)
+			{
+				value = value * 10 + static_cast<uint32_t>(name[position++] - '0');
+			}
+			const size_t digits = position - begin;
+			if (digits == 0 || value > 255 || (digits > 1 && name[begin] == '0'))
+				return false;
+			bytes[static_cast<size_t>(i)] = static_cast<uint8_t>(value);
+			if (i != 0 && (position >= name.size() || name[position++] != '.'))
+				return false;
+		}
+		if (position != name.size())
+			return false;
+		addr4 = IPAddressV4(bytes);
+		return true;
+	}
+
+	bool from_reverse_name(std::string_view name, IPAddressV6& addr6) noexcept
+	{
+		name = trimDot(name);
+		if (!endsWithIgnoreCase(name, kSuffixV6, kSuffixLengthV6) || name.size() != kMaxReverseNameLengthV6)
+			return false;
+
+		ByteArray16 bytes = {};
+		for (size_t i = 0; i < 16; i++)
+		{
+			//nibble labels of byte 15 - i: "l.h."
+			const char* label = name.data() + i * 4;
+			const uint8_t low = kTables.hexValues[static_cast<uint8_t>(label[0])];
+			const uint8_t high = kTables.hexValues[static_cast<uint8_t>(label[2])];
+			if (low == kInvalidNibble || high == kInvalidNibble || label[1] != '.' || label[3] != '.')
+				return false;
+			bytes[15 - i] = static_cast<uint8_t>(high << 4 | low);
+		}
+		addr6 = IPAddressV6(bytes);
+		return true;
+	}
+
+	bool from_reverse_name(std::string_view name, IPAddress& addr) noexcept
+	{
+		IPAddressV4 addr4;
+		if (from_reverse_name(name, addr4))
+		{
+			addr = IPAddress(addr4);
+			return true;
+		}
+		IPAddressV6 addr6;
+		if (from_reverse_name(name, addr6))
+		{
+			addr = IPAddress(addr6);
+			return true;
+		}
+		return false;
+	}
+}
@@ -0,0 +1,72 @@
+#include "SockaddrView.h"
+
+namespace ip_address
+{
+	bool SockaddrView::operator==(const IPEndPoint& rhs) const noexcept
+	{
+		if (!isValid() || getVersion() != rhs.getVersion() || getPort() != rhs.getPort())
+			return false;
+		if (mAddr->sa_family == AF_INET)
+		{
+			const auto* addr4 = reinterpret_cast<const sockaddr_in*>(mAddr);
+			return memcmp(&addr4->sin_addr, &rhs.mAddr.mIpAddress4, sizeof(in_addr)) == 0;
+		}
+		const auto* addr6 = reinterpret_cast<const sockaddr_in6*>(mAddr);
+		return memcmp(&addr6->sin6_addr, &rhs.mAddr.mIpAddress6, sizeof(in6_addr)) == 0;
+	}
+
+	bool SockaddrView::operator!=(const IPEndPoint& rhs) const noexcept
+	{
+		return !this->operator==(rhs);
+	}
+
+	bool SockaddrView::isValid() const noexcept
+	{
+		if (mAddr == nullptr)
+			return false;
+		if (mAddr->sa_family == AF_INET)
+			return mLength >= sizeof(sockaddr_in);
+		if (mAddr->sa_family == AF_INET6)
+			return mLength >= sizeof(sockaddr_in6);
+		return false;
+	}
+
+	IPVersion SockaddrView::getVersion() const noexcept
+	{
+		return isValid() ? static_cast<IPVersion>(mAddr->sa_family) : IPVersion::kUnknown;
+	}
+
+	port_host_byte_order_t SockaddrView::getPort() const noexcept
+	{
+		return to_host_byte_order(getPortNetworkByteOrder());
+	}
+
+	port_network_byte_order_t SockaddrView::getPortNetworkByteOrder() const noexcept
+	{
+		assert(isValid());
+		//sin_port and sin6_port share the same offset
+		return static_cast<port_network_byte_order_t>(reinterpret_cast<const sockaddr_in*>(mAddr)->sin_port);
+	}
+
+	IPAddress SockaddrView::getIPAddress() const noexcept
+	{
+		return toEndPoint().getIPAddress();
+	}
+
+	IPEndPoint SockaddrView::toEndPoint() const noexcept
+	{
+		switch (getVersion())
+		{
+		case IPVersion::kIPv4:
+			return IPEndPoint(*reinterpret_cast<const sockaddr_in*>(mAddr));
+		case IPVersion::kIPv6:
+			return IPEndPoint(*reinterpret_cast<const sockaddr_in6*>(mAddr));
+		default:
+			{
+				IPEndPoint endpoint;
+				endpoint.clear();
+				return endpoint;
+			}
+		}
+	}
+}
@@ -0,0 +1,125 @@
+#include "ToeplitzHash.h"
+
+namespace ip_address
+{
+	namespace
+	{
+		//32 key bits starting at bit offset, bits past the end of the key are 0
+		uint32_t getKeyWindow(Span<const uint8_t> key, size_t offset) noexcept
+		{
+			uint64_t bits = 0;
+			const size_t first = offset / 8;
+			for (size_t i = 0; i < 5; i++)
+			{
+				bits = bits << 8 | (first + i < key.size() ? key[first + i] : 0);
+			}
+			return static_cast<uint32_t>(bits >> (8 - offset % 8));
+		}
+	}
+
+	const std::array<uint8_t, 40> ToeplitzHash::kMicrosoftKey = {
+		0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2, 0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+		0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4, 0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+		0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa,
+	};
+
+	const std::array<uint8_t, 40> ToeplitzHash::kSymmetricKey = {
+		0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a,
+		0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a,
+		0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a, 0x6d, 0x5a,
+	};
+
+	ToeplitzHash::ToeplitzHash(Span<const uint8_t> key, bool includePorts) noexcept : mTable(),
+		mIncludePorts(includePorts)
+	{
+		for (size_t i = 0; i < FlowKey::kMaxHashInputSize; i++)
+		{
+			uint32_t windows[8];
+			for (size_t bit = 0; bit < 8; bit++)
+			{
+				//bit 0 is the most significant bit of the input byte
+				windows[bit] = getKeyWindow(key, i * 8 + bit);
+			}
+			for (size_t value = 0; value < 256; value++)
+			{
+				uint32_t result = 0;
+				for (size_t bit = 0; bit < 8; bit++)
+				{
+					if (value & (0x80u >> bit))
+						result ^= windows[bit];
+				}
+				mTable[i][value] = result;
+			}
+		}
+	}
+
+	ToeplitzHash::ToeplitzHash(const std::array<uint8_t, 40>& key, bool includePorts) noexcept :
+		ToeplitzHash(Span<const uint8_t>(key.data(), key.size()), includePorts) { }
+
+	ToeplitzHash ToeplitzHash::symmetric(bool includePorts) noexcept
+	{
+		return ToeplitzHash(kSymmetricKey, includePorts);
+	}
+
+	template <size_t Size>
+	uint32_t ToeplitzHash::hashFixed(const uint8_t* input) const noexcept
+	{
+		uint32_t result = 0;
+		for (size_t i = 0; i < Size; i++)
+		{
+			result ^= mTable[i][input[i]];
+		}
+		return result;
+	}
+
+	uint32_t ToeplitzHash::hash(const uint8_t* input, size_t size) const noexcept
+	{
+		assert(size <= FlowKey::kMaxHashInputSize);
+		uint32_t result = 0;
+		for (size_t i = 0; i < size; i++)
+		{
+			result ^= mTable[i][input[i]];
+		}
+		return result;
+	}
+
+	uint32_t ToeplitzHash::hash(const FlowKey& key) const noexcept
+	{
+		uint8_t input[FlowKey::kMaxHashInputSize];
+		const size_t size = key.getHashInput(input, hashesPorts(key));
+		//fixed trip counts let the compiler unroll the common sizes
+		switch (size)
+		{
+		case 12:
+			return hashFixed<12>(input);
+		case 36:
+			return hashFixed<36>(input);
+		default:
+			return hash(input, size);
+		}
+	}
+
+	void ToeplitzHash::hash(Span<const FlowKey> keys, uint32_t* hashes) const noexcept
+	{
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			hashes[i] = hash(keys[i]);
+		}
+	}
+
+	uint32_t ToeplitzHash::hashReference(Span<const uint8_t> key, const uint8_t* input, size_t size) noexcept
+	{
+		uint32_t result = 0;
+		for (size_t bit = 0; bit < size * 8; bit++)
+		{
+			if (input[bit / 8] & (0x80u >> bit % 8))
+				result ^= getKeyWindow(key, bit);
+		}
+		return result;
+	}
+
+	bool ToeplitzHash::hashesPorts(const FlowKey& key) const noexcept
+	{
+		return mIncludePorts && (key.getProtocol() == IPPROTO_TCP || key.getProtocol() == IPPROTO_UDP);
+	}
+}
@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+#include <arpa/inet.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "AddressScanner.h"
+using namespace ip_address;
+
+/*
+ * Extracting addresses from 32 MiB of web server log lines (about one address per 60 bytes) against
+ * splitting the text into tokens and trying inet_pton on every token.
+ */
+namespace
+{
+	const std::string& getLog()
+	{
+		static const std::string log = []()
+		{
+			std::mt19937 rng(44);
+			std::string text;
+			char buffer[INET6_ADDRSTRLEN];
+			while (text.size() < (32 << 20))
+			{
+				if (rng() % 4 == 0)
+				{
+					uint8_t addr6[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, static_cast<uint8_t>(rng()) };
+					addr6[15] = static_cast<uint8_t>(rng());
+					inet_ntop(AF_INET6, addr6, buffer, sizeof(buffer));
+				}
+				else
+				{
+					const uint32_t addr4 = htonl(static_cast<uint32_t>(rng()));
+					inet_ntop(AF_INET, &addr4, buffer, sizeof(buffer));
+				}
+				text += buffer;
+				text += " - - [01/May/2024:12:30:45 +0000] \"GET /static/app.js?v=1.2.3 HTTP/1.1\" 200 " +
+					std::to_string(rng() % 100000) + " \"Mozilla/5.0 (X11; Linux x86_64)\"\n";
+			}
+			return text;
+		}();
+		return log;
+	}
+}
+
+static void BM_AddressScannerScan(benchmark::State& state)
+{
+	const std::string& log = getLog();
+	std::vector<AddressMatch> matches;
+	for (auto _ : state)
+	{
+		matches.clear();
+		AddressScanner::scan(log, matches);
+		benchmark::DoNotOptimize(matches.data());
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * log.size()));
+	state.counters["matches"] = static_cast<double>(matches.size());
+}
+BENCHMARK(BM_AddressScannerScan)->Unit(benchmark::kMillisecond);
+
+static void BM_AddressScannerScanParallel(benchmark::State& state)
+{
+	const std::string& log = getLog();
+	std::vector<AddressMatch> matches;
+	for (auto _ : state)
+	{
+		matches.clear();
+		AddressScanner::scanParallel(log, matches, static_cast<size_t>(state.range(0)));
+		benchmark::DoNotOptimize(matches.data());
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * log.size()));
+}
+BENCHMARK(BM_AddressScannerScanParallel)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_AddressScannerTokenizeInetPton(benchmark::State& state)
+{
+	const std::string& log = getLog();
+	for (auto _ : state)
+	{
+		size_t count = 0;
+		size_t start = 0;
+		while (start < log.size())
+		{
+			size_t end = log.find_first_of(" \n\"[]", start);
+			if (end == std::string::npos)
+				end = log.size();
+			if (end > start)
+			{
+				const std::string token = log.substr(start, end - start);
+				uint8_t bytes[16];
+				count += inet_pton(AF_INET, token.c_str(), bytes) == 1 || inet_pton(AF_INET6, token.c_str(), bytes) == 1;
+			}
+			start = end + 1;
+		}
+		benchmark::DoNotOptimize(count);
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * log.size()));
+}
+BENCHMARK(BM_AddressScannerTokenizeInetPton)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,39 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "AddressSelection.h"
+using namespace ip_address;
+
+/*
+ * RFC 6724 sort of a typical dual stack answer against a host with a few interface addresses.
+ */
+namespace
+{
+	std::vector<IPAddress> makeAddresses(std::initializer_list<const char*> texts)
+	{
+		std::vector<IPAddress> addresses;
+		for (const char* text : texts)
+		{
+			addresses.emplace_back(std::string(text));
+		}
+		return addresses;
+	}
+}
+
+static void BM_AddressSorterSort(benchmark::State& state)
+{
+	const AddressSorter sorter(makeAddresses({ "127.0.0.1", "192.0.2.2", "::1", "2001:db8:1::2", "fe80::2",
+	                                           "fd00::2" }));
+	const std::vector<IPAddress> answer = makeAddresses({ "198.51.100.1", "198.51.100.2", "2001:db8:3ffe::1",
+	                                                      "2001:db8:1::1", "2002:c633:6401::1", "fd00::1",
+	                                                      "10.1.2.3", "2001:db8:2::1" });
+	std::vector<IPAddress> addresses;
+	for (auto _ : state)
+	{
+		addresses = answer;
+		sorter.sort(addresses);
+		benchmark::DoNotOptimize(addresses.data());
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * answer.size()));
+}
+BENCHMARK(BM_AddressSorterSort);
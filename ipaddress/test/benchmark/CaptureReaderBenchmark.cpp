@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "CaptureReader.h"
+using namespace ip_address;
+
+namespace
+{
+	/*
+	 * Generated classic pcap file of Ethernet frames with IPv4 and IPv6 TCP/UDP packets of mixed sizes (~64MB),
+	 * written once per process and removed at exit.
+	 */
+	class GeneratedCapture
+	{
+	public:
+		GeneratedCapture()
+		{
+			char path[] = "/tmp/ipaddress_bench_XXXXXX";
+			const int fd = mkstemp(path);
+			close(fd);
+			mPath = path;
+			FILE* file = fopen(mPath.c_str(), "wb");
+			const uint32_t header[6] = { 0xA1B2C3D4, 0x00040002, 0, 0, 65535, 1 };
+			fwrite(header, sizeof(header), 1, file);
+			std::mt19937_64 rng(31);
+			std::vector<uint8_t> frame(1600);
+			while (mSize < (64 << 20))
+			{
+				const uint64_t r = rng();
+				//imix-like sizes: 64, 576 and 1500 bytes
+				const size_t sizes[4] = { 64, 64, 576, 1500 };
+				const size_t length = sizes[r & 3];
+				std::fill(frame.begin(), frame.begin() + length, 0);
+				const bool ipv6 = (r & 0x10) != 0;
+				frame[12] = ipv6 ? 0x86 : 0x08;
+				frame[13] = ipv6 ? 0xDD : 0x00;
+				uint8_t* ip = &frame[14];
+				if (ipv6)
+				{
+					ip[0] = 0x60;
+					ip[6] = (r & 0x20) ? IPPROTO_TCP : IPPROTO_UDP;
+					memcpy(ip + 8, &r, sizeof(r));
+					memcpy(ip + 24, &r, sizeof(r));
+				}
+				else
+				{
+					ip[0] = 0x45;
+					ip[9] = (r & 0x20) ? IPPROTO_TCP : IPPROTO_UDP;
+					memcpy(ip + 12, &r, sizeof(r));
+				}
+				const uint32_t record[4] = { static_cast<uint32_t>(mRecords), static_cast<uint32_t>(r % 1000000),
+				                             static_cast<uint32_t>(length), static_cast<uint32_t>(length) };
+				fwrite(record, sizeof(record), 1, file);
+				fwrite(frame.data(), 1, length, file);
+				mSize += sizeof(record) + length;
+				mRecords++;
+			}
+			fclose(file);
+		}
+		~GeneratedCapture() { unlink(mPath.c_str()); }
+
+		const std::string& getPath() const { return mPath; }
+		size_t getSize() const { return mSize; }
+	private:
+		std::string mPath;
+		size_t mSize = 0;
+		size_t mRecords = 0;
+	};
+
+	const GeneratedCapture& getCapture()
+	{
+		static const GeneratedCapture capture;
+		return capture;
+	}
+}
+
+static void BM_CaptureReaderSequential(benchmark::State& state)
+{
+	const GeneratedCapture& capture = getCapture();
+	CaptureReader reader(capture.getPath());
+	std::vector<CaptureRecord> records(256);
+	size_t packets = 0;
+	for (auto _ : state)
+	{
+		reader.rewind();
+		while (const size_t count = reader.readBatch(records.data(), records.size()))
+		{
+			packets += count;
+			benchmark::DoNotOptimize(records.data());
+		}
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * capture.getSize()));
+	state.SetItemsProcessed(static_cast<int64_t>(packets));
+}
+BENCHMARK(BM_CaptureReaderSequential)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_CaptureReaderParallel(benchmark::State& state)
+{
+	const GeneratedCapture& capture = getCapture();
+	CaptureReader reader(capture.getPath());
+	const size_t threads = static_cast<size_t>(state.range(0));
+	std::atomic<size_t> packets{ 0 };
+	for (auto _ : state)
+	{
+		reader.readParallel(threads, [&packets](size_t, const CaptureRecord*, size_t count)
+		{
+			packets.fetch_add(count, std::memory_order_relaxed);
+		});
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * capture.getSize()));
+	state.SetItemsProcessed(static_cast<int64_t>(packets.load()));
+}
+BENCHMARK(BM_CaptureReaderParallel)->RangeMultiplier(2)->Range(1, 8)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,133 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include "ConsistentHash.h"
+using namespace ip_address;
+
+/*
+ * 10k backends in a Maglev table of ~1M slots (100 slots per backend, <1% imbalance).
+ */
+namespace
+{
+	constexpr uint32_t kBackends = 10000;
+	constexpr uint32_t kTableSize = 1000003;
+
+	const std::vector<IPEndPoint>& getBackends()
+	{
+		static const std::vector<IPEndPoint> backends = []()
+		{
+			std::vector<IPEndPoint> result;
+			for (uint32_t i = 0; i < kBackends; i++)
+			{
+				result.emplace_back(ByteArray4{ 10, static_cast<uint8_t>(i >> 16), static_cast<uint8_t>(i >> 8),
+				                                static_cast<uint8_t>(i) }, port_host_byte_order_t(8080));
+			}
+			return result;
+		}();
+		return backends;
+	}
+
+	const std::vector<IPAddress>& getClients()
+	{
+		static const std::vector<IPAddress> clients = []()
+		{
+			std::mt19937_64 rng(33);
+			std::vector<IPAddress> result;
+			for (int i = 0; i < 4096; i++)
+			{
+				const uint64_t r = rng();
+				if (r & 1)
+				{
+					ByteArray16 bytes = { 0x20, 0x01, 0x0d, 0xb8 };
+					memcpy(&bytes[8], &r, sizeof(r));
+					result.emplace_back(bytes);
+				}
+				else
+				{
+					result.emplace_back(ByteArray4{ static_cast<uint8_t>(r >> 8), static_cast<uint8_t>(r >> 16),
+					                                static_cast<uint8_t>(r >> 24), static_cast<uint8_t>(r >> 32) });
+				}
+			}
+			return result;
+		}();
+		return clients;
+	}
+
+	const MaglevTable& getTable()
+	{
+		static const MaglevTable table = []()
+		{
+			MaglevTable result(kTableSize);
+			const auto& backends = getBackends();
+			result.setBackends(Span<const IPEndPoint>(backends.data(), backends.size()));
+			return result;
+		}();
+		return table;
+	}
+}
+
+static void BM_MaglevBuild(benchmark::State& state)
+{
+	const auto& backends = getBackends();
+	for (auto _ : state)
+	{
+		MaglevTable table(kTableSize);
+		table.setBackends(Span<const IPEndPoint>(backends.data(), backends.size()));
+		benchmark::DoNotOptimize(table.getBackendCount());
+	}
+}
+BENCHMARK(BM_MaglevBuild)->Unit(benchmark::kMillisecond);
+
+static void BM_MaglevRemoveAddBackend(benchmark::State& state)
+{
+	MaglevTable table = getTable();
+	const auto& backends = getBackends();
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const IPEndPoint& backend = backends[i++ % backends.size()];
+		table.removeBackend(backend);
+		table.addBackend(backend);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MaglevRemoveAddBackend)->Unit(benchmark::kMicrosecond);
+
+static void BM_MaglevLookup(benchmark::State& state)
+{
+	const MaglevTable& table = getTable();
+	const auto& clients = getClients();
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(table.lookup(clients[i++ & 4095]));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MaglevLookup);
+
+static void BM_MaglevLookupBatch(benchmark::State& state)
+{
+	const MaglevTable& table = getTable();
+	const auto& clients = getClients();
+	std::vector<const IPEndPoint*> result(clients.size());
+	for (auto _ : state)
+	{
+		table.lookup(Span<const IPAddress>(clients.data(), clients.size()), result.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * clients.size());
+}
+BENCHMARK(BM_MaglevLookupBatch);
+
+static void BM_JumpConsistentHash(benchmark::State& state)
+{
+	const auto& clients = getClients();
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(jumpConsistentHash(clients[i++ & 4095], kBackends));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_JumpConsistentHash);
@@ -0,0 +1,117 @@
+#pragma once
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "IPAddress.h"
+
+/*
+ * Reproducible address corpora for the benchmarks, every generator is seeded so runs on different machines
+ * and versions measure the same inputs.
+ *
+ *	kRandom	uniformly random addresses, IPv6 ones are global unicast with an interface id that is either
+ *			random (SLAAC) or small (::1, ::2a), so both the long and the "::" compressed text forms occur
+ *	kZipf	draws from 4096 distinct addresses with Zipf (s = 1.1) frequencies, like client addresses in logs
+ *	kMixed	kRandom with 30% IPv6 and 70% IPv4 in random order
+ */
+namespace corpus
+{
+	enum Distribution
+	{
+		kRandom,
+		kZipf,
+		kMixed,
+	};
+
+	constexpr uint64_t kSeed = 0x1badb002;
+	constexpr size_t kSize = 4096;
+
+	inline const char* getName(Distribution distribution)
+	{
+		switch (distribution)
+		{
+		case kRandom:
+			return "random";
+		case kZipf:
+			return "zipf";
+		default:
+			return "mixed";
+		}
+	}
+
+	inline ip_address::IPAddress makeRandomV4(std::mt19937_64& rng)
+	{
+		const auto value = static_cast<uint32_t>(rng());
+		return ip_address::IPAddress(ip_address::ByteArray4{ static_cast<uint8_t>(value >> 24),
+			static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value) });
+	}
+
+	inline ip_address::IPAddress makeRandomV6(std::mt19937_64& rng)
+	{
+		ip_address::ByteArray16 bytes = {};
+		const uint64_t high = 0x2000000000000000 | (rng() >> 3);
+		const uint64_t low = rng() % 2 == 0 ? rng() : rng() % 256;
+		for (size_t i = 0; i < 8; i++)
+		{
+			bytes[i] = static_cast<uint8_t>(high >> (56 - i * 8));
+			bytes[8 + i] = static_cast<uint8_t>(low >> (56 - i * 8));
+		}
+		return ip_address::IPAddress(bytes);
+	}
+
+	/*
+	 * @param v6 share of IPv6 addresses for kRandom and kZipf, kMixed always uses 30%.
+	 */
+	inline std::vector<ip_address::IPAddress> makeAddresses(Distribution distribution, double v6, size_t size = kSize)
+	{
+		std::mt19937_64 rng(kSeed + static_cast<uint64_t>(distribution));
+		if (distribution == kMixed)
+			v6 = 0.3;
+		std::bernoulli_distribution isV6(v6);
+		std::vector<ip_address::IPAddress> population;
+		for (size_t i = 0; i < size; i++)
+		{
+			population.push_back(isV6(rng) ? makeRandomV6(rng) : makeRandomV4(rng));
+		}
+		if (distribution != kZipf)
+			return population;
+
+		//inverse transform sampling over the cumulative Zipf weights
+		std::vector<double> cumulative(size);
+		double sum = 0;
+		for (size_t k = 0; k < size; k++)
+		{
+			sum += 1.0 / std::pow(static_cast<double>(k + 1), 1.1);
+			cumulative[k] = sum;
+		}
+		std::uniform_real_distribution<double> uniform(0, sum);
+		std::vector<ip_address::IPAddress> samples;
+		for (size_t i = 0; i < size; i++)
+		{
+			const auto rank = std::upper_bound(cumulative.begin(), cumulative.end(), uniform(rng)) - cumulative.begin();
+			samples.push_back(population[std::min(static_cast<size_t>(rank), size - 1)]);
+		}
+		return samples;
+	}
+
+	/*
+	 * Text forms as written by inet_ntop, which is what parsers see in logs and configuration.
+	 */
+	inline std::vector<std::string> makeStrings(const std::vector<ip_address::IPAddress>& addresses)
+	{
+		std::vector<std::string> strings;
+		char buffer[INET6_ADDRSTRLEN];
+		for (const ip_address::IPAddress& addr : addresses)
+		{
+			if (addr.isIPv4())
+				inet_ntop(AF_INET, addr.asIPv4().bytes().data(), buffer, sizeof(buffer));
+			else
+				inet_ntop(AF_INET6, addr.asIPv6().bytes().data(), buffer, sizeof(buffer));
+			strings.emplace_back(buffer);
+		}
+		return strings;
+	}
+}
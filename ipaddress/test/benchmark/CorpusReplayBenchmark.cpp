@@ -0,0 +1,249 @@
+#include <benchmark/benchmark.h>
+#include <arpa/inet.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "AddressScanner.h"
+#include "IPAddress.h"
+using namespace ip_address;
+
+/*
+ * Replays the differential fuzz corpus (test/fuzz/corpus) through the library and through inet_pton/inet_ntop,
+ * so both sides are timed on the same inputs. Before timing the library results are compared with the system
+ * ones, a benchmark of a diverging side reports an error instead of a time.
+ */
+namespace
+{
+	/*
+	 * Corpus inputs up to their first NUL, as the fuzz target parses them.
+	 */
+	std::vector<std::string> loadCorpus()
+	{
+		std::vector<std::string> inputs;
+		for (const auto& entry : std::filesystem::directory_iterator(IPADDRESS_FUZZ_CORPUS))
+		{
+			std::ifstream file(entry.path(), std::ios::binary);
+			std::string input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			inputs.emplace_back(input.c_str());
+		}
+		return inputs;
+	}
+
+	/*
+	 * Literals of the corpus, the address type parsers resolve other text with getaddrinfo.
+	 */
+	std::vector<std::string> loadLiterals()
+	{
+		std::vector<std::string> literals;
+		uint8_t bytes[16];
+		for (const std::string& input : loadCorpus())
+		{
+			if (inet_pton(AF_INET, input.c_str(), bytes) == 1 || inet_pton(AF_INET6, input.c_str(), bytes) == 1)
+				literals.push_back(input);
+		}
+		return literals;
+	}
+
+	std::vector<IPAddress> loadAddresses()
+	{
+		std::vector<IPAddress> addresses;
+		for (const std::string& literal : loadLiterals())
+		{
+			IPAddress addr;
+			if (IPAddress::parseIPAddress(addr, literal))
+				addresses.push_back(addr);
+		}
+		return addresses;
+	}
+
+	bool parseSystem(const std::string& input, IPAddress& addr)
+	{
+		ByteArray4 bytes4;
+		if (inet_pton(AF_INET, input.c_str(), bytes4.data()) == 1)
+		{
+			addr = IPAddress(bytes4);
+			return true;
+		}
+		ByteArray16 bytes6;
+		if (inet_pton(AF_INET6, input.c_str(), bytes6.data()) == 1)
+		{
+			addr = IPAddress(bytes6);
+			return true;
+		}
+		return false;
+	}
+
+	std::string formatSystem(const IPAddress& addr)
+	{
+		char buffer[INET6_ADDRSTRLEN];
+		if (addr.isIPv4())
+			inet_ntop(AF_INET, addr.asIPv4().bytes().data(), buffer, sizeof(buffer));
+		else
+			inet_ntop(AF_INET6, addr.asIPv6().bytes().data(), buffer, sizeof(buffer));
+		return buffer;
+	}
+
+	template <typename Parse>
+	bool isSameParse(const std::vector<std::string>& inputs, const Parse& parse)
+	{
+		for (const std::string& input : inputs)
+		{
+			IPAddress expected;
+			IPAddress addr;
+			const bool valid = parseSystem(input, expected);
+			if (parse(input, addr) != valid || (valid && addr != expected))
+				return false;
+		}
+		return true;
+	}
+
+	template <typename Format>
+	bool isSameFormat(const std::vector<IPAddress>& addresses, const Format& format)
+	{
+		for (const IPAddress& addr : addresses)
+		{
+			if (format(addr) != formatSystem(addr))
+				return false;
+		}
+		return true;
+	}
+
+	void finish(benchmark::State& state, size_t inputs)
+	{
+		state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * inputs));
+		state.counters["ns/op"] = benchmark::Counter(static_cast<double>(state.iterations() * inputs),
+			benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	}
+}
+
+static void BM_CorpusParseSystem(benchmark::State& state)
+{
+	const std::vector<std::string> inputs = loadCorpus();
+	for (auto _ : state)
+	{
+		for (const std::string& input : inputs)
+		{
+			IPAddress addr;
+			benchmark::DoNotOptimize(parseSystem(input, addr));
+			benchmark::DoNotOptimize(addr);
+		}
+	}
+	finish(state, inputs.size());
+}
+BENCHMARK(BM_CorpusParseSystem);
+
+static void BM_CorpusParseAddressScanner(benchmark::State& state)
+{
+	const std::vector<std::string> inputs = loadCorpus();
+	const auto parse = [](const std::string& input, IPAddress& addr) { return AddressScanner::parse(input, addr); };
+	if (!isSameParse(inputs, parse))
+		state.SkipWithError("AddressScanner::parse diverges from inet_pton");
+	for (auto _ : state)
+	{
+		for (const std::string& input : inputs)
+		{
+			IPAddress addr;
+			benchmark::DoNotOptimize(parse(input, addr));
+			benchmark::DoNotOptimize(addr);
+		}
+	}
+	finish(state, inputs.size());
+}
+BENCHMARK(BM_CorpusParseAddressScanner);
+
+static void BM_CorpusParseLiteralsSystem(benchmark::State& state)
+{
+	const std::vector<std::string> inputs = loadLiterals();
+	for (auto _ : state)
+	{
+		for (const std::string& input : inputs)
+		{
+			IPAddress addr;
+			benchmark::DoNotOptimize(parseSystem(input, addr));
+			benchmark::DoNotOptimize(addr);
+		}
+	}
+	finish(state, inputs.size());
+}
+BENCHMARK(BM_CorpusParseLiteralsSystem);
+
+static void BM_CorpusParseLiteralsIPAddress(benchmark::State& state)
+{
+	const std::vector<std::string> inputs = loadLiterals();
+	const auto parse = [](const std::string& input, IPAddress& addr) { return IPAddress::parseIPAddress(addr, input); };
+	if (!isSameParse(inputs, parse))
+		state.SkipWithError("IPAddress::parseIPAddress diverges from inet_pton");
+	for (auto _ : state)
+	{
+		for (const std::string& input : inputs)
+		{
+			IPAddress addr;
+			benchmark::DoNotOptimize(parse(input, addr));
+			benchmark::DoNotOptimize(addr);
+		}
+	}
+	finish(state, inputs.size());
+}
+BENCHMARK(BM_CorpusParseLiteralsIPAddress);
+
+static void BM_CorpusFormatSystem(benchmark::State& state)
+{
+	const std::vector<IPAddress> addresses = loadAddresses();
+	char buffer[INET6_ADDRSTRLEN];
+	for (auto _ : state)
+	{
+		for (const IPAddress& addr : addresses)
+		{
+			if (addr.isIPv4())
+				benchmark::DoNotOptimize(inet_ntop(AF_INET, addr.asIPv4().bytes().data(), buffer, sizeof(buffer)));
+			else
+				benchmark::DoNotOptimize(inet_ntop(AF_INET6, addr.asIPv6().bytes().data(), buffer, sizeof(buffer)));
+		}
+	}
+	finish(state, addresses.size());
+}
+BENCHMARK(BM_CorpusFormatSystem);
+
+static void BM_CorpusFormatGetString(benchmark::State& state)
+{
+	const std::vector<IPAddress> addresses = loadAddresses();
+	if (!isSameFormat(addresses, [](const IPAddress& addr) { return addr.getString(); }))
+		state.SkipWithError("IPAddress::getString diverges from inet_ntop");
+	for (auto _ : state)
+	{
+		for (const IPAddress& addr : addresses)
+		{
+			benchmark::DoNotOptimize(addr.getString());
+		}
+	}
+	finish(state, addresses.size());
+}
+BENCHMARK(BM_CorpusFormatGetString);
+
+static void BM_CorpusFormatWriteString(benchmark::State& state)
+{
+	const std::vector<IPAddress> addresses = loadAddresses();
+	char buffer[MAX_IPV6_ADDRESS_CHAR_MAX_COUNT];
+	const auto format = [&buffer](const IPAddress& addr)
+	{
+		return std::string(buffer, addr.isIPv4() ? IPAddressV4::writeString(addr.asIPv4().bytes(), buffer) :
+			IPAddressV6::writeString(addr.asIPv6().bytes(), buffer));
+	};
+	if (!isSameFormat(addresses, format))
+		state.SkipWithError("writeString diverges from inet_ntop");
+	for (auto _ : state)
+	{
+		for (const IPAddress& addr : addresses)
+		{
+			if (addr.isIPv4())
+				benchmark::DoNotOptimize(IPAddressV4::writeString(addr.asIPv4().bytes(), buffer));
+			else
+				benchmark::DoNotOptimize(IPAddressV6::writeString(addr.asIPv6().bytes(), buffer));
+		}
+	}
+	finish(state, addresses.size());
+}
+BENCHMARK(BM_CorpusFormatWriteString);
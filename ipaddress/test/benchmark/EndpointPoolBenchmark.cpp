@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include "EndpointPool.h"
+using namespace ip_address;
+
+/*
+ * acquire() + complete() per thread, the rate per thread should stay flat up to Threads(64) since threads only
+ * share the counters of the backend they both picked.
+ */
+namespace
+{
+	constexpr uint32_t kBackends = 256;
+
+	std::unique_ptr<EndpointPool> makePool()
+	{
+		std::unique_ptr<EndpointPool> pool(new EndpointPool());
+		for (uint32_t i = 0; i < kBackends; i++)
+		{
+			pool->addBackend(IPEndPoint(ByteArray4{ 10, 0, static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i) },
+			                            port_host_byte_order_t(8080)));
+		}
+		return pool;
+	}
+}
+
+static void BM_EndpointPoolAcquire(benchmark::State& state)
+{
+	static const std::unique_ptr<EndpointPool> pool = makePool();
+	uint64_t latency = 1000000 + static_cast<uint64_t>(state.thread_index()) * 1000;
+	for (auto _ : state)
+	{
+		EndpointPool::Lease lease = pool->acquire();
+		benchmark::DoNotOptimize(lease.getEndPoint());
+		lease.complete(latency);
+		latency ^= 0x3FF;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EndpointPoolAcquire)->ThreadRange(1, 64)->UseRealTime();
+
+/*
+ * The same with a thread 0 that adds and removes a backend every 1024 picks.
+ */
+static void BM_EndpointPoolAcquireWithUpdates(benchmark::State& state)
+{
+	static const std::unique_ptr<EndpointPool> pool = makePool();
+	const IPEndPoint extra(ByteArray4{ 10, 1, 0, 1 }, port_host_byte_order_t(8080));
+	uint64_t picks = 0;
+	for (auto _ : state)
+	{
+		EndpointPool::Lease lease = pool->acquire();
+		benchmark::DoNotOptimize(lease.getEndPoint());
+		lease.complete(1000000);
+		if (state.thread_index() == 0 && (++picks & 1023) == 0)
+		{
+			if (!pool->removeBackend(extra))
+				pool->addBackend(extra);
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EndpointPoolAcquireWithUpdates)->ThreadRange(1, 64)->UseRealTime();
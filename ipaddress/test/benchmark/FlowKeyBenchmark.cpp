@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include "ToeplitzHash.h"
+using namespace ip_address;
+
+namespace
+{
+	//1024 TCP/UDP flows, state.range(0) percent of them IPv6
+	std::vector<FlowKey> makeFlows(int ipv6Percent)
+	{
+		std::mt19937_64 rng(32);
+		std::vector<FlowKey> flows;
+		for (int i = 0; i < 1024; i++)
+		{
+			const uint64_t r = rng();
+			const auto port = static_cast<port_host_byte_order_t>(r);
+			const uint8_t protocol = (r & 0x10000) ? IPPROTO_TCP : IPPROTO_UDP;
+			if (static_cast<int>(r >> 32) % 100 < ipv6Percent)
+			{
+				ByteArray16 source = { 0x20, 0x01, 0x0d, 0xb8 };
+				memcpy(&source[8], &r, sizeof(r));
+				ByteArray16 destination = source;
+				destination[15] ^= 0xFF;
+				flows.emplace_back(IPEndPoint(source, port), IPEndPoint(destination, port_host_byte_order_t(443)), protocol);
+			}
+			else
+			{
+				const ByteArray4 source = { 10, static_cast<uint8_t>(r >> 8), static_cast<uint8_t>(r >> 16),
+				                            static_cast<uint8_t>(r >> 24) };
+				flows.emplace_back(IPEndPoint(source, port), IPEndPoint(ByteArray4{ 192, 0, 2, 1 },
+				                                                        port_host_byte_order_t(443)), protocol);
+			}
+		}
+		return flows;
+	}
+}
+
+static void BM_ToeplitzHashTable(benchmark::State& state)
+{
+	const auto flows = makeFlows(static_cast<int>(state.range(0)));
+	const ToeplitzHash hash;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(hash.hash(flows[i++ & 1023]));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ToeplitzHashTable)->Arg(0)->Arg(100);
+
+static void BM_ToeplitzHashReference(benchmark::State& state)
+{
+	const auto flows = makeFlows(static_cast<int>(state.range(0)));
+	const Span<const uint8_t> key(ToeplitzHash::kMicrosoftKey.data(), ToeplitzHash::kMicrosoftKey.size());
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		uint8_t input[FlowKey::kMaxHashInputSize];
+		const size_t size = flows[i++ & 1023].getHashInput(input, true);
+		benchmark::DoNotOptimize(ToeplitzHash::hashReference(key, input, size));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ToeplitzHashReference)->Arg(0)->Arg(100);
+
+static void BM_ToeplitzHashBatch(benchmark::State& state)
+{
+	const auto flows = makeFlows(static_cast<int>(state.range(0)));
+	const ToeplitzHash hash;
+	std::vector<uint32_t> hashes(flows.size());
+	for (auto _ : state)
+	{
+		hash.hash(Span<const FlowKey>(flows.data(), flows.size()), hashes.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * flows.size());
+}
+BENCHMARK(BM_ToeplitzHashBatch)->Arg(0)->Arg(25)->Arg(100);
@@ -0,0 +1,145 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <random>
+#include "HierarchicalHeavyHitters.h"
+using namespace ip_address;
+
+/*
+ * Synthetic attack traces replayed into HierarchicalHeavyHitters.
+ * Every trace mixes Zipf distributed background traffic over 4096 /24 networks with one attack pattern.
+ */
+namespace
+{
+	enum class AttackTrace
+	{
+		/* a single source sends 20% of the packets */
+		kFlood,
+		/* 30% of the packets come from random hosts inside 198.51.0.0/16 (carpet bombing) */
+		kSpread,
+		/* 10 /24 networks inside 203.0.0.0/8 each send 3% of the packets */
+		kMultiPrefix,
+	};
+
+	constexpr size_t kTraceSize = 1 << 20;
+
+	std::vector<IPAddressV4> generateTrace(AttackTrace attack)
+	{
+		std::mt19937_64 rng(static_cast<uint64_t>(attack) + 1);
+		std::vector<uint32_t> networks(4096);
+		for (auto& network : networks)
+			network = static_cast<uint32_t>(rng()) & 0xFFFFFF00u;
+		//Zipf(1.0) over the background networks through an inverse cdf table
+		std::vector<double> cdf(networks.size());
+		double sum = 0.0;
+		for (size_t i = 0; i < cdf.size(); i++)
+		{
+			sum += 1.0 / static_cast<double>(i + 1);
+			cdf[i] = sum;
+		}
+		std::uniform_real_distribution<double> uniform(0.0, sum);
+
+		std::vector<IPAddressV4> trace;
+		trace.reserve(kTraceSize);
+		for (size_t i = 0; i < kTraceSize; i++)
+		{
+			const uint32_t r = static_cast<uint32_t>(rng());
+			const uint32_t percent = r % 100;
+			uint32_t addr;
+			if (attack == AttackTrace::kFlood && percent < 20)
+				addr = 0xC0000263u; //192.0.2.99
+			else if (attack == AttackTrace::kSpread && percent < 30)
+				addr = 0xC6330000u | (r >> 16);
+			else if (attack == AttackTrace::kMultiPrefix && percent < 30)
+				addr = 0xCB000000u | ((percent % 10) << 8) | (r >> 24);
+			else
+			{
+				const size_t idx = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+				addr = networks[std::min(idx, networks.size() - 1)] | (r >> 24);
+			}
+			in_addr inAddr = {};
+			inAddr.s_addr = htonl(addr);
+			trace.emplace_back(inAddr);
+		}
+		return trace;
+	}
+
+	const std::vector<IPAddressV4>& getTrace(AttackTrace attack)
+	{
+		static std::vector<IPAddressV4> traces[3] = {
+			generateTrace(AttackTrace::kFlood),
+			generateTrace(AttackTrace::kSpread),
+			generateTrace(AttackTrace::kMultiPrefix),
+		};
+		return traces[static_cast<int>(attack)];
+	}
+}
+
+static void BM_HHHUpdateV4(benchmark::State& state)
+{
+	const auto& trace = getTrace(static_cast<AttackTrace>(state.range(0)));
+	HierarchicalHeavyHittersV4 hhh(1024, 8, static_cast<uint8_t>(state.range(1)));
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		hhh.update(trace[i]);
+		i = (i + 1) & (kTraceSize - 1);
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.counters["levels"] = static_cast<double>(hhh.getPrefixLengths().size());
+}
+BENCHMARK(BM_HHHUpdateV4)->ArgsProduct({ {0, 1, 2}, {1, 8} })->ArgNames({ "trace", "granularity" });
+
+static void BM_HHHReplayAndQueryV4(benchmark::State& state)
+{
+	const auto& trace = getTrace(static_cast<AttackTrace>(state.range(0)));
+	size_t hitters = 0;
+	for (auto _ : state)
+	{
+		HierarchicalHeavyHittersV4 hhh(1024);
+		for (const auto& addr : trace)
+			hhh.update(addr);
+		const auto result = hhh.query(0.02);
+		hitters = result.size();
+		benchmark::DoNotOptimize(result.data());
+	}
+	state.SetItemsProcessed(state.iterations() * trace.size());
+	state.counters["hitters"] = static_cast<double>(hitters);
+}
+BENCHMARK(BM_HHHReplayAndQueryV4)->DenseRange(0, 2)->ArgName("trace")->Unit(benchmark::kMillisecond);
+
+static void BM_HHHQueryV4(benchmark::State& state)
+{
+	const auto& trace = getTrace(AttackTrace::kSpread);
+	HierarchicalHeavyHittersV4 hhh(1024);
+	for (const auto& addr : trace)
+		hhh.update(addr);
+	for (auto _ : state)
+	{
+		auto result = hhh.query(0.01);
+		benchmark::DoNotOptimize(result.data());
+	}
+}
+BENCHMARK(BM_HHHQueryV4)->Unit(benchmark::kMicrosecond);
+
+static void BM_HHHUpdateV6(benchmark::State& state)
+{
+	std::mt19937_64 rng(3);
+	std::vector<IPAddressV6> trace(1 << 16);
+	const IPAddressV6 attack("2001:db8:aa00::");
+	for (size_t i = 0; i < trace.size(); i++)
+	{
+		trace[i] = attack;
+		const uint64_t r = rng();
+		//half of the packets come from random hosts inside 2001:db8:aa00::/40
+		memcpy(&trace[i].bytes()[i % 2 == 0 ? 5 : 0], &r, sizeof(r));
+	}
+	HierarchicalHeavyHittersV6 hhh(1024, 16, static_cast<uint8_t>(state.range(0)));
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		hhh.update(trace[i]);
+		i = (i + 1) & (trace.size() - 1);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HHHUpdateV6)->Arg(1)->Arg(8)->ArgName("granularity");
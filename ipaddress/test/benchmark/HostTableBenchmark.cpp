@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "HostTable.h"
+using namespace ip_address;
+
+/*
+ * 100k service names with two addresses each, lookups of hits and misses and the time to map the table.
+ */
+namespace
+{
+	constexpr uint32_t kNames = 100000;
+
+	std::string getName(uint32_t i)
+	{
+		return "service-" + std::to_string(i) + ".prod.svc.cluster.local";
+	}
+
+	const std::string& getTablePath()
+	{
+		static const std::string path = []()
+		{
+			HostTableBuilder builder;
+			for (uint32_t i = 0; i < kNames; i++)
+			{
+				builder.add(getName(i), IPAddress(ByteArray4{ 10, static_cast<uint8_t>(i >> 16), static_cast<uint8_t>(i >> 8),
+				                                              static_cast<uint8_t>(i) }));
+				builder.add(getName(i), IPAddress(ByteArray16{ 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+				                                               static_cast<uint8_t>(i >> 16), static_cast<uint8_t>(i >> 8),
+				                                               static_cast<uint8_t>(i) }));
+			}
+			std::string result = "/tmp/ipaddress_hosttable_benchmark_" + std::to_string(getpid());
+			builder.write(result);
+			return result;
+		}();
+		return path;
+	}
+
+	const std::vector<std::string>& getQueries(bool hits)
+	{
+		static const std::vector<std::string> hitNames = []()
+		{
+			std::vector<std::string> result;
+			for (uint32_t i = 0; i < 4096; i++)
+				result.push_back(getName(i * 2654435761u % kNames));
+			return result;
+		}();
+		static const std::vector<std::string> missNames = []()
+		{
+			std::vector<std::string> result;
+			for (uint32_t i = 0; i < 4096; i++)
+				result.push_back(getName(kNames + i));
+			return result;
+		}();
+		return hits ? hitNames : missNames;
+	}
+}
+
+static void BM_HostTableLoad(benchmark::State& state)
+{
+	const std::string& path = getTablePath();
+	for (auto _ : state)
+	{
+		HostTable table(path);
+		benchmark::DoNotOptimize(table.lookup("service-1.prod.svc.cluster.local").size());
+	}
+}
+BENCHMARK(BM_HostTableLoad)->Unit(benchmark::kMicrosecond);
+
+static void BM_HostTableLookup(benchmark::State& state)
+{
+	const HostTable table(getTablePath());
+	const std::vector<std::string>& queries = getQueries(state.range(0) != 0);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(table.lookup(queries[i++ & 4095]).size());
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HostTableLookup)->Arg(1)->Arg(0);
@@ -0,0 +1,360 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include "Corpus.h"
+#include "IPEndPoint.h"
+using namespace ip_address;
+
+/*
+ * The core value types: parsing, formatting, comparison, sockaddr conversion, classification and IPEndPoint
+ * construction over the corpora of Corpus.h. Each iteration handles one address, the corpus is walked in
+ * order so the numbers include the branch misses a real input mix causes.
+ *
+ * Results can be exported for trend tracking with the benchmark_json target or
+ *	BenchmarkTest --benchmark_out=results.json --benchmark_out_format=json
+ */
+namespace
+{
+	template <typename Address>
+	std::vector<Address> getFamily(const std::vector<IPAddress>& addresses);
+
+	template <>
+	std::vector<IPAddressV4> getFamily(const std::vector<IPAddress>& addresses)
+	{
+		std::vector<IPAddressV4> result;
+		for (const IPAddress& addr : addresses)
+		{
+			result.push_back(addr.asIPv4());
+		}
+		return result;
+	}
+
+	template <>
+	std::vector<IPAddressV6> getFamily(const std::vector<IPAddress>& addresses)
+	{
+		std::vector<IPAddressV6> result;
+		for (const IPAddress& addr : addresses)
+		{
+			result.push_back(addr.asIPv6());
+		}
+		return result;
+	}
+
+	corpus::Distribution getDistribution(const benchmark::State& state)
+	{
+		return static_cast<corpus::Distribution>(state.range(0));
+	}
+
+	/*
+	 * Addresses of the family of the benchmark, all IPv4 for V4 benchmarks, all IPv6 for V6 ones.
+	 */
+	template <typename Address>
+	std::vector<Address> makeFamily(const benchmark::State& state)
+	{
+		const bool v6 = std::is_same<Address, IPAddressV6>::value;
+		return getFamily<Address>(corpus::makeAddresses(getDistribution(state), v6 ? 1.0 : 0.0));
+	}
+
+	void finish(benchmark::State& state)
+	{
+		state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+		state.SetLabel(corpus::getName(getDistribution(state)));
+	}
+}
+
+static void BM_ParseIPAddressV4(benchmark::State& state)
+{
+	const std::vector<std::string> strings = corpus::makeStrings(corpus::makeAddresses(getDistribution(state), 0));
+	IPAddressV4 addr4;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(IPAddressV4::parseIPAddressV4(addr4, strings[i++ % corpus::kSize]));
+	}
+	finish(state);
+}
+BENCHMARK(BM_ParseIPAddressV4)->Arg(corpus::kRandom)->Arg(corpus::kZipf);
+
+static void BM_ParseIPAddressV6(benchmark::State& state)
+{
+	const std::vector<std::string> strings = corpus::makeStrings(corpus::makeAddresses(getDistribution(state), 1));
+	IPAddressV6 addr6;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(IPAddressV6::parseIPAddressV6(addr6, strings[i++ % corpus::kSize]));
+	}
+	finish(state);
+}
+BENCHMARK(BM_ParseIPAddressV6)->Arg(corpus::kRandom)->Arg(corpus::kZipf);
+
+static void BM_ParseIPAddress(benchmark::State& state)
+{
+	const std::vector<std::string> strings = corpus::makeStrings(corpus::makeAddresses(getDistribution(state), 0));
+	IPAddress addr;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(IPAddress::parseIPAddress(addr, strings[i++ % corpus::kSize]));
+	}
+	finish(state);
+}
+BENCHMARK(BM_ParseIPAddress)->Arg(corpus::kMixed);
+
+static void BM_GetStringV4(benchmark::State& state)
+{
+	const std::vector<IPAddressV4> addresses = makeFamily<IPAddressV4>(state);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(addresses[i++ % corpus::kSize].getString());
+	}
+	finish(state);
+}
+BENCHMARK(BM_GetStringV4)->Arg(corpus::kRandom)->Arg(corpus::kZipf);
+
+static void BM_GetStringV6(benchmark::State& state)
+{
+	const std::vector<IPAddressV6> addresses = makeFamily<IPAddressV6>(state);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(addresses[i++ % corpus::kSize].getString());
+	}
+	finish(state);
+}
+BENCHMARK(BM_GetStringV6)->Arg(corpus::kRandom)->Arg(corpus::kZipf);
+
+static void BM_GetString(benchmark::State& state)
+{
+	const std::vector<IPAddress> addresses = corpus::makeAddresses(getDistribution(state), 0);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(addresses[i++ % corpus::kSize].getString());
+	}
+	finish(state);
+}
+BENCHMARK(BM_GetString)->Arg(corpus::kMixed);
+
+/*
+ * Neighbours in a Zipf corpus are often equal, in the random corpora almost never.
+ */
+static void BM_EqualsV4(benchmark::State& state)
+{
+	const std::vector<IPAddressV4> addresses = makeFamily<IPAddressV4>(state);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(addresses[i % corpus::kSize] == addresses[(i + 1) % corpus::kSize]);
+		i++;
+	}
+	finish(state);
+}
+BENCHMARK(BM_EqualsV4)->Arg(corpus::kRandom)->Arg(corpus::kZipf);
+
+static void BM_EqualsV6(benchmark::State& state)
+{
+	const std::vector<IPAddressV6> addresses = makeFamily<IPAddressV6>(state);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(addresses[i % corpus::kSize] == addresses[(i + 1) % corpus::kSize]);
+		i++;
+	}
+	finish(state);
+}
+BENCHMARK(BM_EqualsV6)->Arg(corpus::kRandom)->Arg(corpus::kZipf);
+
+static void BM_EqualsIPAddress(benchmark::State& state)
+{
+	const std::vector<IPAddress> addresses = corpus::makeAddresses(getDistribution(state), 0);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(addresses[i % corpus::kSize] == addresses[(i + 1) % corpus::kSize]);
+		i++;
+	}
+	finish(state);
+}
+BENCHMARK(BM_EqualsIPAddress)->Arg(corpus::kMixed)->Arg(corpus::kZipf);
+
+static void BM_EqualsIPAddressV4(benchmark::State& state)
+{
+	const std::vector<IPAddress> addresses = corpus::makeAddresses(getDistribution(state), 0);
+	const std::vector<IPAddressV4> addresses4 = makeFamily<IPAddressV4>(state);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(addresses[i % corpus::kSize] == addresses4[(i + 1) % corpus::kSize]);
+		benchmark::DoNotOptimize(addresses4[i % corpus::kSize] != addresses[(i + 1) % corpus::kSize]);
+		i++;
+	}
+	finish(state);
+}
+BENCHMARK(BM_EqualsIPAddressV4)->Arg(corpus::kZipf);
+
+static void BM_ToSockaddr(benchmark::State& state)
+{
+	const std::vector<IPAddress> addresses = corpus::makeAddresses(getDistribution(state), 0);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const IPAddress& addr = addresses[i++ % corpus::kSize];
+		if (addr.isIPv4())
+			benchmark::DoNotOptimize(addr.asIPv4().getSockaddrIn4());
+		else
+			benchmark::DoNotOptimize(addr.asIPv6().getSockaddrIn6());
+	}
+	finish(state);
+}
+BENCHMARK(BM_ToSockaddr)->Arg(corpus::kMixed);
+
+static void BM_FromSockaddr(benchmark::State& state)
+{
+	const std::vector<IPAddress> addresses = corpus::makeAddresses(getDistribution(state), 0);
+	std::vector<sockaddr_storage> storages(corpus::kSize);
+	std::vector<socklen_t> lengths(corpus::kSize);
+	for (size_t i = 0; i < corpus::kSize; i++)
+	{
+		IPEndPoint(addresses[i], port_host_byte_order_t(443)).writeSockaddr(storages[i], lengths[i]);
+	}
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const size_t index = i++ % corpus::kSize;
+		benchmark::DoNotOptimize(IPAddress(reinterpret_cast<const sockaddr*>(&storages[index]), lengths[index]));
+	}
+	finish(state);
+}
+BENCHMARK(BM_FromSockaddr)->Arg(corpus::kMixed);
+
+static void BM_MapIPv4ToIPv6(benchmark::State& state)
+{
+	std::vector<IPAddressV4> addresses = makeFamily<IPAddressV4>(state);
+	IPAddressV6 addr6;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(IPAddressV4::mapIPv4ToIPv6(addresses[i++ % corpus::kSize], addr6));
+		benchmark::DoNotOptimize(addr6);
+	}
+	finish(state);
+}
+BENCHMARK(BM_MapIPv4ToIPv6)->Arg(corpus::kRandom);
+
+static void BM_MapIPv6ToIPv4(benchmark::State& state)
+{
+	std::vector<IPAddressV6> addresses;
+	for (IPAddressV4& addr4 : makeFamily<IPAddressV4>(state))
+	{
+		IPAddressV6 addr6;
+		(void)IPAddressV4::mapIPv4ToIPv6(addr4, addr6);
+		addresses.push_back(addr6);
+	}
+	IPAddressV4 addr4;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(IPAddressV6::mapIPv6ToIPv4(addresses[i++ % corpus::kSize], addr4));
+		benchmark::DoNotOptimize(addr4);
+	}
+	finish(state);
+}
+BENCHMARK(BM_MapIPv6ToIPv4)->Arg(corpus::kRandom);
+
+static void BM_ClassifyV4(benchmark::State& state)
+{
+	const std::vector<IPAddressV4> addresses = makeFamily<IPAddressV4>(state);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const IPAddressV4& addr4 = addresses[i++ % corpus::kSize];
+		benchmark::DoNotOptimize(addr4.isLoopback());
+		benchmark::DoNotOptimize(addr4.isMulticast());
+		benchmark::DoNotOptimize(addr4.isUnicast());
+		benchmark::DoNotOptimize(addr4.isBroadcast());
+		benchmark::DoNotOptimize(addr4.isLinkLocal());
+		benchmark::DoNotOptimize(addr4.isPrivate());
+	}
+	finish(state);
+}
+BENCHMARK(BM_ClassifyV4)->Arg(corpus::kRandom);
+
+static void BM_ClassifyV6(benchmark::State& state)
+{
+	const std::vector<IPAddressV6> addresses = makeFamily<IPAddressV6>(state);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const IPAddressV6& addr6 = addresses[i++ % corpus::kSize];
+		benchmark::DoNotOptimize(addr6.isLoopback());
+		benchmark::DoNotOptimize(addr6.isMulticast());
+		benchmark::DoNotOptimize(addr6.isGlobalUnicast());
+		benchmark::DoNotOptimize(addr6.isUniqueLocal());
+		benchmark::DoNotOptimize(addr6.isLinkLocal());
+		benchmark::DoNotOptimize(addr6.isIPv4Mapped());
+	}
+	finish(state);
+}
+BENCHMARK(BM_ClassifyV6)->Arg(corpus::kRandom);
+
+static void BM_ClassifyIPAddress(benchmark::State& state)
+{
+	const std::vector<IPAddress> addresses = corpus::makeAddresses(getDistribution(state), 0);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const IPAddress& addr = addresses[i++ % corpus::kSize];
+		benchmark::DoNotOptimize(addr.isBroadcast());
+		benchmark::DoNotOptimize(addr.isWildcard());
+	}
+	finish(state);
+}
+BENCHMARK(BM_ClassifyIPAddress)->Arg(corpus::kMixed);
+
+static void BM_IPEndPointFromAddress(benchmark::State& state)
+{
+	const std::vector<IPAddress> addresses = corpus::makeAddresses(getDistribution(state), 0);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(IPEndPoint(addresses[i % corpus::kSize], static_cast<port_host_byte_order_t>(i)));
+		i++;
+	}
+	finish(state);
+}
+BENCHMARK(BM_IPEndPointFromAddress)->Arg(corpus::kMixed);
+
+static void BM_IPEndPointFromString(benchmark::State& state)
+{
+	const std::vector<std::string> strings = corpus::makeStrings(corpus::makeAddresses(getDistribution(state), 0));
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(IPEndPoint(strings[i % corpus::kSize], static_cast<port_host_byte_order_t>(i)));
+		i++;
+	}
+	finish(state);
+}
+BENCHMARK(BM_IPEndPointFromString)->Arg(corpus::kMixed);
+
+static void BM_IPEndPointWriteSockaddr(benchmark::State& state)
+{
+	std::vector<IPEndPoint> endpoints;
+	for (const IPAddress& addr : corpus::makeAddresses(getDistribution(state), 0))
+	{
+		endpoints.emplace_back(addr, port_host_byte_order_t(443));
+	}
+	sockaddr_storage storage;
+	socklen_t length;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		endpoints[i++ % corpus::kSize].writeSockaddr(storage, length);
+		benchmark::DoNotOptimize(storage);
+	}
+	finish(state);
+}
+BENCHMARK(BM_IPEndPointWriteSockaddr)->Arg(corpus::kMixed);
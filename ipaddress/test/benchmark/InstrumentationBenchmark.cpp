@@ -0,0 +1,124 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "Corpus.h"
+#include "IPEndPoint.h"
+#include "Instrumentation.h"
+using namespace ip_address;
+
+/*
+ * Cost of the instrumentation. BenchmarkTest links the library as configured, InstrumentationBenchmark links a
+ * copy built with IPADDRESS_INSTRUMENTATION, both run this file, so
+ *	cmake --build . --target benchmark_instrumentation
+ * writes instrumentation_plain.json and instrumentation_enabled.json with the same benchmark names, e.g. for
+ * tools/compare.py of Google Benchmark. The BM_Instrumented benchmarks are instrumented library paths, the
+ * label tells the build. The BM_Instrumentation benchmarks call the recording API directly and cost the
+ * same in both.
+ */
+namespace
+{
+	const char* getBuild()
+	{
+		return Instrumentation::isEnabled() ? "instrumented" : "plain";
+	}
+}
+
+static void BM_InstrumentedParseV4(benchmark::State& state)
+{
+	const std::vector<std::string> strings = corpus::makeStrings(corpus::makeAddresses(corpus::kRandom, 0));
+	IPAddressV4 addr4;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(IPAddressV4::parseIPAddressV4(addr4, strings[i++ % corpus::kSize]));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+	state.SetLabel(getBuild());
+}
+BENCHMARK(BM_InstrumentedParseV4);
+
+static void BM_InstrumentedParse(benchmark::State& state)
+{
+	const std::vector<std::string> strings = corpus::makeStrings(corpus::makeAddresses(corpus::kMixed, 0));
+	IPAddress addr;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(IPAddress::parseIPAddress(addr, strings[i++ % corpus::kSize]));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+	state.SetLabel(getBuild());
+}
+BENCHMARK(BM_InstrumentedParse);
+
+static void BM_InstrumentedGetString(benchmark::State& state)
+{
+	const std::vector<IPAddress> addresses = corpus::makeAddresses(corpus::kMixed, 0);
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(addresses[i++ % corpus::kSize].getString());
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+	state.SetLabel(getBuild());
+}
+BENCHMARK(BM_InstrumentedGetString);
+
+static void BM_InstrumentedWriteSockaddr(benchmark::State& state)
+{
+	std::vector<IPEndPoint> endpoints;
+	for (const IPAddress& addr : corpus::makeAddresses(corpus::kMixed, 0))
+	{
+		endpoints.emplace_back(addr, port_host_byte_order_t(443));
+	}
+	sockaddr_storage storage;
+	socklen_t length;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		endpoints[i++ % corpus::kSize].writeSockaddr(storage, length);
+		benchmark::DoNotOptimize(storage);
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+	state.SetLabel(getBuild());
+}
+BENCHMARK(BM_InstrumentedWriteSockaddr);
+
+static void BM_InstrumentationCount(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		Instrumentation::count(Instrumentation::Event::kParseFailed);
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_InstrumentationCount)->ThreadRange(1, 4);
+
+static void BM_InstrumentationTimer(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		const Instrumentation::Timer timer(Instrumentation::Operation::kConvert);
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_InstrumentationTimer)->ThreadRange(1, 4);
+
+static void BM_InstrumentationSnapshot(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Instrumentation::snapshot());
+	}
+}
+BENCHMARK(BM_InstrumentationSnapshot);
+
+static void BM_InstrumentationPrometheusText(benchmark::State& state)
+{
+	const Instrumentation::Snapshot snapshot = Instrumentation::snapshot();
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(snapshot.getPrometheusText());
+	}
+}
+BENCHMARK(BM_InstrumentationPrometheusText);
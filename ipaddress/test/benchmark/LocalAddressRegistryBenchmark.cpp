@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+#include <ifaddrs.h>
+#include <string>
+#include <vector>
+#include "LocalAddressRegistry.h"
+using namespace ip_address;
+
+/*
+ * "is this address ours" over a host with 64 addresses, the registry against walking getifaddrs.
+ */
+namespace
+{
+	LocalAddressRegistry& getRegistry()
+	{
+		static LocalAddressRegistry registry([]()
+		{
+			std::vector<LocalAddress> addresses;
+			for (uint8_t i = 0; i < 32; i++)
+			{
+				addresses.push_back({ IPAddress(ByteArray4{ 10, 0, i, 1 }), 24, i });
+				addresses.push_back({ IPAddress(ByteArray16{ 0x20, 0x01, 0x0d, 0xb8, 0, i, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 }),
+				                      64, i });
+			}
+			return addresses;
+		}());
+		return registry;
+	}
+
+	std::vector<IPAddress> makeQueries()
+	{
+		std::vector<IPAddress> queries;
+		for (uint8_t i = 0; i < 64; i++)
+		{
+			queries.emplace_back(ByteArray4{ 10, 0, static_cast<uint8_t>(i % 40), static_cast<uint8_t>(1 + i % 2) });
+		}
+		return queries;
+	}
+}
+
+static void BM_LocalAddressRegistryIsLocal(benchmark::State& state)
+{
+	const LocalAddressRegistry& registry = getRegistry();
+	const std::vector<IPAddress> queries = makeQueries();
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(registry.isLocal(queries[i++ & 63]));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_LocalAddressRegistryIsLocal)->ThreadRange(1, 8);
+
+static void BM_LocalAddressRegistryGetPrefix(benchmark::State& state)
+{
+	const LocalAddressRegistry& registry = getRegistry();
+	const std::vector<IPAddress> queries = makeQueries();
+	IPNetwork network;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(registry.getPrefix(queries[i++ & 63], network));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_LocalAddressRegistryGetPrefix);
+
+static void BM_GetifaddrsIsLocal(benchmark::State& state)
+{
+	const IPAddress query(std::string("127.0.0.1"));
+	for (auto _ : state)
+	{
+		bool found = false;
+		ifaddrs* interfaces = nullptr;
+		if (getifaddrs(&interfaces) != 0)
+			break;
+		for (const ifaddrs* current = interfaces; current != nullptr && !found; current = current->ifa_next)
+		{
+			if (current->ifa_addr != nullptr && current->ifa_addr->sa_family == AF_INET)
+				found = IPAddress(*reinterpret_cast<const sockaddr_in*>(current->ifa_addr)) == query;
+		}
+		freeifaddrs(interfaces);
+		benchmark::DoNotOptimize(found);
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_GetifaddrsIsLocal);
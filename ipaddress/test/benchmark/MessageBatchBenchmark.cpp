@@ -0,0 +1,177 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include <unistd.h>
+#include "MessageBatch.h"
+using namespace ip_address;
+
+namespace
+{
+	//mixed IPv4/IPv6 names in a random order so the per-family branch of the scalar path is unpredictable
+	const std::vector<sockaddr_storage>& getNames()
+	{
+		static const std::vector<sockaddr_storage> names = []()
+		{
+			std::mt19937_64 rng(28);
+			std::vector<sockaddr_storage> result(1024);
+			for (auto& name : result)
+			{
+				memset(&name, 0, sizeof(name));
+				const uint64_t r = rng();
+				if (r & 1)
+				{
+					auto* addr = reinterpret_cast<sockaddr_in6*>(&name);
+					addr->sin6_family = AF_INET6;
+					addr->sin6_port = static_cast<in_port_t>(r >> 8);
+					memcpy(&addr->sin6_addr, &r, sizeof(r));
+				}
+				else
+				{
+					auto* addr = reinterpret_cast<sockaddr_in*>(&name);
+					addr->sin_family = AF_INET;
+					addr->sin_port = static_cast<in_port_t>(r >> 8);
+					addr->sin_addr.s_addr = static_cast<uint32_t>(r >> 32);
+				}
+			}
+			return result;
+		}();
+		return names;
+	}
+}
+
+static void BM_SockaddrToEndPointScalar(benchmark::State& state)
+{
+	const auto& names = getNames();
+	std::vector<IPEndPoint> endpoints(names.size());
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			endpoints[i] = IPEndPoint(reinterpret_cast<const sockaddr*>(&names[i]), sizeof(sockaddr_storage));
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * names.size());
+}
+BENCHMARK(BM_SockaddrToEndPointScalar);
+
+static void BM_SockaddrToEndPointBatch(benchmark::State& state)
+{
+	const auto& names = getNames();
+	std::vector<IPEndPoint> endpoints(names.size());
+	for (auto _ : state)
+	{
+		IPEndPoint::fromSockaddrs(names.data(), names.size(), endpoints.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * names.size());
+}
+BENCHMARK(BM_SockaddrToEndPointBatch);
+
+static void BM_EndPointToSockaddrBatch(benchmark::State& state)
+{
+	const auto& names = getNames();
+	std::vector<IPEndPoint> endpoints(names.size());
+	IPEndPoint::fromSockaddrs(names.data(), names.size(), endpoints.data());
+	std::vector<sockaddr_storage> out(names.size());
+	std::vector<socklen_t> lengths(names.size());
+	for (auto _ : state)
+	{
+		IPEndPoint::toSockaddrs(endpoints.data(), endpoints.size(), out.data(), lengths.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * names.size());
+}
+BENCHMARK(BM_EndPointToSockaddrBatch);
+
+#ifdef __linux__
+/*
+ * Loopback UDP, one datagram per syscall (sendto/recvfrom) against state.range(0) datagrams per sendmmsg/recvmmsg.
+ */
+namespace
+{
+	struct LoopbackPair
+	{
+		LoopbackPair()
+		{
+			receiver = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+			sender = socket(AF_INET, SOCK_DGRAM, 0);
+			sockaddr_in addr = IPAddressV4::loopback().getSockaddrIn4();
+			bind(receiver, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+			socklen_t length = sizeof(addr);
+			getsockname(receiver, reinterpret_cast<sockaddr*>(&addr), &length);
+			destination = IPEndPoint(addr);
+			const int size = 4 << 20;
+			setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+		}
+		~LoopbackPair()
+		{
+			close(receiver);
+			close(sender);
+		}
+		int receiver;
+		int sender;
+		IPEndPoint destination;
+	};
+	constexpr size_t kDatagramSize = 64;
+}
+
+static void BM_LoopbackUdpSingle(benchmark::State& state)
+{
+	LoopbackPair pair;
+	const size_t burst = static_cast<size_t>(state.range(0));
+	char payload[kDatagramSize] = {};
+	char buffer[kDatagramSize];
+	const sockaddr_in destination = pair.destination.getAddressIPv4();
+	std::vector<IPEndPoint> senders(burst);
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < burst; i++)
+		{
+			sendto(pair.sender, payload, sizeof(payload), 0, reinterpret_cast<const sockaddr*>(&destination),
+			       sizeof(destination));
+		}
+		for (size_t i = 0; i < burst; i++)
+		{
+			sockaddr_storage from;
+			socklen_t length = sizeof(from);
+			if (recvfrom(pair.receiver, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&from), &length) < 0)
+				break;
+			senders[i] = IPEndPoint(reinterpret_cast<const sockaddr*>(&from), length);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * burst);
+}
+BENCHMARK(BM_LoopbackUdpSingle)->Arg(32)->Arg(64);
+
+static void BM_LoopbackUdpBatch(benchmark::State& state)
+{
+	LoopbackPair pair;
+	const size_t burst = static_cast<size_t>(state.range(0));
+	char payload[kDatagramSize] = {};
+	static char buffers[64][kDatagramSize];
+	UdpMessageBatch<64> out;
+	UdpMessageBatch<64> in;
+	for (size_t i = 0; i < burst; i++)
+	{
+		out.setBuffer(i, payload, sizeof(payload));
+		out.setMessage(i, pair.destination, sizeof(payload));
+		in.setBuffer(i, buffers[i], sizeof(buffers[i]));
+	}
+	for (auto _ : state)
+	{
+		out.send(pair.sender, burst);
+		size_t received = 0;
+		while (received < burst)
+		{
+			const int n = in.receive(pair.receiver);
+			if (n <= 0)
+				break;
+			received += static_cast<size_t>(n);
+		}
+		benchmark::DoNotOptimize(in.getEndPoints().data());
+	}
+	state.SetItemsProcessed(state.iterations() * burst);
+}
+BENCHMARK(BM_LoopbackUdpBatch)->Arg(32)->Arg(64);
+#endif
@@ -0,0 +1,166 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "PackedAddressList.h"
+using namespace ip_address;
+
+/*
+ * Decode speed and size of packed lists shaped like real blocklists: addresses cluster in a few thousand
+ * networks with a skewed number of hosts each. Ratios are against 4 or 16 bytes per address and against the
+ * text form with one address per line.
+ */
+namespace
+{
+	constexpr size_t kCount = 1 << 20;
+
+	const std::vector<IPAddressV4>& getAddressesV4()
+	{
+		static const std::vector<IPAddressV4> addresses = []()
+		{
+			std::mt19937_64 rng(40);
+			std::vector<uint32_t> keys;
+			while (keys.size() < kCount)
+			{
+				//a /24 with a geometric number of listed hosts
+				const uint32_t network = static_cast<uint32_t>(rng()) & 0xFFFFFF00;
+				const size_t hosts = 1 + static_cast<size_t>(std::geometric_distribution<int>(0.02)(rng));
+				for (size_t i = 0; i < std::min<size_t>(hosts, 254); i++)
+				{
+					keys.push_back(network | static_cast<uint32_t>(1 + rng() % 254));
+				}
+			}
+			std::sort(keys.begin(), keys.end());
+			keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+			std::vector<IPAddressV4> result;
+			for (const uint32_t key : keys)
+			{
+				result.push_back(details::AddressKey<IPAddressV4>::toAddress(key));
+			}
+			return result;
+		}();
+		return addresses;
+	}
+
+	const std::vector<IPAddressV6>& getAddressesV6()
+	{
+		static const std::vector<IPAddressV6> addresses = []()
+		{
+			std::mt19937_64 rng(41);
+			std::vector<details::Uint128> keys;
+			while (keys.size() < kCount)
+			{
+				//a /64 with SLAAC-like random hosts or a few low numbered servers
+				const uint64_t network = 0x2000000000000000ULL | (rng() >> 3);
+				const bool servers = rng() % 2 == 0;
+				const size_t hosts = 1 + static_cast<size_t>(std::geometric_distribution<int>(0.05)(rng));
+				for (size_t i = 0; i < hosts; i++)
+				{
+					keys.push_back({ network, servers ? 1 + rng() % 256 : rng() });
+				}
+			}
+			std::sort(keys.begin(), keys.end());
+			keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+			std::vector<IPAddressV6> result;
+			for (const details::Uint128& key : keys)
+			{
+				result.push_back(details::AddressKey<IPAddressV6>::toAddress(key));
+			}
+			return result;
+		}();
+		return addresses;
+	}
+
+	template <typename Address>
+	size_t getTextSize(const std::vector<Address>& addresses)
+	{
+		size_t size = 0;
+		for (const Address& addr : addresses)
+		{
+			size += addr.getString().size() + 1;
+		}
+		return size;
+	}
+
+	template <typename Address>
+	void setCounters(benchmark::State& state, const std::vector<Address>& addresses, size_t encodedSize, size_t rawSize)
+	{
+		state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * addresses.size()));
+		state.counters["bits_per_address"] = 8.0 * static_cast<double>(encodedSize) / static_cast<double>(addresses.size());
+		state.counters["ratio_binary"] = static_cast<double>(rawSize * addresses.size()) / static_cast<double>(encodedSize);
+		state.counters["ratio_text"] = static_cast<double>(getTextSize(addresses)) / static_cast<double>(encodedSize);
+	}
+}
+
+static void BM_PackedAddressListDecodeBlocksV4(benchmark::State& state)
+{
+	const std::vector<IPAddressV4>& addresses = getAddressesV4();
+	const std::vector<uint8_t> data = PackedAddressList::encode(Span<const IPAddressV4>(addresses.data(), addresses.size()));
+	const PackedAddressList list(Span<const uint8_t>(data.data(), data.size()));
+	uint32_t keys[PackedAddressList::kBlockSize];
+	for (auto _ : state)
+	{
+		for (size_t block = 0; block < list.getBlockCount(); block++)
+		{
+			list.decodeBlock(block, keys);
+			benchmark::DoNotOptimize(keys);
+		}
+	}
+	setCounters(state, addresses, data.size(), 4);
+}
+BENCHMARK(BM_PackedAddressListDecodeBlocksV4);
+
+static void BM_PackedAddressListDecodeV4(benchmark::State& state)
+{
+	const std::vector<IPAddressV4>& addresses = getAddressesV4();
+	const std::vector<uint8_t> data = PackedAddressList::encode(Span<const IPAddressV4>(addresses.data(), addresses.size()));
+	const PackedAddressList list(Span<const uint8_t>(data.data(), data.size()));
+	std::vector<IPAddressV4> decoded;
+	for (auto _ : state)
+	{
+		decoded.clear();
+		list.decode(decoded);
+		benchmark::DoNotOptimize(decoded.data());
+	}
+	setCounters(state, addresses, data.size(), 4);
+}
+BENCHMARK(BM_PackedAddressListDecodeV4);
+
+static void BM_PackedAddressListDecodeBlocksV6(benchmark::State& state)
+{
+	const std::vector<IPAddressV6>& addresses = getAddressesV6();
+	const std::vector<uint8_t> data = PackedAddressList::encode(Span<const IPAddressV6>(addresses.data(), addresses.size()));
+	const PackedAddressList list(Span<const uint8_t>(data.data(), data.size()));
+	details::Uint128 keys[PackedAddressList::kBlockSize];
+	for (auto _ : state)
+	{
+		for (size_t block = 0; block < list.getBlockCount(); block++)
+		{
+			list.decodeBlock(block, keys);
+			benchmark::DoNotOptimize(keys);
+		}
+	}
+	setCounters(state, addresses, data.size(), 16);
+}
+BENCHMARK(BM_PackedAddressListDecodeBlocksV6);
+
+static void BM_PackedAddressListContainsV4(benchmark::State& state)
+{
+	const std::vector<IPAddressV4>& addresses = getAddressesV4();
+	const std::vector<uint8_t> data = PackedAddressList::encode(Span<const IPAddressV4>(addresses.data(), addresses.size()));
+	const PackedAddressList list(Span<const uint8_t>(data.data(), data.size()));
+	std::mt19937_64 rng(42);
+	std::vector<IPAddressV4> queries;
+	for (size_t i = 0; i < 1024; i++)
+	{
+		queries.push_back(i % 2 == 0 ? addresses[rng() % addresses.size()] :
+		                  details::AddressKey<IPAddressV4>::toAddress(static_cast<uint32_t>(rng())));
+	}
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(list.contains(queries[i++ & 1023]));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PackedAddressListContainsV4);
@@ -0,0 +1,250 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include "Corpus.h"
+#include "PacketClassifier.h"
+using namespace ip_address;
+
+/*
+ * ACL style rule sets modeled on the ClassBench seeds: addresses drawn below a few hundred nested site prefixes,
+ * destinations mostly hosts and /24s, sources from wildcards to hosts, destination ports mostly well known exact
+ * ports with some ranges and wildcards, source ports mostly wildcards, mostly TCP. One rule in ten is IPv6. The
+ * flows are ClassBench style traces: a point inside a random rule, one in ten uniformly random. Arg is the number
+ * of rules.
+ */
+namespace
+{
+	const uint16_t kPorts[] = { 20, 21, 22, 23, 25, 53, 80, 110, 123, 143, 161, 389, 443, 445, 514, 993, 1433, 1521,
+		3306, 3389, 5060, 5432, 8080, 8443 };
+
+	struct RuleSet
+	{
+		std::vector<PacketRule> rules;
+		std::vector<FlowKey> flows;
+	};
+
+	IPNetwork makeNetwork(std::mt19937_64& rng, const std::vector<IPAddress>& sites, uint8_t prefixLength)
+	{
+		const IPAddress& site = sites[rng() % sites.size()];
+		if (site.isIPv4())
+		{
+			ByteArray4 bytes = site.getIPv4().bytes();
+			bytes[2] = static_cast<uint8_t>(rng() % 16);
+			bytes[3] = static_cast<uint8_t>(rng());
+			return IPNetwork(IPAddressV4(bytes), prefixLength);
+		}
+		ByteArray16 bytes = site.getIPv6().bytes();
+		bytes[6] = static_cast<uint8_t>(rng() % 16);
+		bytes[15] = static_cast<uint8_t>(rng());
+		return IPNetwork(IPAddressV6(bytes), static_cast<uint8_t>(prefixLength == 0 ? 0 : prefixLength + 96));
+	}
+
+	std::vector<PacketRule> makeRules(size_t count)
+	{
+		std::mt19937_64 rng(corpus::kSeed);
+		std::vector<IPAddress> sitesV4;
+		std::vector<IPAddress> sitesV6;
+		for (size_t i = 0; i < 256; i++)
+		{
+			sitesV4.push_back(corpus::makeRandomV4(rng));
+			sitesV6.push_back(corpus::makeRandomV6(rng));
+		}
+		static const uint8_t kSourceLengths[] = { 0, 0, 0, 8, 16, 16, 24, 24, 28, 32, 32, 32 };
+		static const uint8_t kDestinationLengths[] = { 16, 20, 24, 24, 24, 28, 30, 32, 32, 32, 32, 32 };
+		std::vector<PacketRule> rules;
+		for (size_t i = 0; i < count; i++)
+		{
+			const std::vector<IPAddress>& sites = rng() % 10 == 0 ? sitesV6 : sitesV4;
+			PacketRule rule;
+			const uint8_t sourceLength = kSourceLengths[rng() % 12];
+			const uint8_t destinationLength = kDestinationLengths[rng() % 12];
+			rule.source = makeNetwork(rng, sites, sourceLength);
+			rule.destination = makeNetwork(rng, sites, destinationLength);
+			if (sourceLength == 0 && rng() % 2 == 0)
+				rule.source = IPNetwork();
+			if (rng() % 10 == 0)
+				rule.sourcePortFirst = 1024;
+			switch (rng() % 10)
+			{
+			case 0:
+				break;
+			case 1:
+				rule.destinationPortFirst = 1024;
+				break;
+			case 2:
+				rule.destinationPortFirst = static_cast<port_host_byte_order_t>(rng() % 60000);
+				rule.destinationPortLast = static_cast<port_host_byte_order_t>(rule.destinationPortFirst + rng() % 1000);
+				break;
+			default:
+				rule.destinationPortFirst = rule.destinationPortLast = kPorts[rng() % (sizeof(kPorts) / sizeof(kPorts[0]))];
+				break;
+			}
+			const uint64_t protocol = rng() % 10;
+			if (protocol < 7)
+				rule.protocolFirst = rule.protocolLast = IPPROTO_TCP;
+			else if (protocol < 9)
+				rule.protocolFirst = rule.protocolLast = IPPROTO_UDP;
+			rules.push_back(rule);
+		}
+		//a default rule, like the end of a real ACL
+		rules.emplace_back();
+		return rules;
+	}
+
+	template <typename Bytes>
+	Bytes makeInside(std::mt19937_64& rng, const IPNetwork& network, Bytes bytes)
+	{
+		for (size_t i = network.getPrefixLength() / 8; i < bytes.size(); i++)
+		{
+			const auto random = static_cast<uint8_t>(rng());
+			const auto keep = static_cast<uint8_t>(i * 8 < network.getPrefixLength() ?
+				0xFF << (8 - network.getPrefixLength() % 8) : 0);
+			bytes[i] = static_cast<uint8_t>((bytes[i] & keep) | (random & ~keep));
+		}
+		return bytes;
+	}
+
+	IPAddress makeInside(std::mt19937_64& rng, const IPNetwork& network, bool v6)
+	{
+		if (network.getVersion() == IPVersion::kIPv4)
+			return IPAddress(makeInside(rng, network, network.getAddress().getIPv4().bytes()));
+		if (network.getVersion() == IPVersion::kIPv6)
+			return IPAddress(makeInside(rng, network, network.getAddress().getIPv6().bytes()));
+		return v6 ? corpus::makeRandomV6(rng) : corpus::makeRandomV4(rng);
+	}
+
+	port_host_byte_order_t makeInside(std::mt19937_64& rng, uint32_t first, uint32_t last)
+	{
+		return static_cast<port_host_byte_order_t>(first + rng() % (last - first + 1));
+	}
+
+	const RuleSet& getRuleSet(int64_t count)
+	{
+		static std::vector<std::pair<int64_t, RuleSet>> ruleSets;
+		for (const auto& ruleSet : ruleSets)
+		{
+			if (ruleSet.first == count)
+				return ruleSet.second;
+		}
+		RuleSet ruleSet;
+		ruleSet.rules = makeRules(static_cast<size_t>(count));
+		std::mt19937_64 rng(corpus::kSeed + 1);
+		for (size_t i = 0; i < corpus::kSize; i++)
+		{
+			const PacketRule& rule = ruleSet.rules[rng() % ruleSet.rules.size()];
+			const bool v6 = rule.source.getVersion() == IPVersion::kIPv6 || rule.destination.getVersion() == IPVersion::kIPv6;
+			if (rng() % 10 == 0)
+			{
+				const IPAddress source = v6 ? corpus::makeRandomV6(rng) : corpus::makeRandomV4(rng);
+				const IPAddress destination = v6 ? corpus::makeRandomV6(rng) : corpus::makeRandomV4(rng);
+				ruleSet.flows.emplace_back(IPEndPoint(source, static_cast<port_host_byte_order_t>(rng())),
+					IPEndPoint(destination, static_cast<port_host_byte_order_t>(rng())), IPPROTO_TCP);
+				continue;
+			}
+			const IPEndPoint source(makeInside(rng, rule.source, v6),
+				makeInside(rng, rule.sourcePortFirst, rule.sourcePortLast));
+			const IPEndPoint destination(makeInside(rng, rule.destination, v6),
+				makeInside(rng, rule.destinationPortFirst, rule.destinationPortLast));
+			ruleSet.flows.emplace_back(source, destination,
+				static_cast<uint8_t>(makeInside(rng, rule.protocolFirst, rule.protocolLast)));
+		}
+		ruleSets.emplace_back(count, std::move(ruleSet));
+		return ruleSets.back().second;
+	}
+}
+
+static void BM_PacketClassifierBuild(benchmark::State& state)
+{
+	const RuleSet& ruleSet = getRuleSet(state.range(0));
+	size_t nodes = 0;
+	size_t entries = 0;
+	for (auto _ : state)
+	{
+		const PacketClassifier classifier(ruleSet.rules);
+		nodes = classifier.getNodeCount();
+		entries = classifier.getLeafEntryCount();
+	}
+	state.counters["nodes"] = static_cast<double>(nodes);
+	state.counters["entries"] = static_cast<double>(entries);
+}
+BENCHMARK(BM_PacketClassifierBuild)->Arg(1000)->Arg(5000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+static void BM_PacketClassifierClassify(benchmark::State& state)
+{
+	const RuleSet& ruleSet = getRuleSet(state.range(0));
+	const PacketClassifier classifier(ruleSet.rules);
+	size_t rule = 0;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(classifier.classify(ruleSet.flows[i++ % corpus::kSize], rule));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PacketClassifierClassify)->Arg(1000)->Arg(5000)->Arg(10000);
+
+static void BM_PacketClassifierClassifyEndPoints(benchmark::State& state)
+{
+	const RuleSet& ruleSet = getRuleSet(state.range(0));
+	const PacketClassifier classifier(ruleSet.rules);
+	std::vector<IPEndPoint> sources;
+	std::vector<IPEndPoint> destinations;
+	for (const FlowKey& flow : ruleSet.flows)
+	{
+		sources.push_back(flow.getSource());
+		destinations.push_back(flow.getDestination());
+	}
+	size_t rule = 0;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const size_t flow = i++ % corpus::kSize;
+		benchmark::DoNotOptimize(classifier.classify(sources[flow], destinations[flow], ruleSet.flows[flow].getProtocol(),
+			rule));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PacketClassifierClassifyEndPoints)->Arg(1000)->Arg(10000);
+
+static void BM_PacketClassifierClassifyBatch(benchmark::State& state)
+{
+	const RuleSet& ruleSet = getRuleSet(state.range(0));
+	const PacketClassifier classifier(ruleSet.rules);
+	std::vector<size_t> rules(ruleSet.flows.size());
+	for (auto _ : state)
+	{
+		classifier.classify(Span<const FlowKey>(ruleSet.flows.data(), ruleSet.flows.size()),
+			Span<size_t>(rules.data(), rules.size()));
+		benchmark::DoNotOptimize(rules.data());
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * ruleSet.flows.size()));
+}
+BENCHMARK(BM_PacketClassifierClassifyBatch)->Arg(1000)->Arg(5000)->Arg(10000);
+
+static void BM_PacketClassifierLinear(benchmark::State& state)
+{
+	//first matching rule in order, every rule has the same priority
+	const RuleSet& ruleSet = getRuleSet(state.range(0));
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const FlowKey& flow = ruleSet.flows[i++ % corpus::kSize];
+		const IPEndPoint source = flow.getSource();
+		const IPEndPoint destination = flow.getDestination();
+		size_t rule = 0;
+		for (; rule < ruleSet.rules.size(); rule++)
+		{
+			const PacketRule& candidate = ruleSet.rules[rule];
+			if ((candidate.source.getVersion() == IPVersion::kUnknown || candidate.source.contains(source)) &&
+				(candidate.destination.getVersion() == IPVersion::kUnknown || candidate.destination.contains(destination)) &&
+				source.getPort() >= candidate.sourcePortFirst && source.getPort() <= candidate.sourcePortLast &&
+				destination.getPort() >= candidate.destinationPortFirst &&
+				destination.getPort() <= candidate.destinationPortLast &&
+				flow.getProtocol() >= candidate.protocolFirst && flow.getProtocol() <= candidate.protocolLast)
+				break;
+		}
+		benchmark::DoNotOptimize(rule);
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PacketClassifierLinear)->Arg(1000);
@@ -0,0 +1,153 @@
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "PrefixDatabase.h"
+using namespace ip_address;
+
+/*
+ * Routing table sized database (~900k IPv4 and 200k IPv6 prefixes): time from opening the file to the first
+ * answer, with the file in the page cache and after dropping it, against parsing the same table from text.
+ */
+namespace
+{
+	class Fixture
+	{
+	public:
+		Fixture()
+		{
+			std::mt19937_64 rng(7);
+			std::ostringstream text;
+			for (size_t i = 0; i < 900000; i++)
+			{
+				const IPAddressV4 addr4 = details::AddressKey<IPAddressV4>::toAddress(static_cast<uint32_t>(rng()));
+				text << IPNetwork(addr4, static_cast<uint8_t>(8 + rng() % 17)).getString() << " AS" << (rng() % 70000) << "\n";
+				mQueriesV4.push_back(details::AddressKey<IPAddressV4>::toAddress(static_cast<uint32_t>(rng())));
+			}
+			for (size_t i = 0; i < 200000; i++)
+			{
+				const details::Uint128 key{ 0x2000000000000000 | (rng() >> 3), rng() };
+				const IPAddressV6 addr6 = details::AddressKey<IPAddressV6>::toAddress(key);
+				text << IPNetwork(addr6, static_cast<uint8_t>(19 + rng() % 30)).getString() << " AS" << (rng() % 70000) << "\n";
+				mQueriesV6.push_back(addr6);
+			}
+			mText = text.str();
+			std::istringstream lines(mText);
+			PrefixDatabaseBuilder builder;
+			builder.addLines(lines);
+			char path[] = "/tmp/ipaddress_prefixes_XXXXXX";
+			close(mkstemp(path));
+			mPath = path;
+			builder.write(mPath);
+		}
+		~Fixture() { unlink(mPath.c_str()); }
+
+		const std::string& getPath() const { return mPath; }
+		const std::string& getText() const { return mText; }
+		const std::vector<IPAddressV4>& getQueriesV4() const { return mQueriesV4; }
+		const std::vector<IPAddressV6>& getQueriesV6() const { return mQueriesV6; }
+	private:
+		std::string mPath;
+		std::string mText;
+		std::vector<IPAddressV4> mQueriesV4;
+		std::vector<IPAddressV6> mQueriesV6;
+	};
+
+	const Fixture& getFixture()
+	{
+		static Fixture fixture;
+		return fixture;
+	}
+
+	void dropPageCache(const std::string& path)
+	{
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd >= 0)
+		{
+			fdatasync(fd);
+			posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+			close(fd);
+		}
+	}
+}
+
+static void BM_PrefixDatabaseFirstQuery(benchmark::State& state)
+{
+	const Fixture& fixture = getFixture();
+	const bool cold = state.range(0) != 0;
+	std::string_view value;
+	for (auto _ : state)
+	{
+		if (cold)
+		{
+			state.PauseTiming();
+			dropPageCache(fixture.getPath());
+			state.ResumeTiming();
+		}
+		PrefixDatabase database(fixture.getPath());
+		benchmark::DoNotOptimize(database.lookup(fixture.getQueriesV4()[0], value));
+	}
+	state.SetLabel(cold ? "page cache dropped" : "page cache warm");
+}
+BENCHMARK(BM_PrefixDatabaseFirstQuery)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+static void BM_PrefixDatabaseFirstQueryFromText(benchmark::State& state)
+{
+	const Fixture& fixture = getFixture();
+	for (auto _ : state)
+	{
+		std::istringstream lines(fixture.getText());
+		PrefixDatabaseBuilder builder;
+		builder.addLines(lines);
+		const std::vector<uint8_t> data = builder.build();
+		PrefixDatabase database(Span<const uint8_t>(data.data(), data.size()));
+		std::string_view value;
+		benchmark::DoNotOptimize(database.lookup(fixture.getQueriesV4()[0], value));
+	}
+}
+BENCHMARK(BM_PrefixDatabaseFirstQueryFromText)->Unit(benchmark::kMillisecond)->Iterations(1);
+
+static void BM_PrefixDatabaseLookupV4(benchmark::State& state)
+{
+	const Fixture& fixture = getFixture();
+	const PrefixDatabase database(fixture.getPath());
+	const std::vector<IPAddressV4>& queries = fixture.getQueriesV4();
+	std::string_view value;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(database.lookup(queries[i++ % queries.size()], value));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PrefixDatabaseLookupV4);
+
+static void BM_PrefixDatabaseLookupV6(benchmark::State& state)
+{
+	const Fixture& fixture = getFixture();
+	const PrefixDatabase database(fixture.getPath());
+	const std::vector<IPAddressV6>& queries = fixture.getQueriesV6();
+	std::string_view value;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(database.lookup(queries[i++ % queries.size()], value));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PrefixDatabaseLookupV6);
+
+static void BM_PrefixDatabaseVerify(benchmark::State& state)
+{
+	const PrefixDatabase database(getFixture().getPath());
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(database.verify());
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * database.getSize()));
+	state.SetLabel(std::to_string(database.getSize() >> 20) + " MiB");
+}
+BENCHMARK(BM_PrefixDatabaseVerify)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "PrefixLookupService.h"
+#include "util/RcuPointer.h"
+using namespace ip_address;
+
+/*
+ * Lookups of 256 cached addresses in a 100k prefix database, so the synchronization shows, through
+ * PrefixLookupService readers with and without a reload every millisecond against pinning each lookup with
+ * an RcuPointer read guard.
+ */
+namespace
+{
+	struct Data
+	{
+		std::vector<uint8_t> database;
+		std::vector<IPAddressV4> queries;
+	};
+
+	const Data& getData()
+	{
+		static const Data data = []()
+		{
+			Data result;
+			std::mt19937 rng(42);
+			PrefixDatabaseBuilder builder;
+			for (size_t i = 0; i < 100000; i++)
+			{
+				const IPAddressV4 addr4 = details::AddressKey<IPAddressV4>::toAddress(static_cast<uint32_t>(rng()));
+				builder.add(IPNetwork(addr4, static_cast<uint8_t>(12 + rng() % 13)), "AS" + std::to_string(rng() % 70000));
+				result.queries.push_back(addr4);
+			}
+			result.database = builder.build();
+			return result;
+		}();
+		return data;
+	}
+
+	std::unique_ptr<PrefixDatabase> loadDatabase()
+	{
+		return std::make_unique<PrefixDatabase>(getData().database);
+	}
+
+	/*
+	 * One service per run, created before and destroyed after the threads of the run.
+	 */
+	std::unique_ptr<PrefixLookupService> gService;
+
+	void startService(const benchmark::State& state)
+	{
+		gService = std::make_unique<PrefixLookupService>(loadDatabase, std::chrono::milliseconds(state.range(0)));
+	}
+
+	void stopService(const benchmark::State&)
+	{
+		gService.reset();
+	}
+
+	details::RcuPointer<PrefixDatabase>& getRcuPointer()
+	{
+		static details::RcuPointer<PrefixDatabase> pointer(loadDatabase());
+		return pointer;
+	}
+}
+
+static void BM_PrefixLookupServiceLookup(benchmark::State& state)
+{
+	PrefixLookupService& service = *gService;
+	PrefixLookupService::Reader reader(service);
+	const std::vector<IPAddressV4>& queries = getData().queries;
+	const uint64_t generation = service.getGeneration();
+	std::string_view value;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(reader.lookup(queries[i++ & 255], value));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+	if (state.thread_index() == 0)
+		state.counters["reloads"] = static_cast<double>(service.getGeneration() - generation);
+}
+BENCHMARK(BM_PrefixLookupServiceLookup)->ArgName("reloadMs")->Arg(0)->Arg(1)->ThreadRange(1, 8)->UseRealTime()
+	->Setup(startService)->Teardown(stopService);
+
+static void BM_PrefixLookupRcuLookup(benchmark::State& state)
+{
+	details::RcuPointer<PrefixDatabase>& pointer = getRcuPointer();
+	const std::vector<IPAddressV4>& queries = getData().queries;
+	std::string_view value;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const auto database = pointer.read();
+		benchmark::DoNotOptimize(database->lookup(queries[i++ & 255], value));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PrefixLookupRcuLookup)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,174 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <string_view>
+#include <vector>
+#include "Corpus.h"
+#include "Literals.h"
+#include "PrefixDatabase.h"
+#include "PrefixSet.h"
+using namespace ip_address;
+using namespace ip_address::literals;
+
+/*
+ * Membership in a deny list built by the compiler against the same list built at runtime: sorted ranges with
+ * std::upper_bound, a PrefixDatabase and a loop over IPNetwork::contains. Arg 0 is the 6 network list that
+ * PrefixSet searches linearly, arg 1 the 36 network list that it searches with a binary search. Half of the
+ * queries are inside a listed network.
+ */
+namespace
+{
+	constexpr IPNetwork kSmall[] = { "192.168.0.0/16"_net, "10.0.0.0/8"_net, "172.16.0.0/12"_net, "fc00::/7"_net,
+		"100.64.0.0/10"_net, "fe80::/10"_net };
+	constexpr auto kSmallSet = makePrefixSet<kSmall>();
+
+	constexpr IPNetwork kLarge[] = { "1.0.0.0/24"_net, "1.0.1.0/24"_net, "1.0.2.0/23"_net, "5.5.5.5"_net,
+		"8.8.8.0/24"_net, "9.0.0.0/8"_net, "9.128.0.0/9"_net, "20.0.0.0/7"_net, "23.0.0.0/8"_net, "31.13.64.0/18"_net,
+		"45.0.0.0/16"_net, "64.233.160.0/19"_net, "66.102.0.0/20"_net, "100.64.0.0/10"_net, "127.0.0.0/8"_net,
+		"169.254.0.0/16"_net, "192.0.2.0/24"_net, "198.18.0.0/15"_net, "203.0.113.0/24"_net, "224.0.0.0/4"_net,
+		"240.0.0.0/4"_net, "0.0.0.0/32"_net, "2001:db8::/32"_net, "2001:db9::/32"_net, "2001::/23"_net,
+		"2002::/16"_net, "2400:cb00::/32"_net, "2606:4700::/32"_net, "2a03:2880::/32"_net, "64:ff9b::/96"_net,
+		"::1"_net, "::"_net, "fe80::/10"_net, "ff00::/8"_net, "100::/64"_net, "3fff::/20"_net };
+	constexpr auto kLargeSet = makePrefixSet<kLarge>();
+
+	std::vector<IPNetwork> getNetworks(int64_t list)
+	{
+		if (list == 0)
+			return std::vector<IPNetwork>(std::begin(kSmall), std::end(kSmall));
+		return std::vector<IPNetwork>(std::begin(kLarge), std::end(kLarge));
+	}
+
+	std::vector<IPAddress> getQueries(int64_t list)
+	{
+		std::vector<IPAddress> queries = corpus::makeAddresses(corpus::kMixed, 0);
+		const std::vector<IPNetwork> networks = getNetworks(list);
+		for (size_t i = 0; i < queries.size(); i += 2)
+		{
+			//network address with the host bits of the random address
+			const IPNetwork& network = networks[i / 2 % networks.size()];
+			const IPAddress& host = queries[i];
+			ByteArray16 bytes = network.getAddress().getIPv6().bytes();
+			const size_t size = network.getVersion() == IPVersion::kIPv4 ? 4 : 16;
+			for (size_t j = network.getPrefixLength() / 8; j < size; j++)
+			{
+				const uint8_t random = host.isIPv4() ? host.getIPv4().bytes()[j % 4] : host.getIPv6().bytes()[j];
+				const auto keep = static_cast<uint8_t>(j * 8 < network.getPrefixLength() ?
+					0xFF << (8 - network.getPrefixLength() % 8) : 0);
+				bytes[j] = static_cast<uint8_t>((bytes[j] & keep) | (random & ~keep));
+			}
+			if (size == 4)
+				queries[i] = IPAddress(ByteArray4{ bytes[0], bytes[1], bytes[2], bytes[3] });
+			else
+				queries[i] = IPAddress(bytes);
+		}
+		return queries;
+	}
+
+	template <typename Address>
+	class RuntimeSet
+	{
+	public:
+		using AddressKey = details::AddressKey<Address>;
+		using Key = typename AddressKey::Key;
+
+		void add(const Address& addr, uint8_t prefixLength)
+		{
+			const Key first = AddressKey::toKey(addr);
+			mRanges.push_back({ first, details::getPrefixLast(first, prefixLength) });
+		}
+
+		void build()
+		{
+			std::sort(mRanges.begin(), mRanges.end(), [](const auto& lhs, const auto& rhs) { return lhs.mFirst < rhs.mFirst; });
+			std::vector<details::PrefixRange<Key>> merged;
+			for (const auto& range : mRanges)
+			{
+				if (!merged.empty() && !(merged.back().mLast < range.mFirst))
+					merged.back().mLast = merged.back().mLast < range.mLast ? range.mLast : merged.back().mLast;
+				else
+					merged.push_back(range);
+			}
+			mRanges = std::move(merged);
+		}
+
+		bool contains(const Address& addr) const noexcept
+		{
+			const Key key = AddressKey::toKey(addr);
+			const auto it = std::upper_bound(mRanges.begin(), mRanges.end(), key,
+				[](const Key& lhs, const details::PrefixRange<Key>& rhs) { return lhs < rhs.mFirst; });
+			return it != mRanges.begin() && !((it - 1)->mLast < key);
+		}
+	private:
+		std::vector<details::PrefixRange<Key>> mRanges;
+	};
+}
+
+static void BM_PrefixSetStatic(benchmark::State& state)
+{
+	const std::vector<IPAddress> queries = getQueries(state.range(0));
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const IPAddress& addr = queries[i++ % corpus::kSize];
+		benchmark::DoNotOptimize(state.range(0) == 0 ? kSmallSet.contains(addr) : kLargeSet.contains(addr));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PrefixSetStatic)->Arg(0)->Arg(1);
+
+static void BM_PrefixSetRuntimeRanges(benchmark::State& state)
+{
+	const std::vector<IPAddress> queries = getQueries(state.range(0));
+	RuntimeSet<IPAddressV4> set4;
+	RuntimeSet<IPAddressV6> set6;
+	for (const IPNetwork& network : getNetworks(state.range(0)))
+	{
+		if (network.getVersion() == IPVersion::kIPv4)
+			set4.add(network.getAddress().getIPv4(), network.getPrefixLength());
+		else
+			set6.add(network.getAddress().getIPv6(), network.getPrefixLength());
+	}
+	set4.build();
+	set6.build();
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const IPAddress& addr = queries[i++ % corpus::kSize];
+		benchmark::DoNotOptimize(addr.isIPv4() ? set4.contains(addr.asIPv4()) : set6.contains(addr.asIPv6()));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PrefixSetRuntimeRanges)->Arg(0)->Arg(1);
+
+static void BM_PrefixSetRuntimeDatabase(benchmark::State& state)
+{
+	const std::vector<IPAddress> queries = getQueries(state.range(0));
+	PrefixDatabaseBuilder builder;
+	for (const IPNetwork& network : getNetworks(state.range(0)))
+	{
+		builder.add(network, "deny");
+	}
+	const PrefixDatabase database(builder.build());
+	std::string_view value;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(database.lookup(queries[i++ % corpus::kSize], value));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PrefixSetRuntimeDatabase)->Arg(0)->Arg(1);
+
+static void BM_PrefixSetRuntimeLinear(benchmark::State& state)
+{
+	const std::vector<IPAddress> queries = getQueries(state.range(0));
+	const std::vector<IPNetwork> networks = getNetworks(state.range(0));
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		const IPAddress& addr = queries[i++ % corpus::kSize];
+		benchmark::DoNotOptimize(std::any_of(networks.begin(), networks.end(),
+			[&addr](const IPNetwork& network) { return network.contains(addr); }));
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_PrefixSetRuntimeLinear)->Arg(0)->Arg(1);
@@ -0,0 +1,110 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "ReverseName.h"
+using namespace ip_address;
+
+/*
+ * PTR names for 4096 random addresses per family, the table based writers against getString() concatenation.
+ */
+namespace
+{
+	constexpr size_t kCount = 4096;
+
+	const std::vector<IPAddressV4>& getAddressesV4()
+	{
+		static const std::vector<IPAddressV4> addresses = []()
+		{
+			std::mt19937_64 rng(37);
+			std::vector<IPAddressV4> result;
+			for (size_t i = 0; i < kCount; i++)
+			{
+				const uint64_t r = rng();
+				result.emplace_back(ByteArray4{ static_cast<uint8_t>(r), static_cast<uint8_t>(r >> 8),
+				                                static_cast<uint8_t>(r >> 16), static_cast<uint8_t>(r >> 24) });
+			}
+			return result;
+		}();
+		return addresses;
+	}
+
+	const std::vector<IPAddressV6>& getAddressesV6()
+	{
+		static const std::vector<IPAddressV6> addresses = []()
+		{
+			std::mt19937_64 rng(37);
+			std::vector<IPAddressV6> result;
+			for (size_t i = 0; i < kCount; i++)
+			{
+				ByteArray16 bytes;
+				for (auto& byte : bytes)
+					byte = static_cast<uint8_t>(rng());
+				result.emplace_back(bytes);
+			}
+			return result;
+		}();
+		return addresses;
+	}
+}
+
+static void BM_ReverseNameV4(benchmark::State& state)
+{
+	const auto& addresses = getAddressesV4();
+	std::vector<char> buffer(kCount * (kMaxReverseNameLengthV4 + 1));
+	std::vector<uint32_t> offsets(kCount);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(to_reverse_names(Span<const IPAddressV4>(addresses.data(), kCount), buffer.data(), offsets.data()));
+	}
+	state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_ReverseNameV4);
+
+static void BM_ReverseNameV4String(benchmark::State& state)
+{
+	auto addresses = getAddressesV4();
+	for (auto _ : state)
+	{
+		for (auto& addr : addresses)
+		{
+			const ByteArray4& bytes = addr.bytes();
+			std::string name = std::to_string(bytes[3]) + "." + std::to_string(bytes[2]) + "." + std::to_string(bytes[1]) +
+				"." + std::to_string(bytes[0]) + ".in-addr.arpa";
+			benchmark::DoNotOptimize(name.data());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_ReverseNameV4String);
+
+static void BM_ReverseNameV6(benchmark::State& state)
+{
+	const auto& addresses = getAddressesV6();
+	std::vector<char> buffer(kCount * (kMaxReverseNameLengthV6 + 1));
+	std::vector<uint32_t> offsets(kCount);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(to_reverse_names(Span<const IPAddressV6>(addresses.data(), kCount), buffer.data(), offsets.data()));
+	}
+	state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_ReverseNameV6);
+
+static void BM_ReverseNameParseV6(benchmark::State& state)
+{
+	const auto& addresses = getAddressesV6();
+	std::vector<char> buffer(kCount * (kMaxReverseNameLengthV6 + 1));
+	std::vector<uint32_t> offsets(kCount);
+	to_reverse_names(Span<const IPAddressV6>(addresses.data(), kCount), buffer.data(), offsets.data());
+	IPAddressV6 addr6;
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < kCount; i++)
+		{
+			benchmark::DoNotOptimize(from_reverse_name(std::string_view(buffer.data() + offsets[i], kMaxReverseNameLengthV6), addr6));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_ReverseNameParseV6);
@@ -1,6 +1,3 @@
-#include "Include.h"
+#include <benchmark/benchmark.h>
 
-int main(int argc, char** argv)
-{
-	
-}
\ No newline at end of file
+BENCHMARK_MAIN();
\ No newline at end of file
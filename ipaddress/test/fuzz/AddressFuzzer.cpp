@@ -0,0 +1,112 @@
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "AddressScanner.h"
+#include "IPAddress.h"
+#include "Literals.h"
+using namespace ip_address;
+
+/*
+ * Differential fuzz target, the library parsers and formatters must agree with inet_pton and inet_ntop on
+ * every input. A divergence aborts, which libFuzzer and the replay driver report as a failure.
+ *
+ * The input up to its first NUL is parsed as text by every parser, including the constexpr parsers of the
+ * address literals. The string parsers of the address types fall back to getaddrinfo for text that is not a
+ * literal, they are only given literals inet_pton accepts so the target never resolves names. The first 4 and 16 input bytes and every parsed address are formatted.
+ */
+namespace
+{
+	void check(bool condition, const char* what, const std::string& text)
+	{
+		if (condition)
+			return;
+		fprintf(stderr, "divergence from the system library: %s, input \"%s\"\n", what, text.c_str());
+		abort();
+	}
+
+	void checkFormat(const ByteArray4& bytes)
+	{
+		char expected[INET_ADDRSTRLEN];
+		inet_ntop(AF_INET, bytes.data(), expected, sizeof(expected));
+		const IPAddressV4 addr4(bytes);
+		check(addr4.getString() == expected, "IPAddressV4::getString", expected);
+		check(IPAddress(bytes).getString() == expected, "IPAddress::getString", expected);
+		IPAddressV4 parsed;
+		check(AddressScanner::parseIPv4(expected, parsed) && parsed == addr4, "IPAddressV4 round trip", expected);
+	}
+
+	void checkFormat(const ByteArray16& bytes)
+	{
+		char expected[INET6_ADDRSTRLEN];
+		inet_ntop(AF_INET6, bytes.data(), expected, sizeof(expected));
+		const IPAddressV6 addr6(bytes);
+		check(addr6.getString() == expected, "IPAddressV6::getString", expected);
+		check(IPAddress(bytes).getString() == expected, "IPAddress::getString", expected);
+		IPAddressV6 parsed;
+		check(AddressScanner::parseIPv6(expected, parsed) && parsed == addr6, "IPAddressV6 round trip", expected);
+	}
+
+	void checkParse(const std::string& text)
+	{
+		ByteArray4 expected4;
+		ByteArray16 expected6;
+		const bool valid4 = inet_pton(AF_INET, text.c_str(), expected4.data()) == 1;
+		const bool valid6 = inet_pton(AF_INET6, text.c_str(), expected6.data()) == 1;
+
+		IPAddressV4 scanned4;
+		check(AddressScanner::parseIPv4(text, scanned4) == valid4, "AddressScanner::parseIPv4 result", text);
+		IPAddressV6 scanned6;
+		check(AddressScanner::parseIPv6(text, scanned6) == valid6, "AddressScanner::parseIPv6 result", text);
+		IPAddress scanned;
+		check(AddressScanner::parse(text, scanned) == (valid4 || valid6), "AddressScanner::parse result", text);
+		ByteArray4 literal4 = {};
+		check(details::parseLiteralV4(text.data(), text.size(), literal4) == valid4, "literal IPv4 result", text);
+		ByteArray16 literal6 = {};
+		check(details::parseLiteralV6(text.data(), text.size(), literal6) == valid6, "literal IPv6 result", text);
+		if (valid4)
+		{
+			check(literal4 == expected4, "literal IPv4 value", text);
+			check(scanned4 == IPAddressV4(expected4), "AddressScanner::parseIPv4 value", text);
+			IPAddressV4 addr4;
+			check(IPAddressV4::parseIPAddressV4(addr4, text) && addr4 == IPAddressV4(expected4),
+			      "IPAddressV4::parseIPAddressV4", text);
+			//inet_pton only accepts the canonical dotted decimal form
+			check(addr4.getString() == text, "IPAddressV4 text round trip", text);
+			checkFormat(expected4);
+		}
+		if (valid6)
+		{
+			check(literal6 == expected6, "literal IPv6 value", text);
+			check(scanned6 == IPAddressV6(expected6), "AddressScanner::parseIPv6 value", text);
+			IPAddressV6 addr6;
+			check(IPAddressV6::parseIPAddressV6(addr6, text) && addr6 == IPAddressV6(expected6),
+			      "IPAddressV6::parseIPAddressV6", text);
+			checkFormat(expected6);
+		}
+		if (valid4 || valid6)
+		{
+			const IPAddress expected = valid4 ? IPAddress(expected4) : IPAddress(expected6);
+			check(scanned == expected, "AddressScanner::parse value", text);
+			IPAddress addr;
+			check(IPAddress::parseIPAddress(addr, text) && addr == expected, "IPAddress::parseIPAddress", text);
+		}
+	}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	if (size >= 4)
+		checkFormat(ByteArray4{ data[0], data[1], data[2], data[3] });
+	if (size >= 16)
+	{
+		ByteArray16 bytes;
+		memcpy(bytes.data(), data, bytes.size());
+		checkFormat(bytes);
+	}
+	const auto* text = reinterpret_cast<const char*>(data);
+	checkParse(std::string(text, strnlen(text, size)));
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+/*
+ * Stand-in for the libFuzzer driver on compilers without -fsanitize=fuzzer: runs the target once on every
+ * file and every file in a directory given as argument. Options starting with '-' are ignored, so the same
+ * command line works with either driver.
+ */
+int main(int argc, char** argv)
+{
+	std::vector<std::filesystem::path> paths;
+	for (int i = 1; i < argc; i++)
+	{
+		if (argv[i][0] == '-')
+			continue;
+		const std::filesystem::path path(argv[i]);
+		if (std::filesystem::is_directory(path))
+		{
+			for (const auto& entry : std::filesystem::directory_iterator(path))
+			{
+				if (entry.is_regular_file())
+					paths.push_back(entry.path());
+			}
+		}
+		else
+		{
+			paths.push_back(path);
+		}
+	}
+	std::sort(paths.begin(), paths.end());
+	for (const std::filesystem::path& path : paths)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			fprintf(stderr, "can not open %s\n", path.c_str());
+			return 1;
+		}
+		const std::vector<char> input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+	}
+	printf("replayed %zu inputs\n", paths.size());
+	return 0;
+}
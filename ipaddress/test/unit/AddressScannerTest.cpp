@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "AddressScanner.h"
+using namespace ip_address;
+
+namespace
+{
+	std::vector<std::string> getMatchTexts(std::string_view text, const std::vector<AddressMatch>& matches)
+	{
+		std::vector<std::string> texts;
+		for (const AddressMatch& match : matches)
+		{
+			texts.emplace_back(text.substr(match.offset, match.length));
+		}
+		return texts;
+	}
+
+	bool isSame(const std::vector<AddressMatch>& lhs, const std::vector<AddressMatch>& rhs)
+	{
+		if (lhs.size() != rhs.size())
+			return false;
+		for (size_t i = 0; i < lhs.size(); i++)
+		{
+			if (lhs[i].offset != rhs[i].offset || lhs[i].length != rhs[i].length || lhs[i].address != rhs[i].address)
+				return false;
+		}
+		return true;
+	}
+
+	std::string makeLog(size_t lines)
+	{
+		std::mt19937 rng(43);
+		std::string text;
+		char buffer[INET6_ADDRSTRLEN];
+		for (size_t i = 0; i < lines; i++)
+		{
+			const uint32_t addr4 = htonl(static_cast<uint32_t>(rng()));
+			inet_ntop(AF_INET, &addr4, buffer, sizeof(buffer));
+			text += "2024-05-01T12:30:" + std::to_string(i % 60) + ".123 conn from " + buffer + ":" +
+				std::to_string(rng() % 65536) + " to ";
+			uint8_t addr6[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+			for (size_t b = 4; b < 16; b++)
+			{
+				addr6[b] = static_cast<uint8_t>(rng() % 3 == 0 ? rng() : 0);
+			}
+			inet_ntop(AF_INET6, addr6, buffer, sizeof(buffer));
+			text += std::string("[") + buffer + "] v1.2.3 sha=deadbeef." + std::to_string(i) + "\n";
+		}
+		return text;
+	}
+}
+
+TEST(AddressScannerTest, ParseIPv4)
+{
+	const char* valid[] = { "0.0.0.0", "192.0.2.1", "255.255.255.255", "10.0.10.100" };
+	for (const char* text : valid)
+	{
+		IPAddressV4 addr4;
+		ASSERT_TRUE(AddressScanner::parseIPv4(text, addr4)) << text;
+		EXPECT_EQ(addr4, IPAddressV4(text)) << text;
+	}
+	const char* invalid[] = { "", "1.2.3", "1.2.3.4.5", "256.1.1.1", "01.2.3.4", "1..2.3", "1.2.3.4.", ".1.2.3.4",
+		"1.2.3.a", "1234.1.1.1", "1.2.3.-4", " 1.2.3.4" };
+	for (const char* text : invalid)
+	{
+		IPAddressV4 addr4;
+		EXPECT_FALSE(AddressScanner::parseIPv4(text, addr4)) << text;
+	}
+}
+
+TEST(AddressScannerTest, ParseIPv6)
+{
+	const char* texts[] = { "::", "::1", "1::", "2001:db8::1", "2001:DB8:0:0:8:800:200C:417A", "fe80::1:2:3:4:5:6",
+		"1:2:3:4:5:6:7::", "::ffff:192.0.2.1", "64:ff9b::192.0.2.33", "1:2:3:4:5:6:1.2.3.4", "1:2:3:4:5:6:7:8",
+		":", ":::", "1:::2", "1::2::3", ":1::", "1:2:3:4:5:6:7:8:9", "1:2:3:4:5:6:7", "12345::", "1:2:3:4:5:6:7:8::",
+		"::1.2.3", "::1.2.3.4:1", "1:2:3:4:5:6:7:1.2.3.4", "2001:db8::g", "fe80::1%eth0", "1:", "::01.2.3.4" };
+	for (const char* text : texts)
+	{
+		uint8_t expected[16];
+		const bool valid = inet_pton(AF_INET6, text, expected) == 1;
+		IPAddressV6 addr6;
+		ASSERT_EQ(AddressScanner::parseIPv6(text, addr6), valid) << text;
+		if (valid)
+		{
+			EXPECT_EQ(memcmp(addr6.bytes().data(), expected, 16), 0) << text;
+		}
+	}
+
+	std::mt19937 rng(6);
+	char buffer[INET6_ADDRSTRLEN];
+	for (size_t i = 0; i < 10000; i++)
+	{
+		uint8_t bytes[16] = {};
+		for (uint8_t& byte : bytes)
+		{
+			byte = static_cast<uint8_t>(rng() % 2 == 0 ? rng() : 0);
+		}
+		inet_ntop(AF_INET6, bytes, buffer, sizeof(buffer));
+		IPAddressV6 addr6;
+		ASSERT_TRUE(AddressScanner::parseIPv6(buffer, addr6)) << buffer;
+		EXPECT_EQ(memcmp(addr6.bytes().data(), bytes, 16), 0) << buffer;
+	}
+	IPAddress addr;
+	ASSERT_TRUE(AddressScanner::parse("2001:db8::1", addr));
+	EXPECT_TRUE(addr.isIPv6());
+	ASSERT_TRUE(AddressScanner::parse("192.0.2.1", addr));
+	EXPECT_TRUE(addr.isIPv4());
+	EXPECT_FALSE(AddressScanner::parse("localhost", addr));
+}
+
+TEST(AddressScannerTest, Scan)
+{
+	const std::string text =
+		"Jan 1 12:30:45 host sshd[42]: Failed password from 192.0.2.1 port 22.\n"
+		"GET http://198.51.100.7:8080/index.html from [2001:db8::1]:443 and fe80::1%eth0\n"
+		"client:203.0.113.9 peer=::ffff:192.0.2.200, next hop 2001:db8:0:1::2: unreachable\n"
+		"not addresses: v1.2.3.4 1.2.3.4.5 256.1.1.1 01.2.3.4 std::vector 00:11:22:33:44:55 10.0.0.1x\n"
+		"end 10.0.0.1.";
+	std::vector<AddressMatch> matches;
+	EXPECT_EQ(AddressScanner::scan(text, matches), 8u);
+	const std::vector<std::string> expected = { "192.0.2.1", "198.51.100.7", "2001:db8::1", "fe80::1", "203.0.113.9",
+		"::ffff:192.0.2.200", "2001:db8:0:1::2", "10.0.0.1" };
+	EXPECT_EQ(getMatchTexts(text, matches), expected);
+	for (const AddressMatch& match : matches)
+	{
+		IPAddress addr;
+		ASSERT_TRUE(AddressScanner::parse(text.substr(match.offset, match.length), addr));
+		EXPECT_EQ(match.address, addr);
+	}
+	matches.clear();
+	EXPECT_EQ(AddressScanner::scan("", matches), 0u);
+	EXPECT_EQ(AddressScanner::scan("1.2.3.4", matches), 1u);
+}
+
+TEST(AddressScannerTest, ScanParallel)
+{
+	const std::string text = makeLog(500);
+	std::vector<AddressMatch> expected;
+	EXPECT_EQ(AddressScanner::scan(text, expected), 1000u);
+	//small chunks split candidates at every possible position
+	for (size_t chunkSize = 1; chunkSize < 80; chunkSize += 3)
+	{
+		std::vector<AddressMatch> matches;
+		EXPECT_EQ(AddressScanner::scanParallel(text, matches, 4, chunkSize), expected.size());
+		EXPECT_TRUE(isSame(matches, expected)) << chunkSize;
+	}
+	std::vector<AddressMatch> matches;
+	AddressScanner::scanParallel(text, matches);
+	EXPECT_TRUE(isSame(matches, expected));
+}
+
+TEST(AddressScannerTest, ScanFile)
+{
+	const std::string text = makeLog(200);
+	char path[] = "/tmp/ipaddress_scan_XXXXXX";
+	const int fd = mkstemp(path);
+	ASSERT_GE(fd, 0);
+	ASSERT_EQ(write(fd, text.data(), text.size()), static_cast<ssize_t>(text.size()));
+	close(fd);
+	std::vector<AddressMatch> expected;
+	AddressScanner::scan(text, expected);
+	std::vector<AddressMatch> matches;
+	EXPECT_EQ(AddressScanner::scanFile(path, matches, 2), expected.size());
+	EXPECT_TRUE(isSame(matches, expected));
+	unlink(path);
+	EXPECT_THROW(AddressScanner::scanFile(path, matches), std::runtime_error);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "AddressSelection.h"
+using namespace ip_address;
+
+namespace
+{
+	std::vector<IPAddress> makeAddresses(std::initializer_list<const char*> texts)
+	{
+		std::vector<IPAddress> addresses;
+		for (const char* text : texts)
+		{
+			addresses.emplace_back(std::string(text));
+		}
+		return addresses;
+	}
+
+	IPAddress selectSource(std::initializer_list<const char*> sources, const char* destination)
+	{
+		IPAddress source;
+		EXPECT_TRUE(AddressSorter(makeAddresses(sources)).getSource(IPAddress(std::string(destination)), source));
+		return source;
+	}
+
+	std::vector<IPAddress> sortDestinations(std::initializer_list<const char*> sources,
+	                                        std::initializer_list<const char*> destinations)
+	{
+		std::vector<IPAddress> addresses = makeAddresses(destinations);
+		AddressSorter(makeAddresses(sources)).sort(addresses);
+		return addresses;
+	}
+}
+
+TEST(AddressSelectionTest, PolicyTable)
+{
+	EXPECT_EQ(AddressSorter::getPrecedence(IPAddress(std::string("::1"))), 50);
+	EXPECT_EQ(AddressSorter::getPrecedence(IPAddress(std::string("2001:db8::1"))), 40);
+	EXPECT_EQ(AddressSorter::getPrecedence(IPAddress(std::string("192.0.2.1"))), 35);
+	EXPECT_EQ(AddressSorter::getPrecedence(IPAddress(std::string("2002:c633:6401::1"))), 30);
+	EXPECT_EQ(AddressSorter::getPrecedence(IPAddress(std::string("2001:0:4136:e378::1"))), 5);
+	EXPECT_EQ(AddressSorter::getPrecedence(IPAddress(std::string("fd00::1"))), 3);
+	EXPECT_EQ(AddressSorter::getLabel(IPAddress(std::string("10.1.2.3"))), 4);
+	EXPECT_EQ(AddressSorter::getLabel(IPAddress(std::string("fec0::1"))), 11);
+	EXPECT_EQ(AddressSorter::getLabel(IPAddress(std::string("3ffe::1"))), 12);
+
+	EXPECT_EQ(AddressSorter::getScope(IPAddress(std::string("127.0.0.1"))), AddressSorter::kScopeLinkLocal);
+	EXPECT_EQ(AddressSorter::getScope(IPAddress(std::string("169.254.13.78"))), AddressSorter::kScopeLinkLocal);
+	EXPECT_EQ(AddressSorter::getScope(IPAddress(std::string("10.1.2.3"))), AddressSorter::kScopeGlobal);
+	EXPECT_EQ(AddressSorter::getScope(IPAddress(std::string("fe80::1"))), AddressSorter::kScopeLinkLocal);
+	EXPECT_EQ(AddressSorter::getScope(IPAddress(std::string("fec0::1"))), AddressSorter::kScopeSiteLocal);
+	EXPECT_EQ(AddressSorter::getScope(IPAddress(std::string("ff05::1"))), AddressSorter::kScopeSiteLocal);
+	EXPECT_EQ(AddressSorter::getScope(IPAddress(std::string("ff01::1"))), AddressSorter::kScopeInterfaceLocal);
+}
+
+//RFC 6724 section 10.1
+TEST(AddressSelectionTest, SourceSelection)
+{
+	EXPECT_EQ(selectSource({ "2001:db8:3::1", "fe80::1" }, "2001:db8:1::1"), IPAddress(std::string("2001:db8:3::1")));
+	EXPECT_EQ(selectSource({ "2001:db8:3::1", "fe80::1" }, "ff05::1"), IPAddress(std::string("2001:db8:3::1")));
+	EXPECT_EQ(selectSource({ "2001:db8:1::1", "fe80::2" }, "fe80::1"), IPAddress(std::string("fe80::2")));
+	EXPECT_EQ(selectSource({ "2001:db8:1::2", "2001:db8:1::1" }, "2001:db8:1::1"),
+	          IPAddress(std::string("2001:db8:1::1")));
+	EXPECT_EQ(selectSource({ "2002:c633:6401::2", "2001:db8:1::2" }, "2001:db8:1::1"),
+	          IPAddress(std::string("2001:db8:1::2")));
+	EXPECT_EQ(selectSource({ "2001:db8:1::2", "2002:c633:6401::2" }, "2002:c633:6401::1"),
+	          IPAddress(std::string("2002:c633:6401::2")));
+	EXPECT_EQ(selectSource({ "2001:db8:3::2", "2001:db8:1::2" }, "2001:db8:1::1"),
+	          IPAddress(std::string("2001:db8:1::2")));
+	EXPECT_EQ(selectSource({ "fe80::1", "10.1.2.4", "192.0.2.2" }, "192.0.2.1"), IPAddress(std::string("192.0.2.2")));
+
+	IPAddress source;
+	EXPECT_FALSE(AddressSorter(makeAddresses({ "fe80::1" })).getSource(IPAddress(std::string("10.0.0.1")), source));
+}
+
+//RFC 6724 section 10.2
+TEST(AddressSelectionTest, DestinationSelection)
+{
+	EXPECT_EQ(sortDestinations({ "2001:db8:1::2", "fe80::1", "169.254.13.78" }, { "198.51.100.121", "2001:db8:1::1" }),
+	          makeAddresses({ "2001:db8:1::1", "198.51.100.121" }));
+	EXPECT_EQ(sortDestinations({ "fe80::1", "198.51.100.117" }, { "2001:db8:1::1", "198.51.100.121" }),
+	          makeAddresses({ "198.51.100.121", "2001:db8:1::1" }));
+	EXPECT_EQ(sortDestinations({ "2001:db8:1::2", "fe80::1", "10.1.2.4" }, { "10.1.2.3", "2001:db8:1::1" }),
+	          makeAddresses({ "2001:db8:1::1", "10.1.2.3" }));
+	EXPECT_EQ(sortDestinations({ "2001:db8:1::2", "fe80::2" }, { "2001:db8:1::1", "fe80::1" }),
+	          makeAddresses({ "fe80::1", "2001:db8:1::1" }));
+	EXPECT_EQ(sortDestinations({ "2001:db8:1::2", "2001:db8:3f44::2", "fe80::2" },
+	                           { "2001:db8:3ffe::1", "2001:db8:1::1" }),
+	          makeAddresses({ "2001:db8:1::1", "2001:db8:3ffe::1" }));
+	EXPECT_EQ(sortDestinations({ "2002:c633:6401::2", "fe80::2" }, { "2001:db8:1::1", "2002:c633:6401::1" }),
+	          makeAddresses({ "2002:c633:6401::1", "2001:db8:1::1" }));
+	EXPECT_EQ(sortDestinations({ "2002:c633:6401::2", "2001:db8:1::2", "fe80::2" },
+	                           { "2002:c633:6401::1", "2001:db8:1::1" }),
+	          makeAddresses({ "2001:db8:1::1", "2002:c633:6401::1" }));
+	EXPECT_EQ(sortDestinations({ "2001:db8:1::2", "10.1.2.4", "fe80::2" }, { "10.1.2.3", "2001:db8:1::1", "fe80::1" }),
+	          makeAddresses({ "fe80::1", "2001:db8:1::1", "10.1.2.3" }));
+}
+
+TEST(AddressSelectionTest, Endpoints)
+{
+	std::vector<IPEndPoint> endpoints = { IPEndPoint("192.0.2.1", port_host_byte_order_t(80)),
+	                                      IPEndPoint("2001:db8::1", port_host_byte_order_t(443)),
+	                                      IPEndPoint("10.0.0.1", port_host_byte_order_t(8080)) };
+	AddressSorter(makeAddresses({ "2001:db8::2", "192.0.2.2" })).sort(endpoints);
+	ASSERT_EQ(endpoints.size(), 3u);
+	EXPECT_EQ(endpoints[0], IPEndPoint("2001:db8::1", port_host_byte_order_t(443)));
+	//equal keys keep their order
+	EXPECT_EQ(endpoints[1], IPEndPoint("192.0.2.1", port_host_byte_order_t(80)));
+	EXPECT_EQ(endpoints[2], IPEndPoint("10.0.0.1", port_host_byte_order_t(8080)));
+
+	//without sources nothing is usable, the later rules still order by precedence
+	std::vector<IPAddress> addresses = makeAddresses({ "192.0.2.1", "fe80::1", "::1" });
+	AddressSorter(std::vector<IPAddress>()).sort(addresses);
+	EXPECT_EQ(addresses, makeAddresses({ "::1", "fe80::1", "192.0.2.1" }));
+}
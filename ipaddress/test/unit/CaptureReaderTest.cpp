@@ -0,0 +1,329 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "CaptureReader.h"
+using namespace ip_address;
+
+namespace
+{
+	class CaptureFile
+	{
+	public:
+		CaptureFile()
+		{
+			char path[] = "/tmp/ipaddress_capture_XXXXXX";
+			const int fd = mkstemp(path);
+			close(fd);
+			mPath = path;
+		}
+		~CaptureFile() { unlink(mPath.c_str()); }
+
+		void append32(uint32_t value, bool swapped = false)
+		{
+			if (swapped)
+				value = ByteSwap(value);
+			append(&value, sizeof(value));
+		}
+		void append16(uint16_t value)
+		{
+			append(&value, sizeof(value));
+		}
+		void append(const void* data, size_t size)
+		{
+			const auto* bytes = static_cast<const uint8_t*>(data);
+			mBytes.insert(mBytes.end(), bytes, bytes + size);
+		}
+		void append(const std::vector<uint8_t>& data) { mBytes.insert(mBytes.end(), data.begin(), data.end()); }
+		void pad() { mBytes.resize((mBytes.size() + 3) & ~size_t(3), 0); }
+		size_t size() const { return mBytes.size(); }
+		void truncate(size_t size) { mBytes.resize(size); }
+
+		const std::string& write()
+		{
+			FILE* file = fopen(mPath.c_str(), "wb");
+			fwrite(mBytes.data(), 1, mBytes.size(), file);
+			fclose(file);
+			return mPath;
+		}
+	private:
+		std::string mPath;
+		std::vector<uint8_t> mBytes;
+	};
+
+	std::vector<uint8_t> makeUdpPacket(uint8_t lastSourceByte, uint16_t sourcePort)
+	{
+		std::vector<uint8_t> packet(28, 0);
+		packet[0] = 0x45;
+		packet[9] = IPPROTO_UDP;
+		const uint8_t addresses[8] = { 10, 0, 0, lastSourceByte, 10, 0, 0, 254 };
+		memcpy(&packet[12], addresses, sizeof(addresses));
+		packet[20] = static_cast<uint8_t>(sourcePort >> 8);
+		packet[21] = static_cast<uint8_t>(sourcePort);
+		packet[23] = 53;
+		return packet;
+	}
+
+	std::vector<uint8_t> makeEthernet(const std::vector<uint8_t>& packet, uint16_t etherType, bool vlan)
+	{
+		std::vector<uint8_t> frame(12, 0xEE);
+		if (vlan)
+		{
+			const uint8_t tag[4] = { 0x81, 0x00, 0x00, 0x2A };
+			frame.insert(frame.end(), tag, tag + 4);
+		}
+		frame.push_back(static_cast<uint8_t>(etherType >> 8));
+		frame.push_back(static_cast<uint8_t>(etherType));
+		frame.insert(frame.end(), packet.begin(), packet.end());
+		return frame;
+	}
+
+	void appendPcapHeader(CaptureFile& file, uint32_t magic, uint32_t linkType, bool swapped)
+	{
+		file.append32(magic, swapped);
+		file.append32(swapped ? 0x04000200 : 0x00040002);
+		file.append32(0);
+		file.append32(0);
+		file.append32(65535, swapped);
+		file.append32(linkType, swapped);
+	}
+
+	void appendPcapRecord(CaptureFile& file, uint32_t seconds, uint32_t fraction, const std::vector<uint8_t>& data,
+	                      bool swapped = false)
+	{
+		file.append32(seconds, swapped);
+		file.append32(fraction, swapped);
+		file.append32(static_cast<uint32_t>(data.size()), swapped);
+		file.append32(static_cast<uint32_t>(data.size()), swapped);
+		file.append(data);
+	}
+}
+
+TEST(CaptureReaderTest, Pcap)
+{
+	CaptureFile file;
+	appendPcapHeader(file, 0xA1B2C3D4, 1, false);
+	appendPcapRecord(file, 1700000000, 250000, makeEthernet(makeUdpPacket(1, 1000), 0x0800, false));
+	appendPcapRecord(file, 1700000001, 0, makeEthernet(std::vector<uint8_t>(28, 0), 0x0806, false)); //ARP
+	appendPcapRecord(file, 1700000002, 999999, makeEthernet(makeUdpPacket(2, 2000), 0x0800, true));
+	const size_t complete = file.size();
+	appendPcapRecord(file, 1700000003, 0, makeEthernet(makeUdpPacket(3, 3000), 0x0800, false));
+	file.truncate(complete + 20);
+
+	CaptureReader reader(file.write());
+	EXPECT_EQ(reader.getFormat(), CaptureFormat::kPcap);
+	CaptureRecord records[8];
+	ASSERT_EQ(reader.readBatch(records, 8), 2u);
+	EXPECT_EQ(records[0].timestamp, 1700000000250000000ull);
+	EXPECT_EQ(records[0].source, IPEndPoint(IPAddressV4("10.0.0.1"), port_host_byte_order_t(1000)));
+	EXPECT_EQ(records[0].destination, IPEndPoint(IPAddressV4("10.0.0.254"), port_host_byte_order_t(53)));
+	EXPECT_EQ(records[0].protocol, IPPROTO_UDP);
+	EXPECT_EQ(records[0].packet.size(), 28u);
+	EXPECT_EQ(records[1].timestamp, 1700000002999999000ull);
+	EXPECT_EQ(records[1].source.getPort(), 2000);
+	//the truncated last record ends the stream
+	EXPECT_EQ(reader.readBatch(records, 8), 0u);
+
+	reader.rewind();
+	EXPECT_EQ(reader.readBatch(records, 1), 1u);
+	EXPECT_EQ(reader.readBatch(records, 8), 1u);
+}
+
+TEST(CaptureReaderTest, PcapSwappedNanoseconds)
+{
+	CaptureFile file;
+	appendPcapHeader(file, 0xA1B23C4D, 101, true);
+	appendPcapRecord(file, 5, 123456789, makeUdpPacket(7, 7000), true);
+	CaptureReader reader(file.write());
+	CaptureRecord record;
+	ASSERT_EQ(reader.readBatch(&record, 1), 1u);
+	EXPECT_EQ(record.timestamp, 5123456789ull);
+	EXPECT_EQ(record.source.getPort(), 7000);
+}
+
+TEST(CaptureReaderTest, PcapNg)
+{
+	CaptureFile file;
+	//section header
+	file.append32(0x0A0D0D0A);
+	file.append32(28);
+	file.append32(0x1A2B3C4D);
+	file.append16(1);
+	file.append16(0);
+	file.append32(0xFFFFFFFF);
+	file.append32(0xFFFFFFFF);
+	file.append32(28);
+	//interface 0: ethernet, default microseconds
+	file.append32(1);
+	file.append32(20);
+	file.append16(1);
+	file.append16(0);
+	file.append32(0);
+	file.append32(20);
+	//interface 1: raw IP, if_tsresol 9 (nanoseconds)
+	file.append32(1);
+	file.append32(32);
+	file.append16(101);
+	file.append16(0);
+	file.append32(0);
+	file.append16(9);
+	file.append16(1);
+	file.append32(9);
+	file.append32(0);
+	file.append32(32);
+
+	const auto appendEnhanced = [&file](uint32_t interfaceId, uint64_t ticks, const std::vector<uint8_t>& data)
+	{
+		const uint32_t length = static_cast<uint32_t>(32 + ((data.size() + 3) & ~size_t(3)));
+		file.append32(6);
+		file.append32(length);
+		file.append32(interfaceId);
+		file.append32(static_cast<uint32_t>(ticks >> 32));
+		file.append32(static_cast<uint32_t>(ticks));
+		file.append32(static_cast<uint32_t>(data.size()));
+		file.append32(static_cast<uint32_t>(data.size()));
+		file.append(data);
+		file.pad();
+		file.append32(length);
+	};
+	appendEnhanced(0, 1700000000123456ull, makeEthernet(makeUdpPacket(1, 1111), 0x0800, false));
+	appendEnhanced(1, 1700000000123456789ull, makeUdpPacket(2, 2222));
+	//unknown interface, skipped
+	appendEnhanced(5, 0, makeUdpPacket(3, 3333));
+	//simple packet block on interface 0
+	const auto simple = makeEthernet(makeUdpPacket(4, 4444), 0x0800, false);
+	const uint32_t simpleLength = static_cast<uint32_t>(16 + ((simple.size() + 3) & ~size_t(3)));
+	file.append32(3);
+	file.append32(simpleLength);
+	file.append32(static_cast<uint32_t>(simple.size()));
+	file.append(simple);
+	file.pad();
+	file.append32(simpleLength);
+
+	CaptureReader reader(file.write());
+	EXPECT_EQ(reader.getFormat(), CaptureFormat::kPcapNg);
+	CaptureRecord records[8];
+	ASSERT_EQ(reader.readBatch(records, 8), 3u);
+	EXPECT_EQ(records[0].timestamp, 1700000000123456000ull);
+	EXPECT_EQ(records[0].source.getPort(), 1111);
+	EXPECT_EQ(records[1].timestamp, 1700000000123456789ull);
+	EXPECT_EQ(records[1].source, IPEndPoint(IPAddressV4("10.0.0.2"), port_host_byte_order_t(2222)));
+	EXPECT_EQ(records[2].timestamp, 0u);
+	EXPECT_EQ(records[2].source.getPort(), 4444);
+	EXPECT_EQ(reader.readBatch(records, 8), 0u);
+}
+
+TEST(CaptureReaderTest, Parallel)
+{
+	CaptureFile file;
+	appendPcapHeader(file, 0xA1B2C3D4, 1, false);
+	constexpr uint32_t kRecords = 5000;
+	for (uint32_t i = 0; i < kRecords; i++)
+	{
+		//varying sizes so split points land in the middle of records
+		auto frame = makeEthernet(makeUdpPacket(static_cast<uint8_t>(i), static_cast<uint16_t>(i)), 0x0800, i % 3 == 0);
+		frame.resize(frame.size() + i % 17, 0);
+		appendPcapRecord(file, i, i % 1000000, frame);
+	}
+	CaptureReader reader(file.write());
+	for (size_t threads : { 1, 3, 8 })
+	{
+		std::vector<std::vector<uint32_t>> seen(threads);
+		reader.readParallel(threads, [&seen](size_t part, const CaptureRecord* records, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+				seen[part].push_back(static_cast<uint32_t>(records[i].timestamp / 1000000000ull));
+		}, 64);
+		std::vector<uint32_t> all;
+		for (const auto& part : seen)
+			all.insert(all.end(), part.begin(), part.end());
+		ASSERT_EQ(all.size(), kRecords);
+		for (uint32_t i = 0; i < kRecords; i++)
+			ASSERT_EQ(all[i], i);
+	}
+}
+
+TEST(CaptureReaderTest, ParallelPcapNgLateInterfaces)
+{
+	CaptureFile file;
+	const auto appendSection = [&file]()
+	{
+		file.append32(0x0A0D0D0A);
+		file.append32(28);
+		file.append32(0x1A2B3C4D);
+		file.append16(1);
+		file.append16(0);
+		file.append32(0xFFFFFFFF);
+		file.append32(0xFFFFFFFF);
+		file.append32(28);
+	};
+	const auto appendInterface = [&file](uint16_t linkType)
+	{
+		file.append32(1);
+		file.append32(20);
+		file.append16(linkType);
+		file.append16(0);
+		file.append32(0);
+		file.append32(20);
+	};
+	const auto appendEnhanced = [&file](uint32_t interfaceId, uint64_t ticks, const std::vector<uint8_t>& data)
+	{
+		const uint32_t length = static_cast<uint32_t>(32 + ((data.size() + 3) & ~size_t(3)));
+		file.append32(6);
+		file.append32(length);
+		file.append32(interfaceId);
+		file.append32(static_cast<uint32_t>(ticks >> 32));
+		file.append32(static_cast<uint32_t>(ticks));
+		file.append32(static_cast<uint32_t>(data.size()));
+		file.append32(static_cast<uint32_t>(data.size()));
+		file.append(data);
+		file.pad();
+		file.append32(length);
+	};
+	//ethernet on interface 0, a raw IP interface 1 described after a third of the packets, then a new section
+	//whose interface 0 is raw IP
+	constexpr uint32_t kRecords = 3000;
+	appendSection();
+	appendInterface(1);
+	for (uint32_t i = 0; i < kRecords; i++)
+	{
+		if (i == kRecords / 3)
+			appendInterface(101);
+		if (i == kRecords * 2 / 3)
+		{
+			appendSection();
+			appendInterface(101);
+		}
+		const auto packet = makeUdpPacket(static_cast<uint8_t>(i), static_cast<uint16_t>(i));
+		if (i < kRecords / 3)
+			appendEnhanced(0, i * 1000000ull, makeEthernet(packet, 0x0800, false));
+		else
+			appendEnhanced(i < kRecords * 2 / 3 ? 1 : 0, i * 1000000ull, packet);
+	}
+	CaptureReader reader(file.write());
+	for (size_t threads : { 1, 3, 8 })
+	{
+		std::vector<std::vector<uint32_t>> seen(threads);
+		reader.readParallel(threads, [&seen](size_t part, const CaptureRecord* records, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+				seen[part].push_back(records[i].source.getPort());
+		}, 64);
+		std::vector<uint32_t> all;
+		for (const auto& part : seen)
+			all.insert(all.end(), part.begin(), part.end());
+		ASSERT_EQ(all.size(), kRecords) << threads;
+		for (uint32_t i = 0; i < kRecords; i++)
+			ASSERT_EQ(all[i], i) << threads;
+	}
+}
+
+TEST(CaptureReaderTest, Invalid)
+{
+	CaptureFile file;
+	file.append(std::vector<uint8_t>(64, 0x42));
+	EXPECT_THROW(CaptureReader(file.write()), std::runtime_error);
+	EXPECT_THROW(CaptureReader("/nonexistent/capture.pcap"), std::runtime_error);
+}
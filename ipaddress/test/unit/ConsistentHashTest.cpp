@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+#include "ConsistentHash.h"
+using namespace ip_address;
+
+namespace
+{
+	std::vector<IPEndPoint> makeBackends(size_t count)
+	{
+		std::vector<IPEndPoint> backends;
+		for (size_t i = 0; i < count; i++)
+		{
+			backends.emplace_back(ByteArray4{ 10, 1, static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i) },
+			                      port_host_byte_order_t(8080));
+		}
+		return backends;
+	}
+
+	std::vector<IPAddress> makeClients(size_t count)
+	{
+		std::vector<IPAddress> clients;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (i % 2)
+			{
+				ByteArray16 bytes = { 0x20, 0x01, 0x0d, 0xb8 };
+				bytes[14] = static_cast<uint8_t>(i >> 8);
+				bytes[15] = static_cast<uint8_t>(i);
+				clients.emplace_back(bytes);
+			}
+			else
+			{
+				clients.emplace_back(ByteArray4{ 192, 168, static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i) });
+			}
+		}
+		return clients;
+	}
+
+	std::vector<IPEndPoint> lookupAll(const MaglevTable& table, const std::vector<IPAddress>& clients)
+	{
+		std::vector<const IPEndPoint*> result(clients.size());
+		table.lookup(Span<const IPAddress>(clients.data(), clients.size()), result.data());
+		std::vector<IPEndPoint> backends;
+		for (size_t i = 0; i < clients.size(); i++)
+		{
+			EXPECT_EQ(result[i], table.lookup(clients[i]));
+			backends.push_back(*result[i]);
+		}
+		return backends;
+	}
+
+	void expectBalanced(const MaglevTable& table, const std::vector<IPEndPoint>& backends)
+	{
+		uint32_t total = 0;
+		uint32_t low = table.getTableSize();
+		uint32_t high = 0;
+		for (const IPEndPoint& backend : backends)
+		{
+			const uint32_t slots = table.getSlotCount(backend);
+			total += slots;
+			low = std::min(low, slots);
+			high = std::max(high, slots);
+		}
+		EXPECT_EQ(total, table.getTableSize());
+		EXPECT_LE(high - low, 1u);
+	}
+}
+
+TEST(ConsistentHashTest, Jump)
+{
+	//moving from n to n + 1 buckets only moves keys into the new bucket
+	size_t moved = 0;
+	for (uint64_t key = 0; key < 10000; key++)
+	{
+		const uint32_t before = jumpConsistentHash(key, 10);
+		const uint32_t after = jumpConsistentHash(key, 11);
+		EXPECT_LT(before, 10u);
+		if (before != after)
+		{
+			EXPECT_EQ(after, 10u);
+			moved++;
+		}
+	}
+	EXPECT_NEAR(static_cast<double>(moved), 10000.0 / 11, 150);
+	EXPECT_EQ(jumpConsistentHash(IPAddress("192.0.2.1"), 1), 0u);
+}
+
+TEST(ConsistentHashTest, MaglevPopulate)
+{
+	MaglevTable table(1000);
+	EXPECT_EQ(table.getTableSize(), 1009u);
+	EXPECT_EQ(table.lookup(IPAddress("192.0.2.1")), nullptr);
+
+	auto backends = makeBackends(10);
+	auto reversed = backends;
+	std::reverse(reversed.begin(), reversed.end());
+	reversed.push_back(backends[3]);
+	table.setBackends(Span<const IPEndPoint>(backends.data(), backends.size()));
+	EXPECT_EQ(table.getBackendCount(), 10u);
+	expectBalanced(table, backends);
+
+	//the full population does not depend on the order of the backends and ignores duplicates
+	MaglevTable other(1000);
+	other.setBackends(Span<const IPEndPoint>(reversed.data(), reversed.size()));
+	EXPECT_EQ(other.getBackendCount(), 10u);
+	const auto clients = makeClients(2000);
+	EXPECT_EQ(lookupAll(table, clients), lookupAll(other, clients));
+}
+
+TEST(ConsistentHashTest, MaglevIncremental)
+{
+	MaglevTable table(10007);
+	auto backends = makeBackends(50);
+	for (const IPEndPoint& backend : backends)
+		EXPECT_TRUE(table.addBackend(backend));
+	EXPECT_FALSE(table.addBackend(backends[0]));
+	expectBalanced(table, backends);
+
+	const auto clients = makeClients(20000);
+	const auto before = lookupAll(table, clients);
+
+	//removing a backend only moves the clients that were on it
+	const IPEndPoint removed = backends[17];
+	EXPECT_TRUE(table.removeBackend(removed));
+	EXPECT_FALSE(table.removeBackend(removed));
+	backends.erase(backends.begin() + 17);
+	expectBalanced(table, backends);
+	const auto afterRemove = lookupAll(table, clients);
+	for (size_t i = 0; i < clients.size(); i++)
+	{
+		if (before[i] != removed)
+		{
+			EXPECT_EQ(afterRemove[i], before[i]);
+		}
+		EXPECT_NE(afterRemove[i], removed);
+	}
+
+	//adding a backend only moves clients onto it, about 1/n of them
+	const IPEndPoint added(IPAddressV6("2001:db8::80"), port_host_byte_order_t(443));
+	EXPECT_TRUE(table.addBackend(added));
+	backends.push_back(added);
+	expectBalanced(table, backends);
+	const auto afterAdd = lookupAll(table, clients);
+	size_t moved = 0;
+	for (size_t i = 0; i < clients.size(); i++)
+	{
+		if (afterAdd[i] != afterRemove[i])
+		{
+			EXPECT_EQ(afterAdd[i], added);
+			moved++;
+		}
+	}
+	EXPECT_NEAR(static_cast<double>(moved), clients.size() / 50.0, clients.size() / 50.0 * 0.3);
+
+	while (!backends.empty())
+	{
+		EXPECT_TRUE(table.removeBackend(backends.back()));
+		backends.pop_back();
+	}
+	EXPECT_EQ(table.lookup(clients[0]), nullptr);
+}
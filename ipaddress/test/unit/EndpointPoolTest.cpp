@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "EndpointPool.h"
+using namespace ip_address;
+
+namespace
+{
+	IPEndPoint makeBackend(uint8_t index)
+	{
+		return IPEndPoint(ByteArray4{ 10, 0, 0, index }, port_host_byte_order_t(8080));
+	}
+}
+
+TEST(EndpointPoolTest, Empty)
+{
+	EndpointPool pool;
+	EndpointPool::Lease lease = pool.acquire();
+	EXPECT_FALSE(lease);
+	lease.complete(100);
+	EXPECT_EQ(pool.getBackendCount(), 0u);
+	EXPECT_FALSE(pool.removeBackend(makeBackend(1)));
+}
+
+TEST(EndpointPoolTest, AddRemove)
+{
+	EndpointPool pool;
+	EXPECT_TRUE(pool.addBackend(makeBackend(1)));
+	EXPECT_FALSE(pool.addBackend(makeBackend(1)));
+	EXPECT_TRUE(pool.addBackend(makeBackend(2)));
+	EXPECT_EQ(pool.getBackendCount(), 2u);
+	EXPECT_TRUE(pool.contains(makeBackend(2)));
+
+	//a lease stays valid after its backend is removed
+	EndpointPool::Lease lease = pool.acquire();
+	ASSERT_TRUE(lease);
+	const IPEndPoint leased = lease.getEndPoint();
+	EXPECT_EQ(pool.getInFlight(leased), 1u);
+	EXPECT_TRUE(pool.removeBackend(leased));
+	EXPECT_FALSE(pool.contains(leased));
+	EXPECT_EQ(lease.getEndPoint(), leased);
+	lease.complete(5);
+	EXPECT_FALSE(lease);
+
+	for (int i = 0; i < 10; i++)
+	{
+		EXPECT_NE(pool.acquire().getEndPoint(), leased);
+	}
+	EXPECT_TRUE(pool.addBackend(leased));
+	EXPECT_EQ(pool.getInFlight(leased), 0u);
+}
+
+TEST(EndpointPoolTest, SetBackendsKeepsStatistics)
+{
+	EndpointPool pool(1000, 1);
+	const IPEndPoint backends[] = { makeBackend(1), makeBackend(2), makeBackend(2) };
+	pool.setBackends(backends);
+	EXPECT_EQ(pool.getBackendCount(), 2u);
+
+	EndpointPool::Lease lease = pool.acquire();
+	const IPEndPoint leased = lease.getEndPoint();
+	lease.complete(3000);
+	EXPECT_EQ(pool.getLatency(leased), 2000u);
+
+	const IPEndPoint next[] = { leased, makeBackend(3) };
+	pool.setBackends(next);
+	EXPECT_EQ(pool.getBackendCount(), 2u);
+	EXPECT_EQ(pool.getLatency(leased), 2000u);
+	EXPECT_EQ(pool.getLatency(makeBackend(3)), 1000u);
+}
+
+TEST(EndpointPoolTest, PrefersLeastLoaded)
+{
+	EndpointPool pool;
+	pool.addBackend(makeBackend(1));
+	pool.addBackend(makeBackend(2));
+	//with two backends both are sampled every time, so the idle one always wins
+	std::vector<EndpointPool::Lease> leases;
+	for (int i = 0; i < 100; i++)
+	{
+		leases.push_back(pool.acquire());
+	}
+	EXPECT_EQ(pool.getInFlight(makeBackend(1)), 50u);
+	EXPECT_EQ(pool.getInFlight(makeBackend(2)), 50u);
+	leases.clear();
+	EXPECT_EQ(pool.getInFlight(makeBackend(1)), 0u);
+
+	//one slow sample (average 1ms + 99ms / 8) is worth 12 requests in flight on the other backend
+	EndpointPool::Lease slow = pool.acquire();
+	const IPEndPoint slowEndPoint = slow.getEndPoint();
+	slow.complete(100000000);
+	for (int i = 0; i < 20; i++)
+	{
+		leases.push_back(pool.acquire());
+	}
+	EXPECT_EQ(pool.getInFlight(slowEndPoint), 1u);
+}
+
+TEST(EndpointPoolTest, ConcurrentUpdates)
+{
+	EndpointPool pool;
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		pool.addBackend(makeBackend(i));
+	}
+	std::atomic<bool> stop{ false };
+	std::atomic<uint64_t> acquired{ 0 };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&pool, &stop, &acquired]()
+		{
+			while (!stop.load())
+			{
+				EndpointPool::Lease lease = pool.acquire();
+				if (lease)
+				{
+					//touches the backend, a freed one shows up under ASan
+					EXPECT_NE(lease.getEndPoint().getPort(), 0);
+					lease.complete(1000);
+					acquired++;
+				}
+			}
+		});
+	}
+	//the readers have to be running while the backends change
+	while (acquired.load() == 0)
+	{
+		std::this_thread::yield();
+	}
+	for (int i = 0; i < 200; i++)
+	{
+		const auto index = static_cast<uint8_t>(i % 16);
+		if (!pool.removeBackend(makeBackend(index)))
+			pool.addBackend(makeBackend(index));
+	}
+	stop = true;
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	EXPECT_GT(acquired.load(), 0u);
+	for (uint8_t i = 0; i < 16; i++)
+	{
+		EXPECT_EQ(pool.getInFlight(makeBackend(i)), 0u);
+	}
+}
+
+TEST(EndpointPoolTest, RcuBackToBackUpdates)
+{
+	//a snapshot poisons itself when destroyed, a reader that sees the poison held a freed snapshot
+	struct Value
+	{
+		explicit Value(uint64_t value) : value(value) { }
+		Value(const Value&) = default;
+		~Value() { value = 0; }
+		uint64_t value;
+	};
+	details::RcuPointer<Value> pointer(std::unique_ptr<Value>(new Value(1)));
+	std::atomic<bool> stop{ false };
+	std::atomic<uint64_t> reads{ 0 };
+	std::atomic<uint64_t> poisoned{ 0 };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&pointer, &stop, &reads, &poisoned]()
+		{
+			while (!stop.load())
+			{
+				const auto guard = pointer.read();
+				const uint64_t before = guard->value;
+				std::this_thread::yield();
+				if (before == 0 || guard->value != before)
+					poisoned++;
+				reads++;
+			}
+		});
+	}
+	while (reads.load() == 0)
+	{
+		std::this_thread::yield();
+	}
+	for (uint64_t i = 2; i < 20000; i++)
+	{
+		pointer.update(std::unique_ptr<Value>(new Value(i)));
+	}
+	stop = true;
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	EXPECT_EQ(poisoned.load(), 0u);
+	EXPECT_GT(reads.load(), 0u);
+}
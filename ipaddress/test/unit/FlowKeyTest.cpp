@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "ToeplitzHash.h"
+using namespace ip_address;
+
+namespace
+{
+	FlowKey makeKey(const char* source, port_host_byte_order_t sourcePort, const char* destination,
+	                port_host_byte_order_t destinationPort, uint8_t protocol = IPPROTO_TCP)
+	{
+		return FlowKey(IPEndPoint(IPAddress(source), sourcePort), IPEndPoint(IPAddress(destination), destinationPort),
+		               protocol);
+	}
+}
+
+TEST(FlowKeyTest, Basic)
+{
+	const FlowKey key = makeKey("192.0.2.1", 40000, "198.51.100.1", 443);
+	EXPECT_EQ(key.getVersion(), IPVersion::kIPv4);
+	EXPECT_EQ(key.getSource(), IPEndPoint(IPAddressV4("192.0.2.1"), port_host_byte_order_t(40000)));
+	EXPECT_EQ(key.getDestination(), IPEndPoint(IPAddressV4("198.51.100.1"), port_host_byte_order_t(443)));
+	EXPECT_EQ(key.getProtocol(), IPPROTO_TCP);
+	EXPECT_NE(key, key.reversed());
+	EXPECT_EQ(key, key.reversed().reversed());
+	EXPECT_NE(key, makeKey("192.0.2.1", 40000, "198.51.100.1", 443, IPPROTO_UDP));
+
+	uint8_t input[FlowKey::kMaxHashInputSize];
+	ASSERT_EQ(key.getHashInput(input, true), 12u);
+	const uint8_t expected[12] = { 192, 0, 2, 1, 198, 51, 100, 1, 0x9C, 0x40, 0x01, 0xBB };
+	EXPECT_EQ(memcmp(input, expected, sizeof(expected)), 0);
+	EXPECT_EQ(makeKey("2001:db8::1", 1, "2001:db8::2", 2).getHashInput(input, false), 32u);
+}
+
+TEST(FlowKeyTest, ReusedAddress)
+{
+	//an IPv4 address parsed into storage that held an IPv6 address
+	IPAddress reused;
+	ASSERT_TRUE(IPAddress::parseIPAddress(reused, "2001:db8::1"));
+	ASSERT_TRUE(IPAddress::parseIPAddress(reused, "10.0.0.1"));
+	ASSERT_EQ(reused, IPAddress("10.0.0.1"));
+	const FlowKey key(IPEndPoint(reused, port_host_byte_order_t(1000)),
+	                  IPEndPoint(IPAddress("10.0.0.2"), port_host_byte_order_t(80)), IPPROTO_TCP);
+	EXPECT_EQ(key, makeKey("10.0.0.1", 1000, "10.0.0.2", 80));
+}
+
+TEST(FlowKeyTest, ToeplitzVerificationSuite)
+{
+	//"Verifying the RSS Hash Calculation", Microsoft RSS documentation
+	struct Vector
+	{
+		const char* destination;
+		port_host_byte_order_t destinationPort;
+		const char* source;
+		port_host_byte_order_t sourcePort;
+		uint32_t addressesOnly;
+		uint32_t withPorts;
+	};
+	const Vector vectors[] = {
+		{ "161.142.100.80", 1766, "66.9.149.187", 2794, 0x323e8fc2, 0x51ccc178 },
+		{ "65.69.140.83", 4739, "199.92.111.2", 14230, 0xd718262a, 0xc626b0ea },
+		{ "12.22.207.184", 38024, "24.19.198.95", 12898, 0xd2d0a5de, 0x5c2b394a },
+		{ "209.142.163.6", 2217, "38.27.205.30", 48228, 0x82989176, 0xafc7327f },
+		{ "202.188.127.2", 1303, "153.39.163.191", 44251, 0x5d1809c5, 0x10e828a2 },
+		{ "3ffe:2501:200:3::1", 1766, "3ffe:2501:200:1fff::7", 2794, 0x2cc18cd5, 0x40207d3d },
+		{ "ff02::1", 4739, "3ffe:501:8::260:97ff:fe40:efab", 14230, 0x0f0c461c, 0xdde51bbf },
+		{ "fe80::200:f8ff:fe21:67cf", 38024, "3ffe:1900:4545:3:200:f8ff:fe21:67cf", 44251, 0x4b61e985, 0x02d1feef },
+	};
+	const ToeplitzHash withPorts;
+	const ToeplitzHash addressesOnly(ToeplitzHash::kMicrosoftKey, false);
+	for (const Vector& v : vectors)
+	{
+		const FlowKey key = makeKey(v.source, v.sourcePort, v.destination, v.destinationPort);
+		EXPECT_EQ(addressesOnly.hash(key), v.addressesOnly) << v.destination;
+		EXPECT_EQ(withPorts.hash(key), v.withPorts) << v.destination;
+	}
+	//ports are only hashed for TCP and UDP
+	const FlowKey icmp = makeKey("66.9.149.187", 2794, "161.142.100.80", 1766, IPPROTO_ICMP);
+	EXPECT_EQ(withPorts.hash(icmp), 0x323e8fc2u);
+}
+
+TEST(FlowKeyTest, ToeplitzTableMatchesReference)
+{
+	std::mt19937 rng(32);
+	uint8_t key[52];
+	for (auto& b : key)
+		b = static_cast<uint8_t>(rng());
+	const Span<const uint8_t> keySpan(key, sizeof(key));
+	const ToeplitzHash hash(keySpan);
+	for (int i = 0; i < 1000; i++)
+	{
+		uint8_t input[FlowKey::kMaxHashInputSize];
+		for (auto& b : input)
+			b = static_cast<uint8_t>(rng());
+		const size_t size = rng() % (sizeof(input) + 1);
+		ASSERT_EQ(hash.hash(input, size), ToeplitzHash::hashReference(keySpan, input, size));
+	}
+}
+
+TEST(FlowKeyTest, SymmetricAndBatch)
+{
+	const ToeplitzHash symmetric = ToeplitzHash::symmetric();
+	const ToeplitzHash microsoft;
+	const FlowKey keys[4] = {
+		makeKey("10.0.0.1", 1234, "10.0.0.2", 80),
+		makeKey("10.0.0.2", 80, "10.0.0.1", 1234),
+		makeKey("2001:db8::1", 5353, "2001:db8:ffff::2", 53, IPPROTO_UDP),
+		makeKey("2001:db8:ffff::2", 53, "2001:db8::1", 5353, IPPROTO_UDP),
+	};
+	EXPECT_EQ(symmetric.hash(keys[0]), symmetric.hash(keys[1]));
+	EXPECT_EQ(symmetric.hash(keys[2]), symmetric.hash(keys[3]));
+	EXPECT_NE(microsoft.hash(keys[0]), microsoft.hash(keys[1]));
+
+	uint32_t hashes[4];
+	microsoft.hash(Span<const FlowKey>(keys), hashes);
+	for (size_t i = 0; i < 4; i++)
+		EXPECT_EQ(hashes[i], microsoft.hash(keys[i]));
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <chrono>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "HappyEyeballs.h"
+using namespace ip_address;
+using namespace std::chrono_literals;
+
+namespace
+{
+	/*
+	 * TCP socket bound to a loopback address. listening accepts connections, a bound socket that does not
+	 * listen refuses them and a hanging one has its accept queue filled so new handshakes are never answered.
+	 */
+	class LoopbackListener
+	{
+	public:
+		enum class Mode { kListening, kRefusing, kHanging };
+
+		LoopbackListener(const char* address, Mode mode)
+		{
+			IPEndPoint endpoint(std::string(address), port_host_byte_order_t(0));
+			sockaddr_storage storage;
+			socklen_t length;
+			endpoint.writeSockaddr(storage, length);
+			mFd = socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			EXPECT_GE(mFd, 0);
+			EXPECT_EQ(bind(mFd, reinterpret_cast<const sockaddr*>(&storage), length), 0);
+			length = sizeof(storage);
+			EXPECT_EQ(getsockname(mFd, reinterpret_cast<sockaddr*>(&storage), &length), 0);
+			mEndpoint = IPEndPoint(reinterpret_cast<const sockaddr*>(&storage), length);
+			if (mode == Mode::kRefusing)
+				return;
+			EXPECT_EQ(listen(mFd, mode == Mode::kHanging ? 0 : 16), 0);
+			if (mode == Mode::kHanging)
+			{
+				//one queued connection fills a backlog of 0, the next SYN is dropped
+				mFillers.push_back(socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0));
+				EXPECT_EQ(connect(mFillers.back(), reinterpret_cast<const sockaddr*>(&storage), length), 0);
+			}
+		}
+
+		~LoopbackListener()
+		{
+			for (const int fd : mFillers)
+			{
+				close(fd);
+			}
+			close(mFd);
+		}
+
+		const IPEndPoint& getEndpoint() const noexcept { return mEndpoint; }
+	private:
+		int mFd = -1;
+		std::vector<int> mFillers;
+		IPEndPoint mEndpoint;
+	};
+
+	HappyEyeballsConnector makeConnector(std::chrono::milliseconds attemptDelay, std::chrono::milliseconds timeout)
+	{
+		HappyEyeballsConnector::Options options;
+		options.attemptDelay = attemptDelay;
+		options.timeout = timeout;
+		return HappyEyeballsConnector(options, AddressSorter({ IPAddress(std::string("127.0.0.1")),
+		                                                       IPAddress(std::string("::1")) }));
+	}
+
+	std::chrono::milliseconds getElapsed(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	}
+}
+
+TEST(HappyEyeballsTest, Interleave)
+{
+	const IPEndPoint a6("2001:db8::1", port_host_byte_order_t(1));
+	const IPEndPoint b6("2001:db8::2", port_host_byte_order_t(1));
+	const IPEndPoint c6("2001:db8::3", port_host_byte_order_t(1));
+	const IPEndPoint a4("192.0.2.1", port_host_byte_order_t(1));
+	const IPEndPoint b4("192.0.2.2", port_host_byte_order_t(1));
+	EXPECT_EQ(HappyEyeballsConnector::interleave({ a6, b6, c6, a4, b4 }), std::vector<IPEndPoint>({ a6, a4, b6, b4, c6 }));
+	EXPECT_EQ(HappyEyeballsConnector::interleave({ a4, b4, a6 }), std::vector<IPEndPoint>({ a4, a6, b4 }));
+	EXPECT_EQ(HappyEyeballsConnector::interleave({ a6, b6 }), std::vector<IPEndPoint>({ a6, b6 }));
+	EXPECT_TRUE(HappyEyeballsConnector::interleave({}).empty());
+}
+
+TEST(HappyEyeballsTest, Connect)
+{
+	LoopbackListener listener("127.0.0.1", LoopbackListener::Mode::kListening);
+	const ConnectResult result = makeConnector(250ms, 5000ms).connect({ listener.getEndpoint() });
+	ASSERT_GE(result.fd, 0);
+	EXPECT_EQ(result.endpoint, listener.getEndpoint());
+	EXPECT_EQ(result.attempts, 1u);
+	close(result.fd);
+}
+
+TEST(HappyEyeballsTest, RefusedStartsNextAttempt)
+{
+	LoopbackListener refusing("127.0.0.1", LoopbackListener::Mode::kRefusing);
+	LoopbackListener listener("127.0.0.1", LoopbackListener::Mode::kListening);
+	//a refused connection must not wait for the attempt delay
+	const auto start = std::chrono::steady_clock::now();
+	const ConnectResult result = makeConnector(5000ms, 10000ms).connect({ refusing.getEndpoint(),
+	                                                                     listener.getEndpoint() });
+	EXPECT_LT(getElapsed(start), 2500ms);
+	ASSERT_GE(result.fd, 0);
+	EXPECT_EQ(result.endpoint, listener.getEndpoint());
+	EXPECT_EQ(result.attempts, 2u);
+	close(result.fd);
+}
+
+TEST(HappyEyeballsTest, HangingFallsBackAfterDelay)
+{
+	LoopbackListener hanging("127.0.0.1", LoopbackListener::Mode::kHanging);
+	LoopbackListener listener("127.0.0.1", LoopbackListener::Mode::kListening);
+	const auto start = std::chrono::steady_clock::now();
+	const ConnectResult result = makeConnector(250ms, 5000ms).connect({ hanging.getEndpoint(),
+	                                                                   listener.getEndpoint() });
+	const auto elapsed = getElapsed(start);
+	EXPECT_GE(elapsed, 250ms);
+	EXPECT_LT(elapsed, 2500ms);
+	ASSERT_GE(result.fd, 0);
+	EXPECT_EQ(result.endpoint, listener.getEndpoint());
+	EXPECT_EQ(result.attempts, 2u);
+	close(result.fd);
+}
+
+TEST(HappyEyeballsTest, PrefersIPv6)
+{
+	LoopbackListener listener4("127.0.0.1", LoopbackListener::Mode::kListening);
+	LoopbackListener listener6("::1", LoopbackListener::Mode::kListening);
+	const ConnectResult result = makeConnector(250ms, 5000ms).connect({ listener4.getEndpoint(),
+	                                                                   listener6.getEndpoint() });
+	ASSERT_GE(result.fd, 0);
+	EXPECT_EQ(result.endpoint, listener6.getEndpoint());
+	EXPECT_EQ(result.attempts, 1u);
+	close(result.fd);
+}
+
+TEST(HappyEyeballsTest, IPv6FallsBackToIPv4)
+{
+	LoopbackListener hanging6("::1", LoopbackListener::Mode::kHanging);
+	LoopbackListener refusing6("::1", LoopbackListener::Mode::kRefusing);
+	LoopbackListener listener4("127.0.0.1", LoopbackListener::Mode::kListening);
+	//interleaved as hanging6, listener4, refusing6
+	const ConnectResult result = makeConnector(100ms, 5000ms).connect({ hanging6.getEndpoint(),
+	                                                                   refusing6.getEndpoint(),
+	                                                                   listener4.getEndpoint() });
+	ASSERT_GE(result.fd, 0);
+	EXPECT_EQ(result.endpoint, listener4.getEndpoint());
+	EXPECT_EQ(result.attempts, 2u);
+	close(result.fd);
+}
+
+TEST(HappyEyeballsTest, Failure)
+{
+	LoopbackListener refusing4("127.0.0.1", LoopbackListener::Mode::kRefusing);
+	LoopbackListener refusing6("::1", LoopbackListener::Mode::kRefusing);
+	ConnectResult result = makeConnector(250ms, 5000ms).connect({ refusing4.getEndpoint(), refusing6.getEndpoint() });
+	EXPECT_EQ(result.fd, -1);
+	EXPECT_EQ(result.error, ECONNREFUSED);
+	EXPECT_EQ(result.attempts, 2u);
+
+	LoopbackListener hanging("127.0.0.1", LoopbackListener::Mode::kHanging);
+	const auto start = std::chrono::steady_clock::now();
+	result = makeConnector(50ms, 300ms).connect({ hanging.getEndpoint() });
+	EXPECT_GE(getElapsed(start), 300ms);
+	EXPECT_EQ(result.fd, -1);
+	EXPECT_EQ(result.error, ETIMEDOUT);
+
+	result = makeConnector(50ms, 300ms).connect({});
+	EXPECT_EQ(result.fd, -1);
+	EXPECT_EQ(result.attempts, 0u);
+}
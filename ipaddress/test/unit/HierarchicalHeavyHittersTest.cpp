@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "HierarchicalHeavyHitters.h"
+using namespace ip_address;
+
+namespace
+{
+	bool reported(const std::vector<HeavyHitter>& hitters, const IPNetwork& network)
+	{
+		for (const auto& hitter : hitters)
+		{
+			if (hitter.network == network)
+				return true;
+		}
+		return false;
+	}
+}
+
+TEST(SpaceSavingTest, TopK)
+{
+	details::SpaceSaving<uint32_t, details::AddressKey<IPAddressV4>> summary(4);
+	for (int i = 0; i < 100; i++)
+	{
+		summary.increment(1);
+		summary.increment(2);
+		summary.increment(1000 + i);
+	}
+	EXPECT_EQ(summary.size(), 4u);
+	EXPECT_GE(summary.count(1), 100u);
+	EXPECT_GE(summary.count(2), 100u);
+	uint64_t total = 0;
+	summary.forEach([&](uint32_t, uint64_t count, uint64_t error)
+	{
+		EXPECT_LE(error, count);
+		total += count;
+	});
+	EXPECT_EQ(total, 300u);
+}
+
+TEST(HierarchicalHeavyHittersTest, IPv4SpreadAttack)
+{
+	HierarchicalHeavyHittersV4 hhh(256);
+	std::mt19937 rng(7);
+	const uint32_t spreadPrefix = (10u << 24) | (20u << 16);
+	for (int i = 0; i < 400000; i++)
+	{
+		const uint32_t r = rng();
+		in_addr addr = {};
+		switch (i % 10)
+		{
+		case 0: case 1: case 2: case 3:
+			addr.s_addr = htonl((1u << 24) | (2u << 16) | (3u << 8) | 4u);
+			break;
+		case 4: case 5: case 6:
+			addr.s_addr = htonl(spreadPrefix | (r & 0xFFFF));
+			break;
+		default:
+			addr.s_addr = htonl(r);
+			break;
+		}
+		hhh.update(IPAddressV4(addr));
+	}
+	EXPECT_EQ(hhh.getPacketCount(), 400000u);
+	EXPECT_EQ(hhh.getPrefixLengths().size(), 25u);
+
+	const auto hitters = hhh.query(0.2);
+	EXPECT_TRUE(reported(hitters, IPNetwork("1.2.3.4/32")));
+	EXPECT_TRUE(reported(hitters, IPNetwork("10.20.0.0/16")));
+	//the ancestors of the flood host are fully discounted
+	EXPECT_FALSE(reported(hitters, IPNetwork("1.2.3.0/24")));
+	EXPECT_FALSE(reported(hitters, IPNetwork("1.0.0.0/8")));
+	EXPECT_EQ(hitters.size(), 2u);
+}
+
+TEST(HierarchicalHeavyHittersTest, IPv6ByteGranularity)
+{
+	HierarchicalHeavyHittersV6 hhh(128, 16, 8);
+	EXPECT_EQ(hhh.getPrefixLengths().front(), 128);
+	EXPECT_EQ(hhh.getPrefixLengths().back(), 16);
+	std::mt19937_64 rng(11);
+	const IPAddressV6 base("2001:db8:1234::");
+	for (int i = 0; i < 300000; i++)
+	{
+		IPAddressV6 addr = base;
+		const uint64_t r = rng();
+		if (i % 2 == 0)
+			memcpy(&addr.bytes()[6], &r, 8);
+		else
+			memcpy(&addr.bytes()[0], &r, 8);
+		hhh.update(addr);
+	}
+	const auto hitters = hhh.query(0.3);
+	ASSERT_EQ(hitters.size(), 1u);
+	EXPECT_EQ(hitters[0].network, IPNetwork("2001:db8:1234::/48"));
+	EXPECT_GE(hitters[0].upperBound, hitters[0].lowerBound);
+
+	hhh.clear();
+	EXPECT_EQ(hhh.getPacketCount(), 0u);
+	EXPECT_TRUE(hhh.query(0.1).empty());
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include "HostTable.h"
+using namespace ip_address;
+
+namespace
+{
+	class TableFile
+	{
+	public:
+		TableFile()
+		{
+			char path[] = "/tmp/ipaddress_hosts_XXXXXX";
+			close(mkstemp(path));
+			mPath = path;
+		}
+		~TableFile() { unlink(mPath.c_str()); }
+		const std::string& getPath() const { return mPath; }
+	private:
+		std::string mPath;
+	};
+}
+
+TEST(HostTableTest, HostsFile)
+{
+	std::istringstream hosts(
+		"# comment line\n"
+		"127.0.0.1\tlocalhost\n"
+		"::1 localhost ip6-localhost # trailing comment\n"
+		"10.0.0.1 api.internal API\n"
+		"10.0.0.2 api.internal\n"
+		"10.0.0.1 api.internal\n"
+		"not-an-address bad.internal\n"
+		"10.0.0.3\n"
+		"\n");
+	HostTableBuilder builder;
+	EXPECT_EQ(builder.addHosts(hosts), 2u);
+	EXPECT_EQ(builder.getNameCount(), 4u);
+	TableFile file;
+	builder.write(file.getPath());
+
+	HostTable table(file.getPath());
+	EXPECT_EQ(table.getNameCount(), 4u);
+	EXPECT_EQ(table.getAddressCount(), 6u);
+	Span<const IPAddress> addresses = table.lookup("localhost");
+	ASSERT_EQ(addresses.size(), 2u);
+	EXPECT_EQ(addresses[0], IPAddress("127.0.0.1"));
+	EXPECT_EQ(addresses[1], IPAddress("::1"));
+	addresses = table.lookup("API.Internal.");
+	ASSERT_EQ(addresses.size(), 2u);
+	EXPECT_EQ(addresses[0], IPAddress("10.0.0.1"));
+	EXPECT_EQ(addresses[1], IPAddress("10.0.0.2"));
+	EXPECT_EQ(table.lookup("api").size(), 1u);
+	EXPECT_EQ(table.lookup("ip6-localhost")[0], IPAddress("::1"));
+	EXPECT_TRUE(table.lookup("bad.internal").empty());
+	EXPECT_TRUE(table.lookup("api.internal.example").empty());
+	EXPECT_TRUE(table.lookup("").empty());
+}
+
+TEST(HostTableTest, ManyNames)
+{
+	HostTableBuilder builder;
+	constexpr uint32_t kNames = 20000;
+	for (uint32_t i = 0; i < kNames; i++)
+	{
+		const IPAddress addr(ByteArray4{ 10, static_cast<uint8_t>(i >> 16), static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i) });
+		ASSERT_TRUE(builder.add("host" + std::to_string(i) + ".svc.cluster.local", addr));
+	}
+	TableFile file;
+	builder.write(file.getPath());
+	HostTable table(file.getPath());
+	ASSERT_EQ(table.getNameCount(), kNames);
+	for (uint32_t i = 0; i < kNames; i++)
+	{
+		const Span<const IPAddress> addresses = table.lookup("host" + std::to_string(i) + ".svc.cluster.local");
+		ASSERT_EQ(addresses.size(), 1u);
+		ASSERT_EQ(addresses[0], IPAddress(ByteArray4{ 10, static_cast<uint8_t>(i >> 16), static_cast<uint8_t>(i >> 8),
+		                                              static_cast<uint8_t>(i) }));
+		ASSERT_TRUE(table.lookup("host" + std::to_string(i) + ".svc.cluster").empty());
+	}
+}
+
+TEST(HostTableTest, EmptyAndInvalid)
+{
+	TableFile file;
+	HostTableBuilder().write(file.getPath());
+	HostTable table(file.getPath());
+	EXPECT_EQ(table.getNameCount(), 0u);
+	EXPECT_TRUE(table.lookup("localhost").empty());
+
+	EXPECT_FALSE(HostTableBuilder().add("bad..name", IPAddress("10.0.0.1")));
+	EXPECT_FALSE(HostTableBuilder().add("", IPAddress("10.0.0.1")));
+
+	FILE* out = fopen(file.getPath().c_str(), "wb");
+	fputs("not a host table, but long enough for a header", out);
+	fclose(out);
+	EXPECT_THROW(HostTable(file.getPath()), std::runtime_error);
+	EXPECT_THROW(HostTable("/nonexistent/hosts.table"), std::runtime_error);
+}
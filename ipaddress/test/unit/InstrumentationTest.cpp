@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include "IPAddress.h"
+#include "Instrumentation.h"
+using namespace ip_address;
+
+TEST(InstrumentationTest, Buckets)
+{
+	for (uint64_t value = 0; value < 16; value++)
+	{
+		EXPECT_EQ(Instrumentation::getBucket(value), value);
+	}
+	size_t previous = 0;
+	for (uint64_t value = 1; value < (uint64_t(1) << 40); value = value * 9 / 8 + 1)
+	{
+		const size_t bucket = Instrumentation::getBucket(value);
+		ASSERT_LT(bucket, Instrumentation::kBuckets);
+		EXPECT_GE(bucket, previous);
+		EXPECT_LE(Instrumentation::getBucketLowest(bucket), value);
+		EXPECT_GT(Instrumentation::getBucketLowest(bucket + 1), value);
+		//at most 12.5% wide
+		EXPECT_LE(Instrumentation::getBucketLowest(bucket + 1) - Instrumentation::getBucketLowest(bucket),
+		          std::max<uint64_t>(1, Instrumentation::getBucketLowest(bucket) / 8));
+		previous = bucket;
+	}
+	EXPECT_EQ(Instrumentation::getBucket(UINT64_MAX), Instrumentation::kBuckets - 1);
+}
+
+TEST(InstrumentationTest, Snapshot)
+{
+	using Operation = Instrumentation::Operation;
+	using Event = Instrumentation::Event;
+	const Instrumentation::Snapshot before = Instrumentation::snapshot();
+	for (uint64_t i = 1; i <= 100; i++)
+	{
+		Instrumentation::record(Operation::kResolveV6, i * 1000);
+	}
+	//other threads count into their own slots
+	std::thread thread([]()
+	{
+		Instrumentation::count(Event::kResolveFailed);
+		Instrumentation::record(Operation::kResolveV6, 5000000);
+	});
+	thread.join();
+	Instrumentation::count(Event::kResolveFailed);
+	const Instrumentation::Snapshot after = Instrumentation::snapshot();
+	EXPECT_EQ(after.getCount(Operation::kResolveV6) - before.getCount(Operation::kResolveV6), 101u);
+	EXPECT_EQ(after.getCount(Event::kResolveFailed) - before.getCount(Event::kResolveFailed), 2u);
+	EXPECT_EQ(after.getTotalNanoseconds(Operation::kResolveV6) - before.getTotalNanoseconds(Operation::kResolveV6),
+	          5050000u + 5000000u);
+	if (before.getCount(Operation::kResolveV6) == 0)
+	{
+		const uint64_t median = after.getQuantile(Operation::kResolveV6, 0.5);
+		EXPECT_GE(median, 51000u);
+		EXPECT_LE(median, 51000u * 9 / 8);
+		EXPECT_GE(after.getQuantile(Operation::kResolveV6, 1), 5000000u);
+	}
+
+	const std::string text = after.getPrometheusText();
+	EXPECT_NE(text.find("# TYPE ipaddress_operation_duration_seconds histogram\n"), std::string::npos);
+	EXPECT_NE(text.find("ipaddress_operation_duration_seconds_count{operation=\"resolve_v6\"} " +
+		std::to_string(after.getCount(Operation::kResolveV6)) + "\n"), std::string::npos);
+	EXPECT_NE(text.find("ipaddress_operation_duration_seconds_bucket{operation=\"resolve_v6\",le=\"+Inf\"}"),
+	          std::string::npos);
+	EXPECT_NE(text.find("ipaddress_events_total{event=\"resolve_failed\"} " +
+		std::to_string(after.getCount(Event::kResolveFailed)) + "\n"), std::string::npos);
+	const std::string json = after.getJson();
+	EXPECT_EQ(json.front(), '{');
+	EXPECT_EQ(json.back(), '}');
+	EXPECT_NE(json.find("\"resolve_v6\":{\"count\":" + std::to_string(after.getCount(Operation::kResolveV6))),
+	          std::string::npos);
+}
+
+TEST(InstrumentationTest, Library)
+{
+	using Operation = Instrumentation::Operation;
+	const Instrumentation::Snapshot before = Instrumentation::snapshot();
+	IPAddress addr;
+	ASSERT_TRUE(IPAddress::parseIPAddress(addr, "2001:db8::1"));
+	EXPECT_EQ(addr.getString(), "2001:db8::1");
+	const Instrumentation::Snapshot after = Instrumentation::snapshot();
+	const uint64_t expected = Instrumentation::isEnabled() ? 1 : 0;
+	EXPECT_EQ(after.getCount(Operation::kParse) - before.getCount(Operation::kParse), expected);
+	EXPECT_EQ(after.getCount(Operation::kFormatV6) - before.getCount(Operation::kFormatV6), expected);
+	EXPECT_EQ(after.getCount(Operation::kResolveV4) - before.getCount(Operation::kResolveV4), 0u);
+
+	//a name neither family resolves is one failure, not one per family
+	using Event = Instrumentation::Event;
+	EXPECT_FALSE(IPAddress::parseIPAddress(addr, "no-such-host.invalid"));
+	const Instrumentation::Snapshot failed = Instrumentation::snapshot();
+	EXPECT_EQ(failed.getCount(Event::kParseFailed) - after.getCount(Event::kParseFailed), expected);
+	EXPECT_EQ(failed.getCount(Event::kResolveFailed) - after.getCount(Event::kResolveFailed), expected);
+	EXPECT_EQ(failed.getCount(Operation::kResolveV4) - after.getCount(Operation::kResolveV4), expected);
+	EXPECT_EQ(failed.getCount(Operation::kResolveV6) - after.getCount(Operation::kResolveV6), expected);
+}
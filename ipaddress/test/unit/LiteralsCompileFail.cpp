@@ -0,0 +1,9 @@
+#include "Literals.h"
+using namespace ip_address::literals;
+
+//built by the LiteralsCompileFail tests, which pass when the invalid literal below does not compile
+#if defined(LITERALS_COMPILE_FAIL_V6)
+constexpr ip_address::IPAddressV6 kInvalid = "1:2:3:4:5:6:7:8::"_ipv6;
+#else
+constexpr ip_address::IPAddressV4 kInvalid = "10.0.0.256"_ipv4;
+#endif
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <cstring>
+#include <string>
+#include "IPEndPoint.h"
+#include "Literals.h"
+using namespace ip_address;
+using namespace ip_address::literals;
+
+//evaluated by the compiler, the test fails to build if any of these is false
+static_assert("10.0.0.1"_ipv4 == IPAddressV4(ByteArray4{ 10, 0, 0, 1 }), "");
+static_assert("127.0.0.1"_ipv4 == IPAddressV4::loopback() && "127.0.0.1"_ipv4.isLoopback(), "");
+static_assert("0.0.0.0"_ipv4.isAny() && "255.255.255.255"_ipv4 == IPAddressV4::none(), "");
+static_assert("224.0.0.251"_ipv4.isMulticast() && !"223.255.255.255"_ipv4.isMulticast(), "");
+static_assert("169.254.1.1"_ipv4.isLinkLocal() && "172.20.0.1"_ipv4.isPrivate() && !"8.8.8.8"_ipv4.isPrivate(), "");
+static_assert("10.1.2.3"_ipv4.truncate(8) == "10.0.0.0"_ipv4, "");
+static_assert("10.1.2.3"_ipv4.mask("255.255.0.0"_ipv4) == "10.1.0.0"_ipv4, "");
+static_assert("191.0.0.1"_ipv4.getIPAddressClass() == IPAddressV4Class::B, "");
+
+static_assert("fe80::1"_ipv6.isLinkLocal() && "febf::1"_ipv6.isLinkLocal() && !"fec0::1"_ipv6.isLinkLocal(), "");
+static_assert("::1"_ipv6 == IPAddressV6::loopback() && "::"_ipv6 == IPAddressV6::defaultRoute(), "");
+static_assert("fc00::1"_ipv6.isUniqueLocal() && "fd12:3456::1"_ipv6.isUniqueLocal(), "");
+static_assert("ff02::1"_ipv6.isMulticast() && "2001:db8::1"_ipv6.isGlobalUnicast(), "");
+static_assert("::ffff:192.0.2.1"_ipv6.isIPv4Mapped() && !"::192.0.2.1"_ipv6.isIPv4Mapped(), "");
+static_assert("2001:db8:ffff::1"_ipv6.truncate(33) == "2001:db8:8000::"_ipv6, "");
+static_assert("1:2:3:4:5:6:7:8"_ipv6.bytes()[15] == 8 && "1:2:3:4:5:6:7::"_ipv6.bytes()[14] == 0, "");
+
+static_assert("10.0.0.0/8"_net.contains("10.255.0.1"_ipv4) && !"10.0.0.0/8"_net.contains("11.0.0.1"_ipv4), "");
+static_assert("10.1.2.3/8"_net == IPNetwork("10.0.0.0"_ipv4, 8), "");
+static_assert("fe80::/10"_net.contains("fe80::1"_ipv6) && "fe80::/10"_net.contains("fe80:1::/32"_net), "");
+static_assert("192.0.2.1"_net.getPrefixLength() == 32 && "::1"_net.getPrefixLength() == 128, "");
+
+static_assert(IPAddress("10.0.0.1"_ipv4) == "10.0.0.1"_ipv4 && IPAddress("10.0.0.1"_ipv4) != IPAddress("::1"_ipv6), "");
+static_assert(IPAddress("fe80::1"_ipv6).isLinkLocal() && IPAddress("10.0.0.1"_ipv4).isUnicast(), "");
+static_assert(IPEndPoint("192.0.2.1"_ipv4, 443) == IPEndPoint(ByteArray4{ 192, 0, 2, 1 }, 443), "");
+static_assert(IPEndPoint("::1"_ipv6, 53).getPort() == 53 && IPEndPoint("::1"_ipv6, 53).isIPv6(), "");
+
+namespace
+{
+	const char* kTexts[] = { "0.0.0.0", "10.0.0.1", "255.255.255.255", "256.0.0.1", "1.2.3", "1.2.3.4.5", "01.2.3.4",
+		"1..2.3", "1.2.3.4 ", "", ".", "::", "::1", "1::", "fe80::1", "2001:DB8::1", "1:2:3:4:5:6:7:8",
+		"1:2:3:4:5:6:7::", "::2:3:4:5:6:7:8", "1::2:3:4:5:6:7:8", "1:2:3:4:5:6:7:8:9", ":::", "1:::2", ":1::",
+		"1::2::3", "12345::", "::ffff:192.0.2.1", "::192.0.2.1", "1:2:3:4:5:6:1.2.3.4", "1:2:3:4:5:6:7:1.2.3.4",
+		"::ffff:1.2.3", "::1.2.3.4:5", "fe80::1%eth0", "g::", "1:", ":",
+		"1:2:3:4:5:6:7:8::", "0:0:0:0:0:0:0:0::", "::1:2:3:4:5:6:7:8" };
+}
+
+TEST(LiteralsTest, Parser)
+{
+	for (const char* text : kTexts)
+	{
+		const size_t size = strlen(text);
+		ByteArray4 expected4 = {};
+		ByteArray4 bytes4 = {};
+		const bool valid4 = inet_pton(AF_INET, text, expected4.data()) == 1;
+		ASSERT_EQ(details::parseLiteralV4(text, size, bytes4), valid4) << text;
+		if (valid4)
+		{
+			EXPECT_EQ(bytes4, expected4) << text;
+		}
+
+		ByteArray16 expected6 = {};
+		ByteArray16 bytes6 = {};
+		const bool valid6 = inet_pton(AF_INET6, text, expected6.data()) == 1;
+		ASSERT_EQ(details::parseLiteralV6(text, size, bytes6), valid6) << text;
+		if (valid6)
+		{
+			EXPECT_EQ(bytes6, expected6) << text;
+		}
+	}
+}
+
+TEST(LiteralsTest, Network)
+{
+	for (const char* text : { "10.0.0.0/8", "10.1.2.3/8", "0.0.0.0/0", "192.0.2.1", "fe80::1/10", "::/0",
+		"2001:db8::/129", "10.0.0.0/33", "10.0.0.0/", "10.0.0.0/1000", "10.0.0.0/a", "localhost/8" })
+	{
+		IPNetwork expected;
+		IPNetwork network;
+		const bool valid = IPNetwork::parseIPNetwork(expected, text);
+		ASSERT_EQ(details::parseLiteralNetwork(text, strlen(text), network), valid) << text;
+		if (valid)
+		{
+			EXPECT_EQ(network, expected) << text;
+		}
+	}
+}
+
+TEST(LiteralsTest, Values)
+{
+	EXPECT_EQ("172.217.21.142"_ipv4, IPAddressV4("172.217.21.142"));
+	EXPECT_EQ("2001:db8::1"_ipv6, IPAddressV6("2001:db8::1"));
+	EXPECT_EQ("192.168.0.0/16"_net, IPNetwork("192.168.0.0/16"));
+	EXPECT_EQ(("2001:db8::1"_ipv6).getString(), "2001:db8::1");
+
+	//constexpr objects used at runtime
+	constexpr IPAddress addr = IPAddress("192.0.2.1"_ipv4);
+	EXPECT_EQ(addr.getString(), "192.0.2.1");
+	EXPECT_EQ(addr.asIPv4(), IPAddressV4("192.0.2.1"));
+	constexpr IPEndPoint endpoint("2001:db8::1"_ipv6, 443);
+	EXPECT_EQ(endpoint.getStringWithPort(), IPEndPoint(IPAddressV6("2001:db8::1"), 443).getStringWithPort());
+
+	IPAddress assigned("::1"_ipv6);
+	assigned = "10.0.0.1"_ipv4;
+	EXPECT_TRUE(assigned.isIPv4());
+	EXPECT_EQ(assigned, IPAddressV4("10.0.0.1"));
+	EXPECT_EQ(assigned.getIPv6(), IPAddress("10.0.0.1"_ipv4).getIPv6());
+
+	//assigning an address of the other family to an endpoint changes its version and keeps the port
+	IPEndPoint assignedEndPoint("2001:db8::1"_ipv6, 443);
+	const IPAddressV4 addr4("192.0.2.1");
+	assignedEndPoint = addr4;
+	EXPECT_TRUE(assignedEndPoint.isIPv4());
+	EXPECT_EQ(assignedEndPoint, IPEndPoint("192.0.2.1"_ipv4, 443));
+	EXPECT_EQ(assignedEndPoint.getIPv6(), IPAddress("192.0.2.1"_ipv4).getIPv6());
+	const IPAddressV6 addr6("2001:db8::2");
+	assignedEndPoint = addr6;
+	EXPECT_TRUE(assignedEndPoint.isIPv6());
+	EXPECT_EQ(assignedEndPoint, IPEndPoint("2001:db8::2"_ipv6, 443));
+
+	//an IPv4 address parsed over an IPv6 one keeps none of its bytes
+	IPAddress parsed("2001:db8::1"_ipv6);
+	ASSERT_TRUE(IPAddress::parseIPAddress(parsed, "10.0.0.1"));
+	EXPECT_TRUE(parsed.isIPv4());
+	EXPECT_EQ(parsed.getIPv6(), IPAddress("10.0.0.1"_ipv4).getIPv6());
+}
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "LocalAddressRegistry.h"
+using namespace ip_address;
+
+namespace
+{
+	LocalAddress makeLocal(const char* address, uint8_t prefixLength, uint32_t interfaceIndex = 1)
+	{
+		LocalAddress local;
+		local.address = IPAddress(std::string(address));
+		local.prefixLength = prefixLength;
+		local.interfaceIndex = interfaceIndex;
+		return local;
+	}
+
+	/*
+	 * Adds or deletes an IPv4 address on the loopback interface, returns the netlink error (0, -EPERM, ...).
+	 */
+	int changeLoopbackAddress(uint16_t type, const ByteArray4& address, uint8_t prefixLength)
+	{
+		const int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+		if (fd < 0)
+			return -errno;
+		struct
+		{
+			nlmsghdr header;
+			ifaddrmsg message;
+			char attributes[64];
+		} request = {};
+		request.header.nlmsg_len = NLMSG_LENGTH(sizeof(ifaddrmsg));
+		request.header.nlmsg_type = type;
+		request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | (type == RTM_NEWADDR ? NLM_F_CREATE | NLM_F_EXCL : 0);
+		request.message.ifa_family = AF_INET;
+		request.message.ifa_prefixlen = prefixLength;
+		request.message.ifa_index = if_nametoindex("lo");
+		for (const uint16_t attributeType : { IFA_LOCAL, IFA_ADDRESS })
+		{
+			auto* attribute = reinterpret_cast<rtattr*>(reinterpret_cast<char*>(&request) +
+			                                            NLMSG_ALIGN(request.header.nlmsg_len));
+			attribute->rta_type = attributeType;
+			attribute->rta_len = RTA_LENGTH(address.size());
+			memcpy(RTA_DATA(attribute), address.data(), address.size());
+			request.header.nlmsg_len = NLMSG_ALIGN(request.header.nlmsg_len) + RTA_ALIGN(attribute->rta_len);
+		}
+		int result = -EIO;
+		char buffer[4096];
+		if (send(fd, &request, request.header.nlmsg_len, 0) >= 0 && recv(fd, buffer, sizeof(buffer), 0) > 0)
+		{
+			const auto* header = reinterpret_cast<const nlmsghdr*>(buffer);
+			if (header->nlmsg_type == NLMSG_ERROR)
+				result = static_cast<const nlmsgerr*>(NLMSG_DATA(header))->error;
+		}
+		close(fd);
+		return result;
+	}
+
+	template <typename Condition>
+	bool waitFor(Condition condition)
+	{
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (!condition())
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+				return false;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return true;
+	}
+}
+
+TEST(LocalAddressRegistryTest, Lookup)
+{
+	LocalAddressRegistry registry({ makeLocal("127.0.0.1", 8), makeLocal("192.0.2.2", 24, 2),
+	                                makeLocal("192.0.2.130", 25, 3), makeLocal("::1", 128),
+	                                makeLocal("2001:db8::2", 64, 2), makeLocal("fe80::1", 64, 2) });
+	EXPECT_EQ(registry.size(), 6u);
+	EXPECT_TRUE(registry.isLocal(IPAddress(std::string("192.0.2.2"))));
+	EXPECT_TRUE(registry.isLocal(IPAddressV4("192.0.2.130")));
+	EXPECT_TRUE(registry.isLocal(IPAddress(std::string("2001:db8::2"))));
+	EXPECT_TRUE(registry.isLocal(IPAddressV6("fe80::1")));
+	EXPECT_FALSE(registry.isLocal(IPAddress(std::string("192.0.2.3"))));
+	EXPECT_FALSE(registry.isLocal(IPAddress(std::string("2001:db8::3"))));
+	EXPECT_FALSE(registry.isLocal(IPAddress(std::string("0.0.0.0"))));
+	EXPECT_FALSE(registry.isLocal(IPAddress(std::string("::"))));
+	EXPECT_FALSE(registry.isLocal(IPAddress()));
+
+	IPNetwork network;
+	uint32_t interfaceIndex = 0;
+	ASSERT_TRUE(registry.getPrefix(IPAddress(std::string("192.0.2.200")), network, &interfaceIndex));
+	EXPECT_EQ(network.getString(), IPNetwork("192.0.2.128/25").getString());
+	EXPECT_EQ(interfaceIndex, 3u);
+	ASSERT_TRUE(registry.getPrefix(IPAddress(std::string("192.0.2.7")), network, &interfaceIndex));
+	EXPECT_EQ(network.getString(), IPNetwork("192.0.2.0/24").getString());
+	EXPECT_EQ(interfaceIndex, 2u);
+	ASSERT_TRUE(registry.getPrefix(IPAddress(std::string("2001:db8::ffff")), network));
+	EXPECT_EQ(network.getPrefixLength(), 64);
+	EXPECT_FALSE(registry.getPrefix(IPAddress(std::string("198.51.100.1")), network));
+	EXPECT_FALSE(registry.getPrefix(IPAddress(std::string("2001:db8:1::1")), network));
+}
+
+TEST(LocalAddressRegistryTest, Updates)
+{
+	LocalAddressRegistry registry(std::vector<LocalAddress>{});
+	EXPECT_EQ(registry.size(), 0u);
+	EXPECT_FALSE(registry.isLocal(IPAddress(std::string("10.0.0.1"))));
+	const uint64_t generation = registry.getGeneration();
+
+	EXPECT_TRUE(registry.add(makeLocal("10.0.0.1", 8)));
+	EXPECT_FALSE(registry.add(makeLocal("10.0.0.1", 8)));
+	//the same address on a second interface is a second entry
+	EXPECT_TRUE(registry.add(makeLocal("10.0.0.1", 8, 2)));
+	EXPECT_TRUE(registry.isLocal(IPAddress(std::string("10.0.0.1"))));
+	EXPECT_EQ(registry.getGeneration(), generation + 2);
+
+	EXPECT_TRUE(registry.remove(makeLocal("10.0.0.1", 8)));
+	EXPECT_FALSE(registry.remove(makeLocal("10.0.0.1", 8)));
+	EXPECT_TRUE(registry.isLocal(IPAddress(std::string("10.0.0.1"))));
+	EXPECT_TRUE(registry.remove(makeLocal("10.0.0.1", 8, 2)));
+	EXPECT_FALSE(registry.isLocal(IPAddress(std::string("10.0.0.1"))));
+	EXPECT_TRUE(registry.getAddresses().empty());
+
+	//enough addresses to grow the hash set several times
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		registry.add(makeLocal(("10.1." + std::to_string(i / 256) + "." + std::to_string(i % 256)).c_str(), 16));
+	}
+	EXPECT_EQ(registry.size(), 1000u);
+	EXPECT_TRUE(registry.isLocal(IPAddress(std::string("10.1.3.231"))));
+	EXPECT_FALSE(registry.isLocal(IPAddress(std::string("10.1.3.232"))));
+}
+
+TEST(LocalAddressRegistryTest, ConcurrentReaders)
+{
+	LocalAddressRegistry registry({ makeLocal("192.0.2.2", 24) });
+	std::atomic<bool> stop{ false };
+	std::atomic<uint64_t> lookups{ 0 };
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; t++)
+	{
+		readers.emplace_back([&registry, &stop, &lookups]()
+		{
+			const IPAddress permanent(std::string("192.0.2.2"));
+			while (!stop.load())
+			{
+				//the permanent address is in every snapshot
+				EXPECT_TRUE(registry.isLocal(permanent));
+				lookups++;
+			}
+		});
+	}
+	while (lookups.load() == 0)
+	{
+		std::this_thread::yield();
+	}
+	for (uint32_t i = 0; i < 200; i++)
+	{
+		const LocalAddress changing = makeLocal(("198.51.100." + std::to_string(i % 50)).c_str(), 24);
+		if (!registry.remove(changing))
+			registry.add(changing);
+	}
+	stop = true;
+	for (auto& reader : readers)
+	{
+		reader.join();
+	}
+	EXPECT_EQ(registry.size(), 1u);
+}
+
+TEST(LocalAddressRegistryTest, Netlink)
+{
+	LocalAddressRegistry registry;
+	EXPECT_TRUE(registry.isLocal(IPAddress(std::string("127.0.0.1"))));
+	IPNetwork network;
+	uint32_t interfaceIndex = 0;
+	ASSERT_TRUE(registry.getPrefix(IPAddress(std::string("127.1.2.3")), network, &interfaceIndex));
+	EXPECT_EQ(network.getPrefixLength(), 8);
+	EXPECT_EQ(interfaceIndex, if_nametoindex("lo"));
+
+	const ByteArray4 address = { 198, 51, 100, 77 };
+	const int added = changeLoopbackAddress(RTM_NEWADDR, address, 32);
+	if (added == -EPERM || added == -EACCES)
+		GTEST_SKIP() << "adding an address needs CAP_NET_ADMIN";
+	ASSERT_EQ(added, 0);
+	EXPECT_TRUE(waitFor([&registry, &address]() { return registry.isLocal(IPAddressV4(address)); }));
+	EXPECT_TRUE(registry.getPrefix(IPAddress(address), network) && network.getPrefixLength() == 32);
+	ASSERT_EQ(changeLoopbackAddress(RTM_DELADDR, address, 32), 0);
+	EXPECT_TRUE(waitFor([&registry, &address]() { return !registry.isLocal(IPAddressV4(address)); }));
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "LogFilter.h"
+using namespace ip_address;
+
+namespace
+{
+	std::vector<IPNetwork> getPrefixes()
+	{
+		return { IPNetwork("10.0.0.0/8"), IPNetwork("10.1.0.0/16"), IPNetwork("2001:db8::/32"), IPNetwork("192.0.2.0/24") };
+	}
+
+	std::string makeLog(size_t lines, std::vector<size_t>& expectedCounts, std::string& expectedLines)
+	{
+		const char* addresses[] = { "10.2.3.4", "10.1.0.9", "2001:db8::7", "192.0.2.55", "198.51.100.1", "2001:db9::1",
+			"[2001:db8::8]:443", "10.1.1.1:8080", "-" };
+		const size_t prefixes[] = { 0, 1, 2, 3, SIZE_MAX, SIZE_MAX, 2, 1, SIZE_MAX };
+		std::mt19937 rng(44);
+		std::string text;
+		expectedCounts.assign(4, 0);
+		for (size_t i = 0; i < lines; i++)
+		{
+			const size_t pick = rng() % 9;
+			const std::string line = std::string(addresses[pick]) + " - - [01/May/2024:12:30:45 +0000] \"GET /" +
+				std::to_string(i) + " HTTP/1.1\" 200\n";
+			text += line;
+			if (prefixes[pick] != SIZE_MAX)
+			{
+				expectedCounts[prefixes[pick]]++;
+				expectedLines += line;
+			}
+		}
+		return text;
+	}
+}
+
+TEST(LogFilterTest, MatchLine)
+{
+	const LogFilter byColumn(getPrefixes(), { 2, 0, 1, 1 << 20 });
+	size_t prefix = 0;
+	ASSERT_TRUE(byColumn.matchLine("  a\tb  10.1.2.3 d\r\n", prefix));
+	EXPECT_EQ(prefix, 1u);
+	ASSERT_TRUE(byColumn.matchLine("a b [2001:db8::1]", prefix));
+	EXPECT_EQ(prefix, 2u);
+	EXPECT_FALSE(byColumn.matchLine("a b", prefix));
+	EXPECT_FALSE(byColumn.matchLine("a b 198.51.100.1", prefix));
+	EXPECT_FALSE(byColumn.matchLine("a b 10.1.2.3x", prefix));
+	EXPECT_FALSE(byColumn.matchLine("a b 10.1.2.3:1:2", prefix));
+	EXPECT_FALSE(byColumn.matchLine("", prefix));
+
+	const LogFilter csv(getPrefixes(), { 1, ',', 1, 1 << 20 });
+	ASSERT_TRUE(csv.matchLine("x,192.0.2.1:53,y", prefix));
+	EXPECT_EQ(prefix, 3u);
+	ASSERT_TRUE(csv.matchLine(",10.9.9.9", prefix));
+	EXPECT_EQ(prefix, 0u);
+	EXPECT_FALSE(csv.matchLine("x, 10.9.9.9", prefix));
+	EXPECT_FALSE(csv.matchLine("10.9.9.9", prefix));
+}
+
+TEST(LogFilterTest, FilterAndCount)
+{
+	std::vector<size_t> expectedCounts;
+	std::string expectedLines;
+	const std::string text = makeLog(3000, expectedCounts, expectedLines);
+	//chunks of a few lines on several threads, results have to come back in order
+	for (const size_t threads : { 1, 3, 8 })
+	{
+		for (const size_t chunkSize : { 1, 100, 1000, 1 << 20 })
+		{
+			const LogFilter filter(getPrefixes(), { 0, 0, threads, chunkSize });
+			std::string lines;
+			const size_t matched = filter.filter(text, [&lines](std::string_view chunk) { lines.append(chunk); });
+			EXPECT_EQ(lines, expectedLines) << threads << " " << chunkSize;
+			std::vector<uint64_t> counts;
+			EXPECT_EQ(filter.count(text, counts), matched);
+			ASSERT_EQ(counts.size(), 4u);
+			for (size_t i = 0; i < counts.size(); i++)
+			{
+				EXPECT_EQ(counts[i], expectedCounts[i]) << i;
+			}
+		}
+	}
+	//no newline at the end
+	const LogFilter filter(getPrefixes());
+	std::string lines;
+	EXPECT_EQ(filter.filter("198.51.100.1 a\n10.0.0.1 b", [&lines](std::string_view chunk) { lines.append(chunk); }), 1u);
+	EXPECT_EQ(lines, "10.0.0.1 b");
+}
+
+TEST(LogFilterTest, Files)
+{
+	std::vector<size_t> expectedCounts;
+	std::string expectedLines;
+	const std::string text = makeLog(1000, expectedCounts, expectedLines);
+	char path[] = "/tmp/ipaddress_log_XXXXXX";
+	const int fd = mkstemp(path);
+	ASSERT_GE(fd, 0);
+	ASSERT_EQ(write(fd, text.data(), text.size()), static_cast<ssize_t>(text.size()));
+	close(fd);
+	const LogFilter filter(getPrefixes(), { 0, 0, 4, 4096 });
+	std::string lines;
+	filter.filterFile(path, [&lines](std::string_view chunk) { lines.append(chunk); });
+	EXPECT_EQ(lines, expectedLines);
+	std::vector<uint64_t> counts;
+	filter.countFile(path, counts);
+	EXPECT_EQ(counts[1], expectedCounts[1]);
+
+	//an exception of the sink stops the workers
+	size_t calls = 0;
+	EXPECT_THROW(filter.filterFile(path, [&calls](std::string_view) { if (++calls == 3) throw std::runtime_error("full"); }),
+	             std::runtime_error);
+	EXPECT_EQ(calls, 3u);
+	unlink(path);
+	EXPECT_THROW(filter.countFile(path, counts), std::runtime_error);
+}
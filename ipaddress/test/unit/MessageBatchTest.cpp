@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include "MessageBatch.h"
+using namespace ip_address;
+
+TEST(IPEndPointTest, SockaddrConstructor)
+{
+	sockaddr_in6 addr6 = IPAddressV6("2001:db8::7").getSockaddrIn6();
+	addr6.sin6_port = htons(4433);
+	const IPEndPoint endpoint6(reinterpret_cast<const sockaddr*>(&addr6), sizeof(addr6));
+	EXPECT_TRUE(endpoint6.isIPv6());
+	EXPECT_EQ(endpoint6.getPort(), 4433);
+	EXPECT_EQ(endpoint6.asIPv6(), IPAddressV6("2001:db8::7"));
+
+	sockaddr_in addr4 = IPAddressV4("192.0.2.10").getSockaddrIn4();
+	addr4.sin_port = htons(53);
+	const IPEndPoint endpoint4(reinterpret_cast<const sockaddr*>(&addr4), sizeof(addr4));
+	EXPECT_EQ(endpoint4, IPEndPoint(IPAddressV4("192.0.2.10"), port_host_byte_order_t(53)));
+
+	IPEndPoint copy;
+	copy = endpoint6;
+	EXPECT_EQ(copy, endpoint6);
+}
+
+TEST(IPEndPointTest, SockaddrBatch)
+{
+	const IPEndPoint endpoints[3] = {
+		IPEndPoint(IPAddressV4("10.1.2.3"), port_host_byte_order_t(1000)),
+		IPEndPoint(IPAddressV6("fe80::1:2"), port_host_byte_order_t(2000)),
+		IPEndPoint(IPAddressV4("127.0.0.1"), port_host_byte_order_t(3000)),
+	};
+	sockaddr_storage names[4];
+	memset(names, 0xAB, sizeof(names));
+	socklen_t lengths[3];
+	IPEndPoint::toSockaddrs(endpoints, 3, names, lengths);
+	EXPECT_EQ(lengths[0], sizeof(sockaddr_in));
+	EXPECT_EQ(lengths[1], sizeof(sockaddr_in6));
+	const auto* name4 = reinterpret_cast<const sockaddr_in*>(&names[0]);
+	EXPECT_EQ(name4->sin_family, AF_INET);
+	EXPECT_EQ(ntohs(name4->sin_port), 1000);
+	EXPECT_EQ(ntohl(name4->sin_addr.s_addr), 0x0A010203u);
+	for (const auto b : name4->sin_zero)
+		EXPECT_EQ(b, 0);
+	const auto* name6 = reinterpret_cast<const sockaddr_in6*>(&names[1]);
+	EXPECT_EQ(name6->sin6_flowinfo, 0u);
+	EXPECT_EQ(name6->sin6_scope_id, 0u);
+
+	names[3].ss_family = AF_UNIX;
+	IPEndPoint decoded[4];
+	IPEndPoint::fromSockaddrs(names, 4, decoded);
+	for (size_t i = 0; i < 3; i++)
+		EXPECT_EQ(decoded[i], endpoints[i]);
+	EXPECT_EQ(decoded[3].getVersion(), IPVersion::kUnknown);
+}
+
+#ifdef __linux__
+TEST(UdpMessageBatchTest, LoopbackRoundTrip)
+{
+	const int receiver = socket(AF_INET, SOCK_DGRAM, 0);
+	const int sender = socket(AF_INET, SOCK_DGRAM, 0);
+	ASSERT_GE(receiver, 0);
+	ASSERT_GE(sender, 0);
+	sockaddr_in bound = IPAddressV4::loopback().getSockaddrIn4();
+	ASSERT_EQ(bind(receiver, reinterpret_cast<sockaddr*>(&bound), sizeof(bound)), 0);
+	socklen_t boundLength = sizeof(bound);
+	ASSERT_EQ(getsockname(receiver, reinterpret_cast<sockaddr*>(&bound), &boundLength), 0);
+	sockaddr_in senderName = IPAddressV4::loopback().getSockaddrIn4();
+	ASSERT_EQ(bind(sender, reinterpret_cast<sockaddr*>(&senderName), sizeof(senderName)), 0);
+	socklen_t senderLength = sizeof(senderName);
+	ASSERT_EQ(getsockname(sender, reinterpret_cast<sockaddr*>(&senderName), &senderLength), 0);
+
+	char payload[8][16];
+	UdpMessageBatch<8> out;
+	const IPEndPoint destination(bound);
+	for (size_t i = 0; i < 8; i++)
+	{
+		snprintf(payload[i], sizeof(payload[i]), "datagram %zu", i);
+		out.setBuffer(i, payload[i], sizeof(payload[i]));
+		out.setMessage(i, destination, strlen(payload[i]) + 1);
+	}
+	ASSERT_EQ(out.send(sender, 8), 8);
+
+	char buffers[8][64];
+	UdpMessageBatch<8> in;
+	for (size_t i = 0; i < in.capacity(); i++)
+		in.setBuffer(i, buffers[i], sizeof(buffers[i]));
+	int received = 0;
+	while (received < 8)
+	{
+		const int n = in.receive(receiver, MSG_WAITFORONE);
+		ASSERT_GT(n, 0);
+		for (int i = 0; i < n; i++)
+		{
+			EXPECT_EQ(in.getEndPoints()[i], IPEndPoint(senderName));
+			EXPECT_STREQ(buffers[i], payload[received + i]);
+			EXPECT_EQ(in.getLength(i), strlen(payload[received + i]) + 1);
+		}
+		received += n;
+	}
+	close(sender);
+	close(receiver);
+}
+
+TEST(UdpMessageBatchTest, ReceiveAfterShortReply)
+{
+	const int server = socket(AF_INET, SOCK_DGRAM, 0);
+	const int client = socket(AF_INET, SOCK_DGRAM, 0);
+	ASSERT_GE(server, 0);
+	ASSERT_GE(client, 0);
+	sockaddr_in bound = IPAddressV4::loopback().getSockaddrIn4();
+	ASSERT_EQ(bind(server, reinterpret_cast<sockaddr*>(&bound), sizeof(bound)), 0);
+	socklen_t boundLength = sizeof(bound);
+	ASSERT_EQ(getsockname(server, reinterpret_cast<sockaddr*>(&bound), &boundLength), 0);
+
+	char buffers[4][64];
+	UdpMessageBatch<4> batch;
+	for (size_t i = 0; i < batch.capacity(); i++)
+		batch.setBuffer(i, buffers[i], sizeof(buffers[i]));
+	const char shortPayload[] = "hi";
+	ASSERT_EQ(sendto(client, shortPayload, sizeof(shortPayload), 0, reinterpret_cast<sockaddr*>(&bound), sizeof(bound)),
+		static_cast<ssize_t>(sizeof(shortPayload)));
+	ASSERT_EQ(batch.receive(server, MSG_WAITFORONE), 1);
+	//the echo shortens the first message to the 3 bytes received
+	ASSERT_EQ(batch.reply(server, 1), 1);
+	char echo[64];
+	ASSERT_EQ(recv(client, echo, sizeof(echo), 0), static_cast<ssize_t>(sizeof(shortPayload)));
+
+	char longPayload[48];
+	memset(longPayload, 'x', sizeof(longPayload));
+	ASSERT_EQ(sendto(client, longPayload, sizeof(longPayload), 0, reinterpret_cast<sockaddr*>(&bound), sizeof(bound)),
+		static_cast<ssize_t>(sizeof(longPayload)));
+	ASSERT_EQ(batch.receive(server, MSG_WAITFORONE), 1);
+	EXPECT_EQ(batch.getLength(0), sizeof(longPayload));
+	EXPECT_EQ(batch.getMessages()[0].msg_hdr.msg_flags & MSG_TRUNC, 0);
+	close(client);
+	close(server);
+}
+#endif
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "PackedAddressList.h"
+using namespace ip_address;
+
+namespace
+{
+	std::vector<IPAddressV4> makeAddressesV4(size_t count, uint64_t seed, uint32_t spread)
+	{
+		std::mt19937_64 rng(seed);
+		std::vector<uint32_t> keys;
+		for (size_t i = 0; i < count; i++)
+		{
+			keys.push_back(static_cast<uint32_t>(rng() % spread));
+		}
+		std::sort(keys.begin(), keys.end());
+		std::vector<IPAddressV4> addresses;
+		for (const uint32_t key : keys)
+		{
+			addresses.push_back(details::AddressKey<IPAddressV4>::toAddress(key));
+		}
+		return addresses;
+	}
+
+	std::vector<IPAddressV6> makeAddressesV6(size_t count, uint64_t seed)
+	{
+		std::mt19937_64 rng(seed);
+		std::vector<details::Uint128> keys;
+		for (size_t i = 0; i < count; i++)
+		{
+			//a few /48 sites with hosts in a handful of /64 subnets
+			const uint64_t site = 0x20010db800000000ULL | (rng() % 16) << 16;
+			keys.push_back({ site | rng() % 4, rng() % 1024 });
+		}
+		std::sort(keys.begin(), keys.end());
+		std::vector<IPAddressV6> addresses;
+		for (const details::Uint128& key : keys)
+		{
+			addresses.push_back(details::AddressKey<IPAddressV6>::toAddress(key));
+		}
+		return addresses;
+	}
+
+	template <typename Address>
+	std::vector<Address> roundTrip(const std::vector<Address>& addresses)
+	{
+		const std::vector<uint8_t> data = PackedAddressList::encode(Span<const Address>(addresses.data(), addresses.size()));
+		const PackedAddressList list(Span<const uint8_t>(data.data(), data.size()));
+		EXPECT_EQ(list.size(), addresses.size());
+		std::vector<Address> decoded;
+		list.decode(decoded);
+		return decoded;
+	}
+}
+
+TEST(PackedAddressListTest, RoundTripV4)
+{
+	for (const size_t count : { 0, 1, 2, 127, 128, 129, 1000, 100000 })
+	{
+		const std::vector<IPAddressV4> addresses = makeAddressesV4(count, count, 1u << 24);
+		EXPECT_EQ(roundTrip(addresses), addresses) << count;
+	}
+	//full bit width and duplicates
+	const std::vector<IPAddressV4> extremes = { IPAddressV4("0.0.0.0"), IPAddressV4("0.0.0.0"), IPAddressV4("10.0.0.1"),
+	                                            IPAddressV4("255.255.255.255") };
+	EXPECT_EQ(roundTrip(extremes), extremes);
+	for (uint32_t spread : { 1u, 2u, 1000u, ~0u })
+	{
+		const std::vector<IPAddressV4> addresses = makeAddressesV4(5000, spread, spread);
+		EXPECT_EQ(roundTrip(addresses), addresses) << spread;
+	}
+}
+
+TEST(PackedAddressListTest, RoundTripV6)
+{
+	for (const size_t count : { 0, 1, 127, 128, 129, 10000 })
+	{
+		const std::vector<IPAddressV6> addresses = makeAddressesV6(count, count);
+		EXPECT_EQ(roundTrip(addresses), addresses) << count;
+	}
+	const std::vector<IPAddressV6> extremes = { IPAddressV6("::"), IPAddressV6("::1"), IPAddressV6("::1"),
+	                                            IPAddressV6("2001:db8::1"), IPAddressV6("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff") };
+	EXPECT_EQ(roundTrip(extremes), extremes);
+}
+
+TEST(PackedAddressListTest, RandomAccess)
+{
+	const std::vector<IPAddressV4> addresses = makeAddressesV4(1000, 7, 1u << 20);
+	const std::vector<uint8_t> data = PackedAddressList::encode(Span<const IPAddressV4>(addresses.data(), addresses.size()));
+	const PackedAddressList list(Span<const uint8_t>(data.data(), data.size()));
+	ASSERT_EQ(list.getBlockCount(), 8u);
+	EXPECT_FALSE(list.isIPv6());
+	EXPECT_LT(data.size(), addresses.size() * 4 / 2);
+
+	uint32_t keys[PackedAddressList::kBlockSize];
+	EXPECT_EQ(list.decodeBlock(7, keys), 1000u - 7 * 128);
+	EXPECT_EQ(details::AddressKey<IPAddressV4>::toAddress(keys[0]), addresses[7 * 128]);
+	EXPECT_EQ(list.getFirstV4(7), addresses[7 * 128]);
+	EXPECT_EQ(list.decodeBlock(3, keys), 128u);
+	EXPECT_EQ(details::AddressKey<IPAddressV4>::toAddress(keys[127]), addresses[4 * 128 - 1]);
+
+	for (const IPAddressV4& addr4 : addresses)
+	{
+		EXPECT_TRUE(list.contains(addr4));
+	}
+	EXPECT_FALSE(list.contains(IPAddressV4("255.0.0.1")));
+	EXPECT_FALSE(list.contains(IPAddressV6("::1")));
+
+	const std::vector<IPAddressV6> addresses6 = makeAddressesV6(1000, 8);
+	const std::vector<uint8_t> data6 = PackedAddressList::encode(Span<const IPAddressV6>(addresses6.data(), addresses6.size()));
+	const PackedAddressList list6(Span<const uint8_t>(data6.data(), data6.size()));
+	EXPECT_TRUE(list6.isIPv6());
+	EXPECT_EQ(list6.getFirstV6(2), addresses6[256]);
+	for (const IPAddressV6& addr6 : addresses6)
+	{
+		EXPECT_TRUE(list6.contains(addr6));
+	}
+	EXPECT_FALSE(list6.contains(IPAddressV6("2001:db8:ffff::1")));
+	EXPECT_FALSE(list6.contains(IPAddressV4("10.0.0.1")));
+}
+
+TEST(PackedAddressListTest, Invalid)
+{
+	const std::vector<IPAddressV4> unsorted = { IPAddressV4("10.0.0.2"), IPAddressV4("10.0.0.1") };
+	EXPECT_THROW((void)PackedAddressList::encode(Span<const IPAddressV4>(unsorted.data(), unsorted.size())),
+	             std::runtime_error);
+
+	const std::vector<IPAddressV4> addresses = makeAddressesV4(300, 1, 1u << 24);
+	std::vector<uint8_t> data = PackedAddressList::encode(Span<const IPAddressV4>(addresses.data(), addresses.size()));
+	//truncated blocks, directory and header
+	for (const size_t size : { data.size() - 1, size_t(16 + 3 * 16 - 1), size_t(15), size_t(0) })
+	{
+		EXPECT_THROW(PackedAddressList(Span<const uint8_t>(data.data(), size)), std::runtime_error) << size;
+	}
+	data[0] = 'X';
+	EXPECT_THROW(PackedAddressList(Span<const uint8_t>(data.data(), data.size())), std::runtime_error);
+}
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "PacketClassifier.h"
+using namespace ip_address;
+
+namespace
+{
+	PacketRule makeRule(const char* source, const char* destination, port_host_byte_order_t destinationPortFirst,
+	                    port_host_byte_order_t destinationPortLast, uint8_t protocol, uint32_t priority = 0)
+	{
+		PacketRule rule;
+		if (source != nullptr)
+			rule.source = IPNetwork(source);
+		if (destination != nullptr)
+			rule.destination = IPNetwork(destination);
+		rule.destinationPortFirst = destinationPortFirst;
+		rule.destinationPortLast = destinationPortLast;
+		rule.protocolFirst = protocol;
+		rule.protocolLast = protocol;
+		rule.priority = priority;
+		return rule;
+	}
+
+	FlowKey makeFlow(const char* source, port_host_byte_order_t sourcePort, const char* destination,
+	                 port_host_byte_order_t destinationPort, uint8_t protocol = IPPROTO_TCP)
+	{
+		return FlowKey(IPEndPoint(IPAddress(source), sourcePort), IPEndPoint(IPAddress(destination), destinationPort),
+		               protocol);
+	}
+
+	size_t classify(const PacketClassifier& classifier, const FlowKey& flow)
+	{
+		size_t rule = 0;
+		const bool found = classifier.classify(flow, rule);
+		EXPECT_EQ(found, rule != PacketClassifier::kNoMatch);
+		return rule;
+	}
+
+	bool containsAddress(const IPNetwork& network, const IPAddress& addr)
+	{
+		return network.getVersion() == IPVersion::kUnknown ? true : network.contains(addr);
+	}
+
+	//the rules in priority order, the first that matches
+	size_t classifyLinear(const std::vector<PacketRule>& rules, const FlowKey& flow)
+	{
+		const IPEndPoint source = flow.getSource();
+		const IPEndPoint destination = flow.getDestination();
+		size_t best = PacketClassifier::kNoMatch;
+		for (size_t i = 0; i < rules.size(); i++)
+		{
+			const PacketRule& rule = rules[i];
+			if (containsAddress(rule.source, source) && containsAddress(rule.destination, destination) &&
+				source.getPort() >= rule.sourcePortFirst && source.getPort() <= rule.sourcePortLast &&
+				destination.getPort() >= rule.destinationPortFirst && destination.getPort() <= rule.destinationPortLast &&
+				flow.getProtocol() >= rule.protocolFirst && flow.getProtocol() <= rule.protocolLast &&
+				(best == PacketClassifier::kNoMatch || rule.priority < rules[best].priority))
+			{
+				best = i;
+			}
+		}
+		return best;
+	}
+
+	IPNetwork makeNetwork(std::mt19937_64& rng, bool v6)
+	{
+		//prefix lengths clustered like real ACLs
+		static const uint8_t kLengthsV4[] = { 16, 16, 20, 20, 24, 24, 24, 28, 32, 32 };
+		static const uint8_t kLengthsV6[] = { 40, 44, 48, 48, 56, 64, 64, 96, 128, 128 };
+		const uint64_t value = rng();
+		//a small address space so that the rules overlap
+		if (!v6)
+		{
+			const ByteArray4 bytes = { 10, static_cast<uint8_t>(value % 64), static_cast<uint8_t>(value >> 8),
+				static_cast<uint8_t>(value >> 16) };
+			return IPNetwork(IPAddressV4(bytes), kLengthsV4[(value >> 32) % 10]);
+		}
+		ByteArray16 bytes = { 0x20, 0x01, 0x0d, 0xb8, 0, static_cast<uint8_t>(value % 64) };
+		bytes[6] = static_cast<uint8_t>(value >> 8);
+		bytes[15] = static_cast<uint8_t>(value >> 16);
+		return IPNetwork(IPAddressV6(bytes), kLengthsV6[(value >> 32) % 10]);
+	}
+
+	std::vector<PacketRule> makeRules(size_t count, uint64_t seed)
+	{
+		std::mt19937_64 rng(seed);
+		std::vector<PacketRule> rules;
+		for (size_t i = 0; i < count; i++)
+		{
+			const bool v6 = rng() % 3 == 0;
+			PacketRule rule;
+			rule.source = makeNetwork(rng, v6);
+			rule.destination = makeNetwork(rng, v6);
+			if (rng() % 20 == 0)
+				rule.source = IPNetwork();
+			if (rng() % 3 == 0)
+			{
+				rule.sourcePortFirst = 1024;
+			}
+			switch (rng() % 4)
+			{
+			case 0:
+				break;
+			case 1:
+				rule.destinationPortFirst = rule.destinationPortLast = static_cast<port_host_byte_order_t>(rng() % 64);
+				break;
+			case 2:
+				rule.destinationPortFirst = static_cast<port_host_byte_order_t>(rng() % 64);
+				rule.destinationPortLast = static_cast<port_host_byte_order_t>(rule.destinationPortFirst + rng() % 16);
+				break;
+			default:
+				rule.destinationPortLast = 1023;
+				break;
+			}
+			if (rng() % 3 != 0)
+				rule.protocolFirst = rule.protocolLast = rng() % 2 == 0 ? IPPROTO_TCP : IPPROTO_UDP;
+			rule.priority = static_cast<uint32_t>(rng() % 4);
+			rules.push_back(rule);
+		}
+		return rules;
+	}
+
+	FlowKey makeRandomFlow(std::mt19937_64& rng, const std::vector<PacketRule>& rules)
+	{
+		//an address in the rule space, the other fields often inside a rule
+		const PacketRule& rule = rules[rng() % rules.size()];
+		const bool v6 = rule.source.getVersion() == IPVersion::kIPv6 || rule.destination.getVersion() == IPVersion::kIPv6;
+		const IPNetwork source = makeNetwork(rng, v6);
+		const IPNetwork destination = rng() % 2 == 0 && rule.destination.getVersion() != IPVersion::kUnknown ?
+			rule.destination : makeNetwork(rng, v6);
+		const auto sourcePort = static_cast<port_host_byte_order_t>(rng() % 2 == 0 ? rng() % 2048 : rng());
+		const auto destinationPort = static_cast<port_host_byte_order_t>(rng() % 2 == 0 ?
+			rule.destinationPortFirst + rng() % 4 : rng() % 128);
+		const uint8_t protocol = rng() % 4 == 0 ? IPPROTO_ICMP : rng() % 2 == 0 ? IPPROTO_TCP : IPPROTO_UDP;
+		return FlowKey(IPEndPoint(source.getAddress(), sourcePort), IPEndPoint(destination.getAddress(), destinationPort),
+		               protocol);
+	}
+}
+
+TEST(PacketClassifierTest, Basic)
+{
+	const std::vector<PacketRule> rules = {
+		//0: ssh from the management network, ahead of rule 1 by priority
+		makeRule("10.1.0.0/16", nullptr, 22, 22, IPPROTO_TCP, 1),
+		//1: no ssh to anything
+		makeRule(nullptr, nullptr, 22, 22, IPPROTO_TCP, 2),
+		//2: web servers, IPv4 only
+		makeRule(nullptr, "192.0.2.0/24", 80, 443, IPPROTO_TCP, 2),
+		//3: same priority as 2 but later, only reached for IPv6
+		makeRule(nullptr, nullptr, 80, 443, IPPROTO_TCP, 2),
+		//4: dns
+		makeRule("2001:db8::/32", "2001:db8:53::/48", 53, 53, IPPROTO_UDP, 0),
+		//5: one host before everything
+		makeRule("10.1.2.3", nullptr, 22, 22, IPPROTO_TCP, 0),
+	};
+	const PacketClassifier classifier(rules);
+	EXPECT_EQ(classifier.getRules().size(), rules.size());
+	EXPECT_EQ(classify(classifier, makeFlow("10.1.2.3", 50000, "192.0.2.1", 22)), 5u);
+	EXPECT_EQ(classify(classifier, makeFlow("10.1.2.4", 50000, "192.0.2.1", 22)), 0u);
+	EXPECT_EQ(classify(classifier, makeFlow("10.2.0.1", 50000, "192.0.2.1", 22)), 1u);
+	EXPECT_EQ(classify(classifier, makeFlow("2001:db8::1", 50000, "2001:db8::2", 22)), 1u);
+	EXPECT_EQ(classify(classifier, makeFlow("10.2.0.1", 50000, "192.0.2.1", 80)), 2u);
+	EXPECT_EQ(classify(classifier, makeFlow("10.2.0.1", 50000, "192.0.2.1", 443)), 2u);
+	EXPECT_EQ(classify(classifier, makeFlow("10.2.0.1", 50000, "198.51.100.1", 443)), 3u);
+	EXPECT_EQ(classify(classifier, makeFlow("2001:db8::1", 50000, "2001:db9::1", 80)), 3u);
+	EXPECT_EQ(classify(classifier, makeFlow("2001:db8::1", 50000, "2001:db8:53::1", 53, IPPROTO_UDP)), 4u);
+	EXPECT_EQ(classify(classifier, makeFlow("2001:db8::1", 50000, "2001:db8:53::1", 53)), PacketClassifier::kNoMatch);
+	EXPECT_EQ(classify(classifier, makeFlow("10.2.0.1", 50000, "192.0.2.1", 444)), PacketClassifier::kNoMatch);
+
+	size_t rule = 0;
+	EXPECT_TRUE(classifier.classify(IPEndPoint(IPAddressV4("10.1.9.9"), port_host_byte_order_t(1)),
+		IPEndPoint(IPAddressV4("192.0.2.1"), port_host_byte_order_t(22)), IPPROTO_TCP, rule));
+	EXPECT_EQ(rule, 0u);
+	EXPECT_FALSE(classifier.classify(IPEndPoint(IPAddressV4("10.1.9.9"), port_host_byte_order_t(1)),
+		IPEndPoint(IPAddressV6("2001:db8::1"), port_host_byte_order_t(22)), IPPROTO_TCP, rule));
+	EXPECT_EQ(rule, PacketClassifier::kNoMatch);
+
+	EXPECT_EQ(classify(PacketClassifier({}), makeFlow("10.0.0.1", 1, "10.0.0.2", 2)), PacketClassifier::kNoMatch);
+	EXPECT_THROW(PacketClassifier({ makeRule("10.0.0.0/8", "2001:db8::/32", 0, 65535, 6) }), std::runtime_error);
+	EXPECT_THROW(PacketClassifier({ makeRule(nullptr, nullptr, 443, 80, 6) }), std::runtime_error);
+}
+
+TEST(PacketClassifierTest, Random)
+{
+	for (const size_t leafSize : { 1, 4, 8, 32 })
+	{
+		const std::vector<PacketRule> rules = makeRules(1000, leafSize);
+		PacketClassifier::Options options;
+		options.leafSize = leafSize;
+		const PacketClassifier classifier(rules, options);
+		EXPECT_GE(classifier.getLeafEntryCount(), rules.size() / 2);
+
+		std::mt19937_64 rng(leafSize);
+		std::vector<FlowKey> flows;
+		for (size_t i = 0; i < 5000; i++)
+		{
+			flows.push_back(makeRandomFlow(rng, rules));
+		}
+		std::vector<size_t> results(flows.size());
+		classifier.classify(Span<const FlowKey>(flows.data(), flows.size()), Span<size_t>(results.data(), results.size()));
+		size_t matched = 0;
+		for (size_t i = 0; i < flows.size(); i++)
+		{
+			const size_t expected = classifyLinear(rules, flows[i]);
+			ASSERT_EQ(results[i], expected) << i << " leafSize " << leafSize;
+			size_t rule = 0;
+			const FlowKey& flow = flows[i];
+			EXPECT_EQ(classifier.classify(flow.getSource(), flow.getDestination(), flow.getProtocol(), rule),
+			          expected != PacketClassifier::kNoMatch);
+			ASSERT_EQ(rule, expected);
+			matched += expected != PacketClassifier::kNoMatch ? 1 : 0;
+		}
+		//the flows hit rules often enough to test the priorities
+		EXPECT_GT(matched, flows.size() / 10);
+		EXPECT_LT(matched, flows.size());
+	}
+}
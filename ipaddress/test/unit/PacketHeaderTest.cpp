@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "PacketHeader.h"
+using namespace ip_address;
+
+namespace
+{
+	std::vector<uint8_t> makeIPv4(uint8_t protocol, uint16_t fragment = 0, uint8_t options = 0)
+	{
+		std::vector<uint8_t> packet(20 + options + 8, 0);
+		packet[0] = static_cast<uint8_t>(0x40 | (5 + options / 4));
+		packet[6] = static_cast<uint8_t>(fragment >> 8);
+		packet[7] = static_cast<uint8_t>(fragment);
+		packet[9] = protocol;
+		const uint8_t addresses[8] = { 192, 0, 2, 1, 198, 51, 100, 2 };
+		memcpy(&packet[12], addresses, sizeof(addresses));
+		const uint8_t ports[4] = { 0x30, 0x39, 0x00, 0x50 }; //12345 -> 80
+		memcpy(&packet[20 + options], ports, sizeof(ports));
+		return packet;
+	}
+
+	std::vector<uint8_t> makeIPv6(const std::vector<uint8_t>& extensions, uint8_t first)
+	{
+		std::vector<uint8_t> packet(40, 0);
+		packet[0] = 0x60;
+		packet[6] = first;
+		const ByteArray16 source = IPAddressV6("2001:db8::1").bytes();
+		const ByteArray16 destination = IPAddressV6("2001:db8::2").bytes();
+		memcpy(&packet[8], source.data(), 16);
+		memcpy(&packet[24], destination.data(), 16);
+		packet.insert(packet.end(), extensions.begin(), extensions.end());
+		const uint8_t transport[8] = { 0x01, 0xBB, 0xC3, 0x50 }; //443 -> 50000
+		packet.insert(packet.end(), transport, transport + sizeof(transport));
+		return packet;
+	}
+}
+
+TEST(PacketHeaderTest, IPv4)
+{
+	PacketHeader header;
+	auto packet = makeIPv4(IPPROTO_TCP, 0, 8);
+	ASSERT_TRUE(PacketHeader::parsePacketHeader(header, packet.data(), packet.size()));
+	EXPECT_EQ(header.getVersion(), IPVersion::kIPv4);
+	EXPECT_EQ(header.getSource(), IPEndPoint(IPAddressV4("192.0.2.1"), port_host_byte_order_t(12345)));
+	EXPECT_EQ(header.getDestination(), IPEndPoint(IPAddressV4("198.51.100.2"), port_host_byte_order_t(80)));
+	EXPECT_EQ(header.getProtocol(), IPPROTO_TCP);
+	EXPECT_EQ(header.getTransportOffset(), 28);
+	EXPECT_TRUE(header.hasPorts());
+
+	//ICMP has no ports, later fragments carry no transport header
+	packet = makeIPv4(IPPROTO_ICMP);
+	ASSERT_TRUE(PacketHeader::parsePacketHeader(header, packet.data(), packet.size()));
+	EXPECT_FALSE(header.hasPorts());
+	EXPECT_EQ(header.getSource().getPort(), 0);
+	packet = makeIPv4(IPPROTO_UDP, 0x0010);
+	ASSERT_TRUE(PacketHeader::parsePacketHeader(header, packet.data(), packet.size()));
+	EXPECT_TRUE(header.isLaterFragment());
+	EXPECT_FALSE(header.hasPorts());
+
+	//truncated captures
+	EXPECT_FALSE(PacketHeader::parsePacketHeader(header, packet.data(), 19));
+	EXPECT_EQ(header.getVersion(), IPVersion::kUnknown);
+	packet = makeIPv4(IPPROTO_UDP);
+	ASSERT_TRUE(PacketHeader::parsePacketHeader(header, packet.data(), 22));
+	EXPECT_FALSE(header.hasPorts());
+	packet[0] = 0x44; //IHL below the minimum
+	EXPECT_FALSE(PacketHeader::parsePacketHeader(header, packet.data(), packet.size()));
+}
+
+TEST(PacketHeaderTest, IPv6ExtensionHeaders)
+{
+	PacketHeader header;
+	auto packet = makeIPv6({}, IPPROTO_UDP);
+	ASSERT_TRUE(PacketHeader::parsePacketHeader(header, Span<const uint8_t>(packet.data(), packet.size())));
+	EXPECT_EQ(header.getSource(), IPEndPoint(IPAddressV6("2001:db8::1"), port_host_byte_order_t(443)));
+	EXPECT_EQ(header.getDestination(), IPEndPoint(IPAddressV6("2001:db8::2"), port_host_byte_order_t(50000)));
+	EXPECT_EQ(header.getTransportOffset(), 40);
+
+	//hop-by-hop (8 bytes) -> routing (24 bytes) -> fragment (first) -> destination options (16 bytes) -> TCP
+	std::vector<uint8_t> extensions;
+	const uint8_t hopByHop[8] = { IPPROTO_ROUTING, 0 };
+	extensions.insert(extensions.end(), hopByHop, hopByHop + 8);
+	uint8_t routing[24] = { IPPROTO_FRAGMENT, 2 };
+	extensions.insert(extensions.end(), routing, routing + 24);
+	const uint8_t fragment[8] = { IPPROTO_DSTOPTS, 0, 0x00, 0x01 };
+	extensions.insert(extensions.end(), fragment, fragment + 8);
+	const uint8_t destination[16] = { IPPROTO_TCP, 1 };
+	extensions.insert(extensions.end(), destination, destination + 16);
+	packet = makeIPv6(extensions, IPPROTO_HOPOPTS);
+	ASSERT_TRUE(PacketHeader::parsePacketHeader(header, packet.data(), packet.size()));
+	EXPECT_EQ(header.getProtocol(), IPPROTO_TCP);
+	EXPECT_EQ(header.getTransportOffset(), 40 + 56);
+	EXPECT_TRUE(header.hasPorts());
+	EXPECT_EQ(header.getSource().getPort(), 443);
+
+	//authentication header, payload length counts 4 byte words minus 2
+	const uint8_t ah[12] = { IPPROTO_UDP, 1 };
+	packet = makeIPv6(std::vector<uint8_t>(ah, ah + 12), IPPROTO_AH);
+	ASSERT_TRUE(PacketHeader::parsePacketHeader(header, packet.data(), packet.size()));
+	EXPECT_EQ(header.getProtocol(), IPPROTO_UDP);
+	EXPECT_EQ(header.getDestination().getPort(), 50000);
+
+	//later fragment
+	const uint8_t later[8] = { IPPROTO_UDP, 0, 0x05, 0x00 };
+	packet = makeIPv6(std::vector<uint8_t>(later, later + 8), IPPROTO_FRAGMENT);
+	ASSERT_TRUE(PacketHeader::parsePacketHeader(header, packet.data(), packet.size()));
+	EXPECT_TRUE(header.isLaterFragment());
+	EXPECT_FALSE(header.hasPorts());
+
+	//extension header cut off by the capture length
+	packet = makeIPv6(extensions, IPPROTO_HOPOPTS);
+	ASSERT_TRUE(PacketHeader::parsePacketHeader(header, packet.data(), 41));
+	EXPECT_EQ(header.getProtocol(), IPPROTO_NONE);
+	EXPECT_EQ(header.getSource().asIPv6(), IPAddressV6("2001:db8::1"));
+	EXPECT_FALSE(PacketHeader::parsePacketHeader(header, packet.data(), 39));
+}
+
+TEST(PacketHeaderTest, Batch)
+{
+	const auto packet4 = makeIPv4(IPPROTO_UDP);
+	const auto packet6 = makeIPv6({}, IPPROTO_TCP);
+	const uint8_t garbage[4] = { 0x12, 0x34, 0x56, 0x78 };
+	const Span<const uint8_t> ring[3] = {
+		Span<const uint8_t>(packet4.data(), packet4.size()),
+		Span<const uint8_t>(garbage, sizeof(garbage)),
+		Span<const uint8_t>(packet6.data(), packet6.size()),
+	};
+	PacketHeader headers[3];
+	EXPECT_EQ(PacketHeader::parsePacketHeaders(ring, 3, headers), 2u);
+	EXPECT_EQ(headers[0].getVersion(), IPVersion::kIPv4);
+	EXPECT_EQ(headers[1].getVersion(), IPVersion::kUnknown);
+	EXPECT_EQ(headers[2].getVersion(), IPVersion::kIPv6);
+	EXPECT_EQ(headers[2].getDestination().getPort(), 50000);
+}
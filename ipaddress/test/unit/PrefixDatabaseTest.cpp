@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "PrefixDatabase.h"
+using namespace ip_address;
+
+namespace
+{
+	class DatabaseFile
+	{
+	public:
+		DatabaseFile()
+		{
+			char path[] = "/tmp/ipaddress_prefixes_XXXXXX";
+			close(mkstemp(path));
+			mPath = path;
+		}
+		~DatabaseFile() { unlink(mPath.c_str()); }
+		const std::string& getPath() const { return mPath; }
+	private:
+		std::string mPath;
+	};
+
+	struct Prefix
+	{
+		IPNetwork network;
+		std::string value;
+	};
+
+	//longest match by scanning every prefix, later ones win on equal networks like in the builder
+	bool findLongest(const std::vector<Prefix>& prefixes, const IPAddress& addr, std::string& value, uint8_t& length)
+	{
+		bool found = false;
+		for (const Prefix& prefix : prefixes)
+		{
+			if (prefix.network.contains(addr) && (!found || prefix.network.getPrefixLength() >= length))
+			{
+				value = prefix.value;
+				length = prefix.network.getPrefixLength();
+				found = true;
+			}
+		}
+		return found;
+	}
+
+	void expectSameMatches(const PrefixDatabase& database, const std::vector<Prefix>& prefixes,
+	                       const std::vector<IPAddress>& queries)
+	{
+		for (const IPAddress& query : queries)
+		{
+			std::string expected;
+			uint8_t expectedLength = 0;
+			const bool found = findLongest(prefixes, query, expected, expectedLength);
+			std::string_view value;
+			uint8_t length = 0;
+			ASSERT_EQ(database.lookup(query, value, &length), found) << query.getString();
+			if (found)
+			{
+				EXPECT_EQ(value, expected) << query.getString();
+				EXPECT_EQ(length, expectedLength) << query.getString();
+			}
+		}
+	}
+}
+
+TEST(PrefixDatabaseTest, Lines)
+{
+	std::istringstream lines(
+		"# network value\n"
+		"0.0.0.0/0 default\n"
+		"10.0.0.0/8\tAS64500 private\n"
+		"10.1.0.0/16 AS64501\n"
+		"10.1.2.3/32 AS64502\r\n"
+		"2001:db8::/32 AS64510\n"
+		"2001:db8:1::/48 AS64511\n"
+		"10.0.0.0/33 invalid\n"
+		"not-a-prefix AS1\n"
+		"\n");
+	PrefixDatabaseBuilder builder;
+	EXPECT_EQ(builder.addLines(lines), 2u);
+	EXPECT_EQ(builder.getPrefixCount(), 6u);
+	DatabaseFile file;
+	builder.write(file.getPath());
+
+	PrefixDatabase database(file.getPath());
+	EXPECT_TRUE(database.verify());
+	EXPECT_EQ(database.getPrefixCountV4(), 4u);
+	EXPECT_EQ(database.getPrefixCountV6(), 2u);
+	std::string_view value;
+	uint8_t length = 0;
+	ASSERT_TRUE(database.lookup(IPAddressV4("10.1.2.3"), value, &length));
+	EXPECT_EQ(value, "AS64502");
+	EXPECT_EQ(length, 32);
+	ASSERT_TRUE(database.lookup(IPAddressV4("10.1.2.4"), value, &length));
+	EXPECT_EQ(value, "AS64501");
+	EXPECT_EQ(length, 16);
+	ASSERT_TRUE(database.lookup(IPAddress(std::string("10.200.0.1")), value));
+	EXPECT_EQ(value, "AS64500 private");
+	ASSERT_TRUE(database.lookup(IPAddressV4("192.0.2.1"), value, &length));
+	EXPECT_EQ(value, "default");
+	EXPECT_EQ(length, 0);
+	ASSERT_TRUE(database.lookup(IPAddressV6("2001:db8:1:2::1"), value, &length));
+	EXPECT_EQ(value, "AS64511");
+	EXPECT_EQ(length, 48);
+	ASSERT_TRUE(database.lookup(IPAddress(std::string("2001:db8:2::1")), value));
+	EXPECT_EQ(value, "AS64510");
+	EXPECT_FALSE(database.lookup(IPAddressV6("2001:db9::1"), value));
+	EXPECT_FALSE(database.lookup(IPAddress(), value));
+}
+
+TEST(PrefixDatabaseTest, MatchesLinearScan)
+{
+	std::mt19937_64 rng(41);
+	std::vector<Prefix> prefixes;
+	std::vector<IPAddress> queries;
+	PrefixDatabaseBuilder builder;
+	for (size_t i = 0; i < 2000; i++)
+	{
+		//a narrow address range makes prefixes nest and share nodes
+		const uint32_t key4 = 0x0A000000 | static_cast<uint32_t>(rng() & 0x00FF0FFF);
+		const IPAddressV4 addr4 = details::AddressKey<IPAddressV4>::toAddress(key4);
+		const auto length4 = static_cast<uint8_t>(rng() % 33);
+		prefixes.push_back({ IPNetwork(addr4, length4), "v4-" + std::to_string(i % 300) });
+		ByteArray16 bytes6 = { 0x20, 0x01, 0x0d, 0xb8, 0, static_cast<uint8_t>(rng() % 4) };
+		for (size_t b = 6; b < 16; b++)
+		{
+			bytes6[b] = static_cast<uint8_t>(rng() % 3 == 0 ? rng() : 0);
+		}
+		const auto length6 = static_cast<uint8_t>(rng() % 129);
+		prefixes.push_back({ IPNetwork(IPAddressV6(bytes6), length6), "v6-" + std::to_string(i % 300) });
+		queries.emplace_back(addr4);
+		queries.emplace_back(details::AddressKey<IPAddressV4>::toAddress(key4 ^ static_cast<uint32_t>(1 << (rng() % 32))));
+		queries.emplace_back(bytes6);
+		bytes6[rng() % 16] ^= static_cast<uint8_t>(1 << (rng() % 8));
+		queries.emplace_back(bytes6);
+	}
+	//replacing a value of an existing network
+	prefixes.push_back({ prefixes[10].network, "replaced" });
+	for (const Prefix& prefix : prefixes)
+	{
+		ASSERT_TRUE(builder.add(prefix.network, prefix.value));
+	}
+	const std::vector<uint8_t> data = builder.build();
+	PrefixDatabase database(Span<const uint8_t>(data.data(), data.size()));
+	EXPECT_TRUE(database.verify());
+	expectSameMatches(database, prefixes, queries);
+}
+
+TEST(PrefixDatabaseTest, Empty)
+{
+	const std::vector<uint8_t> data = PrefixDatabaseBuilder().build();
+	PrefixDatabase database(Span<const uint8_t>(data.data(), data.size()));
+	EXPECT_TRUE(database.verify());
+	std::string_view value;
+	EXPECT_FALSE(database.lookup(IPAddressV4("10.0.0.1"), value));
+	EXPECT_FALSE(database.lookup(IPAddressV6("::1"), value));
+
+	PrefixDatabaseBuilder builder;
+	builder.add(IPNetwork("::/0"), "any");
+	const std::vector<uint8_t> any = builder.build();
+	PrefixDatabase anyDatabase(Span<const uint8_t>(any.data(), any.size()));
+	EXPECT_FALSE(anyDatabase.lookup(IPAddressV4("10.0.0.1"), value));
+	ASSERT_TRUE(anyDatabase.lookup(IPAddressV6("ffff::1"), value));
+	EXPECT_EQ(value, "any");
+}
+
+TEST(PrefixDatabaseTest, Invalid)
+{
+	EXPECT_THROW(PrefixDatabase("/nonexistent/prefixes.db"), std::runtime_error);
+	PrefixDatabaseBuilder builder;
+	builder.add(IPNetwork("192.0.2.0/24"), "TEST-NET-1");
+	builder.add(IPNetwork("2001:db8::/32"), "DOCUMENTATION");
+	std::vector<uint8_t> data = builder.build();
+	EXPECT_THROW(PrefixDatabase(Span<const uint8_t>(data.data(), data.size() - 1)), std::runtime_error);
+	EXPECT_THROW(PrefixDatabase(Span<const uint8_t>(data.data(), 16)), std::runtime_error);
+
+	//a flipped bit in a section is only found by verify()
+	data[data.size() - 1] ^= 1;
+	PrefixDatabase corrupt(Span<const uint8_t>(data.data(), data.size()));
+	EXPECT_FALSE(corrupt.verify());
+	data[data.size() - 1] ^= 1;
+	data[0] ^= 1;
+	EXPECT_THROW(PrefixDatabase(Span<const uint8_t>(data.data(), data.size())), std::runtime_error);
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PrefixLookupService.h"
+using namespace ip_address;
+
+namespace
+{
+	/*
+	 * Database of generation in which every value is "<generation>:" followed by a pattern derived from the
+	 * generation, so a reader can tell a torn or freed value from a valid one.
+	 */
+	std::unique_ptr<PrefixDatabase> makeDatabase(uint64_t generation)
+	{
+		const std::string value = std::to_string(generation) + ":" + std::string(32, static_cast<char>('a' + generation % 26));
+		PrefixDatabaseBuilder builder;
+		builder.add(IPNetwork("10.0.0.0/8"), value);
+		builder.add(IPNetwork("10.1.0.0/16"), value + "/16");
+		builder.add(IPNetwork("2001:db8::/32"), value);
+		return std::make_unique<PrefixDatabase>(builder.build());
+	}
+
+	bool isValid(std::string_view value, uint64_t& generation)
+	{
+		const size_t colon = value.find(':');
+		if (colon == std::string_view::npos)
+			return false;
+		generation = std::stoull(std::string(value.substr(0, colon)));
+		return value.substr(colon + 1, 32) == std::string(32, static_cast<char>('a' + generation % 26));
+	}
+
+	template <typename Condition>
+	bool waitFor(Condition&& condition)
+	{
+		for (int i = 0; i < 2000 && !condition(); i++)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		return condition();
+	}
+}
+
+TEST(PrefixLookupServiceTest, Reload)
+{
+	std::atomic<uint64_t> loads{ 0 };
+	PrefixLookupService service([&loads]() { return makeDatabase(++loads); });
+	EXPECT_EQ(service.getGeneration(), 1u);
+	PrefixLookupService::Reader reader(service);
+	std::string_view value;
+	uint8_t length = 0;
+	ASSERT_TRUE(reader.lookup(IPAddress(std::string("10.1.2.3")), value, &length));
+	EXPECT_EQ(value.substr(0, 2), "1:");
+	EXPECT_EQ(length, 16);
+	EXPECT_FALSE(reader.lookup(IPAddressV4("192.0.2.1"), value));
+
+	//the value of the last lookup stays valid while the reader is online
+	ASSERT_TRUE(reader.lookup(IPAddressV6("2001:db8::1"), value));
+	const std::string before(value);
+	service.requestReload();
+	ASSERT_TRUE(waitFor([&service]() { return service.getGeneration() == 2; }));
+	EXPECT_TRUE(waitFor([&service]() { return service.getRetiredCount() == 1; }));
+	EXPECT_EQ(std::string(value), before);
+
+	ASSERT_TRUE(reader.lookup(IPAddressV4("10.0.0.1"), value));
+	EXPECT_EQ(value.substr(0, 2), "2:");
+	EXPECT_TRUE(waitFor([&service]() { return service.getRetiredCount() == 0; }));
+
+	//an offline reader does not hold back reclamation
+	reader.offline();
+	service.requestReload();
+	ASSERT_TRUE(waitFor([&service]() { return service.getGeneration() == 3; }));
+	EXPECT_TRUE(waitFor([&service]() { return service.getRetiredCount() == 0; }));
+	ASSERT_TRUE(reader.lookup(IPAddressV4("10.0.0.1"), value));
+	EXPECT_EQ(value.substr(0, 2), "3:");
+}
+
+TEST(PrefixLookupServiceTest, FailedReload)
+{
+	std::atomic<int> calls{ 0 };
+	PrefixLookupService service([&calls]() -> std::unique_ptr<PrefixDatabase>
+	{
+		const int call = calls++;
+		if (call == 1)
+			throw std::runtime_error("source unavailable");
+		if (call == 2)
+			return nullptr;
+		return makeDatabase(static_cast<uint64_t>(call));
+	});
+	service.requestReload();
+	ASSERT_TRUE(waitFor([&service]() { return service.getFailedReloads() == 1; }));
+	service.requestReload();
+	ASSERT_TRUE(waitFor([&calls]() { return calls == 3; }));
+	EXPECT_EQ(service.getGeneration(), 1u);
+	service.requestReload();
+	ASSERT_TRUE(waitFor([&service]() { return service.getGeneration() == 2; }));
+
+	PrefixLookupService::Reader reader(service);
+	std::string_view value;
+	ASSERT_TRUE(reader.lookup(IPAddressV4("10.0.0.1"), value));
+	EXPECT_EQ(value.substr(0, 2), "3:");
+
+	EXPECT_THROW(PrefixLookupService([]() { return std::unique_ptr<PrefixDatabase>(); }), std::runtime_error);
+}
+
+TEST(PrefixLookupServiceTest, ReadersDuringReloads)
+{
+	std::atomic<uint64_t> loads{ 0 };
+	PrefixLookupService service([&loads]() { return makeDatabase(++loads); }, std::chrono::milliseconds(1));
+	std::atomic<bool> stop{ false };
+	std::atomic<size_t> errors{ 0 };
+	std::atomic<size_t> lookups{ 0 };
+	std::vector<std::thread> readers;
+	for (size_t t = 0; t < 4; t++)
+	{
+		readers.emplace_back([&service, &stop, &errors, &lookups, t]()
+		{
+			PrefixLookupService::Reader reader(service);
+			uint64_t last = 0;
+			size_t count = 0;
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				std::string_view value;
+				uint64_t generation = 0;
+				const bool found = (count & 1) != 0 ? reader.lookup(IPAddressV6("2001:db8::1"), value)
+				                                    : reader.lookup(IPAddressV4("10.1.0.1"), value);
+				//generations never go backwards for one reader
+				if (!found || !isValid(value, generation) || generation < last)
+					errors++;
+				last = generation;
+				if (t == 0 && ++count % 4096 == 0)
+					reader.offline();
+				else if (t != 0)
+					count++;
+			}
+			lookups += count;
+		});
+	}
+	//a writer thread requesting reloads on top of the periodic ones
+	std::thread requester([&service, &stop]()
+	{
+		while (!stop.load(std::memory_order_relaxed))
+		{
+			service.requestReload();
+			std::this_thread::yield();
+		}
+	});
+	EXPECT_TRUE(waitFor([&service]() { return service.getGeneration() >= 200; }));
+	stop = true;
+	requester.join();
+	for (std::thread& reader : readers)
+	{
+		reader.join();
+	}
+	EXPECT_EQ(errors.load(), 0u);
+	EXPECT_GT(lookups.load(), 0u);
+	EXPECT_EQ(service.getFailedReloads(), 0u);
+	EXPECT_TRUE(waitFor([&service]() { return service.getRetiredCount() == 0; }));
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "Literals.h"
+#include "PrefixSet.h"
+using namespace ip_address;
+using namespace ip_address::literals;
+
+namespace
+{
+	constexpr IPNetwork kPrivate[] = { "192.168.0.0/16"_net, "10.0.0.0/8"_net, "172.16.0.0/12"_net, "fc00::/7"_net,
+		"10.20.0.0/16"_net, "fe80::/10"_net };
+	constexpr auto kPrivateSet = makePrefixSet<kPrivate>();
+
+	//more than kLinearV4 and kLinearV6 ranges, with overlapping and adjacent networks
+	constexpr IPNetwork kLarge[] = { "1.0.0.0/24"_net, "1.0.1.0/24"_net, "1.0.2.0/23"_net, "5.5.5.5"_net,
+		"8.8.8.0/24"_net, "9.0.0.0/8"_net, "9.128.0.0/9"_net, "20.0.0.0/7"_net, "23.0.0.0/8"_net, "31.13.64.0/18"_net,
+		"45.0.0.0/16"_net, "64.233.160.0/19"_net, "66.102.0.0/20"_net, "100.64.0.0/10"_net, "127.0.0.0/8"_net,
+		"169.254.0.0/16"_net, "192.0.2.0/24"_net, "198.18.0.0/15"_net, "203.0.113.0/24"_net, "224.0.0.0/4"_net,
+		"240.0.0.0/4"_net, "0.0.0.0/32"_net, "2001:db8::/32"_net, "2001:db9::/32"_net, "2001::/23"_net,
+		"2002::/16"_net, "2400:cb00::/32"_net, "2606:4700::/32"_net, "2a03:2880::/32"_net, "64:ff9b::/96"_net,
+		"::1"_net, "::"_net, "fe80::/10"_net, "ff00::/8"_net, "100::/64"_net, "3fff::/20"_net };
+	constexpr auto kLargeSet = makePrefixSet<kLarge>();
+}
+
+//192.168/16, 10/8 with 10.20/16 inside it and 172.16/12, fc00::/7 and fe80::/10
+static_assert(kPrivateSet.kCountV4 == 3 && kPrivateSet.kCountV6 == 2 && kPrivateSet.getSize() == 5, "");
+static_assert(kPrivateSet.contains("10.20.30.40"_ipv4) && kPrivateSet.contains("172.31.255.255"_ipv4), "");
+static_assert(!kPrivateSet.contains("172.32.0.0"_ipv4) && !kPrivateSet.contains("11.0.0.0"_ipv4), "");
+static_assert(kPrivateSet.contains("fd00::1"_ipv6) && !kPrivateSet.contains("fec0::1"_ipv6), "");
+static_assert(kPrivateSet.contains(IPAddress("192.168.1.1"_ipv4)) && !kPrivateSet.contains(IPAddress()), "");
+//1.0.0.0/22 merged, 9/8 covers 9.128/9, 20/7 and 23/8 stay apart, 224/4 and 240/4 merged,
+//2001:db8::/32 and 2001:db9::/32 merged but not into 2001::/23, :: and ::1 merged
+static_assert(kLargeSet.kCountV4 == 18 && kLargeSet.kCountV6 == 12, "");
+static_assert(kLargeSet.contains("1.0.3.255"_ipv4) && !kLargeSet.contains("1.0.4.0"_ipv4), "");
+static_assert(kLargeSet.contains("255.255.255.255"_ipv4) && kLargeSet.contains("0.0.0.0"_ipv4), "");
+static_assert(!kLargeSet.contains("0.0.0.1"_ipv4) && !kLargeSet.contains("22.0.0.0"_ipv4), "");
+static_assert(kLargeSet.contains("::1"_ipv6) && !kLargeSet.contains("::2"_ipv6), "");
+static_assert(kLargeSet.contains("2001:1ff:ffff::1"_ipv6) && !kLargeSet.contains("2001:200::"_ipv6), "");
+static_assert(kLargeSet.contains("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"_ipv6), "");
+
+namespace
+{
+	template <size_t Size>
+	bool containsLinear(const IPNetwork (&networks)[Size], const IPAddress& addr)
+	{
+		for (const IPNetwork& network : networks)
+		{
+			if (network.contains(addr))
+				return true;
+		}
+		return false;
+	}
+
+	template <typename Bytes>
+	void step(Bytes& bytes, bool up)
+	{
+		for (size_t i = bytes.size(); i-- > 0;)
+		{
+			bytes[i] = static_cast<uint8_t>(up ? bytes[i] + 1 : bytes[i] - 1);
+			if (bytes[i] != (up ? 0 : 0xFF))
+				break;
+		}
+	}
+
+	//the first and last address of the network, the addresses next to them, one inside and one anywhere
+	template <typename Bytes>
+	void addProbes(const Bytes& first, uint8_t prefixLength, std::mt19937_64& rng, std::vector<IPAddress>& probes)
+	{
+		Bytes last = first;
+		Bytes inside = first;
+		Bytes random = first;
+		for (size_t i = 0; i < first.size(); i++)
+		{
+			const size_t bit = i * 8;
+			const auto host = static_cast<uint8_t>(bit >= prefixLength ? 0xFF : bit + 8 <= prefixLength ? 0 :
+				0xFF >> (prefixLength - bit));
+			last[i] = static_cast<uint8_t>(first[i] | host);
+			inside[i] = static_cast<uint8_t>((first[i] & ~host) | (rng() & host));
+			random[i] = static_cast<uint8_t>(rng());
+		}
+		Bytes before = first;
+		step(before, false);
+		Bytes after = last;
+		step(after, true);
+		for (const Bytes& bytes : { first, last, inside, random, before, after })
+		{
+			probes.emplace_back(bytes);
+		}
+	}
+
+	template <size_t Size, typename Set>
+	void checkSet(const IPNetwork (&networks)[Size], const Set& set)
+	{
+		std::mt19937_64 rng(11);
+		std::vector<IPAddress> probes;
+		for (size_t i = 0; i < 1000; i++)
+		{
+			for (const IPNetwork& network : networks)
+			{
+				if (network.getVersion() == IPVersion::kIPv4)
+					addProbes(network.getAddress().getIPv4().bytes(), network.getPrefixLength(), rng, probes);
+				else
+					addProbes(network.getAddress().getIPv6().bytes(), network.getPrefixLength(), rng, probes);
+			}
+		}
+		for (const IPAddress& addr : probes)
+		{
+			ASSERT_EQ(set.contains(addr), containsLinear(networks, addr)) << addr.getString();
+		}
+	}
+}
+
+TEST(PrefixSetTest, Private)
+{
+	checkSet(kPrivate, kPrivateSet);
+	EXPECT_TRUE(kPrivateSet.contains(IPAddressV4("10.255.255.255")));
+	EXPECT_FALSE(kPrivateSet.contains(IPAddressV4("9.255.255.255")));
+	EXPECT_FALSE(kPrivateSet.contains(IPAddress(IPAddressV6("::ffff:10.0.0.1"))));
+}
+
+TEST(PrefixSetTest, Large)
+{
+	checkSet(kLarge, kLargeSet);
+	EXPECT_TRUE(kLargeSet.contains(IPAddress(IPAddressV6("2a03:2880::1"))));
+	EXPECT_FALSE(kLargeSet.contains(IPAddressV6("2a03:2881::")));
+}
+
+TEST(PrefixSetTest, SingleVersion)
+{
+	static constexpr IPNetwork kDefault[] = { "0.0.0.0/0"_net };
+	constexpr auto set = makePrefixSet<kDefault>();
+	static_assert(set.kCountV4 == 1 && set.kCountV6 == 0, "");
+	EXPECT_TRUE(set.contains(IPAddressV4("203.0.113.7")));
+	EXPECT_FALSE(set.contains(IPAddressV6("::")));
+	EXPECT_FALSE(set.contains(IPAddress()));
+}
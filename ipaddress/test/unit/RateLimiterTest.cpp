@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "RateLimiter.h"
+using namespace ip_address;
+
+namespace
+{
+	constexpr uint64_t kSecond = 1000000000ULL;
+}
+
+TEST(RateLimiterTest, BurstAndRefill)
+{
+	RateLimiter limiter(10.0, 5, 1024);
+	const IPAddress client("192.0.2.1");
+	const uint64_t start = 100 * kSecond;
+	for (int i = 0; i < 5; i++)
+		EXPECT_TRUE(limiter.admit(client, start));
+	EXPECT_FALSE(limiter.admit(client, start));
+	EXPECT_EQ(limiter.getTokens(client, start), 0u);
+	//10 tokens per second, one token after 100ms
+	EXPECT_FALSE(limiter.admit(client, start + kSecond / 20));
+	EXPECT_TRUE(limiter.admit(client, start + kSecond / 10));
+	EXPECT_FALSE(limiter.admit(client, start + kSecond / 10));
+	EXPECT_EQ(limiter.getTokens(client, start + 10 * kSecond), 5u);
+	EXPECT_FALSE(limiter.admit(client, start + 10 * kSecond, 6));
+	//other clients have their own bucket
+	EXPECT_TRUE(limiter.admit(IPAddress("192.0.2.2"), start));
+}
+
+TEST(RateLimiterTest, PrefixKeys)
+{
+	RateLimiter limiter(1.0, 2, 1024, 24, 64);
+	const uint64_t now = 50 * kSecond;
+	EXPECT_TRUE(limiter.admit(IPAddressV4("198.51.100.1"), now));
+	EXPECT_TRUE(limiter.admit(IPAddressV4("198.51.100.200"), now));
+	EXPECT_FALSE(limiter.admit(IPAddressV4("198.51.100.7"), now));
+	EXPECT_TRUE(limiter.admit(IPAddressV4("198.51.101.7"), now));
+
+	EXPECT_TRUE(limiter.admit(IPAddressV6("2001:db8::1"), now));
+	EXPECT_TRUE(limiter.admit(IPAddressV6("2001:db8::ffff:1"), now));
+	EXPECT_FALSE(limiter.admit(IPAddressV6("2001:db8::2"), now));
+	EXPECT_TRUE(limiter.admit(IPAddressV6("2001:db8:0:1::1"), now));
+}
+
+TEST(RateLimiterTest, EvictionAndBoundedMemory)
+{
+	RateLimiter limiter(1000.0, 1, 64);
+	EXPECT_EQ(limiter.capacity(), 64u);
+	const uint64_t now = 10 * kSecond;
+	in_addr addr = {};
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		addr.s_addr = htonl(0x0A000000u + i);
+		EXPECT_TRUE(limiter.admit(IPAddress(addr), now));
+	}
+	EXPECT_LE(limiter.size(), limiter.capacity());
+	EXPECT_GT(limiter.getOverflowCount(), 0u);
+	//every bucket is full again after 1ms
+	EXPECT_EQ(limiter.evictIdle(now + kSecond), limiter.capacity());
+	EXPECT_EQ(limiter.size(), 0u);
+
+	limiter.startEviction(std::chrono::milliseconds(1));
+	EXPECT_TRUE(limiter.admit(IPAddress("10.0.0.1")));
+	for (int i = 0; i < 1000 && limiter.size() != 0; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	EXPECT_EQ(limiter.size(), 0u);
+	limiter.stopEviction();
+}
+
+TEST(RateLimiterTest, ConcurrentAdmits)
+{
+	RateLimiter limiter(1.0, 1000, 4096);
+	const uint64_t now = 10 * kSecond;
+	std::atomic<uint32_t> admitted{ 0 };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 8; t++)
+	{
+		threads.emplace_back([&]()
+		{
+			for (int i = 0; i < 500; i++)
+			{
+				if (limiter.admit(IPAddressV4("203.0.113.9"), now))
+					admitted++;
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	EXPECT_EQ(admitted.load(), 1000u);
+}
+
+TEST(RateLimiterTest, ConcurrentFirstAdmits)
+{
+	//threads racing on the first request of a key share one bucket
+	RateLimiter limiter(1.0, 2, 4096);
+	const uint64_t now = 10 * kSecond;
+	std::atomic<uint32_t> admitted{ 0 };
+	std::atomic<bool> start{ false };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&]()
+		{
+			while (!start.load())
+				std::this_thread::yield();
+			in_addr addr = {};
+			for (uint32_t i = 0; i < 500; i++)
+			{
+				addr.s_addr = htonl(0xC6336400u + i);
+				for (int j = 0; j < 2; j++)
+				{
+					if (limiter.admit(IPAddress(addr), now))
+						admitted++;
+				}
+			}
+		});
+	}
+	start = true;
+	for (auto& thread : threads)
+		thread.join();
+	EXPECT_EQ(admitted.load(), 1000u);
+	EXPECT_EQ(limiter.size(), 500u);
+}
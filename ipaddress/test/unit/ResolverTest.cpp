@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
+#include "Resolver.h"
+using namespace ip_address;
+
+namespace
+{
+	struct StubRecord
+	{
+		std::vector<IPAddress> addresses;
+		uint32_t ttl = 300;
+		bool nameError = false;
+		bool drop = false;
+		std::chrono::milliseconds delay{ 0 };
+	};
+
+	/*
+	 * Answers A and AAAA queries on a loopback UDP port from a fixed table, names are matched in lower case.
+	 */
+	class StubDnsServer
+	{
+	public:
+		explicit StubDnsServer(std::map<std::string, StubRecord> records) : mRecords(std::move(records))
+		{
+			mFd = socket(AF_INET, SOCK_DGRAM, 0);
+			sockaddr_in address = IPAddressV4::loopback().getSockaddrIn4();
+			bind(mFd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+			socklen_t length = sizeof(address);
+			getsockname(mFd, reinterpret_cast<sockaddr*>(&address), &length);
+			mEndPoint = IPEndPoint(IPAddressV4::loopback(), port_network_byte_order_t(address.sin_port));
+			mThread = std::thread(&StubDnsServer::run, this);
+		}
+		~StubDnsServer()
+		{
+			mStop = true;
+			mThread.join();
+			close(mFd);
+		}
+
+		const IPEndPoint& getEndPoint() const { return mEndPoint; }
+		uint32_t getQueryCount() const { return mQueries.load(); }
+	private:
+		void run()
+		{
+			while (!mStop)
+			{
+				pollfd descriptor = { mFd, POLLIN, 0 };
+				if (poll(&descriptor, 1, 20) <= 0)
+					continue;
+				uint8_t query[512];
+				sockaddr_storage client;
+				socklen_t clientLength = sizeof(client);
+				const ssize_t size = recvfrom(mFd, query, sizeof(query), 0, reinterpret_cast<sockaddr*>(&client), &clientLength);
+				if (size < 17)
+					continue;
+				mQueries++;
+				//question name starts at 12, type follows the terminating zero label
+				std::string name;
+				size_t offset = 12;
+				while (query[offset] != 0)
+				{
+					if (!name.empty())
+						name += '.';
+					name.append(reinterpret_cast<const char*>(&query[offset + 1]), query[offset]);
+					offset += query[offset] + 1;
+				}
+				const size_t questionEnd = offset + 5;
+				const uint16_t type = static_cast<uint16_t>(query[offset + 1] << 8 | query[offset + 2]);
+				const auto found = mRecords.find(name);
+				if (found == mRecords.end() || found->second.drop)
+					continue;
+				const StubRecord& record = found->second;
+				std::this_thread::sleep_for(record.delay);
+
+				std::vector<uint8_t> response(query, query + questionEnd);
+				response[2] = 0x81;
+				response[3] = record.nameError ? 0x83 : 0x80;
+				uint16_t answers = 0;
+				for (const IPAddress& addr : record.addresses)
+				{
+					if ((type == 1) != addr.isIPv4())
+						continue;
+					const size_t length = addr.isIPv4() ? 4 : 16;
+					const uint8_t header[] = { 0xC0, 12, 0, static_cast<uint8_t>(type), 0, 1,
+					                           static_cast<uint8_t>(record.ttl >> 24), static_cast<uint8_t>(record.ttl >> 16),
+					                           static_cast<uint8_t>(record.ttl >> 8), static_cast<uint8_t>(record.ttl),
+					                           0, static_cast<uint8_t>(length) };
+					response.insert(response.end(), header, header + sizeof(header));
+					const uint8_t* bytes = addr.isIPv4() ? addr.asIPv4().bytes().data() : addr.asIPv6().bytes().data();
+					response.insert(response.end(), bytes, bytes + length);
+					answers++;
+				}
+				response[6] = static_cast<uint8_t>(answers >> 8);
+				response[7] = static_cast<uint8_t>(answers);
+				if (answers == 0)
+				{
+					//SOA with TTL 60 and minimum 5 in the authority section
+					const uint8_t soa[] = { 0xC0, 12, 0, 6, 0, 1, 0, 0, 0, 60, 0, 22, 0, 0,
+					                        0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 5 };
+					response.insert(response.end(), soa, soa + sizeof(soa));
+					response[9] = 1;
+				}
+				sendto(mFd, response.data(), response.size(), 0, reinterpret_cast<sockaddr*>(&client), clientLength);
+			}
+		}
+
+		std::map<std::string, StubRecord> mRecords;
+		int mFd = -1;
+		IPEndPoint mEndPoint;
+		std::atomic<bool> mStop{ false };
+		std::atomic<uint32_t> mQueries{ 0 };
+		std::thread mThread;
+	};
+
+	Resolver::Options makeOptions(const StubDnsServer& server)
+	{
+		Resolver::Options options;
+		options.nameServers.push_back(server.getEndPoint());
+		options.timeout = std::chrono::milliseconds(200);
+		options.attempts = 1;
+		return options;
+	}
+}
+
+TEST(ResolverTest, ResolveAndCache)
+{
+	StubRecord record;
+	record.addresses = { IPAddress("10.0.0.1"), IPAddress("10.0.0.2"), IPAddress("2001:db8::1") };
+	StubDnsServer server({ { "service.example", record } });
+	Resolver resolver(makeOptions(server));
+
+	std::vector<IPAddress> addresses = resolver.resolve("Service.Example.").get();
+	ASSERT_EQ(addresses.size(), 3u);
+	EXPECT_EQ(addresses[0], IPAddress("10.0.0.1"));
+	EXPECT_EQ(addresses[2], IPAddress("2001:db8::1"));
+	EXPECT_EQ(server.getQueryCount(), 2u);
+	EXPECT_EQ(resolver.getQueryCount(), 2u);
+
+	//cached, the callback runs on this thread
+	bool called = false;
+	resolver.resolve("service.example", [&called](ResolveStatus status, const std::vector<IPAddress>& found)
+	{
+		EXPECT_EQ(status, ResolveStatus::kOk);
+		EXPECT_EQ(found.size(), 3u);
+		called = true;
+	});
+	EXPECT_TRUE(called);
+	EXPECT_TRUE(resolver.lookupCached("SERVICE.example", addresses));
+	EXPECT_EQ(server.getQueryCount(), 2u);
+
+	resolver.clearCache();
+	EXPECT_FALSE(resolver.lookupCached("service.example", addresses));
+}
+
+TEST(ResolverTest, FamilyAndTtl)
+{
+	StubRecord record;
+	record.addresses = { IPAddress("10.0.0.1"), IPAddress("2001:db8::1") };
+	record.ttl = 1;
+	StubDnsServer server({ { "short.example", record } });
+	Resolver::Options options = makeOptions(server);
+	options.family = Resolver::Family::kIPv6;
+	Resolver resolver(options);
+
+	std::vector<IPAddress> addresses = resolver.resolve("short.example").get();
+	ASSERT_EQ(addresses.size(), 1u);
+	EXPECT_TRUE(addresses[0].isIPv6());
+	EXPECT_EQ(server.getQueryCount(), 1u);
+	std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+	EXPECT_FALSE(resolver.lookupCached("short.example", addresses));
+	EXPECT_EQ(resolver.resolve("short.example").get().size(), 1u);
+	EXPECT_EQ(server.getQueryCount(), 2u);
+}
+
+TEST(ResolverTest, NegativeCache)
+{
+	StubRecord missing;
+	missing.nameError = true;
+	StubRecord noAaaa;
+	noAaaa.addresses = { IPAddress("10.0.0.1") };
+	StubDnsServer server({ { "missing.example", missing }, { "v4only.example", noAaaa } });
+	Resolver::Options options = makeOptions(server);
+	options.family = Resolver::Family::kIPv6;
+	Resolver resolver(options);
+
+	EXPECT_TRUE(resolver.resolve("missing.example").get().empty());
+	EXPECT_TRUE(resolver.resolve("v4only.example").get().empty());
+	EXPECT_EQ(server.getQueryCount(), 2u);
+	std::vector<IPAddress> addresses(1);
+	EXPECT_TRUE(resolver.lookupCached("missing.example", addresses));
+	EXPECT_TRUE(addresses.empty());
+	EXPECT_TRUE(resolver.resolve("v4only.example").get().empty());
+	EXPECT_EQ(server.getQueryCount(), 2u);
+
+	//invalid names never reach the server
+	EXPECT_TRUE(resolver.resolve("bad..name").get().empty());
+	EXPECT_EQ(server.getQueryCount(), 2u);
+}
+
+TEST(ResolverTest, Coalescing)
+{
+	StubRecord record;
+	record.addresses = { IPAddress("10.0.0.1") };
+	record.delay = std::chrono::milliseconds(50);
+	StubDnsServer server({ { "slow.example", record } });
+	Resolver::Options options = makeOptions(server);
+	options.family = Resolver::Family::kIPv4;
+	options.threads = 4;
+	Resolver resolver(options);
+
+	std::vector<std::future<std::vector<IPAddress>>> futures;
+	for (int i = 0; i < 16; i++)
+	{
+		futures.push_back(resolver.resolve("slow.example"));
+	}
+	for (auto& future : futures)
+	{
+		EXPECT_EQ(future.get().size(), 1u);
+	}
+	EXPECT_EQ(server.getQueryCount(), 1u);
+}
+
+TEST(ResolverTest, TimeoutAndNumeric)
+{
+	StubRecord record;
+	record.drop = true;
+	StubDnsServer server({ { "dropped.example", record } });
+	Resolver resolver(makeOptions(server));
+
+	std::future<std::vector<IPAddress>> future = resolver.resolve("dropped.example");
+	EXPECT_THROW(future.get(), std::runtime_error);
+	std::vector<IPAddress> addresses;
+	EXPECT_FALSE(resolver.lookupCached("dropped.example", addresses));
+
+	EXPECT_EQ(resolver.resolve("192.0.2.7").get().at(0), IPAddress("192.0.2.7"));
+	EXPECT_EQ(resolver.resolve("2001:db8::7").get().at(0), IPAddress("2001:db8::7"));
+	EXPECT_EQ(server.getQueryCount(), 2u);
+}
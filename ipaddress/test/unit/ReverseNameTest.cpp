@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "ReverseName.h"
+using namespace ip_address;
+
+TEST(ReverseNameTest, IPv4)
+{
+	char buffer[kMaxReverseNameLengthV4 + 1];
+	EXPECT_EQ(to_reverse_name(IPAddressV4("192.0.2.1"), buffer), 22u);
+	EXPECT_STREQ(buffer, "1.2.0.192.in-addr.arpa");
+	EXPECT_EQ(to_reverse_name(IPAddressV4("255.255.255.255"), buffer), kMaxReverseNameLengthV4);
+	EXPECT_STREQ(buffer, "255.255.255.255.in-addr.arpa");
+	EXPECT_EQ(to_reverse_name(IPAddress("10.0.100.9"), buffer), 23u);
+	EXPECT_STREQ(buffer, "9.100.0.10.in-addr.arpa");
+
+	IPAddressV4 addr4;
+	ASSERT_TRUE(from_reverse_name("1.2.0.192.in-addr.arpa", addr4));
+	EXPECT_EQ(addr4, IPAddressV4("192.0.2.1"));
+	ASSERT_TRUE(from_reverse_name("255.255.255.0.IN-ADDR.ARPA.", addr4));
+	EXPECT_EQ(addr4, IPAddressV4("0.255.255.255"));
+	for (const char* invalid : { "2.0.192.in-addr.arpa", "1.2.3.4.5.in-addr.arpa", "256.2.0.192.in-addr.arpa",
+	                             "01.2.0.192.in-addr.arpa", "1..0.192.in-addr.arpa", "1.2.0.192.in-addr.arpa..",
+	                             "0/25.2.0.192.in-addr.arpa", "1.2.0.192.ip6.arpa", "in-addr.arpa", "" })
+	{
+		EXPECT_FALSE(from_reverse_name(invalid, addr4)) << invalid;
+	}
+}
+
+TEST(ReverseNameTest, IPv6)
+{
+	char buffer[kMaxReverseNameLengthV6 + 1];
+	EXPECT_EQ(to_reverse_name(IPAddressV6("4321:0:1:2:3:4:567:89ab"), buffer), kMaxReverseNameLengthV6);
+	EXPECT_STREQ(buffer, "b.a.9.8.7.6.5.0.4.0.0.0.3.0.0.0.2.0.0.0.1.0.0.0.0.0.0.0.1.2.3.4.ip6.arpa");
+
+	IPAddressV6 addr6;
+	ASSERT_TRUE(from_reverse_name("B.A.9.8.7.6.5.0.4.0.0.0.3.0.0.0.2.0.0.0.1.0.0.0.0.0.0.0.1.2.3.4.IP6.ARPA.", addr6));
+	EXPECT_EQ(addr6, IPAddressV6("4321:0:1:2:3:4:567:89ab"));
+	IPAddress addr;
+	ASSERT_TRUE(from_reverse_name(buffer, addr));
+	EXPECT_TRUE(addr.isIPv6());
+	ASSERT_TRUE(from_reverse_name("4.3.2.1.in-addr.arpa", addr));
+	EXPECT_EQ(addr, IPAddress("1.2.3.4"));
+	for (const char* invalid : { "a.9.8.7.6.5.0.4.0.0.0.3.0.0.0.2.0.0.0.1.0.0.0.0.0.0.0.1.2.3.4.ip6.arpa",
+	                             "g.a.9.8.7.6.5.0.4.0.0.0.3.0.0.0.2.0.0.0.1.0.0.0.0.0.0.0.1.2.3.4.ip6.arpa",
+	                             "ba.9.8.7.6.5.0.4.0.0.0.3.0.0.0.2.0.0.0.1.0.0.0.0.0.0.0.1.2.3.4.ip6.arpa.",
+	                             "b.a.9.8.7.6.5.0.4.0.0.0.3.0.0.0.2.0.0.0.1.0.0.0.0.0.0.0.1.2.3.4.ip7.arpa" })
+	{
+		EXPECT_FALSE(from_reverse_name(invalid, addr6)) << invalid;
+		EXPECT_FALSE(from_reverse_name(invalid, addr)) << invalid;
+	}
+}
+
+TEST(ReverseNameTest, RoundTripAndBatch)
+{
+	std::mt19937_64 rng(37);
+	std::vector<IPAddressV4> addresses4;
+	std::vector<IPAddressV6> addresses6;
+	for (int i = 0; i < 1000; i++)
+	{
+		const uint64_t r = rng();
+		addresses4.emplace_back(ByteArray4{ static_cast<uint8_t>(r), static_cast<uint8_t>(r >> 8),
+		                                    static_cast<uint8_t>(r >> 16), static_cast<uint8_t>(r >> 24) });
+		ByteArray16 bytes;
+		for (size_t j = 0; j < bytes.size(); j++)
+			bytes[j] = static_cast<uint8_t>(rng());
+		addresses6.emplace_back(bytes);
+	}
+
+	std::vector<char> buffer(addresses4.size() * (kMaxReverseNameLengthV4 + 1));
+	std::vector<uint32_t> offsets(addresses4.size());
+	const size_t size4 = to_reverse_names(Span<const IPAddressV4>(addresses4.data(), addresses4.size()), buffer.data(),
+	                                      offsets.data());
+	EXPECT_LE(size4, buffer.size());
+	for (size_t i = 0; i < addresses4.size(); i++)
+	{
+		const char* name = buffer.data() + offsets[i];
+		std::string expected;
+		ByteArray4& bytes = addresses4[i].bytes();
+		for (int j = 3; j >= 0; j--)
+			expected += std::to_string(bytes[static_cast<size_t>(j)]) + ".";
+		ASSERT_EQ(std::string(name), expected + "in-addr.arpa");
+		IPAddressV4 parsed;
+		ASSERT_TRUE(from_reverse_name(name, parsed));
+		ASSERT_EQ(parsed, addresses4[i]);
+	}
+
+	buffer.assign(addresses6.size() * (kMaxReverseNameLengthV6 + 1), 0);
+	EXPECT_EQ(to_reverse_names(Span<const IPAddressV6>(addresses6.data(), addresses6.size()), buffer.data(), offsets.data()),
+	          addresses6.size() * (kMaxReverseNameLengthV6 + 1));
+	for (size_t i = 0; i < addresses6.size(); i++)
+	{
+		IPAddressV6 parsed;
+		ASSERT_TRUE(from_reverse_name(buffer.data() + offsets[i], parsed));
+		ASSERT_EQ(parsed, addresses6[i]);
+	}
+}
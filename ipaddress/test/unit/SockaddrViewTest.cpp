@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include "SockaddrView.h"
+using namespace ip_address;
+
+TEST(SockaddrViewTest, KernelMemory)
+{
+	sockaddr_storage storage;
+	memset(&storage, 0xCD, sizeof(storage));
+	auto* addr6 = reinterpret_cast<sockaddr_in6*>(&storage);
+	addr6->sin6_family = AF_INET6;
+	addr6->sin6_port = htons(443);
+	addr6->sin6_addr = IPAddressV6("2001:db8::1").getSockaddrIn6().sin6_addr;
+
+	const SockaddrView view(storage, sizeof(sockaddr_in6));
+	EXPECT_TRUE(view.isValid());
+	EXPECT_EQ(view.getVersion(), IPVersion::kIPv6);
+	EXPECT_EQ(view.getPort(), 443);
+	const IPEndPoint endpoint(IPAddressV6("2001:db8::1"), port_host_byte_order_t(443));
+	EXPECT_TRUE(view == endpoint);
+	EXPECT_TRUE(view != IPEndPoint(IPAddressV6("2001:db8::1"), port_host_byte_order_t(80)));
+	EXPECT_EQ(view.toEndPoint(), endpoint);
+	EXPECT_EQ(view.getIPAddress(), IPAddress(IPAddressV6("2001:db8::1")));
+
+	//truncated or foreign addresses are rejected instead of read past their end
+	EXPECT_FALSE(SockaddrView(storage, sizeof(sockaddr_in)).isValid());
+	storage.ss_family = AF_UNIX;
+	EXPECT_FALSE(SockaddrView(storage, sizeof(storage)).isValid());
+	EXPECT_EQ(SockaddrView(storage, sizeof(storage)).toEndPoint().getVersion(), IPVersion::kUnknown);
+	EXPECT_FALSE(SockaddrView().isValid());
+}
+
+TEST(SockaddrViewTest, WriteSockaddr)
+{
+	const IPEndPoint endpoint4(IPAddressV4("198.51.100.7"), port_host_byte_order_t(8443));
+	sockaddr_storage storage;
+	memset(&storage, 0xCD, sizeof(storage));
+	socklen_t length = 0;
+	endpoint4.writeSockaddr(storage, length);
+	EXPECT_EQ(length, sizeof(sockaddr_in));
+	const SockaddrView view(storage, length);
+	EXPECT_TRUE(view == endpoint4);
+	const auto* addr4 = reinterpret_cast<const sockaddr_in*>(&storage);
+	for (const auto b : addr4->sin_zero)
+		EXPECT_EQ(b, 0);
+
+	const IPEndPoint endpoint6(IPAddressV6("fe80::abcd"), port_host_byte_order_t(9));
+	endpoint6.writeSockaddr(storage, length);
+	EXPECT_EQ(length, sizeof(sockaddr_in6));
+	EXPECT_EQ(SockaddrView(storage, length).toEndPoint(), endpoint6);
+}
+
+TEST(SockaddrViewTest, SockaddrConstructors)
+{
+	sockaddr_in addr4 = {};
+	addr4.sin_family = AF_INET;
+	addr4.sin_addr.s_addr = htonl(0xC0000201);
+	EXPECT_EQ(IPAddressV4(addr4), IPAddressV4("192.0.2.1"));
+	EXPECT_EQ(IPAddress(addr4), IPAddress(IPAddressV4("192.0.2.1")));
+
+	sockaddr_in6 addr6 = IPAddressV6("2001:db8::2").getSockaddrIn6();
+	addr6.sin6_scope_id = 0xFFFFFFFF;
+	EXPECT_EQ(IPAddressV6(addr6), IPAddressV6("2001:db8::2"));
+	EXPECT_EQ(IPAddress(addr6), IPAddress(IPAddressV6("2001:db8::2")));
+
+	//IPv4 endpoints are handed to dual-stack sockets as IPv4-mapped addresses
+	const sockaddr_in6 mapped = IPEndPoint(IPAddressV4("192.0.2.1"), port_host_byte_order_t(53)).getAddressIPv6();
+	const uint8_t expected[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF, 192, 0, 2, 1 };
+	EXPECT_EQ(memcmp(&mapped.sin6_addr, expected, sizeof(expected)), 0);
+	EXPECT_EQ(ntohs(mapped.sin6_port), 53);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "IPEndPoint.h"
+#include "IPNetwork.h"
 #include <thread>         
 using namespace ip_address;
 TEST(IPAddressV4Test, parse)
@@ -31,6 +32,29 @@ TEST(IPAddressV4Test, Any)
 	EXPECT_TRUE(ip6.getString() == "0.0.0.0");
 }
 
+TEST(IPAddressV4Test, Classification)
+{
+	EXPECT_TRUE(IPAddressV4("239.255.255.250").isMulticast());
+	EXPECT_FALSE(IPAddressV4("240.0.0.1").isMulticast());
+	EXPECT_TRUE(IPAddressV4("169.254.10.1").isLinkLocal());
+	EXPECT_FALSE(IPAddressV4("169.1.254.1").isLinkLocal());
+	EXPECT_EQ(IPAddressV4("10.0.0.1").getIPAddressClass(), IPAddressV4Class::A);
+	EXPECT_EQ(IPAddressV4("172.16.0.1").getIPAddressClass(), IPAddressV4Class::B);
+	EXPECT_EQ(IPAddressV4("192.168.0.1").getIPAddressClass(), IPAddressV4Class::C);
+	EXPECT_EQ(IPAddressV4("224.0.0.1").getIPAddressClass(), IPAddressV4Class::D);
+	EXPECT_EQ(IPAddressV4("250.0.0.1").getIPAddressClass(), IPAddressV4Class::E);
+}
+
+TEST(IPAddressV6Test, Mapping)
+{
+	const IPAddressV6 mapped = IPAddressV4("192.0.2.1").toIPv6();
+	EXPECT_EQ(mapped, IPAddressV6("::ffff:192.0.2.1"));
+	EXPECT_TRUE(mapped.isIPv4Mapped());
+	EXPECT_EQ(mapped.toIPv4(), IPAddressV4("192.0.2.1"));
+	IPAddressV4 addr4;
+	EXPECT_FALSE(IPAddressV6::mapIPv6ToIPv4(IPAddressV6("2001:db8::1"), addr4));
+}
+
 TEST(IPAddressV6Test, parse)
 {
 
@@ -53,6 +77,21 @@ TEST(IPAddressV6Test, Operator)
 	EXPECT_FALSE(ip1 != ip2);
 }
 
+TEST(IPAddressV6Test, String)
+{
+	/* RFC 5952 text as written by inet_ntop */
+	const char* texts[] = { "::", "::1", "2001:db8::1", "2001:db8:0:1:1:1:1:1", "2001:0:0:1::1", "1::2:0:0:3:4",
+		"1:2:3:4:5:6::", "::ffff:192.0.2.1", "::192.0.2.1", "::ffff:0:0:1" };
+	for (const char* text : texts)
+	{
+		EXPECT_EQ(ip_address::IPAddressV6(text).getString(), text);
+	}
+	//a single zero group is not compressed
+	EXPECT_EQ(ip_address::IPAddressV6("1:2:3:4:5:6:7::").getString(), "1:2:3:4:5:6:7:0");
+	EXPECT_EQ(ip_address::IPAddressV6("2001:DB8:0000::0001").getString(), "2001:db8::1");
+	EXPECT_EQ(ip_address::IPAddress(ip_address::IPAddressV6("2001:db8::1")).getString(), "2001:db8::1");
+}
+
 void func1()
 {
 	IPEndPoint ipend(IPAddressV4("123.123.123.123"), 1001);
@@ -73,6 +112,32 @@ TEST(IPEndPoint, basic)
 	thread.join();
 
 }
+TEST(IPNetworkTest, parse)
+{
+	IPNetwork net1("10.1.2.3/8");
+	EXPECT_EQ(net1.getPrefixLength(), 8);
+	EXPECT_EQ(net1.getAddress(), IPAddressV4("10.0.0.0"));
+	EXPECT_EQ(net1, IPNetwork(IPAddressV4("10.0.0.0"), 8));
+
+	IPNetwork net2;
+	EXPECT_TRUE(IPNetwork::parseIPNetwork(net2, "fe80::1/10"));
+	EXPECT_EQ(net2.getAddress(), IPAddressV6("fe80::"));
+	EXPECT_FALSE(IPNetwork::parseIPNetwork(net2, "10.0.0.0/33"));
+	EXPECT_FALSE(IPNetwork::parseIPNetwork(net2, "10.0.0.0/"));
+	EXPECT_FALSE(IPNetwork::parseIPNetwork(net2, "localhost/8"));
+}
+
+TEST(IPNetworkTest, contains)
+{
+	IPNetwork net("192.168.0.0/16");
+	EXPECT_TRUE(net.contains(IPAddressV4("192.168.10.1")));
+	EXPECT_FALSE(net.contains(IPAddressV4("192.169.0.1")));
+	EXPECT_FALSE(net.contains(IPAddressV6("::1")));
+	EXPECT_TRUE(net.contains(IPNetwork("192.168.1.0/24")));
+	EXPECT_FALSE(net.contains(IPNetwork("192.0.0.0/8")));
+	EXPECT_EQ(IPAddressV6("2001:db8:ffff::1").truncate(33), IPAddressV6("2001:db8:8000::"));
+}
+
 TEST(SanityTest, Sanity)
 {
 	IPAddressV4 ipv4;
@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "HostTable.h"
+using namespace ip_address;
+
+/*
+ * Compiles hosts format files into a HostTable file.
+ *
+ *	HostTableBuilder -o services.table /etc/hosts extra_hosts
+ */
+int main(int argc, char** argv)
+{
+	std::string output;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			output = argv[++i];
+		else
+			inputs.emplace_back(argv[i]);
+	}
+	if (output.empty() || inputs.empty())
+	{
+		fprintf(stderr, "usage: %s -o <table> <hosts file>...\n", argv[0]);
+		return 2;
+	}
+
+	HostTableBuilder builder;
+	for (const std::string& input : inputs)
+	{
+		std::ifstream hosts(input);
+		if (!hosts)
+		{
+			fprintf(stderr, "can not read %s\n", input.c_str());
+			return 1;
+		}
+		const size_t skipped = builder.addHosts(hosts);
+		if (skipped != 0)
+			fprintf(stderr, "%s: skipped %zu invalid lines\n", input.c_str(), skipped);
+	}
+	try
+	{
+		builder.write(output);
+		//load it back so a broken table is never shipped
+		const HostTable table(output);
+		printf("%s: %zu names, %zu addresses\n", output.c_str(), table.getNameCount(), table.getAddressCount());
+	}
+	catch (const std::runtime_error& error)
+	{
+		fprintf(stderr, "%s: %s\n", output.c_str(), error.what());
+		return 1;
+	}
+	return 0;
+}
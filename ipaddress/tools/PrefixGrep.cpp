@@ -0,0 +1,125 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "LogFilter.h"
+using namespace ip_address;
+
+/*
+ * Prints the lines of log files whose address field is in one of the prefixes, or counts them per prefix.
+ *
+ *	PrefixGrep -n 10.0.0.0/8 -n 2001:db8::/32 access.log
+ *	PrefixGrep -c -p blocklist.txt -f 2 -d , -t 8 flows.csv
+ */
+int main(int argc, char** argv)
+{
+	std::vector<IPNetwork> prefixes;
+	//prefixes as given, for the counts
+	std::vector<std::string> names;
+	std::vector<std::string> inputs;
+	LogFilter::Options options;
+	bool countOnly = false;
+	for (int i = 1; i < argc; i++)
+	{
+		const bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "-c") == 0)
+		{
+			countOnly = true;
+		}
+		else if (strcmp(argv[i], "-f") == 0 && hasValue)
+		{
+			options.column = strtoul(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "-d") == 0 && hasValue)
+		{
+			options.delimiter = argv[++i][0];
+		}
+		else if (strcmp(argv[i], "-t") == 0 && hasValue)
+		{
+			options.threads = strtoul(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "-n") == 0 && hasValue)
+		{
+			IPNetwork network;
+			if (!IPNetwork::parseIPNetwork(network, argv[++i]))
+			{
+				fprintf(stderr, "invalid prefix %s\n", argv[i]);
+				return 2;
+			}
+			prefixes.push_back(network);
+			names.emplace_back(argv[i]);
+		}
+		else if (strcmp(argv[i], "-p") == 0 && hasValue)
+		{
+			//one prefix per line, '#' starts a comment
+			std::ifstream file(argv[++i]);
+			if (!file)
+			{
+				fprintf(stderr, "can not read %s\n", argv[i]);
+				return 1;
+			}
+			size_t skipped = 0;
+			std::string line;
+			while (std::getline(file, line))
+			{
+				line = line.substr(0, line.find('#'));
+				line.erase(line.find_last_not_of(" \t\r") + 1);
+				line.erase(0, line.find_first_not_of(" \t"));
+				IPNetwork network;
+				if (line.empty())
+					continue;
+				if (IPNetwork::parseIPNetwork(network, line))
+				{
+					prefixes.push_back(network);
+					names.push_back(line);
+				}
+				else
+				{
+					skipped++;
+				}
+			}
+			if (skipped != 0)
+				fprintf(stderr, "%s: skipped %zu invalid lines\n", argv[i], skipped);
+		}
+		else
+		{
+			inputs.emplace_back(argv[i]);
+		}
+	}
+	if (prefixes.empty() || inputs.empty())
+	{
+		fprintf(stderr, "usage: %s [-c] [-f column] [-d delimiter] [-t threads] (-n prefix | -p prefix file)... <log>...\n",
+		        argv[0]);
+		return 2;
+	}
+
+	const LogFilter filter(prefixes, options);
+	std::vector<uint64_t> counts;
+	size_t matched = 0;
+	for (const std::string& input : inputs)
+	{
+		try
+		{
+			if (countOnly)
+				matched += filter.countFile(input, counts);
+			else
+				matched += filter.filterFile(input, [](std::string_view lines) { fwrite(lines.data(), 1, lines.size(), stdout); });
+		}
+		catch (const std::runtime_error& error)
+		{
+			fprintf(stderr, "%s: %s\n", input.c_str(), error.what());
+			return 1;
+		}
+	}
+	if (countOnly)
+	{
+		for (size_t i = 0; i < prefixes.size(); i++)
+		{
+			printf("%s %llu\n", names[i].c_str(), static_cast<unsigned long long>(counts[i]));
+		}
+	}
+	return matched != 0 ? 0 : 1;
+}